@@ -41,6 +41,8 @@
 #include "ns3/udp-socket-factory.h"
 #include "ns3/string.h"
 #include "ns3/pointer.h"
+#include <algorithm>
+#include <vector>
 
 namespace ns3 {
 
@@ -82,6 +84,12 @@ OnOffApplication::GetTypeId (void)
                    UintegerValue (0),
                    MakeUintegerAccessor (&OnOffApplication::m_maxBytes),
                    MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("BatchSize",
+                   "The number of packets handed to the socket at once in the On "
+                   "state.  The trains are spaced so as to keep the data rate.",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&OnOffApplication::m_batchSize),
+                   MakeUintegerChecker<uint32_t> (1))
     .AddAttribute ("Protocol", "The type of protocol to use. This should be "
                    "a subclass of ns3::SocketFactory",
                    TypeIdValue (UdpSocketFactory::GetTypeId ()),
@@ -244,7 +252,7 @@ void OnOffApplication::ScheduleNextTx ()
 
   if (m_maxBytes == 0 || m_totBytes < m_maxBytes)
     {
-      uint32_t bits = m_pktSize * 8 - m_residualBits;
+      uint32_t bits = m_batchSize * m_pktSize * 8 - m_residualBits;
       NS_LOG_LOGIC ("bits = " << bits);
       Time nextTime (Seconds (bits /
                               static_cast<double>(m_cbrRate.GetBitRate ()))); // Time till next packet
@@ -282,31 +290,55 @@ void OnOffApplication::SendPacket ()
   NS_LOG_FUNCTION (this);
 
   NS_ASSERT (m_sendEvent.IsExpired ());
-  Ptr<Packet> packet = Create<Packet> (m_pktSize);
-  m_txTrace (packet);
-  m_socket->Send (packet);
-  m_totBytes += m_pktSize;
-  Address localAddress;
-  m_socket->GetSockName (localAddress);
-  if (InetSocketAddress::IsMatchingType (m_peer))
+  // A train of up to m_batchSize packets, without overshooting MaxBytes
+  uint32_t count = m_batchSize;
+  if (m_maxBytes != 0)
+    {
+      uint64_t left = (m_maxBytes - m_totBytes + m_pktSize - 1) / m_pktSize;
+      count = static_cast<uint32_t> (std::min<uint64_t> (count, std::max<uint64_t> (left, 1)));
+    }
+  std::vector<Ptr<Packet> > packets;
+  packets.reserve (count);
+  for (uint32_t i = 0; i < count; i++)
+    {
+      Ptr<Packet> packet = Create<Packet> (m_pktSize);
+      m_txTrace (packet);
+      packets.push_back (packet);
+    }
+  if (count == 1)
+    {
+      m_socket->Send (packets.front ());
+    }
+  else
     {
-      NS_LOG_INFO ("At time " << Simulator::Now ().GetSeconds ()
-                   << "s on-off application sent "
-                   <<  packet->GetSize () << " bytes to "
-                   << InetSocketAddress::ConvertFrom(m_peer).GetIpv4 ()
-                   << " port " << InetSocketAddress::ConvertFrom (m_peer).GetPort ()
-                   << " total Tx " << m_totBytes << " bytes");
-      m_txTraceWithAddresses (packet, localAddress, InetSocketAddress::ConvertFrom (m_peer));
+      m_socket->SendBatch (packets, 0);
     }
-  else if (Inet6SocketAddress::IsMatchingType (m_peer))
+  Address localAddress;
+  m_socket->GetSockName (localAddress);
+  for (std::vector<Ptr<Packet> >::const_iterator i = packets.begin (); i != packets.end (); i++)
     {
-      NS_LOG_INFO ("At time " << Simulator::Now ().GetSeconds ()
-                   << "s on-off application sent "
-                   <<  packet->GetSize () << " bytes to "
-                   << Inet6SocketAddress::ConvertFrom(m_peer).GetIpv6 ()
-                   << " port " << Inet6SocketAddress::ConvertFrom (m_peer).GetPort ()
-                   << " total Tx " << m_totBytes << " bytes");
-      m_txTraceWithAddresses (packet, localAddress, Inet6SocketAddress::ConvertFrom(m_peer));
+      Ptr<Packet> packet = *i;
+      m_totBytes += m_pktSize;
+      if (InetSocketAddress::IsMatchingType (m_peer))
+        {
+          NS_LOG_INFO ("At time " << Simulator::Now ().GetSeconds ()
+                       << "s on-off application sent "
+                       <<  packet->GetSize () << " bytes to "
+                       << InetSocketAddress::ConvertFrom(m_peer).GetIpv4 ()
+                       << " port " << InetSocketAddress::ConvertFrom (m_peer).GetPort ()
+                       << " total Tx " << m_totBytes << " bytes");
+          m_txTraceWithAddresses (packet, localAddress, InetSocketAddress::ConvertFrom (m_peer));
+        }
+      else if (Inet6SocketAddress::IsMatchingType (m_peer))
+        {
+          NS_LOG_INFO ("At time " << Simulator::Now ().GetSeconds ()
+                       << "s on-off application sent "
+                       <<  packet->GetSize () << " bytes to "
+                       << Inet6SocketAddress::ConvertFrom(m_peer).GetIpv6 ()
+                       << " port " << Inet6SocketAddress::ConvertFrom (m_peer).GetPort ()
+                       << " total Tx " << m_totBytes << " bytes");
+          m_txTraceWithAddresses (packet, localAddress, Inet6SocketAddress::ConvertFrom(m_peer));
+        }
     }
   m_lastStartTime = Simulator::Now ();
   m_residualBits = 0;
@@ -32,6 +32,8 @@
 #include "seq-ts-header.h"
 #include <cstdlib>
 #include <cstdio>
+#include <algorithm>
+#include <vector>
 
 namespace ns3 {
 
@@ -69,6 +71,12 @@ UdpClient::GetTypeId (void)
                    UintegerValue (1024),
                    MakeUintegerAccessor (&UdpClient::m_size),
                    MakeUintegerChecker<uint32_t> (12,65507))
+    .AddAttribute ("BatchSize",
+                   "The maximum number of packets handed to the socket at once, "
+                   "as a train sent every BatchSize intervals",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&UdpClient::m_batchSize),
+                   MakeUintegerChecker<uint32_t> (1))
   ;
   return tid;
 }
@@ -172,10 +180,6 @@ UdpClient::Send (void)
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (m_sendEvent.IsExpired ());
-  SeqTsHeader seqTs;
-  seqTs.SetSeq (m_sent);
-  Ptr<Packet> p = Create<Packet> (m_size-(8+4)); // 8+4 : the size of the seqTs header
-  p->AddHeader (seqTs);
 
   std::stringstream peerAddressStringStream;
   if (Ipv4Address::IsMatchingType (m_peerAddress))
@@ -187,14 +191,32 @@ UdpClient::Send (void)
       peerAddressStringStream << Ipv6Address::ConvertFrom (m_peerAddress);
     }
 
-  if ((m_socket->Send (p)) >= 0)
+  // A train of up to m_batchSize packets, handed to the socket at once
+  uint32_t count = m_sent < m_count ? std::min (m_batchSize, m_count - m_sent) : 1;
+  std::vector<Ptr<Packet> > packets;
+  packets.reserve (count);
+  for (uint32_t i = 0; i < count; i++)
     {
-      ++m_sent;
-      NS_LOG_INFO ("TraceDelay TX " << m_size << " bytes to "
-                                    << peerAddressStringStream.str () << " Uid: "
-                                    << p->GetUid () << " Time: "
-                                    << (Simulator::Now ()).GetSeconds ());
+      SeqTsHeader seqTs;
+      seqTs.SetSeq (m_sent + i);
+      Ptr<Packet> p = Create<Packet> (m_size-(8+4)); // 8+4 : the size of the seqTs header
+      p->AddHeader (seqTs);
+      packets.push_back (p);
+    }
 
+  int sent = count == 1 ? m_socket->Send (packets.front ()) : m_socket->SendBatch (packets, 0);
+  if (sent >= 0)
+    {
+      // a single packet is reported as its size in bytes by Send ()
+      sent = count == 1 ? 1 : sent;
+      for (int i = 0; i < sent; i++)
+        {
+          NS_LOG_INFO ("TraceDelay TX " << m_size << " bytes to "
+                                        << peerAddressStringStream.str () << " Uid: "
+                                        << packets[i]->GetUid () << " Time: "
+                                        << (Simulator::Now ()).GetSeconds ());
+        }
+      m_sent += sent;
     }
   else
     {
@@ -204,7 +226,7 @@ UdpClient::Send (void)
 
   if (m_sent < m_count)
     {
-      m_sendEvent = Simulator::Schedule (m_interval, &UdpClient::Send, this);
+      m_sendEvent = Simulator::Schedule (m_interval * count, &UdpClient::Send, this);
     }
 }
 
@@ -74,13 +74,14 @@ private:
   virtual void StopApplication (void);
 
   /**
-   * \brief Send a packet
+   * \brief Send a packet, or a train of BatchSize packets
    */
   void Send (void);
 
   uint32_t m_count; //!< Maximum number of packets the application will send
   Time m_interval; //!< Packet inter-send time
   uint32_t m_size; //!< Size of the sent packet (including the SeqTsHeader)
+  uint32_t m_batchSize; //!< Maximum number of packets sent at once
 
   uint32_t m_sent; //!< Counter for sent packets
   Ptr<Socket> m_socket; //!< Socket
@@ -25,6 +25,7 @@
 #include "ns3/ethernet-trailer.h"
 #include "ns3/llc-snap-header.h"
 #include "ns3/error-model.h"
+#include "ns3/tso-tag.h"
 #include "ns3/enum.h"
 #include "ns3/boolean.h"
 #include "ns3/uinteger.h"
@@ -558,7 +559,14 @@ CsmaNetDevice::TransmitStart (void)
           m_backoff.ResetBackoffTime ();
           m_txMachineState = BUSY;
 
-          Time tEvent = m_bps.CalculateBytesTxTime (m_currentPkt->GetSize ());
+          // A super-segment takes as long as the frames it stands for
+          uint32_t wireSize = m_currentPkt->GetSize ();
+          TsoTag tso;
+          if (m_currentPkt->PeekPacketTag (tso))
+            {
+              wireSize = tso.GetWireSize (wireSize);
+            }
+          Time tEvent = m_bps.CalculateBytesTxTime (wireSize);
           NS_LOG_LOGIC ("Schedule TransmitCompleteEvent in " << tEvent.GetSeconds () << "sec");
           Simulator::Schedule (tEvent, &CsmaNetDevice::TransmitCompleteEvent, this);
         }
@@ -749,7 +757,13 @@ CsmaNetDevice::Receive (Ptr<Packet> packet, Ptr<CsmaNetDevice> senderDevice)
       return;
     }
 
-  if (m_receiveErrorModel && m_receiveErrorModel->IsCorrupt (packet) )
+  bool corrupt = false;
+  if (m_receiveErrorModel)
+    {
+      corrupt = TsoTag::IsCorrupt (m_receiveErrorModel, packet);
+    }
+
+  if (corrupt)
     {
       NS_LOG_LOGIC ("Dropping pkt due to error model ");
       m_phyRxDropTrace (packet);
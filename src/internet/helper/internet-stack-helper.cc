@@ -28,6 +28,7 @@
 #include "ns3/packet-socket-factory.h"
 #include "ns3/config.h"
 #include "ns3/simulator.h"
+#include "ns3/system-wall-clock-ms.h"
 #include "ns3/string.h"
 #include "ns3/net-device.h"
 #include "ns3/callback.h"
@@ -267,10 +268,13 @@ InternetStackHelper::SetTcp (std::string tid, std::string n0, const AttributeVal
 void 
 InternetStackHelper::Install (NodeContainer c) const
 {
+  SystemWallClockMs clock;
+  clock.Start ();
   for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
     {
       Install (*i);
     }
+  NS_LOG_INFO ("Installed internet stack on " << c.GetN () << " nodes in " << clock.End () << " ms");
 }
 
 void 
@@ -22,6 +22,7 @@
 #include "ns3/ipv4-global-routing.h"
 #include "ns3/ipv4-list-routing.h"
 #include "ns3/log.h"
+#include "ns3/system-wall-clock-ms.h"
 
 namespace ns3 {
 
@@ -60,15 +61,21 @@ Ipv4GlobalRoutingHelper::Create (Ptr<Node> node) const
 void 
 Ipv4GlobalRoutingHelper::PopulateRoutingTables (void)
 {
+  SystemWallClockMs clock;
+  clock.Start ();
   GlobalRouteManager::BuildGlobalRoutingDatabase ();
+  NS_LOG_INFO ("Built global routing database in " << clock.End () << " ms");
+  clock.Start ();
   GlobalRouteManager::InitializeRoutes ();
+  NS_LOG_INFO ("Initialized routes in " << clock.End () << " ms");
 }
 void 
 Ipv4GlobalRoutingHelper::RecomputeRoutingTables (void)
 {
-  GlobalRouteManager::DeleteGlobalRoutes ();
-  GlobalRouteManager::BuildGlobalRoutingDatabase ();
-  GlobalRouteManager::InitializeRoutes ();
+  SystemWallClockMs clock;
+  clock.Start ();
+  GlobalRouteManager::UpdateGlobalRoutes ();
+  NS_LOG_INFO ("Recomputed routes in " << clock.End () << " ms");
 }
 
 
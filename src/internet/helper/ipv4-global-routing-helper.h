@@ -82,6 +82,10 @@ public:
    * Users must first call PopulateRoutingTables() and then may subsequently
    * call RecomputeRoutingTables() at any later time in the simulation.
    *
+   * When the GlobalRoutingIncremental global value is set, only the
+   * routers whose routes may have changed since the previous computation
+   * compute them again, and the routes of the other routers are kept or
+   * reinstalled as they are.
    */
   static void RecomputeRoutingTables (void);
 private:
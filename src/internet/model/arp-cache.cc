@@ -75,6 +75,13 @@ ArpCache::GetTypeId (void)
                    UintegerValue (3),
                    MakeUintegerAccessor (&ArpCache::m_pendingQueueSize),
                    MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxPendingPackets",
+                   "The maximum number of packets pending an arp reply in all "
+                   "the entries of the cache.  Beyond this limit, only the first "
+                   "packet to a destination is kept.",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&ArpCache::m_maxPendingPackets),
+                   MakeUintegerChecker<uint32_t> ())
     .AddTraceSource ("Drop",
                      "Packet dropped due to ArpCache entry "
                      "in WaitReply expiring.",
@@ -86,7 +93,8 @@ ArpCache::GetTypeId (void)
 
 ArpCache::ArpCache ()
   : m_device (0), 
-    m_interface (0)
+    m_interface (0),
+    m_pendingPackets (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -197,40 +205,41 @@ ArpCache::HandleWaitReplyTimeout (void)
   NS_LOG_FUNCTION (this);
   ArpCache::Entry* entry;
   bool restartWaitReplyTimer = false;
-  for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++) 
+  std::list<ArpCache::Entry *>::iterator next;
+  for (std::list<ArpCache::Entry *>::iterator i = m_waitReplyEntries.begin (); i != m_waitReplyEntries.end (); i = next) 
     {
-      entry = (*i).second;
-      if (entry != 0 && entry->IsWaitReply ())
+      // marking the entry dead takes it out of the list
+      next = i;
+      next++;
+      entry = *i;
+      NS_ASSERT (entry->IsWaitReply ());
+      if (entry->GetRetries () < m_maxRetries)
         {
-          if (entry->GetRetries () < m_maxRetries)
-            {
-              NS_LOG_LOGIC ("node="<< m_device->GetNode ()->GetId () <<
-                            ", ArpWaitTimeout for " << entry->GetIpv4Address () <<
-                            " expired -- retransmitting arp request since retries = " <<
-                            entry->GetRetries ());
-              m_arpRequestCallback (this, entry->GetIpv4Address ());
-              restartWaitReplyTimer = true;
-              entry->IncrementRetries ();
-            }
-          else
+          NS_LOG_LOGIC ("node="<< m_device->GetNode ()->GetId () <<
+                        ", ArpWaitTimeout for " << entry->GetIpv4Address () <<
+                        " expired -- retransmitting arp request since retries = " <<
+                        entry->GetRetries ());
+          m_arpRequestCallback (this, entry->GetIpv4Address ());
+          restartWaitReplyTimer = true;
+          entry->IncrementRetries ();
+        }
+      else
+        {
+          NS_LOG_LOGIC ("node="<<m_device->GetNode ()->GetId () <<
+                        ", wait reply for " << entry->GetIpv4Address () <<
+                        " expired -- drop since max retries exceeded: " <<
+                        entry->GetRetries ());
+          entry->MarkDead ();
+          entry->ClearRetries ();
+          Ipv4PayloadHeaderPair pending = entry->DequeuePending ();
+          while (pending.first != 0)
             {
-              NS_LOG_LOGIC ("node="<<m_device->GetNode ()->GetId () <<
-                            ", wait reply for " << entry->GetIpv4Address () <<
-                            " expired -- drop since max retries exceeded: " <<
-                            entry->GetRetries ());
-              entry->MarkDead ();
-              entry->ClearRetries ();
-              Ipv4PayloadHeaderPair pending = entry->DequeuePending ();
-              while (pending.first != 0)
-                {
-                  // add the Ipv4 header for tracing purposes
-                  pending.first->AddHeader (pending.second);
-                  m_dropTrace (pending.first);
-                  pending = entry->DequeuePending ();
-                }
+              // add the Ipv4 header for tracing purposes
+              pending.first->AddHeader (pending.second);
+              m_dropTrace (pending.first);
+              pending = entry->DequeuePending ();
             }
         }
-
     }
   if (restartWaitReplyTimer)
     {
@@ -249,6 +258,9 @@ ArpCache::Flush (void)
       delete (*i).second;
     }
   m_arpCache.erase (m_arpCache.begin (), m_arpCache.end ());
+  m_inverseCache.clear ();
+  m_waitReplyEntries.clear ();
+  m_pendingPackets = 0;
   if (m_waitReplyTimer.IsRunning ())
     {
       NS_LOG_LOGIC ("Stopping WaitReplyTimer at " << Simulator::Now ().GetSeconds () << " due to ArpCache flush");
@@ -302,13 +314,10 @@ ArpCache::LookupInverse (Address to)
   NS_LOG_FUNCTION (this << to);
 
   std::list<ArpCache::Entry *> entryList;
-  for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++)
+  InverseCache::const_iterator it = m_inverseCache.find (to);
+  if (it != m_inverseCache.end ())
     {
-      ArpCache::Entry *entry = (*i).second;
-      if (entry->GetMacAddress () == to)
-        {
-          entryList.push_back (entry);
-        }
+      entryList.insert (entryList.end (), it->second.begin (), it->second.end ());
     }
   return entryList;
 }
@@ -343,19 +352,50 @@ ArpCache::Remove (ArpCache::Entry *entry)
 {
   NS_LOG_FUNCTION (this << entry);
   
-  for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++)
+  CacheI i = m_arpCache.find (entry->GetIpv4Address ());
+  if (i != m_arpCache.end () && (*i).second == entry)
     {
-      if ((*i).second == entry)
+      m_arpCache.erase (i);
+      UpdateInverse (entry, entry->GetMacAddress (), Address ());
+      if (entry->IsWaitReply ())
         {
-          m_arpCache.erase (i);
-          entry->ClearPendingPacket (); //clear the pending packets for entry's ipaddress
-          delete entry;
-          return;
+          m_waitReplyEntries.erase (entry->m_waitReplyIterator);
         }
+      entry->ClearPendingPacket (); //clear the pending packets for entry's ipaddress
+      delete entry;
+      return;
     }
   NS_LOG_WARN ("Entry not found in this ARP Cache");
 }
 
+void
+ArpCache::UpdateInverse (ArpCache::Entry *entry, const Address &oldAddress, const Address &newAddress)
+{
+  NS_LOG_FUNCTION (this << entry << oldAddress << newAddress);
+  if (!oldAddress.IsInvalid ())
+    {
+      InverseCache::iterator it = m_inverseCache.find (oldAddress);
+      NS_ASSERT (it != m_inverseCache.end ());
+      std::vector<ArpCache::Entry *> &entries = it->second;
+      for (std::vector<ArpCache::Entry *>::iterator j = entries.begin (); j != entries.end (); j++)
+        {
+          if (*j == entry)
+            {
+              entries.erase (j);
+              break;
+            }
+        }
+      if (entries.empty ())
+        {
+          m_inverseCache.erase (it);
+        }
+    }
+  if (!newAddress.IsInvalid ())
+    {
+      m_inverseCache[newAddress].push_back (entry);
+    }
+}
+
 ArpCache::Entry::Entry (ArpCache *arp)
   : m_arp (arp),
     m_state (ALIVE),
@@ -396,7 +436,7 @@ ArpCache::Entry::MarkDead (void)
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (m_state == ALIVE || m_state == WAIT_REPLY || m_state == DEAD);
-  m_state = DEAD;
+  SetState (DEAD);
   ClearRetries ();
   UpdateSeen ();
 }
@@ -405,8 +445,8 @@ ArpCache::Entry::MarkAlive (Address macAddress)
 {
   NS_LOG_FUNCTION (this << macAddress);
   NS_ASSERT (m_state == WAIT_REPLY);
-  m_macAddress = macAddress;
-  m_state = ALIVE;
+  SetMacAddress (macAddress);
+  SetState (ALIVE);
   ClearRetries ();
   UpdateSeen ();
 }
@@ -416,7 +456,7 @@ ArpCache::Entry::MarkPermanent (void)
   NS_LOG_FUNCTION (this << m_macAddress);
   NS_ASSERT (!m_macAddress.IsInvalid ());
 
-  m_state = PERMANENT;
+  SetState (PERMANENT);
   ClearRetries ();
   UpdateSeen ();
 }
@@ -429,11 +469,13 @@ ArpCache::Entry::UpdateWaitReply (Ipv4PayloadHeaderPair waiting)
    * we dump the previously waiting packet and
    * replace it with this one.
    */
-  if (m_pending.size () >= m_arp->m_pendingQueueSize)
+  if (m_pending.size () >= m_arp->m_pendingQueueSize
+      || m_arp->m_pendingPackets >= m_arp->m_maxPendingPackets)
     {
       return false;
     }
   m_pending.push_back (waiting);
+  m_arp->m_pendingPackets++;
   return true;
 }
 void 
@@ -444,8 +486,10 @@ ArpCache::Entry::MarkWaitReply (Ipv4PayloadHeaderPair waiting)
   NS_ASSERT (m_pending.empty ());
   NS_ASSERT_MSG (waiting.first, "Can not add a null packet to the ARP queue");
 
-  m_state = WAIT_REPLY;
+  SetState (WAIT_REPLY);
+  // the first packet is kept whatever the number of pending packets
   m_pending.push_back (waiting);
+  m_arp->m_pendingPackets++;
   UpdateSeen ();
   m_arp->StartWaitReplyTimer ();
 }
@@ -460,12 +504,13 @@ void
 ArpCache::Entry::SetMacAddresss (Address macAddress)
 {
   NS_LOG_FUNCTION (this);
-  m_macAddress = macAddress;
+  SetMacAddress (macAddress);
 }
 void 
 ArpCache::Entry::SetMacAddress (Address macAddress)
 {
   NS_LOG_FUNCTION (this);
+  m_arp->UpdateInverse (this, m_macAddress, macAddress);
   m_macAddress = macAddress;
 }
 Ipv4Address 
@@ -525,6 +570,7 @@ ArpCache::Entry::DequeuePending (void)
     {
       Ipv4PayloadHeaderPair p = m_pending.front ();
       m_pending.pop_front ();
+      m_arp->m_pendingPackets--;
       return p;
     }
 }
@@ -532,8 +578,23 @@ void
 ArpCache::Entry::ClearPendingPacket (void)
 {
   NS_LOG_FUNCTION (this);
+  m_arp->m_pendingPackets -= m_pending.size ();
   m_pending.clear ();
 }
+void
+ArpCache::Entry::SetState (ArpCacheEntryState_e state)
+{
+  NS_LOG_FUNCTION (this << state);
+  if (m_state == WAIT_REPLY && state != WAIT_REPLY)
+    {
+      m_arp->m_waitReplyEntries.erase (m_waitReplyIterator);
+    }
+  else if (m_state != WAIT_REPLY && state == WAIT_REPLY)
+    {
+      m_waitReplyIterator = m_arp->m_waitReplyEntries.insert (m_arp->m_waitReplyEntries.end (), this);
+    }
+  m_state = state;
+}
 void 
 ArpCache::Entry::UpdateSeen (void)
 {
@@ -22,6 +22,7 @@
 
 #include <stdint.h>
 #include <list>
+#include <vector>
 #include "ns3/simulator.h"
 #include "ns3/callback.h"
 #include "ns3/packet.h"
@@ -47,6 +48,12 @@ class Ipv4Header;
  *
  * A cached lookup table for translating layer 3 addresses to layer 2.
  * This implementation does lookups from IPv4 to a MAC address
+ *
+ * The entries are indexed by MAC address too, so that LookupInverse ()
+ * does not scan the cache, and the entries waiting for a reply are kept
+ * in a list walked by the single WaitReply timer of the cache.  Besides
+ * the PendingQueueSize limit of each entry, the packets pending in all
+ * the entries are limited by MaxPendingPackets.
  */
 class ArpCache : public Object
 {
@@ -306,6 +313,15 @@ private:
      */
     Time GetTimeout (void) const;
 
+    /**
+     * \brief Changes the state of this entry, and keeps the list of
+     * entries waiting for a reply up to date
+     * \param state the new state
+     */
+    void SetState (ArpCacheEntryState_e state);
+
+    friend class ArpCache; //!< The cache takes removed entries out of its list of waiting entries
+
     ArpCache *m_arp; //!< pointer to the ARP cache owning the entry
     ArpCacheEntryState_e m_state; //!< state of the entry
     Time m_lastSeen; //!< last moment a packet from that address has been seen
@@ -313,6 +329,7 @@ private:
     Ipv4Address m_ipv4Address; //!< entry's IP address
     std::list<Ipv4PayloadHeaderPair> m_pending; //!< list of pending packets for the entry's IP
     uint32_t m_retries; //!< rerty counter
+    std::list<Entry *>::iterator m_waitReplyIterator; //!< position in the list of entries waiting for a reply, if waiting
   };
 
 private:
@@ -324,6 +341,18 @@ private:
    * \brief ARP Cache container iterator
    */
   typedef sgi::hash_map<Ipv4Address, ArpCache::Entry *, Ipv4AddressHash>::iterator CacheI;
+  /**
+   * \brief ARP Cache index by MAC address
+   */
+  typedef sgi::hash_map<Address, std::vector<ArpCache::Entry *>, AddressHash> InverseCache;
+
+  /**
+   * \brief Move an entry in the index by MAC address
+   * \param entry the entry
+   * \param oldAddress the MAC address the entry is indexed by, if valid
+   * \param newAddress the MAC address to index the entry by, if valid
+   */
+  void UpdateInverse (ArpCache::Entry *entry, const Address &oldAddress, const Address &newAddress);
 
   virtual void DoDispose (void);
 
@@ -343,7 +372,11 @@ private:
    */
   void HandleWaitReplyTimeout (void);
   uint32_t m_pendingQueueSize; //!< number of packets waiting for a resolution
+  uint32_t m_maxPendingPackets; //!< number of packets waiting for a resolution, in all the entries
+  uint32_t m_pendingPackets; //!< packets currently waiting for a resolution, in all the entries
   Cache m_arpCache; //!< the ARP cache
+  InverseCache m_inverseCache; //!< the ARP cache entries, by MAC address
+  std::list<ArpCache::Entry *> m_waitReplyEntries; //!< the entries in WAIT_REPLY state
   TracedCallback<Ptr<const Packet> > m_dropTrace; //!< trace for packets dropped by the ARP cache queue
 };
 
@@ -51,22 +51,25 @@ operator<< (std::ostream& os, const CandidateQueue& q)
 {
   typedef CandidateQueue::CandidateList_t List_t;
   typedef List_t::const_iterator CIter_t;
-  const CandidateQueue::CandidateList_t& list = q.m_candidates;
+  List_t list = q.m_candidates;
+  std::sort (list.begin (), list.end (), &CandidateQueue::Before);
 
   os << "*** CandidateQueue Begin (<id, distance, LSA-type>) ***" << std::endl;
   for (CIter_t iter = list.begin (); iter != list.end (); iter++)
     {
       os << "<" 
-      << (*iter)->GetVertexId () << ", "
-      << (*iter)->GetDistanceFromRoot () << ", "
-      << (*iter)->GetVertexType () << ">" << std::endl;
+      << iter->vertex->GetVertexId () << ", "
+      << iter->vertex->GetDistanceFromRoot () << ", "
+      << iter->vertex->GetVertexType () << ">" << std::endl;
     }
   os << "*** CandidateQueue End ***";
   return os;
 }
 
 CandidateQueue::CandidateQueue()
-  : m_candidates ()
+  : m_candidates (),
+    m_index (),
+    m_order (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -94,11 +97,12 @@ CandidateQueue::Push (SPFVertex *vNew)
 {
   NS_LOG_FUNCTION (this << vNew);
 
-  CandidateList_t::iterator i = std::upper_bound (
-      m_candidates.begin (), m_candidates.end (), vNew,
-      &CandidateQueue::CompareSPFVertex
-      );
-  m_candidates.insert (i, vNew);
+  Candidate c;
+  c.vertex = vNew;
+  c.order = m_order++;
+  m_candidates.push_back (c);
+  Place (m_candidates.size () - 1, c);
+  SiftUp (m_candidates.size () - 1);
 }
 
 SPFVertex *
@@ -110,8 +114,20 @@ CandidateQueue::Pop (void)
       return 0;
     }
 
-  SPFVertex *v = m_candidates.front ();
-  m_candidates.pop_front ();
+  SPFVertex *v = m_candidates.front ().vertex;
+  CandidateIndex_t::iterator i = m_index.find (v->GetVertexId ());
+  if (i != m_index.end () && i->second == 0)
+    {
+      m_index.erase (i);
+    }
+
+  Candidate last = m_candidates.back ();
+  m_candidates.pop_back ();
+  if (!m_candidates.empty ())
+    {
+      Place (0, last);
+      SiftDown (0);
+    }
   return v;
 }
 
@@ -124,7 +140,7 @@ CandidateQueue::Top (void) const
       return 0;
     }
 
-  return m_candidates.front ();
+  return m_candidates.front ().vertex;
 }
 
 bool
@@ -145,18 +161,27 @@ SPFVertex *
 CandidateQueue::Find (const Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (this);
-  CandidateList_t::const_iterator i = m_candidates.begin ();
-
-  for (; i != m_candidates.end (); i++)
+  CandidateIndex_t::const_iterator i = m_index.find (addr);
+  if (i == m_index.end ())
     {
-      SPFVertex *v = *i;
-      if (v->GetVertexId () == addr)
-        {
-          return v;
-        }
+      return 0;
     }
+  return m_candidates[i->second].vertex;
+}
 
-  return 0;
+void
+CandidateQueue::DecreaseKey (SPFVertex *v)
+{
+  NS_LOG_FUNCTION (this << v);
+  CandidateIndex_t::const_iterator i = m_index.find (v->GetVertexId ());
+  NS_ASSERT_MSG (i != m_index.end () && m_candidates[i->second].vertex == v,
+                 "CandidateQueue::DecreaseKey (): vertex not in the queue");
+
+  uint32_t pos = i->second;
+  m_candidates[pos].order = m_order++;
+  SiftUp (pos);
+  NS_LOG_LOGIC ("After decreasing the key of " << v->GetVertexId ());
+  NS_LOG_LOGIC (*this);
 }
 
 void
@@ -164,11 +189,74 @@ CandidateQueue::Reorder (void)
 {
   NS_LOG_FUNCTION (this);
 
-  m_candidates.sort (&CandidateQueue::CompareSPFVertex);
+  for (uint32_t pos = m_candidates.size () / 2; pos-- > 0; )
+    {
+      SiftDown (pos);
+    }
   NS_LOG_LOGIC ("After reordering the CandidateQueue");
   NS_LOG_LOGIC (*this);
 }
 
+void
+CandidateQueue::Place (uint32_t pos, const Candidate &c)
+{
+  m_candidates[pos] = c;
+  m_index[c.vertex->GetVertexId ()] = pos;
+}
+
+void
+CandidateQueue::SiftUp (uint32_t pos)
+{
+  Candidate c = m_candidates[pos];
+  while (pos > 0)
+    {
+      uint32_t parent = (pos - 1) / 2;
+      if (!Before (c, m_candidates[parent]))
+        {
+          break;
+        }
+      Place (pos, m_candidates[parent]);
+      pos = parent;
+    }
+  Place (pos, c);
+}
+
+void
+CandidateQueue::SiftDown (uint32_t pos)
+{
+  Candidate c = m_candidates[pos];
+  uint32_t size = m_candidates.size ();
+  while (2 * pos + 1 < size)
+    {
+      uint32_t child = 2 * pos + 1;
+      if (child + 1 < size && Before (m_candidates[child + 1], m_candidates[child]))
+        {
+          child++;
+        }
+      if (!Before (m_candidates[child], c))
+        {
+          break;
+        }
+      Place (pos, m_candidates[child]);
+      pos = child;
+    }
+  Place (pos, c);
+}
+
+bool
+CandidateQueue::Before (const Candidate &c1, const Candidate &c2)
+{
+  if (CompareSPFVertex (c1.vertex, c2.vertex))
+    {
+      return true;
+    }
+  if (CompareSPFVertex (c2.vertex, c1.vertex))
+    {
+      return false;
+    }
+  return c1.order < c2.order;
+}
+
 /*
  * In this implementation, SPFVertex follows the ordering where
  * a vertex is ranked first if its GetDistanceFromRoot () is smaller;
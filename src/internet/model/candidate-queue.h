@@ -22,8 +22,9 @@
 #define CANDIDATE_QUEUE_H
 
 #include <stdint.h>
-#include <list>
+#include <vector>
 #include "ns3/ipv4-address.h"
+#include "ns3/sgi-hashmap.h"
 
 namespace ns3 {
 
@@ -45,8 +46,14 @@ class SPFVertex;
  *
  * Although a STL priority_queue almost does what we want, the requirement
  * for a Find () operation, the dynamic nature of the data and the derived
- * requirement for a Reorder () operation led us to implement this simple 
+ * requirement for a DecreaseKey () operation led us to implement this
  * enhanced priority queue.
+ *
+ * The queue is a binary heap indexed by vertex ID, so that Push (), Pop ()
+ * and DecreaseKey () take O(log n) time and Find () takes constant time.
+ * Vertices which compare equal are popped in the order in which they were
+ * pushed.  Find () and DecreaseKey () assume that vertex IDs are unique
+ * within the queue, as they are in the link state database.
  */
 class CandidateQueue
 {
@@ -139,6 +146,19 @@ public:
  */
   SPFVertex* Find (const Ipv4Address addr) const;
 
+/**
+ * @brief Move a vertex up the queue after its distance from the root has
+ * been reduced.
+ *
+ * The vertex is then popped after the vertices already in the queue
+ * having the same new distance, as if it had just been pushed.
+ *
+ * @see SPFVertex
+ * @param v The Shortest Path First Vertex, already in the queue, whose
+ * m_distanceFromRoot has decreased.
+ */
+  void DecreaseKey (SPFVertex *v);
+
 /**
  * @brief Reorders the Candidate Queue according to the priority scheme.
  * 
@@ -148,7 +168,8 @@ public:
  * increasing distance.
  *
  * This method is provided in case the values of m_distanceFromRoot change
- * during the routing calculations.
+ * during the routing calculations.  When a single vertex got closer to the
+ * root, DecreaseKey () does the same in O(log n) time.
  *
  * @see SPFVertex
  */
@@ -184,9 +205,50 @@ private:
  */
   static bool CompareSPFVertex (const SPFVertex* v1, const SPFVertex* v2);
 
-  typedef std::list<SPFVertex*> CandidateList_t; //!< container of SPFVertex pointers
+  /**
+   * \brief A vertex in the heap, with the sequence number breaking ties
+   * between vertices which compare equal.
+   */
+  struct Candidate
+  {
+    SPFVertex *vertex; //!< the vertex
+    uint64_t order;    //!< sequence number of the last Push () or DecreaseKey ()
+  };
+
+  /**
+   * \param c1 first operand
+   * \param c2 second operand
+   * \return True if c1 should be popped before c2; false otherwise
+   */
+  static bool Before (const Candidate &c1, const Candidate &c2);
+
+  /**
+   * \brief Store a candidate at a heap position and index it.
+   * \param pos the heap position
+   * \param c the candidate
+   */
+  void Place (uint32_t pos, const Candidate &c);
+
+  /**
+   * \brief Move the candidate at a heap position towards the top.
+   * \param pos the heap position
+   */
+  void SiftUp (uint32_t pos);
+
+  /**
+   * \brief Move the candidate at a heap position towards the bottom.
+   * \param pos the heap position
+   */
+  void SiftDown (uint32_t pos);
+
+  typedef std::vector<Candidate> CandidateList_t; //!< binary heap of SPFVertex candidates
   CandidateList_t m_candidates;  //!< SPFVertex candidates
 
+  /// container of heap positions, by vertex ID
+  typedef sgi::hash_map<Ipv4Address, uint32_t, Ipv4AddressHash> CandidateIndex_t;
+  CandidateIndex_t m_index;      //!< heap position of each candidate
+  uint64_t m_order;              //!< next sequence number
+
   /**
    * \brief Stream insertion operator.
    *
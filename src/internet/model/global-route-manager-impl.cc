@@ -24,6 +24,7 @@
 
 #include <utility>
 #include <vector>
+#include <set>
 #include <queue>
 #include <algorithm>
 #include <iostream>
@@ -35,6 +36,14 @@
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/ipv4-list-routing.h"
 #include "ns3/mpi-interface.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include <thread>
+#include "ns3/system-thread.h"
+#endif
 #include "global-router-interface.h"
 #include "global-route-manager-impl.h"
 #include "candidate-queue.h"
@@ -44,6 +53,27 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("GlobalRouteManagerImpl");
 
+/**
+ * \brief The number of threads computing the SPF trees of the routers.
+ */
+static GlobalValue g_globalRoutingThreads = GlobalValue ("GlobalRoutingThreads",
+                                                         "The number of threads computing the shortest path trees when "
+                                                         "global routes are populated or recomputed; 0 uses one thread "
+                                                         "per processor core",
+                                                         UintegerValue (1),
+                                                         MakeUintegerChecker<uint32_t> ());
+
+/**
+ * \brief Whether the routes are updated incrementally after a change of the
+ * topology.
+ */
+static GlobalValue g_globalRoutingIncremental = GlobalValue ("GlobalRoutingIncremental",
+                                                             "Whether a recomputation of the global routes only runs the "
+                                                             "shortest path calculation of the routers whose trees may "
+                                                             "have changed",
+                                                             BooleanValue (false),
+                                                             MakeBooleanChecker ());
+
 /**
  * \brief Stream insertion operator.
  *
@@ -470,7 +500,59 @@ GlobalRouteManagerLSDB::Insert (Ipv4Address addr, GlobalRoutingLSA* lsa)
     } 
   else
     {
-      m_database.insert (LSDBPair_t (addr, lsa));
+      if (!m_database.insert (LSDBPair_t (addr, lsa)).second)
+        {
+          return;
+        }
+//
+// Index the TransitNetwork link records by their link data, so that
+// GetLSAByLinkData does not have to walk every LSA of the database.  If
+// several LSAs share a link data, keep the one a walk of the database in
+// address order would have found first.
+//
+      for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+          if (lr->GetLinkType () != GlobalRoutingLinkRecord::TransitNetwork)
+            {
+              continue;
+            }
+          std::pair<LSDBLinkDataMap_t::iterator, bool> result =
+            m_linkDataIndex.insert (LSDBLinkDataMap_t::value_type (lr->GetLinkData (), addr));
+          if (!result.second && addr < result.first->second)
+            {
+              result.first->second = addr;
+            }
+        }
+    }
+}
+
+GlobalRouteManagerLSDB*
+GlobalRouteManagerLSDB::Copy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  GlobalRouteManagerLSDB *lsdb = new GlobalRouteManagerLSDB ();
+  for (LSDBMap_t::const_iterator i = m_database.begin (); i != m_database.end (); i++)
+    {
+      lsdb->Insert (i->first, new GlobalRoutingLSA (*i->second));
+    }
+  for (uint32_t j = 0; j < m_extdatabase.size (); j++)
+    {
+      GlobalRoutingLSA *lsa = m_extdatabase[j];
+      lsdb->Insert (lsa->GetLinkStateId (), new GlobalRoutingLSA (*lsa));
+    }
+  return lsdb;
+}
+
+void
+GlobalRouteManagerLSDB::GetLinkStateIds (std::vector<Ipv4Address> &ids) const
+{
+  NS_LOG_FUNCTION (this << &ids);
+  ids.clear ();
+  ids.reserve (m_database.size ());
+  for (LSDBMap_t::const_iterator i = m_database.begin (); i != m_database.end (); i++)
+    {
+      ids.push_back (i->first);
     }
 }
 
@@ -495,15 +577,12 @@ GlobalRouteManagerLSDB::GetLSA (Ipv4Address addr) const
 //
 // Look up an LSA by its address.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LSDBMap_t::const_iterator i = m_database.find (addr);
+  if (i == m_database.end ())
     {
-      if (i->first == addr)
-        {
-          return i->second;
-        }
+      return 0;
     }
-  return 0;
+  return i->second;
 }
 
 GlobalRoutingLSA*
@@ -511,24 +590,15 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (this << addr);
 //
-// Look up an LSA by its address.
+// Look up the address of the LSA through the link data index built on
+// insertion.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LSDBLinkDataMap_t::const_iterator i = m_linkDataIndex.find (addr);
+  if (i == m_linkDataIndex.end ())
     {
-      GlobalRoutingLSA* temp = i->second;
-// Iterate among temp's Link Records
-      for (uint32_t j = 0; j < temp->GetNLinkRecords (); j++)
-        {
-          GlobalRoutingLinkRecord *lr = temp->GetLinkRecord (j);
-          if ( lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork &&
-               lr->GetLinkData () == addr)
-            {
-              return temp;
-            }
-        }
+      return 0;
     }
-  return 0;
+  return GetLSA (i->second);
 }
 
 // ---------------------------------------------------------------------------
@@ -539,7 +609,9 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 
 GlobalRouteManagerImpl::GlobalRouteManagerImpl () 
   :
-    m_spfroot (0)
+    m_spfroot (0),
+    m_recordTrees (false),
+    m_spfRecord (0)
 {
   NS_LOG_FUNCTION (this);
   m_lsdb = new GlobalRouteManagerLSDB ();
@@ -572,25 +644,7 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
   NodeList::Iterator listEnd = NodeList::End ();
   for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
     {
-      Ptr<Node> node = *i;
-      Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-      if (router == 0)
-        {
-          continue;
-        }
-      Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-      uint32_t j = 0;
-      uint32_t nRoutes = gr->GetNRoutes ();
-      NS_LOG_LOGIC ("Deleting " << gr->GetNRoutes ()<< " routes from node " << node->GetId ());
-      // Each time we delete route 0, the route index shifts downward
-      // We can delete all routes if we delete the route numbered 0
-      // nRoutes times
-      for (j = 0; j < nRoutes; j++)
-        {
-          NS_LOG_LOGIC ("Deleting global route " << j << " from node " << node->GetId ());
-          gr->RemoveRoute (0);
-        }
-      NS_LOG_LOGIC ("Deleted " << j << " global routes from node "<< node->GetId ());
+      DeleteRoutes (*i);
     }
   if (m_lsdb)
     {
@@ -598,6 +652,32 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
       delete m_lsdb;
       m_lsdb = new GlobalRouteManagerLSDB ();
     }
+  m_routerNodes.clear ();
+  m_spfTrees.clear ();
+}
+
+void
+GlobalRouteManagerImpl::DeleteRoutes (Ptr<Node> node)
+{
+  NS_LOG_FUNCTION (this << node);
+  Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
+  if (router == 0)
+    {
+      return;
+    }
+  Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
+  uint32_t j = 0;
+  uint32_t nRoutes = gr->GetNRoutes ();
+  NS_LOG_LOGIC ("Deleting " << gr->GetNRoutes ()<< " routes from node " << node->GetId ());
+  // Each time we delete route 0, the route index shifts downward
+  // We can delete all routes if we delete the route numbered 0
+  // nRoutes times
+  for (j = 0; j < nRoutes; j++)
+    {
+      NS_LOG_LOGIC ("Deleting global route " << j << " from node " << node->GetId ());
+      gr->RemoveRoute (0);
+    }
+  NS_LOG_LOGIC ("Deleted " << j << " global routes from node "<< node->GetId ());
 }
 
 //
@@ -638,6 +718,12 @@ GlobalRouteManagerImpl::BuildGlobalRoutingDatabase ()
 // DiscoverLSAs () will get zero as the number since no routes have been 
 // found.
 //
+//
+// Remember which node owns this router ID, so that the SPF calculations do
+// not have to walk the list of nodes to find the node they install routes on.
+//
+      m_routerNodes[rtr->GetRouterId ()] = PeekPointer (node);
+
       Ptr<Ipv4GlobalRouting> grouting = rtr->GetRoutingProtocol ();
       uint32_t numLSAs = rtr->DiscoverLSAs ();
       NS_LOG_LOGIC ("Found " << numLSAs << " LSAs");
@@ -696,10 +782,26 @@ void
 GlobalRouteManagerImpl::InitializeRoutes ()
 {
   NS_LOG_FUNCTION (this);
+  NS_LOG_INFO ("About to start SPF calculation");
+  BooleanValue incremental;
+  g_globalRoutingIncremental.GetValue (incremental);
+  m_recordTrees = incremental.Get ();
+  m_spfTrees.clear ();
+
+  std::vector<Ipv4Address> roots;
+  GetSPFRoots (roots);
+  SPFCalculateInThreads (roots);
+  NS_LOG_INFO ("Finished SPF calculation");
+}
+
+void
+GlobalRouteManagerImpl::GetSPFRoots (std::vector<Ipv4Address> &roots) const
+{
+  NS_LOG_FUNCTION (this << &roots);
 //
 // Walk the list of nodes in the system.
 //
-  NS_LOG_INFO ("About to start SPF calculation");
+  roots.clear ();
   NodeList::Iterator listEnd = NodeList::End ();
   for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
     {
@@ -724,10 +826,584 @@ GlobalRouteManagerImpl::InitializeRoutes ()
 //
       if (rtr && rtr->GetNumLSAs () )
         {
-          SPFCalculate (rtr->GetRouterId ());
+          roots.push_back (rtr->GetRouterId ());
+        }
+    }
+}
+
+void
+GlobalRouteManagerImpl::SPFCalculateInThreads (const std::vector<Ipv4Address> &roots)
+{
+  NS_LOG_FUNCTION (this << &roots);
+  UintegerValue threadsValue;
+  g_globalRoutingThreads.GetValue (threadsValue);
+  uint32_t threads = threadsValue.Get ();
+#ifdef HAVE_PTHREAD_H
+  if (threads == 0)
+    {
+      threads = std::max (1u, std::thread::hardware_concurrency ());
+    }
+#else
+  threads = 1;
+#endif
+  threads = std::min<uint32_t> (threads, roots.size ());
+
+  if (threads <= 1)
+    {
+      SPFCalculateRoots (this, &roots);
+      return;
+    }
+
+#ifdef HAVE_PTHREAD_H
+//
+// Each thread gets its own route manager with a copy of the LSDB, since the
+// SPF calculation keeps its state in the LSAs, and a share of the roots.
+// Installing the routes of a root only touches the node of that root, so
+// the threads do not share any object. The reference counts are not atomic,
+// hence all of the workers are built before the first thread starts, the
+// nodes are only found through the raw pointers of m_routerNodes, and the
+// workers are deleted once all of the threads have joined.
+//
+  NS_LOG_INFO ("Running SPF calculation on " << threads << " threads");
+  std::vector<GlobalRouteManagerImpl*> workers (threads);
+  std::vector<std::vector<Ipv4Address> > shares (threads);
+  std::vector<Ptr<SystemThread> > systemThreads (threads);
+  for (uint32_t i = 0; i < roots.size (); i++)
+    {
+      shares[i % threads].push_back (roots[i]);
+    }
+  for (uint32_t t = 0; t < threads; t++)
+    {
+      workers[t] = new GlobalRouteManagerImpl ();
+      workers[t]->DebugUseLsdb (m_lsdb->Copy ());
+      workers[t]->m_routerNodes = m_routerNodes;
+      workers[t]->m_recordTrees = m_recordTrees;
+      systemThreads[t] = Create<SystemThread> (MakeBoundCallback (&GlobalRouteManagerImpl::SPFCalculateRoots,
+                                                                  workers[t], &shares[t]));
+    }
+  for (uint32_t t = 0; t < threads; t++)
+    {
+      systemThreads[t]->Start ();
+    }
+  for (uint32_t t = 0; t < threads; t++)
+    {
+      systemThreads[t]->Join ();
+    }
+  for (uint32_t t = 0; t < threads; t++)
+    {
+      for (SPFTreeMap_t::iterator i = workers[t]->m_spfTrees.begin (); i != workers[t]->m_spfTrees.end (); i++)
+        {
+          std::swap (m_spfTrees[i->first], i->second);
+        }
+      delete workers[t];
+    }
+#endif
+}
+
+void
+GlobalRouteManagerImpl::SPFCalculateRoots (GlobalRouteManagerImpl *impl, const std::vector<Ipv4Address> *roots)
+{
+  NS_LOG_FUNCTION (impl << roots);
+  for (std::vector<Ipv4Address>::const_iterator i = roots->begin (); i != roots->end (); i++)
+    {
+      impl->SPFCalculate (*i);
+    }
+}
+
+/**
+ * \brief The point-to-point links of the router LSAs of a LSDB, reversed so
+ * that a Dijkstra calculation from a router finds the distances of all of
+ * the routers to it.
+ */
+struct SPFReverseGraph
+{
+  /// container of router IDs / vertex indices
+  typedef sgi::hash_map<Ipv4Address, uint32_t, Ipv4AddressHash> VertexIndex_t;
+  /// a link from a vertex, with its metric
+  typedef std::pair<uint32_t, uint32_t> Link_t;
+
+  VertexIndex_t m_index; //!< index of the vertex of each router
+  std::vector<std::vector<Link_t> > m_links; //!< links into each vertex
+};
+
+/**
+ * \brief Build the reversed graph of the router LSAs of a LSDB.
+ *
+ * \param lsdb the LSDB
+ * \param ids the link state IDs of the LSAs of the LSDB
+ * \param graph [out] the graph
+ * \returns false if the LSDB holds network LSAs or links to transit networks
+ */
+static bool
+BuildReverseGraph (const GlobalRouteManagerLSDB *lsdb, const std::vector<Ipv4Address> &ids,
+                   SPFReverseGraph &graph)
+{
+  for (uint32_t i = 0; i < ids.size (); i++)
+    {
+      graph.m_index[ids[i]] = i;
+    }
+  graph.m_links.resize (ids.size ());
+  for (uint32_t i = 0; i < ids.size (); i++)
+    {
+      GlobalRoutingLSA *lsa = lsdb->GetLSA (ids[i]);
+      if (lsa->GetLSType () != GlobalRoutingLSA::RouterLSA)
+        {
+          return false;
+        }
+      for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+          if (lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork)
+            {
+              return false;
+            }
+          if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
+            {
+              continue;
+            }
+          SPFReverseGraph::VertexIndex_t::const_iterator w = graph.m_index.find (lr->GetLinkId ());
+          if (w != graph.m_index.end ())
+            {
+              graph.m_links[w->second].push_back (SPFReverseGraph::Link_t (i, lr->GetMetric ()));
+            }
+        }
+    }
+  return true;
+}
+
+/**
+ * \brief Compute the distances of all of the routers to a router.
+ *
+ * \param graph the reversed graph of the LSDB
+ * \param target the router ID of the router
+ * \param distances [out] the distance of each vertex of the graph to the
+ * target, or SPF_INFINITY
+ */
+static void
+ReverseDistances (const SPFReverseGraph &graph, Ipv4Address target, std::vector<uint32_t> &distances)
+{
+  typedef std::pair<uint32_t, uint32_t> Entry_t;
+  distances.assign (graph.m_links.size (), SPF_INFINITY);
+  SPFReverseGraph::VertexIndex_t::const_iterator t = graph.m_index.find (target);
+  if (t == graph.m_index.end ())
+    {
+      return;
+    }
+  std::priority_queue<Entry_t, std::vector<Entry_t>, std::greater<Entry_t> > queue;
+  distances[t->second] = 0;
+  queue.push (Entry_t (0, t->second));
+  while (!queue.empty ())
+    {
+      Entry_t e = queue.top ();
+      queue.pop ();
+      if (e.first > distances[e.second])
+        {
+          continue;
+        }
+      const std::vector<SPFReverseGraph::Link_t> &links = graph.m_links[e.second];
+      for (uint32_t i = 0; i < links.size (); i++)
+        {
+          uint32_t distance = e.first + links[i].second;
+          if (distance < distances[links[i].first])
+            {
+              distances[links[i].first] = distance;
+              queue.push (Entry_t (distance, links[i].first));
+            }
+        }
+    }
+}
+
+/**
+ * \brief Compare two LSAs, ignoring their SPF status.
+ *
+ * \param a the first LSA
+ * \param b the second LSA
+ * \returns true if the LSAs advertise the same links in the same order
+ */
+static bool
+SameLSA (GlobalRoutingLSA *a, GlobalRoutingLSA *b)
+{
+  if (a->GetLSType () != b->GetLSType ()
+      || a->GetLinkStateId () != b->GetLinkStateId ()
+      || a->GetAdvertisingRouter () != b->GetAdvertisingRouter ()
+      || a->GetNLinkRecords () != b->GetNLinkRecords ())
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i < a->GetNLinkRecords (); i++)
+    {
+      GlobalRoutingLinkRecord *la = a->GetLinkRecord (i);
+      GlobalRoutingLinkRecord *lb = b->GetLinkRecord (i);
+      if (la->GetLinkType () != lb->GetLinkType ()
+          || la->GetLinkId () != lb->GetLinkId ()
+          || la->GetLinkData () != lb->GetLinkData ()
+          || la->GetMetric () != lb->GetMetric ())
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+/**
+ * \brief A point-to-point link whose advertisements changed between two
+ * LSDBs.
+ */
+struct SPFChangedLink
+{
+  Ipv4Address m_from;  //!< router ID of the router advertising the link
+  Ipv4Address m_to;    //!< router ID of the router at the other end
+  uint32_t m_metric;   //!< metric of the link
+  bool m_inOld;        //!< true if the old LSDB has the link
+  bool m_inNew;        //!< true if the new LSDB has the link
+};
+
+/**
+ * \brief Find the point-to-point links of a router whose advertisements
+ * changed.
+ *
+ * A link, identified by its other end and its metric, changed if it is
+ * advertised a different number of times.  The SPF calculation examines the
+ * links in the order of the LSA, so if the other links are not advertised in
+ * the same order, all of the links of the router changed.
+ *
+ * \param from the router ID of the router
+ * \param oldLsa the LSA of the router in the old LSDB, or 0
+ * \param newLsa the LSA of the router in the new LSDB, or 0
+ * \param changed [out] the changed links are appended to this vector
+ */
+static void
+GetChangedLinks (Ipv4Address from, GlobalRoutingLSA *oldLsa, GlobalRoutingLSA *newLsa,
+                 std::vector<SPFChangedLink> &changed)
+{
+  typedef std::pair<Ipv4Address, uint32_t> Link_t;
+  std::vector<Link_t> links[2];
+  GlobalRoutingLSA *lsas[2] = { oldLsa, newLsa };
+  std::map<Link_t, std::pair<uint32_t, uint32_t> > counts;
+  for (uint32_t k = 0; k < 2; k++)
+    {
+      for (uint32_t j = 0; lsas[k] && j < lsas[k]->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *lr = lsas[k]->GetLinkRecord (j);
+          if (lr->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint)
+            {
+              Link_t link (lr->GetLinkId (), lr->GetMetric ());
+              links[k].push_back (link);
+              (k == 0 ? counts[link].first : counts[link].second)++;
+            }
+        }
+    }
+  std::vector<Link_t> kept[2];
+  for (uint32_t k = 0; k < 2; k++)
+    {
+      for (uint32_t j = 0; j < links[k].size (); j++)
+        {
+          const std::pair<uint32_t, uint32_t> &count = counts[links[k][j]];
+          if (count.first == count.second)
+            {
+              kept[k].push_back (links[k][j]);
+            }
+        }
+    }
+  bool reordered = kept[0] != kept[1];
+  for (std::map<Link_t, std::pair<uint32_t, uint32_t> >::const_iterator i = counts.begin (); i != counts.end (); i++)
+    {
+      if (reordered || i->second.first != i->second.second)
+        {
+          SPFChangedLink link;
+          link.m_from = from;
+          link.m_to = i->first.first;
+          link.m_metric = i->first.second;
+          link.m_inOld = i->second.first > 0;
+          link.m_inNew = i->second.second > 0;
+          changed.push_back (link);
+        }
+    }
+}
+
+void
+GlobalRouteManagerImpl::UpdateGlobalRoutes ()
+{
+  NS_LOG_FUNCTION (this);
+  BooleanValue incremental;
+  g_globalRoutingIncremental.GetValue (incremental);
+  if (!incremental.Get () || m_spfTrees.empty ())
+    {
+      DeleteGlobalRoutes ();
+      BuildGlobalRoutingDatabase ();
+      InitializeRoutes ();
+      return;
+    }
+
+  GlobalRouteManagerLSDB *oldLsdb = m_lsdb;
+  m_lsdb = new GlobalRouteManagerLSDB ();
+  m_routerNodes.clear ();
+  BuildGlobalRoutingDatabase ();
+
+  std::vector<Ipv4Address> roots;
+  std::vector<Ipv4Address> recompute;
+  std::vector<Ipv4Address> reinstall;
+  GetSPFRoots (roots);
+  bool compared = CompareLsdb (oldLsdb, roots, recompute, reinstall);
+  delete oldLsdb;
+  if (!compared)
+    {
+      NS_LOG_INFO ("Recomputing all routes");
+      DeleteGlobalRoutes ();
+      BuildGlobalRoutingDatabase ();
+      InitializeRoutes ();
+      return;
+    }
+
+//
+// Forget the trees and delete the routes of the routers which are no longer
+// roots, as a full recomputation would, then run the SPF calculation of the
+// routers whose trees may have changed, which records their new trees, and
+// reinstall the routes of the routers whose trees reach a changed LSA.
+//
+  std::set<Ipv4Address> rootSet (roots.begin (), roots.end ());
+  for (SPFTreeMap_t::iterator i = m_spfTrees.begin (); i != m_spfTrees.end (); )
+    {
+      if (rootSet.count (i->first) == 0)
+        {
+          Ptr<Node> node = GetRouterNode (i->first);
+          if (node)
+            {
+              DeleteRoutes (node);
+            }
+          m_spfTrees.erase (i++);
+        }
+      else
+        {
+          i++;
+        }
+    }
+  m_recordTrees = true;
+  for (uint32_t i = 0; i < recompute.size (); i++)
+    {
+      DeleteRoutes (GetRouterNode (recompute[i]));
+      m_spfTrees.erase (recompute[i]);
+    }
+  SPFCalculateInThreads (recompute);
+  for (uint32_t i = 0; i < reinstall.size (); i++)
+    {
+      SPFReinstallRoutes (reinstall[i], m_spfTrees[reinstall[i]]);
+    }
+  NS_LOG_INFO ("Of " << roots.size () << " routers, " << recompute.size () <<
+               " ran the SPF calculation and " << reinstall.size () <<
+               " reinstalled their routes");
+}
+
+bool
+GlobalRouteManagerImpl::CompareLsdb (const GlobalRouteManagerLSDB *oldLsdb,
+                                     const std::vector<Ipv4Address> &roots,
+                                     std::vector<Ipv4Address> &recompute,
+                                     std::vector<Ipv4Address> &reinstall)
+{
+  NS_LOG_FUNCTION (this << oldLsdb << &roots << &recompute << &reinstall);
+  if (oldLsdb->GetNumExtLSAs () || m_lsdb->GetNumExtLSAs ())
+    {
+      return false;
+    }
+  std::vector<Ipv4Address> oldIds;
+  std::vector<Ipv4Address> newIds;
+  oldLsdb->GetLinkStateIds (oldIds);
+  m_lsdb->GetLinkStateIds (newIds);
+  SPFReverseGraph oldGraph;
+  SPFReverseGraph newGraph;
+  if (!BuildReverseGraph (oldLsdb, oldIds, oldGraph) || !BuildReverseGraph (m_lsdb, newIds, newGraph))
+    {
+      return false;
+    }
+
+//
+// Walk both LSDBs in link state ID order to find the LSAs which changed,
+// and the point-to-point links they no longer or newly advertise.
+//
+  typedef sgi::hash_map<Ipv4Address, bool, Ipv4AddressHash> ChangedSet_t;
+  ChangedSet_t changed;
+  std::vector<SPFChangedLink> changedLinks;
+  std::vector<Ipv4Address>::const_iterator i = oldIds.begin ();
+  std::vector<Ipv4Address>::const_iterator j = newIds.begin ();
+  while (i != oldIds.end () || j != newIds.end ())
+    {
+      GlobalRoutingLSA *oldLsa = 0;
+      GlobalRoutingLSA *newLsa = 0;
+      Ipv4Address id;
+      if (j == newIds.end () || (i != oldIds.end () && *i < *j))
+        {
+          id = *i++;
+          oldLsa = oldLsdb->GetLSA (id);
+        }
+      else if (i == oldIds.end () || *j < *i)
+        {
+          id = *j++;
+          newLsa = m_lsdb->GetLSA (id);
+        }
+      else
+        {
+          id = *i++;
+          j++;
+          oldLsa = oldLsdb->GetLSA (id);
+          newLsa = m_lsdb->GetLSA (id);
+          if (SameLSA (oldLsa, newLsa))
+            {
+              continue;
+            }
+        }
+      NS_LOG_LOGIC ("LSA " << id << " changed");
+      changed[id] = true;
+      GetChangedLinks (id, oldLsa, newLsa, changedLinks);
+    }
+  if (changed.empty ())
+    {
+      NS_LOG_LOGIC ("No LSA changed");
+      return true;
+    }
+
+//
+// A link from u to v with metric c is on a shortest path from the root r
+// if d(r, u) + c == d(r, v).  The distances of all of the routers to the
+// ends of the changed links are found by Dijkstra calculations on the
+// reversed graphs of the old and new LSDBs.
+//
+  typedef std::map<Ipv4Address, std::vector<uint32_t> > Distances_t;
+  Distances_t oldDistances;
+  Distances_t newDistances;
+  for (uint32_t k = 0; k < changedLinks.size (); k++)
+    {
+      const SPFChangedLink &link = changedLinks[k];
+      if (link.m_inOld && oldDistances.find (link.m_from) == oldDistances.end ())
+        {
+          ReverseDistances (oldGraph, link.m_from, oldDistances[link.m_from]);
+        }
+      if (link.m_inOld && oldDistances.find (link.m_to) == oldDistances.end ())
+        {
+          ReverseDistances (oldGraph, link.m_to, oldDistances[link.m_to]);
+        }
+      if (link.m_inNew && newDistances.find (link.m_from) == newDistances.end ())
+        {
+          ReverseDistances (newGraph, link.m_from, newDistances[link.m_from]);
+        }
+      if (link.m_inNew && newDistances.find (link.m_to) == newDistances.end ())
+        {
+          ReverseDistances (newGraph, link.m_to, newDistances[link.m_to]);
+        }
+    }
+
+  recompute.clear ();
+  reinstall.clear ();
+  for (std::vector<Ipv4Address>::const_iterator r = roots.begin (); r != roots.end (); r++)
+    {
+      SPFTreeMap_t::const_iterator tree = m_spfTrees.find (*r);
+//
+// The next hops to the neighbors of the root come from the LSAs of the root
+// and of its neighbors.
+//
+      bool changedTree = tree == m_spfTrees.end () || changed.find (*r) != changed.end ();
+      GlobalRoutingLSA *rlsa = m_lsdb->GetLSA (*r);
+      for (uint32_t k = 0; !changedTree && k < rlsa->GetNLinkRecords (); k++)
+        {
+          GlobalRoutingLinkRecord *lr = rlsa->GetLinkRecord (k);
+          changedTree = lr->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint
+            && changed.find (lr->GetLinkId ()) != changed.end ();
+        }
+      for (uint32_t k = 0; !changedTree && k < changedLinks.size (); k++)
+        {
+          const SPFChangedLink &link = changedLinks[k];
+          if (link.m_inOld)
+            {
+              uint32_t root = oldGraph.m_index.find (*r)->second;
+              uint64_t from = oldDistances[link.m_from][root];
+              changedTree = from != SPF_INFINITY && from + link.m_metric == oldDistances[link.m_to][root];
+            }
+          if (!changedTree && link.m_inNew)
+            {
+              uint32_t root = newGraph.m_index.find (*r)->second;
+              uint64_t from = newDistances[link.m_from][root];
+              changedTree = from != SPF_INFINITY && from + link.m_metric == newDistances[link.m_to][root];
+            }
+        }
+      if (changedTree)
+        {
+          recompute.push_back (*r);
+          continue;
+        }
+//
+// The tree is unchanged.  If it reaches a changed LSA, the routes to the
+// addresses of that LSA changed.
+//
+      const std::vector<Ipv4Address> &vertices = tree->second.m_vertices;
+      for (uint32_t k = 0; k < vertices.size (); k++)
+        {
+          if (changed.find (vertices[k]) != changed.end ())
+            {
+              reinstall.push_back (*r);
+              break;
+            }
+        }
+    }
+  return true;
+}
+
+void
+GlobalRouteManagerImpl::SPFReinstallRoutes (Ipv4Address root, const SPFTreeRecord &tree)
+{
+  NS_LOG_FUNCTION (this << root << &tree);
+  Ptr<Node> node = GetRouterNode (root);
+  NS_ASSERT (node);
+  Ptr<Ipv4GlobalRouting> gr = node->GetObject<GlobalRouter> ()->GetRoutingProtocol ();
+  NS_ASSERT (gr);
+  DeleteRoutes (node);
+//
+// Install the host routes in the order SPFIntraAddRouter () installed them
+// when the vertices joined the tree, then the stub routes in the order
+// SPFProcessStubs () walked the tree.
+//
+  for (uint32_t i = 0; i < tree.m_vertices.size (); i++)
+    {
+      GlobalRoutingLSA *lsa = m_lsdb->GetLSA (tree.m_vertices[i]);
+      NS_ASSERT (lsa && lsa->GetLSType () == GlobalRoutingLSA::RouterLSA);
+      uint32_t end = i + 1 < tree.m_vertices.size () ? tree.m_exitIndex[i + 1] : tree.m_exits.size ();
+      for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+          if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
+            {
+              continue;
+            }
+          for (uint32_t k = tree.m_exitIndex[i]; k < end; k++)
+            {
+              if (tree.m_exits[k].second >= 0)
+                {
+                  gr->AddHostRouteTo (lr->GetLinkData (), tree.m_exits[k].first, tree.m_exits[k].second);
+                }
+            }
+        }
+    }
+  for (uint32_t s = 0; s < tree.m_stubOrder.size (); s++)
+    {
+      uint32_t i = tree.m_stubOrder[s];
+      GlobalRoutingLSA *lsa = m_lsdb->GetLSA (tree.m_vertices[i]);
+      uint32_t end = i + 1 < tree.m_vertices.size () ? tree.m_exitIndex[i + 1] : tree.m_exits.size ();
+      for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+          if (lr->GetLinkType () != GlobalRoutingLinkRecord::StubNetwork)
+            {
+              continue;
+            }
+          Ipv4Mask mask (lr->GetLinkData ().Get ());
+          Ipv4Address network = lr->GetLinkId ().CombineMask (mask);
+          for (uint32_t k = tree.m_exitIndex[i]; k < end; k++)
+            {
+              if (tree.m_exits[k].second >= 0)
+                {
+                  gr->AddNetworkRouteTo (network, mask, tree.m_exits[k].first, tree.m_exits[k].second);
+                }
+            }
         }
     }
-  NS_LOG_INFO ("Finished SPF calculation");
 }
 
 //
@@ -958,9 +1634,9 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
                 {
 //
 // If we've changed the cost to get to the vertex represented by <w>, we 
-// must reorder the priority queue keyed to that cost.
+// must move it up the priority queue keyed to that cost.
 //
-                  candidate.Reorder ();
+                  candidate.DecreaseKey (cw);
                 }
             } // new lower cost path found
         } // end W is already on the candidate list
@@ -1240,6 +1916,18 @@ GlobalRouteManagerImpl::SPFGetNextLink (
   return 0;
 }
 
+Ptr<Node>
+GlobalRouteManagerImpl::GetRouterNode (Ipv4Address routerId) const
+{
+  NS_LOG_FUNCTION (this << routerId);
+  RouterNodeMap_t::const_iterator i = m_routerNodes.find (routerId);
+  if (i == m_routerNodes.end ())
+    {
+      return 0;
+    }
+  return i->second;
+}
+
 //
 // Used for unit tests.
 //
@@ -1320,7 +2008,10 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
               if (lr->GetLinkId () == myRouterId)
                 {
                   // Next hop is stored in the LinkID field of lr
-                  Ptr<GlobalRouter> router = rlsa->GetNode ()->GetObject<GlobalRouter> ();
+                  // not rlsa->GetNode (), which goes through the NodeList
+                  Ptr<Node> node = GetRouterNode (root);
+                  NS_ASSERT (node);
+                  Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
                   NS_ASSERT (router);
                   Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
                   NS_ASSERT (gr);
@@ -1369,6 +2060,17 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
   v->SetDistanceFromRoot (0);
   v->GetLSA ()->SetStatus (GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
   NS_LOG_LOGIC ("Starting SPFCalculate for node " << root);
+//
+// If the routes are updated incrementally, remember the order in which the
+// vertices join the tree and how the root reaches them, which is all that
+// the routes of the root depend on besides the LSAs.
+//
+  if (m_recordTrees)
+    {
+      m_spfRecord = &m_spfTrees[root];
+      *m_spfRecord = SPFTreeRecord ();
+      m_spfRecordIndex.clear ();
+    }
 
 //
 // Optimize SPF calculation, for ns-3.
@@ -1377,10 +2079,12 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // reached.  Instead, short-circuit this computation and just install
 // a default route in the CheckForStubNode() method.
 //
-  if (NodeList::GetNNodes () > 0 && CheckForStubNode (root))
+  if (!m_routerNodes.empty () && CheckForStubNode (root))
     {
       NS_LOG_LOGIC ("SPFCalculate truncated for stub node " << root);
       delete m_spfroot;
+      m_spfroot = 0;
+      m_spfRecord = 0;
       return;
     }
 
@@ -1477,6 +2181,16 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
         {
           NS_ASSERT_MSG (0, "illegal SPFVertex type");
         }
+      if (m_spfRecord)
+        {
+          m_spfRecordIndex[v->GetVertexId ()] = m_spfRecord->m_vertices.size ();
+          m_spfRecord->m_vertices.push_back (v->GetVertexId ());
+          m_spfRecord->m_exitIndex.push_back (m_spfRecord->m_exits.size ());
+          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+            {
+              m_spfRecord->m_exits.push_back (v->GetRootExitDirection (i));
+            }
+        }
 //
 // RFC2328 16.1. (5). 
 //
@@ -1502,6 +2216,7 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 //
   delete m_spfroot;
   m_spfroot = 0;
+  m_spfRecord = 0;
 }
 
 void
@@ -1560,58 +2275,37 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// Look up the node that has the router ID corresponding to the root vertex.
+// This is the one we're going to write the routing information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Node> node = GetRouterNode (routerId);
+  if (node == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
+      NS_LOG_LOGIC ("No GlobalRouter interface with router ID " << routerId);
+      return;
+    }
+  NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
 //
 // Routing information is updated using the Ipv4 interface.  We need to QI
 // for that interface.  If the node is acting as an IP version 4 router, it
 // should absolutely have an Ipv4 interface.
 //
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  NS_ASSERT_MSG (ipv4, 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "QI for <Ipv4> interface failed");
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = extlsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = extlsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
 
 //
 // Here's why we did all of that work.  We're going to add a host route to the
@@ -1626,39 +2320,36 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add external network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+  Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
+  if (router == 0)
+    {
+      return;
+    }
+  Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
+  NS_ASSERT (gr);
+  // walk through all next-hop-IPs and out-going-interfaces for reaching
+  // the stub network gateway 'v' from the root node
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
+        {
+          gr->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                        " add external network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
 
@@ -1674,6 +2365,10 @@ GlobalRouteManagerImpl::SPFProcessStubs (SPFVertex* v)
     {
       GlobalRoutingLSA *rlsa = v->GetLSA ();
       NS_LOG_LOGIC ("Processing router LSA with id " << rlsa->GetLinkStateId ());
+      if (m_spfRecord && v != m_spfroot)
+        {
+          m_spfRecord->m_stubOrder.push_back (m_spfRecordIndex[v->GetVertexId ()]);
+        }
       for (uint32_t i = 0; i < rlsa->GetNLinkRecords (); i++)
         {
           NS_LOG_LOGIC ("Examining link " << i << " of " << 
@@ -1729,60 +2424,37 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// Look up the node that has the router ID corresponding to the root vertex.
+// This is the one we're going to write the routing information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Node> node = GetRouterNode (routerId);
+  if (node == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
+      NS_LOG_LOGIC ("No GlobalRouter interface with router ID " << routerId);
+      return;
+    }
+  NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
 //
 // Routing information is updated using the Ipv4 interface.  We need to QI
 // for that interface.  If the node is acting as an IP version 4 router, it
 // should absolutely have an Ipv4 interface.
 //
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  NS_ASSERT_MSG (ipv4, 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "QI for <Ipv4> interface failed");
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask (l->GetLinkData ().Get ());
-          Ipv4Address tempip = l->GetLinkId ();
-          tempip = tempip.CombineMask (tempmask);
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask (l->GetLinkData ().Get ());
+  Ipv4Address tempip = l->GetLinkId ();
+  tempip = tempip.CombineMask (tempmask);
 //
 // Here's why we did all of that work.  We're going to add a host route to the
 // host address found in the m_linkData field of the point-to-point link
@@ -1797,39 +2469,36 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
 // which the packets should be send for forwarding.
 //
 
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+  Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
+  if (router == 0)
+    {
+      return;
+    }
+  Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
+  NS_ASSERT (gr);
+  // walk through all next-hop-IPs and out-going-interfaces for reaching
+  // the stub network gateway 'v' from the root node
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
+        {
+          gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
 //
@@ -1853,61 +2522,40 @@ GlobalRouteManagerImpl::FindOutgoingInterfaceId (Ipv4Address a, Ipv4Mask amask)
 //
   Ipv4Address routerId = m_spfroot->GetVertexId ();
 //
-// Walk the list of nodes in the system looking for the one corresponding to
-// the node at the root of the SPF tree.  This is the node for which we are
-// building the routing table.
+// Look up the node that has the router ID corresponding to the root vertex.
+// This is the one we're going to write the routing information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Node> node = GetRouterNode (routerId);
+  if (node == 0)
     {
-      Ptr<Node> node = *i;
-
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-//
-// If the node doesn't have a GlobalRouter interface it can't be the one
-// we're interested in.
-//
-      if (rtr == 0)
-        {
-          continue;
-        }
-
-      if (rtr->GetRouterId () == routerId)
-        {
+      NS_LOG_LOGIC ("Can't find root node " << routerId);
+      return -1;
+    }
 //
 // This is the node we're building the routing table for.  We're going to need
 // the Ipv4 interface to look for the ipv4 interface index.  Since this node
 // is participating in routing IP version 4 packets, it certainly must have 
 // an Ipv4 interface.
 //
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::FindOutgoingInterfaceId (): "
-                         "GetObject for <Ipv4> interface failed");
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  NS_ASSERT_MSG (ipv4, 
+                 "GlobalRouteManagerImpl::FindOutgoingInterfaceId (): "
+                 "GetObject for <Ipv4> interface failed");
 //
 // Look through the interfaces on this node for one that has the IP address
 // we're looking for.  If we find one, return the corresponding interface
 // index, or -1 if not found.
 //
-          int32_t interface = ipv4->GetInterfaceForPrefix (a, amask);
+  int32_t interface = ipv4->GetInterfaceForPrefix (a, amask);
 
 #if 0
-          if (interface < 0)
-            {
-              NS_FATAL_ERROR ("GlobalRouteManagerImpl::FindOutgoingInterfaceId(): "
-                              "Expected an interface associated with address a:" << a);
-            }
-#endif 
-          return interface;
-        }
+  if (interface < 0)
+    {
+      NS_FATAL_ERROR ("GlobalRouteManagerImpl::FindOutgoingInterfaceId(): "
+                      "Expected an interface associated with address a:" << a);
     }
-//
-// Couldn't find it.
-//
-  NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find root node " << routerId);
-  return -1;
+#endif 
+  return interface;
 }
 
 //
@@ -1944,60 +2592,37 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// Look up the node that has the router ID corresponding to the root vertex.
+// This is the one we're going to write the routing information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Node> node = GetRouterNode (routerId);
+  if (node == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
+      NS_LOG_LOGIC ("No GlobalRouter interface with router ID " << routerId);
+      return;
+    }
+  NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
 //
 // Routing information is updated using the Ipv4 interface.  We need to 
 // GetObject for that interface.  If the node is acting as an IP version 4 
 // router, it should absolutely have an Ipv4 interface.
 //
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "GetObject for <Ipv4> interface failed");
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  NS_ASSERT_MSG (ipv4, 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "GetObject for <Ipv4> interface failed");
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
 
-          uint32_t nLinkRecords = lsa->GetNLinkRecords ();
+  uint32_t nLinkRecords = lsa->GetNLinkRecords ();
 //
 // Iterate through the link records on the vertex to which we're going to add
 // routes.  To make sure we're being clear, we're going to add routing table
@@ -2006,18 +2631,18 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // the local side of the point-to-point links found on the node described by
 // the vertex <v>.
 //
-          NS_LOG_LOGIC (" Node " << node->GetId () <<
-                        " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
-          for (uint32_t j = 0; j < nLinkRecords; ++j)
-            {
+  NS_LOG_LOGIC (" Node " << node->GetId () <<
+                " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
+  for (uint32_t j = 0; j < nLinkRecords; ++j)
+    {
 //
 // We are only concerned about point-to-point links
 //
-              GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
-              if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
-                {
-                  continue;
-                }
+      GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+      if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
+        {
+          continue;
+        }
 //
 // Here's why we did all of that work.  We're going to add a host route to the
 // host address found in the m_linkData field of the point-to-point link
@@ -2031,44 +2656,38 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-              Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-              if (router == 0)
-                {
-                  continue;
-                }
-              Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-              NS_ASSERT (gr);
-              // walk through all available exit directions due to ECMP,
-              // and add host route for each of the exit direction toward
-              // the vertex 'v'
-              for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-                {
-                  SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-                  Ipv4Address nextHop = exit.first;
-                  int32_t outIf = exit.second;
-                  if (outIf >= 0)
-                    {
-                      gr->AddHostRouteTo (lr->GetLinkData (), nextHop,
-                                          outIf);
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " adding host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " and outgoing interface " << outIf);
-                    }
-                  else
-                    {
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " NOT able to add host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " since outgoing interface id is negative " << outIf);
-                    }
-                } // for all routes from the root the vertex 'v'
-            }
-//
-// Done adding the routes for the selected node.
-//
-          return;
+      Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
+      if (router == 0)
+        {
+          continue;
         }
+      Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
+      NS_ASSERT (gr);
+      // walk through all available exit directions due to ECMP,
+      // and add host route for each of the exit direction toward
+      // the vertex 'v'
+      for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+        {
+          SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+          Ipv4Address nextHop = exit.first;
+          int32_t outIf = exit.second;
+          if (outIf >= 0)
+            {
+              gr->AddHostRouteTo (lr->GetLinkData (), nextHop,
+                                  outIf);
+              NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                            " adding host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " and outgoing interface " << outIf);
+            }
+          else
+            {
+              NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                            " NOT able to add host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " since outgoing interface id is negative " << outIf);
+            }
+        } // for all routes from the root the vertex 'v'
     }
 }
 void
@@ -2089,95 +2708,70 @@ GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// Look up the node that has the router ID corresponding to the root vertex.
+// This is the one we're going to write the routing information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Node> node = GetRouterNode (routerId);
+  if (node == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("setting routes for node " << node->GetId ());
+      NS_LOG_LOGIC ("No GlobalRouter interface with router ID " << routerId);
+      return;
+    }
+  NS_LOG_LOGIC ("setting routes for node " << node->GetId ());
 //
 // Routing information is updated using the Ipv4 interface.  We need to 
 // GetObject for that interface.  If the node is acting as an IP version 4 
 // router, it should absolutely have an Ipv4 interface.
 //
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "GetObject for <Ipv4> interface failed");
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  NS_ASSERT_MSG (ipv4, 
+                 "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
+                 "GetObject for <Ipv4> interface failed");
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = lsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all available exit directions due to ECMP,
-          // and add host route for each of the exit direction toward
-          // the vertex 'v'
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = lsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
+  Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
+  if (router == 0)
+    {
+      return;
+    }
+  Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
+  NS_ASSERT (gr);
+  // walk through all available exit directions due to ECMP,
+  // and add host route for each of the exit direction toward
+  // the vertex 'v'
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
 
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative " << outIf);
-                }
-            }
+      if (outIf >= 0)
+        {
+          gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
         }
-    } 
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative " << outIf);
+        }
+    }
 }
 
 // Derived from quagga ospf_vertex_add_parents ()
@@ -30,6 +30,7 @@
 #include "ns3/object.h"
 #include "ns3/ptr.h"
 #include "ns3/ipv4-address.h"
+#include "ns3/sgi-hashmap.h"
 #include "global-router-interface.h"
 
 namespace ns3 {
@@ -674,12 +675,33 @@ public:
    */
   uint32_t GetNumExtLSAs () const;
 
+/**
+ * @brief Get the link state IDs of the Link State Advertisements of the
+ * database, in increasing order.  The AS external LSAs are not included.
+ *
+ * @param ids [out] the link state IDs
+ */
+  void GetLinkStateIds (std::vector<Ipv4Address> &ids) const;
+
+/**
+ * @brief Make a deep copy of the Link State Database.
+ *
+ * The copy holds copies of all of the Link State Advertisements, so that an
+ * SPF calculation can run on it while another one runs on this database.
+ *
+ * @returns A new Link State Database, owned by the caller.
+ */
+  GlobalRouteManagerLSDB* Copy (void) const;
+
 
 private:
   typedef std::map<Ipv4Address, GlobalRoutingLSA*> LSDBMap_t; //!< container of IPv4 addresses / Link State Advertisements
   typedef std::pair<Ipv4Address, GlobalRoutingLSA*> LSDBPair_t; //!< pair of IPv4 addresses / Link State Advertisements
 
+  typedef std::map<Ipv4Address, Ipv4Address> LSDBLinkDataMap_t; //!< container of TransitNetwork link data / LSA addresses
+
   LSDBMap_t m_database; //!< database of IPv4 addresses / Link State Advertisements
+  LSDBLinkDataMap_t m_linkDataIndex; //!< index of the TransitNetwork link records, by link data
   std::vector<GlobalRoutingLSA*> m_extdatabase; //!< database of External Link State Advertisements
 
 /**
@@ -732,9 +754,42 @@ public:
 /**
  * @brief Compute routes using a Dijkstra SPF computation and populate
  * per-node forwarding tables
+ *
+ * The SPF trees of the routers are independent, so they are computed by
+ * as many threads as the GlobalRoutingThreads global value asks for, each
+ * thread working on its own copy of the LSDB and filling the forwarding
+ * tables of its own set of nodes.  Every forwarding table is filled by a
+ * single SPF calculation, so the routes do not depend on the number of
+ * threads.  Logging from several threads is interleaved.
  */
   virtual void InitializeRoutes ();
 
+/**
+ * @brief Bring the per-node forwarding tables up to date after a change of
+ * the topology, such as an interface going up or down.
+ *
+ * By default, this deletes all of the routes and runs
+ * BuildGlobalRoutingDatabase () and InitializeRoutes () again.  When the
+ * GlobalRoutingIncremental global value is set, the new LSDB is compared
+ * with the previous one instead:
+ *
+ * - if no LSA changed, the routes are left alone;
+ * - a router whose shortest path tree may have changed, that is a router
+ *   whose own LSA changed, which has a link to a router whose LSA changed,
+ *   or whose shortest paths used or would use a link which changed, runs
+ *   the SPF calculation again;
+ * - a router whose tree reaches a changed LSA through unchanged shortest
+ *   paths reinstalls its routes from the tree recorded by its previous SPF
+ *   calculation, without running the Dijkstra stage;
+ * - the other routers keep their routes.
+ *
+ * The forwarding tables are the same as the ones a full recomputation
+ * would build, entry for entry.  The incremental update only handles
+ * point-to-point topologies: with network or AS external LSAs in the
+ * database, all of the routes are recomputed.
+ */
+  virtual void UpdateGlobalRoutes ();
+
 /**
  * @brief Debugging routine; allow client code to supply a pre-built LSDB
  */
@@ -769,6 +824,109 @@ private:
   SPFVertex* m_spfroot; //!< the root node
   GlobalRouteManagerLSDB* m_lsdb; //!< the Link State DataBase (LSDB) of the Global Route Manager
 
+  /**
+   * \brief container of router IDs / nodes
+   *
+   * The nodes are held by the NodeList; raw pointers let the SPF threads
+   * copy and read the map without touching the reference counts of nodes
+   * shared between threads.
+   */
+  typedef sgi::hash_map<Ipv4Address, Node*, Ipv4AddressHash> RouterNodeMap_t;
+  RouterNodeMap_t m_routerNodes; //!< node of each router, filled while building the LSDB
+
+  /**
+   * \brief The part of the shortest path tree of a root which its routes
+   * depend on, recorded by SPFCalculate () when incremental updates are
+   * enabled.
+   *
+   * Given the LSAs of the vertices, this is enough to install the routes
+   * of the root again in the same order, without running the Dijkstra
+   * stage of the SPF calculation.
+   */
+  struct SPFTreeRecord
+  {
+    std::vector<Ipv4Address> m_vertices;        //!< vertices, in the order they joined the tree
+    std::vector<uint32_t> m_exitIndex;          //!< index in m_exits of the first exit direction of each vertex
+    std::vector<SPFVertex::NodeExit_t> m_exits; //!< root exit directions of the vertices
+    std::vector<uint32_t> m_stubOrder;          //!< vertices, as indices in m_vertices, in the order their stubs were processed
+  };
+
+  /// container of router IDs / recorded shortest path trees
+  typedef std::map<Ipv4Address, SPFTreeRecord> SPFTreeMap_t;
+  SPFTreeMap_t m_spfTrees; //!< tree of each root, when incremental updates are enabled
+  bool m_recordTrees; //!< true if SPFCalculate () records the tree of its root
+  SPFTreeRecord *m_spfRecord; //!< tree being recorded by SPFCalculate ()
+  /// container of router IDs / indices of the vertices in m_spfRecord
+  typedef sgi::hash_map<Ipv4Address, uint32_t, Ipv4AddressHash> SPFRecordIndex_t;
+  SPFRecordIndex_t m_spfRecordIndex; //!< index of the vertices of m_spfRecord
+
+  /**
+   * \brief Run the SPF calculation of a list of roots.
+   *
+   * This is the body of the threads started by InitializeRoutes ().
+   *
+   * \param impl the route manager, with its own copy of the LSDB
+   * \param roots the router IDs of the roots
+   */
+  static void SPFCalculateRoots (GlobalRouteManagerImpl *impl, const std::vector<Ipv4Address> *roots);
+
+  /**
+   * \brief Run the SPF calculation of a list of roots, on as many threads as
+   * the GlobalRoutingThreads global value asks for.
+   *
+   * \param roots the router IDs of the roots
+   */
+  void SPFCalculateInThreads (const std::vector<Ipv4Address> &roots);
+
+  /**
+   * \brief Get the roots of the SPF calculations: the routers of this
+   * system which have LSAs.
+   *
+   * \param roots [out] the router IDs of the roots
+   */
+  void GetSPFRoots (std::vector<Ipv4Address> &roots) const;
+
+  /**
+   * \brief Delete all of the routes installed on a node by global routing.
+   *
+   * \param node the node
+   */
+  void DeleteRoutes (Ptr<Node> node);
+
+  /**
+   * \brief Install the routes of a root again from its recorded shortest
+   * path tree, using the LSAs of the current LSDB.
+   *
+   * \param root the router ID of the root
+   * \param tree the shortest path tree recorded for the root
+   */
+  void SPFReinstallRoutes (Ipv4Address root, const SPFTreeRecord &tree);
+
+  /**
+   * \brief Find the roots whose shortest path trees may differ between two
+   * LSDBs, and the roots whose trees reach a changed LSA.
+   *
+   * \param oldLsdb the LSDB the current routes were computed from
+   * \param roots the router IDs of the roots
+   * \param recompute [out] the roots which must run the SPF calculation
+   * \param reinstall [out] the roots which must reinstall their routes
+   * \returns false if the LSDBs hold LSAs the comparison does not handle,
+   * in which case all of the routes must be recomputed
+   */
+  bool CompareLsdb (const GlobalRouteManagerLSDB *oldLsdb,
+                    const std::vector<Ipv4Address> &roots,
+                    std::vector<Ipv4Address> &recompute,
+                    std::vector<Ipv4Address> &reinstall);
+
+  /**
+   * \brief Find the node of a router, as registered by
+   * BuildGlobalRoutingDatabase ().
+   *
+   * \param routerId the router ID
+   * \returns the node, or 0 if no node has this router ID
+   */
+  Ptr<Node> GetRouterNode (Ipv4Address routerId) const;
+
   /**
    * \brief Test if a node is a stub, from an OSPF sense.
    *
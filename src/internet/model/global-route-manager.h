@@ -65,6 +65,16 @@ public:
  */
   static void InitializeRoutes ();
 
+/**
+ * @brief Bring the per-node forwarding tables up to date after a change of
+ * the topology.
+ *
+ * This deletes all of the routes and computes them again, unless the
+ * GlobalRoutingIncremental global value is set, in which case only the
+ * routers whose routes may have changed compute them again.
+ */
+  static void UpdateGlobalRoutes ();
+
 private:
 /**
  * @brief Global Route Manager copy construction is disallowed.  There's no 
@@ -18,6 +18,8 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 
+#include <algorithm>
+#include <vector>
 #include "ipv4-end-point-demux.h"
 #include "ipv4-end-point.h"
 #include "ipv4-interface-address.h"
@@ -28,6 +30,24 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Ipv4EndPointDemux");
 
+bool
+Ipv4EndPointDemux::FourTuple::operator== (const FourTuple &other) const
+{
+  return m_localAddr == other.m_localAddr
+         && m_localPort == other.m_localPort
+         && m_peerAddr == other.m_peerAddr
+         && m_peerPort == other.m_peerPort;
+}
+
+size_t
+Ipv4EndPointDemux::FourTupleHash::operator() (const FourTuple &x) const
+{
+  size_t hash = x.m_peerAddr.Get ();
+  hash = hash * 31 + x.m_localAddr.Get ();
+  hash = hash * 31 + ((static_cast<uint32_t> (x.m_peerPort) << 16) | x.m_localPort);
+  return hash;
+}
+
 Ipv4EndPointDemux::Ipv4EndPointDemux ()
   : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152)
 {
@@ -40,6 +60,7 @@ Ipv4EndPointDemux::~Ipv4EndPointDemux ()
   for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
     {
       Ipv4EndPoint *endPoint = *i;
+      endPoint->m_demux = 0;
       delete endPoint;
     }
   m_endPoints.clear ();
@@ -49,14 +70,7 @@ bool
 Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
 {
   NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
-    {
-      if ((*i)->GetLocalPort  () == port) 
-        {
-          return true;
-        }
-    }
-  return false;
+  return m_localPorts.find (port) != m_localPorts.end ();
 }
 
 bool
@@ -86,7 +100,7 @@ Ipv4EndPointDemux::Allocate (void)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (Ipv4Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -102,7 +116,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -125,7 +139,7 @@ Ipv4EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice, Ipv4Address address,
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -136,7 +150,30 @@ Ipv4EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice,
                              Ipv4Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort << boundNetDevice);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  // Only the endpoints in the same table entry can have the same four-tuple
+  EndPoints candidates;
+  if (peerAddress == Ipv4Address::GetAny () || peerPort == 0)
+    {
+      Listeners::iterator listeners = m_listeners.find (localPort);
+      if (listeners != m_listeners.end ())
+        {
+          candidates = listeners->second;
+        }
+    }
+  else
+    {
+      FourTuple key;
+      key.m_localAddr = localAddress;
+      key.m_localPort = localPort;
+      key.m_peerAddr = peerAddress;
+      key.m_peerPort = peerPort;
+      Connections::iterator connections = m_connections.find (key);
+      if (connections != m_connections.end ())
+        {
+          candidates = connections->second;
+        }
+    }
+  for (EndPointsI i = candidates.begin (); i != candidates.end (); i++) 
     {
       if ((*i)->GetLocalPort () == localPort &&
           (*i)->GetLocalAddress () == localAddress &&
@@ -150,7 +187,7 @@ Ipv4EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice,
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
 
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
 
@@ -165,6 +202,8 @@ Ipv4EndPointDemux::DeAllocate (Ipv4EndPoint *endPoint)
     {
       if (*i == endPoint)
         {
+          Unindex (endPoint);
+          endPoint->m_demux = 0;
           delete endPoint;
           m_endPoints.erase (i);
           break;
@@ -208,7 +247,43 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
   EndPoints retval4; // Exact match on all 4
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr << ":" << dport);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+
+  // The endpoints with a wildcard peer on this port, plus the ones with this
+  // peer and a local address which can match: the destination, Any, or the
+  // network part of an address of the incoming interface.
+  EndPoints candidates;
+  Listeners::iterator listeners = m_listeners.find (dport);
+  if (listeners != m_listeners.end ())
+    {
+      candidates = listeners->second;
+    }
+  std::vector<Ipv4Address> localAddresses;
+  localAddresses.push_back (daddr);
+  localAddresses.push_back (Ipv4Address::GetAny ());
+  for (uint32_t i = 0; incomingInterface != 0 && i < incomingInterface->GetNAddresses (); i++)
+    {
+      Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
+      Ipv4Address addrNetpart = addr.GetLocal ().CombineMask (addr.GetMask ());
+      if (std::find (localAddresses.begin (), localAddresses.end (), addrNetpart) == localAddresses.end ())
+        {
+          localAddresses.push_back (addrNetpart);
+        }
+    }
+  FourTuple key;
+  key.m_localPort = dport;
+  key.m_peerAddr = saddr;
+  key.m_peerPort = sport;
+  for (std::vector<Ipv4Address>::const_iterator j = localAddresses.begin (); j != localAddresses.end (); j++)
+    {
+      key.m_localAddr = *j;
+      Connections::iterator connections = m_connections.find (key);
+      if (connections != m_connections.end ())
+        {
+          candidates.insert (candidates.end (), connections->second.begin (), connections->second.end ());
+        }
+    }
+
+  for (EndPointsI i = candidates.begin (); i != candidates.end (); i++) 
     {
       Ipv4EndPoint* endP = *i;
 
@@ -301,6 +376,8 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
         continue;
 
       bool localAddressMatchesWildCard = localAddressIsAny || localAddressIsSubnetAny;
+      // The peer address or port, or both, are wildcards which match
+      bool remoteMatchesWildCard = !(remoteAddressMatchesExact && remotePortMatchesExact);
 
       if (localAddressMatchesExact && remoteAddressMatchesExact && remotePortMatchesExact)
         { // All 4 match - this is the case of an open TCP connection, for example.
@@ -312,12 +389,12 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
           NS_LOG_LOGIC ("Found an endpoint for case 3, adding " << endP->GetLocalAddress () << ":" << endP->GetLocalPort ());
           retval3.push_back (endP);
         }
-      if (localAddressMatchesExact && remoteAddressMatchesWildCard && remotePortMatchesWildCard)
+      if (localAddressMatchesExact && remoteMatchesWildCard)
         { // Only local port and local address matches exactly - Not yet opened connection
           NS_LOG_LOGIC ("Found an endpoint for case 2, adding " << endP->GetLocalAddress () << ":" << endP->GetLocalPort ());
           retval2.push_back (endP);
         }
-      if (localAddressMatchesWildCard && remoteAddressMatchesWildCard && remotePortMatchesWildCard)
+      if (localAddressMatchesWildCard && remoteMatchesWildCard)
         { // Only local port matches exactly - Endpoint open to "any" connection
           NS_LOG_LOGIC ("Found an endpoint for case 1, adding " << endP->GetLocalAddress () << ":" << endP->GetLocalPort ());
           retval1.push_back (endP);
@@ -377,6 +454,73 @@ Ipv4EndPointDemux::SimpleLookup (Ipv4Address daddr,
     }
   return generic;
 }
+
+void
+Ipv4EndPointDemux::Insert (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  m_endPoints.push_back (endPoint);
+  endPoint->m_demux = this;
+  Index (endPoint);
+}
+
+void
+Ipv4EndPointDemux::Index (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  m_localPorts[endPoint->m_localPort]++;
+  if (endPoint->m_peerAddr == Ipv4Address::GetAny () || endPoint->m_peerPort == 0)
+    {
+      m_listeners[endPoint->m_localPort].push_back (endPoint);
+    }
+  else
+    {
+      FourTuple key;
+      key.m_localAddr = endPoint->m_localAddr;
+      key.m_localPort = endPoint->m_localPort;
+      key.m_peerAddr = endPoint->m_peerAddr;
+      key.m_peerPort = endPoint->m_peerPort;
+      m_connections[key].push_back (endPoint);
+    }
+}
+
+void
+Ipv4EndPointDemux::Unindex (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  std::map<uint16_t, uint32_t>::iterator port = m_localPorts.find (endPoint->m_localPort);
+  NS_ASSERT (port != m_localPorts.end ());
+  if (--port->second == 0)
+    {
+      m_localPorts.erase (port);
+    }
+  if (endPoint->m_peerAddr == Ipv4Address::GetAny () || endPoint->m_peerPort == 0)
+    {
+      Listeners::iterator listeners = m_listeners.find (endPoint->m_localPort);
+      NS_ASSERT (listeners != m_listeners.end ());
+      listeners->second.remove (endPoint);
+      if (listeners->second.empty ())
+        {
+          m_listeners.erase (listeners);
+        }
+    }
+  else
+    {
+      FourTuple key;
+      key.m_localAddr = endPoint->m_localAddr;
+      key.m_localPort = endPoint->m_localPort;
+      key.m_peerAddr = endPoint->m_peerAddr;
+      key.m_peerPort = endPoint->m_peerPort;
+      Connections::iterator connections = m_connections.find (key);
+      NS_ASSERT (connections != m_connections.end ());
+      connections->second.remove (endPoint);
+      if (connections->second.empty ())
+        {
+          m_connections.erase (connections);
+        }
+    }
+}
+
 uint16_t
 Ipv4EndPointDemux::AllocateEphemeralPort (void)
 {
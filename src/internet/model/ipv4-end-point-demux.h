@@ -23,7 +23,9 @@
 
 #include <stdint.h>
 #include <list>
+#include <map>
 #include "ns3/ipv4-address.h"
+#include "ns3/sgi-hashmap.h"
 #include "ipv4-interface.h"
 
 namespace ns3 {
@@ -40,6 +42,13 @@ class Ipv4EndPoint;
  * of endpoints, and has APIs to add and find endpoints in this demux.  This
  * code is shared in common to TCP and UDP protocols in ns3.  This demux
  * sits between ns3's layer four and the socket layer
+ *
+ * Besides the list, the endpoints are indexed by local port, and either by
+ * their four-tuple when both a peer address and port are set, or by local
+ * port alone when the peer address or port is a wildcard.  Lookup () then
+ * only examines the endpoints which can match a packet, whatever the number
+ * of open connections.  The endpoints keep the index up to date when their
+ * addresses change.
  */
 
 class Ipv4EndPointDemux {
@@ -166,6 +175,72 @@ public:
   void DeAllocate (Ipv4EndPoint *endPoint);
 
 private:
+  friend class Ipv4EndPoint;
+
+  /**
+   * \brief Local and peer addresses and ports of an endpoint.
+   */
+  struct FourTuple
+  {
+    Ipv4Address m_localAddr; //!< Local address
+    uint16_t m_localPort;    //!< Local port
+    Ipv4Address m_peerAddr;  //!< Peer address
+    uint16_t m_peerPort;     //!< Peer port
+
+    /**
+     * \brief Equal to operator.
+     * \param other the other four-tuple
+     * \returns true if the four-tuples are equal
+     */
+    bool operator== (const FourTuple &other) const;
+  };
+
+  /**
+   * \brief Hash function class for four-tuples.
+   */
+  struct FourTupleHash
+  {
+    /**
+     * \brief Returns the hash of a four-tuple.
+     * \param x the four-tuple
+     * \return the hash
+     */
+    size_t operator() (const FourTuple &x) const;
+  };
+
+  /**
+   * \brief Endpoints with both a peer address and port, by four-tuple.
+   */
+  typedef sgi::hash_map<FourTuple, EndPoints, FourTupleHash> Connections;
+
+  /**
+   * \brief Endpoints with a wildcard peer address or port, by local port.
+   */
+  typedef std::map<uint16_t, EndPoints> Listeners;
+
+  /**
+   * \brief Add an endpoint to the list and to the index.
+   * \param endPoint the endpoint
+   */
+  void Insert (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Add an endpoint to the index.
+   *
+   * Called by the endpoint after its addresses change.
+   *
+   * \param endPoint the endpoint
+   */
+  void Index (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Remove an endpoint from the index.
+   *
+   * Called by the endpoint before its addresses change.
+   *
+   * \param endPoint the endpoint
+   */
+  void Unindex (Ipv4EndPoint *endPoint);
 
   /**
    * \brief Allocate an ephemeral port.
@@ -192,6 +267,21 @@ private:
    * \brief A list of IPv4 end points.
    */
   EndPoints m_endPoints;
+
+  /**
+   * \brief Number of endpoints on each local port.
+   */
+  std::map<uint16_t, uint32_t> m_localPorts;
+
+  /**
+   * \brief Endpoints with both a peer address and port, by four-tuple.
+   */
+  Connections m_connections;
+
+  /**
+   * \brief Endpoints with a wildcard peer address or port, by local port.
+   */
+  Listeners m_listeners;
 };
 
 } // namespace ns3
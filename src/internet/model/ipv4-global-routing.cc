@@ -17,6 +17,7 @@
 //
 
 #include <vector>
+#include <limits>
 #include <iomanip>
 #include "ns3/names.h"
 #include "ns3/log.h"
@@ -27,6 +28,8 @@
 #include "ns3/ipv4-route.h"
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
 #include "ns3/node.h"
 #include "ipv4-global-routing.h"
 #include "global-route-manager.h"
@@ -37,6 +40,26 @@ NS_LOG_COMPONENT_DEFINE ("Ipv4GlobalRouting");
 
 NS_OBJECT_ENSURE_REGISTERED (Ipv4GlobalRouting);
 
+/// Number of destinations whose routes are cached
+static const uint32_t ECMP_GROUP_CACHE_SIZE = 4096;
+/// Number of flowlets tracked, by flow hash
+static const uint32_t FLOWLET_TABLE_SIZE = 4096;
+
+/**
+ * \param h a 64 bit value
+ * \return the value with all its bits mixed (finalizer of MurmurHash3)
+ */
+static uint64_t
+MixBits (uint64_t h)
+{
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
 TypeId 
 Ipv4GlobalRouting::GetTypeId (void)
 { 
@@ -53,13 +76,34 @@ Ipv4GlobalRouting::GetTypeId (void)
                    BooleanValue (false),
                    MakeBooleanAccessor (&Ipv4GlobalRouting::m_respondToInterfaceEvents),
                    MakeBooleanChecker ())
+    .AddAttribute ("EcmpMode",
+                   "The choice of a route among several routes of equal cost; "
+                   "RandomEcmpRouting set to true takes precedence",
+                   EnumValue (ECMP_NONE),
+                   MakeEnumAccessor (&Ipv4GlobalRouting::m_ecmpMode),
+                   MakeEnumChecker (ECMP_NONE, "None",
+                                    ECMP_RANDOM, "Random",
+                                    ECMP_FLOW_HASH, "FlowHash",
+                                    ECMP_FLOWLET, "Flowlet"))
+    .AddAttribute ("EcmpHashSeed",
+                   "The seed of the flow hash; routers with different seeds spread the same flows differently",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&Ipv4GlobalRouting::m_ecmpHashSeed),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("FlowletTimeout",
+                   "The idle time after which a flow may move to another route in the Flowlet mode",
+                   TimeValue (MicroSeconds (500)),
+                   MakeTimeAccessor (&Ipv4GlobalRouting::m_flowletTimeout),
+                   MakeTimeChecker ())
   ;
   return tid;
 }
 
 Ipv4GlobalRouting::Ipv4GlobalRouting () 
   : m_randomEcmpRouting (false),
-    m_respondToInterfaceEvents (false)
+    m_respondToInterfaceEvents (false),
+    m_ecmpMode (ECMP_NONE),
+    m_ecmpHashSeed (0)
 {
   NS_LOG_FUNCTION (this);
 
@@ -80,6 +124,8 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, nextHop, interface);
   m_hostRoutes.push_back (route);
+  m_hostTrie.Add (route);
+  InvalidateCache ();
 }
 
 void 
@@ -90,6 +136,8 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, interface);
   m_hostRoutes.push_back (route);
+  m_hostTrie.Add (route);
+  InvalidateCache ();
 }
 
 void 
@@ -105,6 +153,8 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (route);
+  m_networkTrie.Add (route);
+  InvalidateCache ();
 }
 
 void 
@@ -118,6 +168,8 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (route);
+  m_networkTrie.Add (route);
+  InvalidateCache ();
 }
 
 void 
@@ -133,104 +185,225 @@ Ipv4GlobalRouting::AddASExternalRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_ASexternalRoutes.push_back (route);
+  m_ASexternalTrie.Add (route);
+  InvalidateCache ();
 }
 
 
-Ptr<Ipv4Route>
-Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
+void
+Ipv4GlobalRouting::InvalidateCache (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_ecmpGroups.clear ();
+}
+
+void
+Ipv4GlobalRouting::FindRoutes (Ipv4Address dest, Ptr<NetDevice> oif, EcmpGroup &group)
 {
   NS_LOG_FUNCTION (this << dest << oif);
   NS_LOG_LOGIC ("Looking for route for destination " << dest);
-  Ptr<Ipv4Route> rtentry = 0;
   // store all available routes that bring packets to their destination
-  typedef std::vector<Ipv4RoutingTableEntry*> RouteVec_t;
-  RouteVec_t allRoutes;
+  std::vector<Ipv4RoutingTableEntry*> &allRoutes = group.m_routes;
+  allRoutes.clear ();
+  // the routes matching the destination, in routing table order
+  std::vector<Ipv4RouteTrie::Entry> matches;
 
   NS_LOG_LOGIC ("Number of m_hostRoutes = " << m_hostRoutes.size ());
-  for (HostRoutesCI i = m_hostRoutes.begin (); 
-       i != m_hostRoutes.end (); 
+  m_hostTrie.Lookup (dest, matches);
+  for (std::vector<Ipv4RouteTrie::Entry>::const_iterator i = matches.begin (); 
+       i != matches.end (); 
        i++) 
     {
-      NS_ASSERT ((*i)->IsHost ());
-      if ((*i)->GetDest ().IsEqual (dest)) 
+      Ipv4RoutingTableEntry *route = i->m_route;
+      NS_ASSERT (route->IsHost ());
+      if (oif != 0)
         {
-          if (oif != 0)
+          if (oif != m_ipv4->GetNetDevice (route->GetInterface ()))
             {
-              if (oif != m_ipv4->GetNetDevice ((*i)->GetInterface ()))
-                {
-                  NS_LOG_LOGIC ("Not on requested interface, skipping");
-                  continue;
-                }
+              NS_LOG_LOGIC ("Not on requested interface, skipping");
+              continue;
             }
-          allRoutes.push_back (*i);
-          NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << *i); 
         }
+      allRoutes.push_back (route);
+      NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << route); 
     }
   if (allRoutes.size () == 0) // if no host route is found
     {
       NS_LOG_LOGIC ("Number of m_networkRoutes" << m_networkRoutes.size ());
-      for (NetworkRoutesI j = m_networkRoutes.begin (); 
-           j != m_networkRoutes.end (); 
+      m_networkTrie.Lookup (dest, matches);
+      for (std::vector<Ipv4RouteTrie::Entry>::const_iterator j = matches.begin (); 
+           j != matches.end (); 
            j++) 
         {
-          Ipv4Mask mask = (*j)->GetDestNetworkMask ();
-          Ipv4Address entry = (*j)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry)) 
+          Ipv4RoutingTableEntry *route = j->m_route;
+          if (oif != 0)
             {
-              if (oif != 0)
+              if (oif != m_ipv4->GetNetDevice (route->GetInterface ()))
                 {
-                  if (oif != m_ipv4->GetNetDevice ((*j)->GetInterface ()))
-                    {
-                      NS_LOG_LOGIC ("Not on requested interface, skipping");
-                      continue;
-                    }
+                  NS_LOG_LOGIC ("Not on requested interface, skipping");
+                  continue;
                 }
-              allRoutes.push_back (*j);
-              NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << *j);
             }
+          allRoutes.push_back (route);
+          NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << route);
         }
     }
   if (allRoutes.size () == 0)  // consider external if no host/network found
     {
-      for (ASExternalRoutesI k = m_ASexternalRoutes.begin ();
-           k != m_ASexternalRoutes.end ();
+      m_ASexternalTrie.Lookup (dest, matches);
+      for (std::vector<Ipv4RouteTrie::Entry>::const_iterator k = matches.begin ();
+           k != matches.end ();
            k++)
         {
-          Ipv4Mask mask = (*k)->GetDestNetworkMask ();
-          Ipv4Address entry = (*k)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry))
+          Ipv4RoutingTableEntry *route = k->m_route;
+          NS_LOG_LOGIC ("Found external route" << route);
+          if (oif != 0)
             {
-              NS_LOG_LOGIC ("Found external route" << *k);
-              if (oif != 0)
+              if (oif != m_ipv4->GetNetDevice (route->GetInterface ()))
                 {
-                  if (oif != m_ipv4->GetNetDevice ((*k)->GetInterface ()))
-                    {
-                      NS_LOG_LOGIC ("Not on requested interface, skipping");
-                      continue;
-                    }
+                  NS_LOG_LOGIC ("Not on requested interface, skipping");
+                  continue;
                 }
-              allRoutes.push_back (*k);
-              break;
             }
+          allRoutes.push_back (route);
+          break;
         }
     }
-  if (allRoutes.size () > 0 ) // if route(s) is found
+
+  group.m_loads.clear ();
+  for (std::vector<Ipv4RoutingTableEntry*>::const_iterator l = allRoutes.begin ();
+       l != allRoutes.end ();
+       l++)
+    {
+      // the counters are created on first use, zeroed by value-initialization
+      NextHopLoad &load = m_nextHopLoads[std::make_pair ((*l)->GetInterface (), (*l)->GetGateway ())];
+      group.m_loads.push_back (&load);
+    }
+}
+
+uint32_t
+Ipv4GlobalRouting::SelectRoute (const EcmpGroup &group, uint32_t flowHash)
+{
+  NS_LOG_FUNCTION (this << flowHash);
+  uint32_t n = group.m_routes.size ();
+  // pick up one of the routes uniformly at random if random
+  // ECMP routing is enabled, or always select the first route
+  // consistently if ECMP routing is disabled
+  EcmpMode mode = m_randomEcmpRouting ? ECMP_RANDOM : m_ecmpMode;
+  // random ECMP draws even for a single route, as it always did, so that
+  // the random stream of existing scripts is unchanged
+  if (n == 1 && mode != ECMP_RANDOM)
+    {
+      return 0;
+    }
+  switch (mode)
+    {
+    case ECMP_RANDOM:
+      return m_rand->GetInteger (0, n - 1);
+    case ECMP_FLOW_HASH:
+      // multiply-shift maps the hash onto [0, n) without a division
+      return static_cast<uint32_t> ((static_cast<uint64_t> (flowHash) * n) >> 32);
+    case ECMP_FLOWLET:
+      {
+        if (m_flowlets.empty ())
+          {
+            Flowlet unused;
+            unused.m_lastSeen = Seconds (0);
+            unused.m_index = std::numeric_limits<uint32_t>::max ();
+            m_flowlets.resize (FLOWLET_TABLE_SIZE, unused);
+          }
+        // the flows sharing a slot share their flowlets
+        Flowlet &flowlet = m_flowlets[flowHash % FLOWLET_TABLE_SIZE];
+        Time now = Simulator::Now ();
+        if (flowlet.m_index >= n || now - flowlet.m_lastSeen > m_flowletTimeout)
+          {
+            uint32_t best = 0;
+            for (uint32_t i = 1; i < n; i++)
+              {
+                if (group.m_loads[i]->m_bytes < group.m_loads[best]->m_bytes)
+                  {
+                    best = i;
+                  }
+              }
+            NS_LOG_LOGIC ("New flowlet on route " << best);
+            flowlet.m_index = best;
+          }
+        flowlet.m_lastSeen = now;
+        return flowlet.m_index;
+      }
+    case ECMP_NONE:
+    default:
+      return 0;
+    }
+}
+
+bool
+Ipv4GlobalRouting::IsFlowHashUsed (void) const
+{
+  return !m_randomEcmpRouting && (m_ecmpMode == ECMP_FLOW_HASH || m_ecmpMode == ECMP_FLOWLET);
+}
+
+uint32_t
+Ipv4GlobalRouting::GetFlowHash (Ptr<const Packet> p, const Ipv4Header &header) const
+{
+  NS_LOG_FUNCTION (this << p << header);
+  uint8_t protocol = header.GetProtocol ();
+  uint32_t ports = 0;
+  // only the first fragment holds the ports: hash none of the fragments
+  // on them, so that all the fragments of a packet follow the same route
+  if (p != 0 && (protocol == 6 || protocol == 17)
+      && header.IsLastFragment () && header.GetFragmentOffset () == 0
+      && p->GetSize () >= 4)
+    {
+      uint8_t buffer[4];
+      p->CopyData (buffer, 4);
+      ports = (buffer[0] << 24) | (buffer[1] << 16) | (buffer[2] << 8) | buffer[3];
+    }
+  uint64_t addresses = (static_cast<uint64_t> (header.GetSource ().Get ()) << 32)
+    | header.GetDestination ().Get ();
+  uint64_t h = MixBits (addresses ^ (static_cast<uint64_t> (m_ecmpHashSeed) * 0x9e3779b97f4a7c15ULL));
+  h = MixBits (h ^ ((static_cast<uint64_t> (protocol) << 32) | ports));
+  return static_cast<uint32_t> (h >> 32);
+}
+
+Ptr<Ipv4Route>
+Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif, uint32_t flowHash, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (this << dest << oif << flowHash << p);
+  EcmpGroup found;
+  const EcmpGroup *group = &found;
+  if (oif == 0)
     {
-      // pick up one of the routes uniformly at random if random
-      // ECMP routing is enabled, or always select the first route
-      // consistently if random ECMP routing is disabled
-      uint32_t selectIndex;
-      if (m_randomEcmpRouting)
+      EcmpGroups::iterator cached = m_ecmpGroups.find (dest);
+      if (cached == m_ecmpGroups.end ())
         {
-          selectIndex = m_rand->GetInteger (0, allRoutes.size ()-1);
+          if (m_ecmpGroups.size () >= ECMP_GROUP_CACHE_SIZE)
+            {
+              NS_LOG_LOGIC ("Route cache full, clearing it");
+              m_ecmpGroups.clear ();
+            }
+          cached = m_ecmpGroups.insert (std::make_pair (dest, EcmpGroup ())).first;
+          FindRoutes (dest, oif, cached->second);
         }
-      else 
+      group = &cached->second;
+    }
+  else
+    {
+      FindRoutes (dest, oif, found);
+    }
+
+  if (group->m_routes.size () > 0 ) // if route(s) is found
+    {
+      uint32_t selectIndex = SelectRoute (*group, flowHash);
+      Ipv4RoutingTableEntry* route = group->m_routes[selectIndex];
+      if (p != 0)
         {
-          selectIndex = 0;
+          NextHopLoad *load = group->m_loads[selectIndex];
+          load->m_packets++;
+          load->m_bytes += p->GetSize ();
         }
-      Ipv4RoutingTableEntry* route = allRoutes.at (selectIndex); 
       // create a Ipv4Route object from the selected routing table entry
-      rtentry = Create<Ipv4Route> ();
+      Ptr<Ipv4Route> rtentry = Create<Ipv4Route> ();
       rtentry->SetDestination (route->GetDest ());
       /// \todo handle multi-address case
       rtentry->SetSource (m_ipv4->GetAddress (route->GetInterface (), 0).GetLocal ());
@@ -245,6 +418,22 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
     }
 }
 
+uint64_t
+Ipv4GlobalRouting::GetNextHopPackets (uint32_t interface, Ipv4Address gateway) const
+{
+  NS_LOG_FUNCTION (this << interface << gateway);
+  NextHopLoads::const_iterator i = m_nextHopLoads.find (std::make_pair (interface, gateway));
+  return i == m_nextHopLoads.end () ? 0 : i->second.m_packets;
+}
+
+uint64_t
+Ipv4GlobalRouting::GetNextHopBytes (uint32_t interface, Ipv4Address gateway) const
+{
+  NS_LOG_FUNCTION (this << interface << gateway);
+  NextHopLoads::const_iterator i = m_nextHopLoads.find (std::make_pair (interface, gateway));
+  return i == m_nextHopLoads.end () ? 0 : i->second.m_bytes;
+}
+
 uint32_t 
 Ipv4GlobalRouting::GetNRoutes (void) const
 {
@@ -319,6 +508,8 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
           if (tmp  == index)
             {
               NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_hostRoutes.size ());
+              InvalidateCache ();
+              m_hostTrie.Remove (*i);
               delete *i;
               m_hostRoutes.erase (i);
               NS_LOG_LOGIC ("Done removing host route " << index << "; host route remaining size = " << m_hostRoutes.size ());
@@ -336,6 +527,8 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
       if (tmp == index)
         {
           NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_networkRoutes.size ());
+          InvalidateCache ();
+          m_networkTrie.Remove (*j);
           delete *j;
           m_networkRoutes.erase (j);
           NS_LOG_LOGIC ("Done removing network route " << index << "; network route remaining size = " << m_networkRoutes.size ());
@@ -352,6 +545,8 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
       if (tmp == index)
         {
           NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_ASexternalRoutes.size ());
+          InvalidateCache ();
+          m_ASexternalTrie.Remove (*k);
           delete *k;
           m_ASexternalRoutes.erase (k);
           NS_LOG_LOGIC ("Done removing network route " << index << "; network route remaining size = " << m_networkRoutes.size ());
@@ -374,6 +569,11 @@ void
 Ipv4GlobalRouting::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  m_hostTrie.Clear ();
+  m_networkTrie.Clear ();
+  m_ASexternalTrie.Clear ();
+  m_ecmpGroups.clear ();
+  m_flowlets.clear ();
   for (HostRoutesI i = m_hostRoutes.begin (); 
        i != m_hostRoutes.end (); 
        i = m_hostRoutes.erase (i)) 
@@ -468,7 +668,8 @@ Ipv4GlobalRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<Net
 // See if this is a unicast packet we have a route for.
 //
   NS_LOG_LOGIC ("Unicast destination- looking up");
-  Ptr<Ipv4Route> rtentry = LookupGlobal (header.GetDestination (), oif);
+  uint32_t flowHash = IsFlowHashUsed () ? GetFlowHash (0, header) : 0;
+  Ptr<Ipv4Route> rtentry = LookupGlobal (header.GetDestination (), oif, flowHash, p);
   if (rtentry)
     {
       sockerr = Socket::ERROR_NOTERROR;
@@ -517,7 +718,8 @@ Ipv4GlobalRouting::RouteInput  (Ptr<const Packet> p, const Ipv4Header &header, P
     }
   // Next, try to find a route
   NS_LOG_LOGIC ("Unicast destination- looking up global route");
-  Ptr<Ipv4Route> rtentry = LookupGlobal (header.GetDestination ());
+  uint32_t flowHash = IsFlowHashUsed () ? GetFlowHash (p, header) : 0;
+  Ptr<Ipv4Route> rtentry = LookupGlobal (header.GetDestination (), 0, flowHash, p);
   if (rtentry != 0)
     {
       NS_LOG_LOGIC ("Found unicast destination- calling unicast callback");
@@ -537,9 +739,7 @@ Ipv4GlobalRouting::NotifyInterfaceUp (uint32_t i)
   NS_LOG_FUNCTION (this << i);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::UpdateGlobalRoutes ();
     }
 }
 
@@ -549,9 +749,7 @@ Ipv4GlobalRouting::NotifyInterfaceDown (uint32_t i)
   NS_LOG_FUNCTION (this << i);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::UpdateGlobalRoutes ();
     }
 }
 
@@ -561,9 +759,7 @@ Ipv4GlobalRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress ad
   NS_LOG_FUNCTION (this << interface << address);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::UpdateGlobalRoutes ();
     }
 }
 
@@ -573,9 +769,7 @@ Ipv4GlobalRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress
   NS_LOG_FUNCTION (this << interface << address);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::UpdateGlobalRoutes ();
     }
 }
 
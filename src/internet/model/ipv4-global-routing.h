@@ -21,13 +21,18 @@
 #define IPV4_GLOBAL_ROUTING_H
 
 #include <list>
+#include <map>
+#include <vector>
 #include <stdint.h>
+#include "ns3/sgi-hashmap.h"
+#include "ns3/nstime.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv4-header.h"
 #include "ns3/ptr.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/ipv4-route-trie.h"
 
 namespace ns3 {
 
@@ -65,6 +70,31 @@ class Node;
  *
  * This class deals with Ipv4 unicast routes only.
  *
+ * When several routes of equal cost lead to a destination, the route
+ * used by each packet depends on the EcmpMode attribute:
+ *  - ECMP_NONE always uses the first route;
+ *  - ECMP_RANDOM picks a route at random for every packet, which
+ *    reorders the packets of a flow;
+ *  - ECMP_FLOW_HASH picks a route from a hash of the addresses, the
+ *    protocol and, for the forwarded TCP and UDP packets that are not
+ *    fragments, the ports, so that a flow keeps its route;
+ *  - ECMP_FLOWLET picks the route with the fewest bytes sent at the
+ *    start of every flowlet, i.e., whenever a flow has been idle for
+ *    longer than FlowletTimeout, and keeps it until the next gap.
+ *
+ * The packets routed by RouteOutput () are hashed without their ports,
+ * since the transport header is not always added to the packet at this
+ * point.  Routers using the same EcmpHashSeed make the same choices for
+ * a flow; giving each router its own seed avoids the polarization of the
+ * traffic on the same routes at every stage of a multi-stage topology.
+ *
+ * The routes to the destinations recently looked up are cached with
+ * their next hops, so that a packet to a destination reached by a large
+ * group of routes does not walk the routing table; the cache is cleared
+ * whenever a route is added or removed.  The packets and bytes routed
+ * to each next hop are counted, see GetNextHopPackets () and
+ * GetNextHopBytes ().
+ *
  * \see Ipv4RoutingProtocol
  * \see GlobalRouteManager
  */
@@ -76,6 +106,18 @@ public:
    * \return the object TypeId
    */
   static TypeId GetTypeId (void);
+
+  /**
+   * \brief The choice of a route among several routes of equal cost
+   */
+  enum EcmpMode
+  {
+    ECMP_NONE,       //!< Always use the first route
+    ECMP_RANDOM,     //!< Pick a route at random for every packet
+    ECMP_FLOW_HASH,  //!< Pick a route from a hash of the flow
+    ECMP_FLOWLET     //!< Pick the least loaded route at the start of every flowlet
+  };
+
   /**
    * \brief Construct an empty Ipv4GlobalRouting routing protocol,
    *
@@ -228,6 +270,22 @@ public:
    */
   int64_t AssignStreams (int64_t stream);
 
+  /**
+   * \brief Get the number of packets routed to a next hop.
+   * \param interface the interface of the next hop
+   * \param gateway the gateway of the next hop, or 0.0.0.0 for a destination on-link
+   * \return the number of packets routed since the creation of this object
+   */
+  uint64_t GetNextHopPackets (uint32_t interface, Ipv4Address gateway) const;
+
+  /**
+   * \brief Get the number of bytes routed to a next hop.
+   * \param interface the interface of the next hop
+   * \param gateway the gateway of the next hop, or 0.0.0.0 for a destination on-link
+   * \return the number of bytes routed since the creation of this object, without the IPv4 headers
+   */
+  uint64_t GetNextHopBytes (uint32_t interface, Ipv4Address gateway) const;
+
 protected:
   void DoDispose (void);
 
@@ -238,6 +296,12 @@ private:
   bool m_respondToInterfaceEvents;
   /// A uniform random number generator for randomly routing packets among ECMP 
   Ptr<UniformRandomVariable> m_rand;
+  /// The choice of a route among several routes of equal cost
+  EcmpMode m_ecmpMode;
+  /// The seed of the flow hash
+  uint32_t m_ecmpHashSeed;
+  /// The idle time after which a flow may move to another route
+  Time m_flowletTimeout;
 
   /// container of Ipv4RoutingTableEntry (routes to hosts)
   typedef std::list<Ipv4RoutingTableEntry *> HostRoutes;
@@ -260,18 +324,98 @@ private:
   /// iterator of container of Ipv4RoutingTableEntry (routes to external AS)
   typedef std::list<Ipv4RoutingTableEntry *>::iterator ASExternalRoutesI;
 
+  /**
+   * \brief The packets and bytes routed to a next hop
+   */
+  struct NextHopLoad
+  {
+    uint64_t m_packets;   //!< Number of packets
+    uint64_t m_bytes;     //!< Number of bytes, without the IPv4 headers
+  };
+
+  /// container of NextHopLoad, by interface and gateway
+  typedef std::map<std::pair<uint32_t, Ipv4Address>, NextHopLoad> NextHopLoads;
+
+  /**
+   * \brief The routes to a destination, with the load of their next hops
+   */
+  struct EcmpGroup
+  {
+    std::vector<Ipv4RoutingTableEntry *> m_routes; //!< Routes, in routing table order
+    std::vector<NextHopLoad *> m_loads;            //!< Load of the next hop of each route
+  };
+
+  /// container of EcmpGroup, by destination
+  typedef sgi::hash_map<Ipv4Address, EcmpGroup, Ipv4AddressHash> EcmpGroups;
+
+  /**
+   * \brief The route of the current flowlet of the flows sharing a hash slot
+   */
+  struct Flowlet
+  {
+    Time m_lastSeen;   //!< Time of the last packet
+    uint32_t m_index;  //!< Index of the route in the group
+  };
+
   /**
    * \brief Lookup in the forwarding table for destination.
    * \param dest destination address
    * \param oif output interface if any (put 0 otherwise)
+   * \param flowHash hash of the flow of the packet
+   * \param p the packet routed, or 0 if no packet is sent
    * \return Ipv4Route to route the packet to reach dest address
    */
-  Ptr<Ipv4Route> LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif = 0);
+  Ptr<Ipv4Route> LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif = 0,
+                               uint32_t flowHash = 0, Ptr<const Packet> p = 0);
+
+  /**
+   * \brief Find the routes to a destination.
+   * \param dest destination address
+   * \param oif output interface if any (put 0 otherwise)
+   * \param group [out] the routes found, with the load of their next hops
+   */
+  void FindRoutes (Ipv4Address dest, Ptr<NetDevice> oif, EcmpGroup &group);
+
+  /**
+   * \brief Choose one of the routes of a group.
+   * \param group the routes, at least one
+   * \param flowHash hash of the flow of the packet
+   * \return the index of the route in the group
+   */
+  uint32_t SelectRoute (const EcmpGroup &group, uint32_t flowHash);
+
+  /**
+   * \brief Check if the route selection uses the flow hash.
+   * \return true in the FlowHash and Flowlet modes
+   */
+  bool IsFlowHashUsed (void) const;
+
+  /**
+   * \brief Hash the flow of a packet.
+   * \param p the packet, starting with the transport header, or 0
+   * \param header the IPv4 header of the packet
+   * \return the hash of the addresses, the protocol and, if the packet
+   * is a TCP or UDP packet which is not a fragment, the ports
+   */
+  uint32_t GetFlowHash (Ptr<const Packet> p, const Ipv4Header &header) const;
+
+  /**
+   * \brief Clear the cache of the routes, after a change of the routing table.
+   */
+  void InvalidateCache (void);
 
   HostRoutes m_hostRoutes;             //!< Routes to hosts
   NetworkRoutes m_networkRoutes;       //!< Routes to networks
   ASExternalRoutes m_ASexternalRoutes; //!< External routes imported
 
+  Ipv4RouteTrie m_hostTrie;            //!< Index of m_hostRoutes by destination
+  Ipv4RouteTrie m_networkTrie;         //!< Index of m_networkRoutes by destination
+  Ipv4RouteTrie m_ASexternalTrie;      //!< Index of m_ASexternalRoutes by destination
+
+  EcmpGroups m_ecmpGroups;             //!< Cache of the routes to the destinations looked up
+  NextHopLoads m_nextHopLoads;         //!< Packets and bytes routed to each next hop
+  std::vector<Flowlet> m_flowlets;     //!< Current flowlets, by flow hash
+
   Ptr<Ipv4> m_ipv4; //!< associated IPv4 instance
 };
 
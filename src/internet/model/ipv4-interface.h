@@ -25,6 +25,7 @@
 #include <list>
 #include "ns3/ptr.h"
 #include "ns3/object.h"
+#include "ns3/callback.h"
 
 namespace ns3 {
 
@@ -188,6 +189,14 @@ public:
    */
   Ipv4InterfaceAddress RemoveAddress (Ipv4Address address);
 
+  /**
+   * \brief Set the callback invoked after an address is added or removed.
+   *
+   * Ipv4L3Protocol uses it to keep its address index up to date.
+   * \param callback the callback
+   */
+  void SetAddressChangeCallback (Callback<void> callback);
+
 protected:
   virtual void DoDispose (void);
 private:
@@ -239,6 +248,7 @@ private:
   Ptr<NetDevice> m_device; //!< The associated NetDevice
   Ptr<TrafficControlLayer> m_tc; //!< The associated TrafficControlLayer
   Ptr<ArpCache> m_cache; //!< ARP cache
+  Callback<void> m_addressChangeCallback; //!< Called after an address is added or removed
 };
 
 } // namespace ns3
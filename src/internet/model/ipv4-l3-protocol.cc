@@ -33,6 +33,7 @@
 #include "ns3/boolean.h"
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/traffic-control-layer.h"
+#include "ns3/tso-tag.h"
 
 #include "loopback-net-device.h"
 #include "arp-l3-protocol.h"
@@ -48,6 +49,15 @@ NS_LOG_COMPONENT_DEFINE ("Ipv4L3Protocol");
 
 const uint16_t Ipv4L3Protocol::PROT_NUMBER = 0x0800;
 
+/**
+ * \brief Number of bits of the hash indexing the identification counters.
+ *
+ * The {src, dst, proto} tuples share 2^10 counters, as in the Linux
+ * ip_idents table, so that the memory used does not grow with the number
+ * of peers.  Tuples sharing a counter still get increasing identifications.
+ */
+static const uint32_t IDENTIFICATION_HASH_BITS = 10;
+
 NS_OBJECT_ENSURE_REGISTERED (Ipv4L3Protocol);
 
 TypeId 
@@ -297,6 +307,8 @@ Ipv4L3Protocol::DoDispose (void)
     }
   m_interfaces.clear ();
   m_reverseInterfacesContainer.clear ();
+  m_localAddresses.clear ();
+  m_broadcastAddresses.clear ();
 
   m_sockets.clear ();
   m_node = 0;
@@ -307,16 +319,10 @@ Ipv4L3Protocol::DoDispose (void)
       it->second = 0;
     }
 
-  for (MapFragmentsTimers_t::iterator it = m_fragmentsTimers.begin (); it != m_fragmentsTimers.end (); it++)
-    {
-      if (it->second.IsRunning ())
-        {
-          it->second.Cancel ();
-        }
-    }
-
+  m_fragmentsTimer.Cancel ();
   m_fragments.clear ();
-  m_fragmentsTimers.clear ();
+  m_fragmentsExpiry.clear ();
+  m_identification.clear ();
 
   Object::DoDispose ();
 }
@@ -399,9 +405,32 @@ Ipv4L3Protocol::AddIpv4Interface (Ptr<Ipv4Interface>interface)
   uint32_t index = m_interfaces.size ();
   m_interfaces.push_back (interface);
   m_reverseInterfacesContainer[interface->GetDevice ()] = index;
+  interface->SetAddressChangeCallback (MakeCallback (&Ipv4L3Protocol::IndexAddresses, this));
+  IndexAddresses ();
   return index;
 }
 
+void
+Ipv4L3Protocol::IndexAddresses (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_localAddresses.clear ();
+  m_broadcastAddresses.clear ();
+  for (uint32_t i = 0; i < m_interfaces.size (); i++)
+    {
+      for (uint32_t j = 0; j < m_interfaces[i]->GetNAddresses (); j++)
+        {
+          // insert () keeps the first interface using an address
+          Ipv4InterfaceAddress ifAddr = m_interfaces[i]->GetAddress (j);
+          m_localAddresses.insert (std::make_pair (ifAddr.GetLocal (), i));
+          if (ifAddr.GetMask () != Ipv4Mask::GetOnes ())
+            {
+              m_broadcastAddresses.insert (std::make_pair (ifAddr.GetBroadcast (), i));
+            }
+        }
+    }
+}
+
 Ptr<Ipv4Interface>
 Ipv4L3Protocol::GetInterface (uint32_t index) const
 {
@@ -425,18 +454,10 @@ Ipv4L3Protocol::GetInterfaceForAddress (
   Ipv4Address address) const
 {
   NS_LOG_FUNCTION (this << address);
-  int32_t interface = 0;
-  for (Ipv4InterfaceList::const_iterator i = m_interfaces.begin (); 
-       i != m_interfaces.end (); 
-       i++, interface++)
+  Ipv4AddressIndex::const_iterator it = m_localAddresses.find (address);
+  if (it != m_localAddresses.end ())
     {
-      for (uint32_t j = 0; j < (*i)->GetNAddresses (); j++)
-        {
-          if ((*i)->GetAddress (j).GetLocal () == address)
-            {
-              return interface;
-            }
-        }
+      return it->second;
     }
 
   return -1;
@@ -465,6 +486,12 @@ Ipv4L3Protocol::GetInterfaceForPrefix (
   return -1;
 }
 
+size_t
+Ipv4L3Protocol::NetDeviceHash::operator() (Ptr<const NetDevice> device) const
+{
+  return reinterpret_cast<size_t> (PeekPointer (device)) / sizeof (void *);
+}
+
 int32_t 
 Ipv4L3Protocol::GetInterfaceForDevice (
   Ptr<const NetDevice> device) const
@@ -520,24 +547,16 @@ Ipv4L3Protocol::IsDestinationAddress (Ipv4Address address, uint32_t iif) const
 
   if (GetWeakEsModel ())  // Check other interfaces
     { 
-      for (uint32_t j = 0; j < GetNInterfaces (); j++)
+      if (m_localAddresses.find (address) != m_localAddresses.end ())
         {
-          if (j == uint32_t (iif)) continue;
-          for (uint32_t i = 0; i < GetNAddresses (j); i++)
-            {
-              Ipv4InterfaceAddress iaddr = GetAddress (j, i);
-              if (address == iaddr.GetLocal ())
-                {
-                  NS_LOG_LOGIC ("For me (destination " << address << " match) on another interface");
-                  return true;
-                }
-              //  This is a small corner case:  match another interface's broadcast address
-              if (address == iaddr.GetBroadcast ())
-                {
-                  NS_LOG_LOGIC ("For me (interface broadcast address on another interface)");
-                  return true;
-                }
-            }
+          NS_LOG_LOGIC ("For me (destination " << address << " match) on another interface");
+          return true;
+        }
+      //  This is a small corner case:  match another interface's broadcast address
+      if (m_broadcastAddresses.find (address) != m_broadcastAddresses.end ())
+        {
+          NS_LOG_LOGIC ("For me (interface broadcast address on another interface)");
+          return true;
         }
     }
   return false;
@@ -787,27 +806,18 @@ Ipv4L3Protocol::Send (Ptr<Packet> packet,
     }
 
   // 2) check: packet is destined to a subnet-directed broadcast address
-  uint32_t ifaceIndex = 0;
-  for (Ipv4InterfaceList::iterator ifaceIter = m_interfaces.begin ();
-       ifaceIter != m_interfaces.end (); ifaceIter++, ifaceIndex++)
+  Ipv4AddressIndex::const_iterator broadcast = m_broadcastAddresses.find (destination);
+  if (broadcast != m_broadcastAddresses.end ())
     {
-      Ptr<Ipv4Interface> outInterface = *ifaceIter;
-      for (uint32_t j = 0; j < GetNAddresses (ifaceIndex); j++)
-        {
-          Ipv4InterfaceAddress ifAddr = GetAddress (ifaceIndex, j);
-          NS_LOG_LOGIC ("Testing address " << ifAddr.GetLocal () << " with mask " << ifAddr.GetMask ());
-          if (destination.IsSubnetDirectedBroadcast (ifAddr.GetMask ()) && 
-              destination.CombineMask (ifAddr.GetMask ()) == ifAddr.GetLocal ().CombineMask (ifAddr.GetMask ())   )
-            {
-              NS_LOG_LOGIC ("Ipv4L3Protocol::Send case 2:  subnet directed bcast to " << ifAddr.GetLocal ());
-              ipHeader = BuildHeader (source, destination, protocol, packet->GetSize (), ttl, tos, mayFragment);
-              Ptr<Packet> packetCopy = packet->Copy ();
-              m_sendOutgoingTrace (ipHeader, packetCopy, ifaceIndex);
-              CallTxTrace (ipHeader, packetCopy, m_node->GetObject<Ipv4> (), ifaceIndex);
-              outInterface->Send (packetCopy, ipHeader, destination);
-              return;
-            }
-        }
+      uint32_t ifaceIndex = broadcast->second;
+      Ptr<Ipv4Interface> outInterface = m_interfaces[ifaceIndex];
+      NS_LOG_LOGIC ("Ipv4L3Protocol::Send case 2:  subnet directed bcast on interface " << ifaceIndex);
+      ipHeader = BuildHeader (source, destination, protocol, packet->GetSize (), ttl, tos, mayFragment);
+      Ptr<Packet> packetCopy = packet->Copy ();
+      m_sendOutgoingTrace (ipHeader, packetCopy, ifaceIndex);
+      CallTxTrace (ipHeader, packetCopy, m_node->GetObject<Ipv4> (), ifaceIndex);
+      outInterface->Send (packetCopy, ipHeader, destination);
+      return;
     }
 
   // 3) packet is not broadcast, and is passed in with a route entry
@@ -882,13 +892,18 @@ Ipv4L3Protocol::BuildHeader (
   uint64_t src = source.Get ();
   uint64_t dst = destination.Get ();
   uint64_t srcDst = dst | (src << 32);
-  std::pair<uint64_t, uint8_t> key = std::make_pair (srcDst, protocol);
+  uint64_t hash = (srcDst ^ (uint64_t (protocol) << 56)) * UINT64_C (0x9e3779b97f4a7c15);
+  if (m_identification.empty ())
+    {
+      m_identification.resize (1 << IDENTIFICATION_HASH_BITS, 0);
+    }
+  uint16_t &identification = m_identification[hash >> (64 - IDENTIFICATION_HASH_BITS)];
 
   if (mayFragment == true)
     {
       ipHeader.SetMayFragment ();
-      ipHeader.SetIdentification (m_identification[key]);
-      m_identification[key]++;
+      ipHeader.SetIdentification (identification);
+      identification++;
     }
   else
     {
@@ -897,8 +912,8 @@ Ipv4L3Protocol::BuildHeader (
       // identification requirement:
       // >> Originating sources MAY set the IPv4 ID field of atomic datagrams
       //    to any value.
-      ipHeader.SetIdentification (m_identification[key]);
-      m_identification[key]++;
+      ipHeader.SetIdentification (identification);
+      identification++;
     }
   if (Node::ChecksumEnabled ())
     {
@@ -925,12 +940,17 @@ Ipv4L3Protocol::SendRealOut (Ptr<Ipv4Route> route,
   Ptr<Ipv4Interface> outInterface = GetInterface (interface);
   NS_LOG_LOGIC ("Send via NetDevice ifIndex " << outDev->GetIfIndex () << " ipv4InterfaceIndex " << interface);
 
+  // Super-segments are not fragmented: the devices send them as the
+  // frames they stand for
+  TsoTag tso;
+  bool offload = packet->PeekPacketTag (tso);
+
   if (!route->GetGateway ().IsEqual (Ipv4Address ("0.0.0.0")))
     {
       if (outInterface->IsUp ())
         {
           NS_LOG_LOGIC ("Send to gateway " << route->GetGateway ());
-          if ( packet->GetSize () + ipHeader.GetSerializedSize () > outInterface->GetDevice ()->GetMtu () )
+          if (!offload && packet->GetSize () + ipHeader.GetSerializedSize () > outInterface->GetDevice ()->GetMtu ())
             {
               std::list<Ipv4PayloadHeaderPair> listFragments;
               DoFragmentation (packet, ipHeader, outInterface->GetDevice ()->GetMtu (), listFragments);
@@ -957,7 +977,7 @@ Ipv4L3Protocol::SendRealOut (Ptr<Ipv4Route> route,
       if (outInterface->IsUp ())
         {
           NS_LOG_LOGIC ("Send to destination " << ipHeader.GetDestination ());
-          if ( packet->GetSize () + ipHeader.GetSerializedSize () > outInterface->GetDevice ()->GetMtu () )
+          if (!offload && packet->GetSize () + ipHeader.GetSerializedSize () > outInterface->GetDevice ()->GetMtu ())
             {
               std::list<Ipv4PayloadHeaderPair> listFragments;
               DoFragmentation (packet, ipHeader, outInterface->GetDevice ()->GetMtu (), listFragments);
@@ -1489,6 +1509,14 @@ Ipv4L3Protocol::DoFragmentation (Ptr<Packet> packet, const Ipv4Header & ipv4Head
   return;
 }
 
+size_t
+Ipv4L3Protocol::FragmentKeyHash::operator() (const FragmentKey_t &key) const
+{
+  uint64_t hash = key.first * UINT64_C (0x9e3779b97f4a7c15);
+  hash ^= (hash >> 32) + key.second * UINT64_C (0xc2b2ae3d27d4eb4f);
+  return static_cast<size_t> (hash ^ (hash >> 29));
+}
+
 bool
 Ipv4L3Protocol::ProcessFragment (Ptr<Packet>& packet, Ipv4Header& ipHeader, uint32_t iif)
 {
@@ -1496,7 +1524,7 @@ Ipv4L3Protocol::ProcessFragment (Ptr<Packet>& packet, Ipv4Header& ipHeader, uint
 
   uint64_t addressCombination = uint64_t (ipHeader.GetSource ().Get ()) << 32 | uint64_t (ipHeader.GetDestination ().Get ());
   uint32_t idProto = uint32_t (ipHeader.GetIdentification ()) << 16 | uint32_t (ipHeader.GetProtocol ());
-  std::pair<uint64_t, uint32_t> key;
+  FragmentKey_t key;
   bool ret = false;
   Ptr<Packet> p = packet->Copy ();
 
@@ -1510,9 +1538,33 @@ Ipv4L3Protocol::ProcessFragment (Ptr<Packet>& packet, Ipv4Header& ipHeader, uint
     {
       fragments = Create<Fragments> ();
       m_fragments.insert (std::make_pair (key, fragments));
-      m_fragmentsTimers[key] = Simulator::Schedule (m_fragmentExpirationTimeout,
-                                                    &Ipv4L3Protocol::HandleFragmentsTimeout, this,
-                                                    key, ipHeader, iif);
+
+      // The timeout rarely changes: the new packet expires last, and only
+      // the timer of the first packet in the list needs to be running.
+      FragmentsExpiry expiry;
+      expiry.m_expiration = Simulator::Now () + m_fragmentExpirationTimeout;
+      expiry.m_key = key;
+      expiry.m_ipHeader = ipHeader;
+      expiry.m_iif = iif;
+      FragmentsExpiryList_t::iterator pos = m_fragmentsExpiry.end ();
+      while (pos != m_fragmentsExpiry.begin ())
+        {
+          FragmentsExpiryList_t::iterator prev = pos;
+          prev--;
+          if (prev->m_expiration <= expiry.m_expiration)
+            {
+              break;
+            }
+          pos = prev;
+        }
+      pos = m_fragmentsExpiry.insert (pos, expiry);
+      fragments->SetExpiry (pos);
+      if (pos == m_fragmentsExpiry.begin ())
+        {
+          m_fragmentsTimer.Cancel ();
+          m_fragmentsTimer = Simulator::Schedule (m_fragmentExpirationTimeout,
+                                                  &Ipv4L3Protocol::ExpireFragments, this);
+        }
     }
   else
     {
@@ -1526,14 +1578,11 @@ Ipv4L3Protocol::ProcessFragment (Ptr<Packet>& packet, Ipv4Header& ipHeader, uint
   if ( fragments->IsEntire () )
     {
       packet = fragments->GetPacket ();
+      // the timer is left running if the packet was the first to expire,
+      // ExpireFragments () then rearms it for the next one
+      m_fragmentsExpiry.erase (fragments->GetExpiry ());
       fragments = 0;
       m_fragments.erase (key);
-      if (m_fragmentsTimers[key].IsRunning ())
-        {
-          NS_LOG_LOGIC ("Stopping WaitFragmentsTimer at " << Simulator::Now ().GetSeconds () << " due to complete packet");
-          m_fragmentsTimers[key].Cancel ();
-        }
-      m_fragmentsTimers.erase (key);
       ret = true;
     }
 
@@ -1556,22 +1605,35 @@ Ipv4L3Protocol::Fragments::AddFragment (Ptr<Packet> fragment, uint16_t fragmentO
 {
   NS_LOG_FUNCTION (this << fragment << fragmentOffset << moreFragment);
 
-  std::list<std::pair<Ptr<Packet>, uint16_t> >::iterator it;
+  std::multimap<uint16_t, Ptr<Packet> >::iterator it = m_fragments.upper_bound (fragmentOffset);
+
+  if (it == m_fragments.end ())
+    {
+      m_moreFragment = moreFragment;
+    }
+
+  m_fragments.insert (it, std::make_pair (fragmentOffset, fragment));
 
-  for (it = m_fragments.begin (); it != m_fragments.end (); it++)
+  // merge the byte range of the fragment with the ranges it overlaps or touches
+  uint32_t start = fragmentOffset;
+  uint32_t end = start + fragment->GetSize ();
+  std::map<uint32_t, uint32_t>::iterator interval = m_intervals.upper_bound (start);
+  if (interval != m_intervals.begin ())
     {
-      if (it->second > fragmentOffset)
+      std::map<uint32_t, uint32_t>::iterator previous = interval;
+      previous--;
+      if (previous->second >= start)
         {
-          break;
+          start = previous->first;
+          interval = previous;
         }
     }
-
-  if (it == m_fragments.end ())
+  while (interval != m_intervals.end () && interval->first <= end)
     {
-      m_moreFragment = moreFragment;
+      end = std::max (end, interval->second);
+      m_intervals.erase (interval++);
     }
-
-  m_fragments.insert (it, std::pair<Ptr<Packet>, uint16_t> (fragment, fragmentOffset));
+  m_intervals[start] = end;
 }
 
 bool
@@ -1579,29 +1641,8 @@ Ipv4L3Protocol::Fragments::IsEntire () const
 {
   NS_LOG_FUNCTION (this);
 
-  bool ret = !m_moreFragment && m_fragments.size () > 0;
-
-  if (ret)
-    {
-      uint16_t lastEndOffset = 0;
-
-      for (std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_fragments.begin (); it != m_fragments.end (); it++)
-        {
-          // overlapping fragments do exist
-          NS_LOG_LOGIC ("Checking overlaps " << lastEndOffset << " - " << it->second );
-
-          if (lastEndOffset < it->second)
-            {
-              ret = false;
-              break;
-            }
-          // fragments might overlap in strange ways
-          uint16_t fragmentEnd = it->first->GetSize () + it->second;
-          lastEndOffset = std::max ( lastEndOffset, fragmentEnd );
-        }
-    }
-
-  return ret;
+  // overlapping fragments do exist, and are merged in the intervals
+  return !m_moreFragment && m_intervals.size () == 1 && m_intervals.begin ()->first == 0;
 }
 
 Ptr<Packet>
@@ -1609,32 +1650,32 @@ Ipv4L3Protocol::Fragments::GetPacket () const
 {
   NS_LOG_FUNCTION (this);
 
-  std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_fragments.begin ();
+  std::multimap<uint16_t, Ptr<Packet> >::const_iterator it = m_fragments.begin ();
 
-  Ptr<Packet> p = it->first->Copy ();
+  Ptr<Packet> p = it->second->Copy ();
   uint16_t lastEndOffset = p->GetSize ();
   it++;
 
   for ( ; it != m_fragments.end (); it++)
     {
-      if ( lastEndOffset > it->second )
+      if ( lastEndOffset > it->first )
         {
           // The fragments are overlapping.
           // We do not overwrite the "old" with the "new" because we do not know when each arrived.
           // This is different from what Linux does.
           // It is not possible to emulate a fragmentation attack.
-          uint32_t newStart = lastEndOffset - it->second;
-          if ( it->first->GetSize () > newStart )
+          uint32_t newStart = lastEndOffset - it->first;
+          if ( it->second->GetSize () > newStart )
             {
-              uint32_t newSize = it->first->GetSize () - newStart;
-              Ptr<Packet> tempFragment = it->first->CreateFragment (newStart, newSize);
+              uint32_t newSize = it->second->GetSize () - newStart;
+              Ptr<Packet> tempFragment = it->second->CreateFragment (newStart, newSize);
               p->AddAtEnd (tempFragment);
             }
         }
       else
         {
-          NS_LOG_LOGIC ("Adding: " << *(it->first) );
-          p->AddAtEnd (it->first);
+          NS_LOG_LOGIC ("Adding: " << *(it->second) );
+          p->AddAtEnd (it->second);
         }
       lastEndOffset = p->GetSize ();
     }
@@ -1646,30 +1687,25 @@ Ptr<Packet>
 Ipv4L3Protocol::Fragments::GetPartialPacket () const
 {
   NS_LOG_FUNCTION (this);
-  
-  std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_fragments.begin ();
 
   Ptr<Packet> p = Create<Packet> ();
   uint16_t lastEndOffset = 0;
 
-  if ( m_fragments.begin ()->second > 0 )
+  if ( m_fragments.begin ()->first > 0 )
     {
       return p;
     }
 
-  for ( it = m_fragments.begin (); it != m_fragments.end (); it++)
+  // the fragments up to the first hole
+  for (std::multimap<uint16_t, Ptr<Packet> >::const_iterator it = m_fragments.begin ();
+       it != m_fragments.end () && it->first <= lastEndOffset; it++)
     {
-      if ( lastEndOffset > it->second )
-        {
-          uint32_t newStart = lastEndOffset - it->second;
-          uint32_t newSize = it->first->GetSize () - newStart;
-          Ptr<Packet> tempFragment = it->first->CreateFragment (newStart, newSize);
-          p->AddAtEnd (tempFragment);
-        }
-      else if ( lastEndOffset == it->second )
+      uint32_t newStart = lastEndOffset - it->first;
+      if ( it->second->GetSize () > newStart )
         {
-          NS_LOG_LOGIC ("Adding: " << *(it->first) );
-          p->AddAtEnd (it->first);
+          NS_LOG_LOGIC ("Adding: " << *(it->second) );
+          uint32_t newSize = it->second->GetSize () - newStart;
+          p->AddAtEnd (it->second->CreateFragment (newStart, newSize));
         }
       lastEndOffset = p->GetSize ();
     }
@@ -1678,7 +1714,21 @@ Ipv4L3Protocol::Fragments::GetPartialPacket () const
 }
 
 void
-Ipv4L3Protocol::HandleFragmentsTimeout (std::pair<uint64_t, uint32_t> key, Ipv4Header & ipHeader, uint32_t iif)
+Ipv4L3Protocol::Fragments::SetExpiry (FragmentsExpiryList_t::iterator expiry)
+{
+  NS_LOG_FUNCTION (this);
+  m_expiry = expiry;
+}
+
+Ipv4L3Protocol::FragmentsExpiryList_t::iterator
+Ipv4L3Protocol::Fragments::GetExpiry () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_expiry;
+}
+
+void
+Ipv4L3Protocol::HandleFragmentsTimeout (FragmentKey_t key, Ipv4Header & ipHeader, uint32_t iif)
 {
   NS_LOG_FUNCTION (this << &key << &ipHeader << iif);
 
@@ -1697,6 +1747,25 @@ Ipv4L3Protocol::HandleFragmentsTimeout (std::pair<uint64_t, uint32_t> key, Ipv4H
   it->second = 0;
 
   m_fragments.erase (key);
-  m_fragmentsTimers.erase (key);
+}
+
+void
+Ipv4L3Protocol::ExpireFragments (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Time now = Simulator::Now ();
+  while (!m_fragmentsExpiry.empty () && m_fragmentsExpiry.front ().m_expiration <= now)
+    {
+      FragmentsExpiry expiry = m_fragmentsExpiry.front ();
+      m_fragmentsExpiry.pop_front ();
+      HandleFragmentsTimeout (expiry.m_key, expiry.m_ipHeader, expiry.m_iif);
+    }
+
+  if (!m_fragmentsExpiry.empty ())
+    {
+      m_fragmentsTimer = Simulator::Schedule (m_fragmentsExpiry.front ().m_expiration - now,
+                                              &Ipv4L3Protocol::ExpireFragments, this);
+    }
 }
 } // namespace ns3
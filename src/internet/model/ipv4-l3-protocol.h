@@ -34,6 +34,7 @@
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/nstime.h"
 #include "ns3/simulator.h"
+#include "ns3/sgi-hashmap.h"
 
 class Ipv4L3ProtocolTestCase;
 
@@ -405,6 +406,9 @@ private:
    */
   void DoFragmentation (Ptr<Packet> packet, const Ipv4Header& ipv4Header, uint32_t outIfaceMtu, std::list<Ipv4PayloadHeaderPair>& listFragments);
 
+  /// Key identifying a fragmented packet: (src addr, dst addr) and (identification, protocol)
+  typedef std::pair<uint64_t, uint32_t> FragmentKey_t;
+
   /**
    * \brief Process a packet fragment
    * \param packet the packet
@@ -420,7 +424,13 @@ private:
    * \param ipHeader the IP header of the original packet
    * \param iif Input Interface
    */
-  void HandleFragmentsTimeout ( std::pair<uint64_t, uint32_t> key, Ipv4Header & ipHeader, uint32_t iif);
+  void HandleFragmentsTimeout (FragmentKey_t key, Ipv4Header & ipHeader, uint32_t iif);
+
+  /**
+   * \brief Handle the fragments whose reassembly timer expired, and
+   * arm the timer for the next ones.
+   */
+  void ExpireFragments (void);
 
   /**
    * \brief Make a copy of the packet, add the header and invoke the TX trace callback
@@ -434,14 +444,36 @@ private:
    */
   void CallTxTrace (const Ipv4Header & ipHeader, Ptr<Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
 
+  /**
+   * \brief Rebuild the indices of the local and broadcast addresses,
+   * after an address is added to or removed from an interface.
+   */
+  void IndexAddresses (void);
+
   /**
    * \brief Container of the IPv4 Interfaces.
    */
   typedef std::vector<Ptr<Ipv4Interface> > Ipv4InterfaceList;
+  /**
+   * \brief Hash function class for NetDevices.
+   */
+  struct NetDeviceHash
+  {
+    /**
+     * \brief Returns the hash of a NetDevice.
+     * \param device the NetDevice
+     * \return the hash
+     */
+    size_t operator() (Ptr<const NetDevice> device) const;
+  };
   /**
    * \brief Container of NetDevices registered to IPv4 and their interface indexes.
    */
-  typedef std::map<Ptr<const NetDevice>, uint32_t > Ipv4InterfaceReverseContainer;
+  typedef sgi::hash_map<Ptr<const NetDevice>, uint32_t, NetDeviceHash> Ipv4InterfaceReverseContainer;
+  /**
+   * \brief Container of addresses and the index of the first interface using them.
+   */
+  typedef sgi::hash_map<Ipv4Address, uint32_t, Ipv4AddressHash> Ipv4AddressIndex;
   /**
    * \brief Container of the IPv4 Raw Sockets.
    */
@@ -462,8 +494,10 @@ private:
   L4List_t m_protocols;  //!< List of transport protocol.
   Ipv4InterfaceList m_interfaces; //!< List of IPv4 interfaces.
   Ipv4InterfaceReverseContainer m_reverseInterfacesContainer; //!< Container of NetDevice / Interface index associations.
+  Ipv4AddressIndex m_localAddresses; //!< Interface of each local address.
+  Ipv4AddressIndex m_broadcastAddresses; //!< Interface of each subnet-directed broadcast address.
   uint8_t m_defaultTtl;  //!< Default TTL
-  std::map<std::pair<uint64_t, uint8_t>, uint16_t> m_identification; //!< Identification (for each {src, dst, proto} tuple)
+  std::vector<uint16_t> m_identification; //!< Identification counters, by hash of the {src, dst, proto} tuple
   Ptr<Node> m_node; //!< Node attached to stack.
 
   /// Trace of sent packets
@@ -492,6 +526,20 @@ private:
 
   SocketList m_sockets; //!< List of IPv4 raw sockets.
 
+  /**
+   * \brief A fragmented packet waiting for its reassembly timer.
+   */
+  struct FragmentsExpiry
+  {
+    Time m_expiration;      //!< Expiration time
+    FragmentKey_t m_key;    //!< Key of the fragmented packet
+    Ipv4Header m_ipHeader;  //!< Header of the first fragment received
+    uint32_t m_iif;         //!< Interface of the first fragment received
+  };
+
+  /// Fragmented packets, by increasing expiration time
+  typedef std::list<FragmentsExpiry> FragmentsExpiryList_t;
+
   /**
    * \brief A Set of Fragment belonging to the same packet (src, dst, identification and proto)
    */
@@ -534,6 +582,18 @@ public:
      */
     Ptr<Packet> GetPartialPacket () const;
 
+    /**
+     * \brief Set the position of the packet in the expiration list.
+     * \param expiry the position
+     */
+    void SetExpiry (FragmentsExpiryList_t::iterator expiry);
+
+    /**
+     * \brief Get the position of the packet in the expiration list.
+     * \return the position
+     */
+    FragmentsExpiryList_t::iterator GetExpiry () const;
+
 private:
     /**
      * \brief True if other fragments will be sent.
@@ -541,20 +601,44 @@ private:
     bool m_moreFragment;
 
     /**
-     * \brief The current fragments.
+     * \brief The current fragments, by offset, in order of arrival for
+     * the same offset.
+     */
+    std::multimap<uint16_t, Ptr<Packet> > m_fragments;
+
+    /**
+     * \brief The byte ranges received, as disjoint [start, end) intervals
+     * indexed by their start.  Intervals which touch are merged, so that
+     * the packet is entire when a single interval remains, from offset 0.
      */
-    std::list<std::pair<Ptr<Packet>, uint16_t> > m_fragments;
+    std::map<uint32_t, uint32_t> m_intervals;
 
+    /**
+     * \brief The position of the packet in the expiration list.
+     */
+    FragmentsExpiryList_t::iterator m_expiry;
+  };
+
+  /**
+   * \brief Hash function class for fragment keys.
+   */
+  struct FragmentKeyHash
+  {
+    /**
+     * \brief Returns the hash of a fragment key.
+     * \param key the key
+     * \return the hash
+     */
+    size_t operator() (const FragmentKey_t &key) const;
   };
 
-  /// Container of fragments, stored as pairs(src+dst addr, src+dst port) / fragment
-  typedef std::map< std::pair<uint64_t, uint32_t>, Ptr<Fragments> > MapFragments_t;
-  /// Container of fragment timeout event, stored as pairs(src+dst addr, src+dst port) / EventId
-  typedef std::map< std::pair<uint64_t, uint32_t>, EventId > MapFragmentsTimers_t;
+  /// Container of fragments, stored as pairs(src+dst addr, id+proto) / fragment
+  typedef sgi::hash_map<FragmentKey_t, Ptr<Fragments>, FragmentKeyHash> MapFragments_t;
 
-  MapFragments_t       m_fragments; //!< Fragmented packets.
-  Time                 m_fragmentExpirationTimeout; //!< Expiration timeout
-  MapFragmentsTimers_t m_fragmentsTimers; //!< Expiration events.
+  MapFragments_t        m_fragments; //!< Fragmented packets.
+  Time                  m_fragmentExpirationTimeout; //!< Expiration timeout
+  FragmentsExpiryList_t m_fragmentsExpiry; //!< Fragmented packets, by expiration time.
+  EventId               m_fragmentsTimer; //!< Expiration event of the first fragmented packet.
 
 };
 
@@ -0,0 +1,282 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ipv4-route-trie.h"
+#include "ipv4-routing-table-entry.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Ipv4RouteTrie");
+
+/**
+ * \param length a prefix length
+ * \return the mask of this length
+ */
+static uint32_t
+PrefixMask (uint8_t length)
+{
+  return length == 0 ? 0 : 0xffffffff << (32 - length);
+}
+
+/**
+ * \param address an address
+ * \param index a bit index, counted from the most significant bit
+ * \return the bit of the address at this index
+ */
+static uint32_t
+PrefixBit (uint32_t address, uint8_t index)
+{
+  return (address >> (31 - index)) & 1;
+}
+
+/**
+ * \param a an address
+ * \param b an address
+ * \param length the maximum length to compare
+ * \return the length of the common prefix of the two addresses, up to length
+ */
+static uint8_t
+CommonLength (uint32_t a, uint32_t b, uint8_t length)
+{
+  uint8_t common = 0;
+  uint32_t diff = a ^ b;
+  while (common < length && PrefixBit (diff, common) == 0)
+    {
+      common++;
+    }
+  return common;
+}
+
+/**
+ * \param a an entry
+ * \param b an entry
+ * \return true if a was added before b
+ */
+static bool
+AddedBefore (const Ipv4RouteTrie::Entry &a, const Ipv4RouteTrie::Entry &b)
+{
+  return a.m_order < b.m_order;
+}
+
+Ipv4RouteTrie::Ipv4RouteTrie ()
+  : m_root (0),
+    m_order (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+Ipv4RouteTrie::~Ipv4RouteTrie ()
+{
+  NS_LOG_FUNCTION (this);
+  Clear ();
+}
+
+Ipv4RouteTrie::Node *
+Ipv4RouteTrie::CreateNode (uint32_t prefix, uint8_t length)
+{
+  NS_LOG_FUNCTION (prefix << static_cast<uint32_t> (length));
+  Node *node = new Node;
+  node->m_prefix = prefix;
+  node->m_length = length;
+  node->m_child[0] = 0;
+  node->m_child[1] = 0;
+  return node;
+}
+
+void
+Ipv4RouteTrie::DeleteNode (Node *node)
+{
+  NS_LOG_FUNCTION (node);
+  if (node != 0)
+    {
+      DeleteNode (node->m_child[0]);
+      DeleteNode (node->m_child[1]);
+      delete node;
+    }
+}
+
+void
+Ipv4RouteTrie::Prune (Node **link)
+{
+  NS_LOG_FUNCTION (link);
+  Node *node = *link;
+  if (!node->m_entries.empty () || (node->m_child[0] != 0 && node->m_child[1] != 0))
+    {
+      return;
+    }
+  *link = node->m_child[0] != 0 ? node->m_child[0] : node->m_child[1];
+  delete node;
+}
+
+void
+Ipv4RouteTrie::Add (Ipv4RoutingTableEntry *route, uint32_t metric)
+{
+  NS_LOG_FUNCTION (this << route << metric);
+  Entry entry;
+  entry.m_route = route;
+  entry.m_metric = metric;
+  entry.m_order = m_order++;
+
+  uint32_t mask = route->GetDestNetworkMask ().Get ();
+  if ((~mask & (~mask + 1)) != 0)
+    {
+      NS_LOG_LOGIC ("Mask " << route->GetDestNetworkMask () << " is not a prefix");
+      m_irregular.push_back (entry);
+      return;
+    }
+  uint8_t length = route->GetDestNetworkMask ().GetPrefixLength ();
+  uint32_t prefix = route->GetDestNetwork ().Get () & mask;
+
+  Node **link = &m_root;
+  while (true)
+    {
+      Node *node = *link;
+      if (node == 0)
+        {
+          node = CreateNode (prefix, length);
+          node->m_entries.push_back (entry);
+          *link = node;
+          return;
+        }
+      uint8_t common = CommonLength (node->m_prefix, prefix, std::min (node->m_length, length));
+      if (common == node->m_length && common == length)
+        {
+          node->m_entries.push_back (entry);
+          return;
+        }
+      if (common == node->m_length)
+        {
+          link = &node->m_child[PrefixBit (prefix, common)];
+          continue;
+        }
+      //
+      // The new prefix leaves the path of this node before its end: it
+      // either is a prefix of the node, or both branch off a shorter one.
+      //
+      Node *added = CreateNode (prefix, length);
+      added->m_entries.push_back (entry);
+      if (common == length)
+        {
+          added->m_child[PrefixBit (node->m_prefix, common)] = node;
+          *link = added;
+          return;
+        }
+      Node *branch = CreateNode (prefix & PrefixMask (common), common);
+      branch->m_child[PrefixBit (node->m_prefix, common)] = node;
+      branch->m_child[PrefixBit (prefix, common)] = added;
+      *link = branch;
+      return;
+    }
+}
+
+void
+Ipv4RouteTrie::Remove (Ipv4RoutingTableEntry *route)
+{
+  NS_LOG_FUNCTION (this << route);
+  uint32_t mask = route->GetDestNetworkMask ().Get ();
+  if ((~mask & (~mask + 1)) != 0)
+    {
+      for (std::vector<Entry>::iterator i = m_irregular.begin (); i != m_irregular.end (); i++)
+        {
+          if (i->m_route == route)
+            {
+              m_irregular.erase (i);
+              return;
+            }
+        }
+      NS_ASSERT_MSG (false, "Route not found");
+      return;
+    }
+  uint8_t length = route->GetDestNetworkMask ().GetPrefixLength ();
+  uint32_t prefix = route->GetDestNetwork ().Get () & mask;
+
+  Node **parent = 0;
+  Node **link = &m_root;
+  while (*link != 0 && (*link)->m_length < length)
+    {
+      parent = link;
+      link = &(*link)->m_child[PrefixBit (prefix, (*link)->m_length)];
+    }
+  Node *node = *link;
+  NS_ASSERT_MSG (node != 0 && node->m_length == length && node->m_prefix == prefix, "Route not found");
+
+  for (std::vector<Entry>::iterator i = node->m_entries.begin (); i != node->m_entries.end (); i++)
+    {
+      if (i->m_route == route)
+        {
+          node->m_entries.erase (i);
+          Prune (link);
+          if (parent != 0)
+            {
+              Prune (parent);
+            }
+          return;
+        }
+    }
+  NS_ASSERT_MSG (false, "Route not found");
+}
+
+void
+Ipv4RouteTrie::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  DeleteNode (m_root);
+  m_root = 0;
+  m_irregular.clear ();
+}
+
+void
+Ipv4RouteTrie::Lookup (Ipv4Address dest, std::vector<Entry> &matches) const
+{
+  NS_LOG_FUNCTION (this << dest);
+  matches.clear ();
+  uint32_t address = dest.Get ();
+  bool sorted = true;
+  for (const Node *node = m_root; node != 0; )
+    {
+      if ((address & PrefixMask (node->m_length)) != node->m_prefix)
+        {
+          break;
+        }
+      if (!node->m_entries.empty ())
+        {
+          sorted = sorted && (matches.empty () || matches.back ().m_order < node->m_entries.front ().m_order);
+          matches.insert (matches.end (), node->m_entries.begin (), node->m_entries.end ());
+        }
+      if (node->m_length == 32)
+        {
+          break;
+        }
+      node = node->m_child[PrefixBit (address, node->m_length)];
+    }
+  for (std::vector<Entry>::const_iterator i = m_irregular.begin (); i != m_irregular.end (); i++)
+    {
+      if (i->m_route->GetDestNetworkMask ().IsMatch (dest, i->m_route->GetDestNetwork ()))
+        {
+          sorted = false;
+          matches.push_back (*i);
+        }
+    }
+  if (!sorted)
+    {
+      std::sort (matches.begin (), matches.end (), &AddedBefore);
+    }
+}
+
+} // namespace ns3
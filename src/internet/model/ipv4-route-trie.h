@@ -0,0 +1,136 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IPV4_ROUTE_TRIE_H
+#define IPV4_ROUTE_TRIE_H
+
+#include <stdint.h>
+#include <vector>
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+
+class Ipv4RoutingTableEntry;
+
+/**
+ * \ingroup ipv4Routing
+ *
+ * \brief An index of IPv4 unicast routes by destination prefix.
+ *
+ * The routing protocols keep their routes in lists, and the order of a
+ * list decides between routes that match a destination equally well.
+ * This index lets them find the routes matching a destination without
+ * scanning the whole list: routes are stored in a path-compressed binary
+ * trie keyed by their destination prefix, so that a lookup visits at most
+ * one node per distinct prefix length on the path to the destination.
+ *
+ * Lookup () returns every route matching the destination, in the order in
+ * which the routes were added, which is the order in which a scan of the
+ * list would have found them.  The caller then applies its own selection
+ * rules (longest prefix, metric, ECMP) to this short list.
+ *
+ * Routes whose mask is not a contiguous prefix cannot be placed in the
+ * trie; they are kept aside and checked one by one on every lookup.
+ */
+class Ipv4RouteTrie
+{
+public:
+  /**
+   * \brief A route stored in the index.
+   */
+  struct Entry
+  {
+    Ipv4RoutingTableEntry *m_route; //!< The route
+    uint32_t m_metric;              //!< Metric of the route
+    uint64_t m_order;               //!< Rank of the route in the order of addition
+  };
+
+  Ipv4RouteTrie ();
+  ~Ipv4RouteTrie ();
+
+  /**
+   * \brief Add a route.  The route must not be modified while it is
+   * in the index.
+   * \param route the route
+   * \param metric metric of the route
+   */
+  void Add (Ipv4RoutingTableEntry *route, uint32_t metric = 0);
+
+  /**
+   * \brief Remove a route previously added.
+   * \param route the route
+   */
+  void Remove (Ipv4RoutingTableEntry *route);
+
+  /**
+   * \brief Remove all the routes.
+   */
+  void Clear (void);
+
+  /**
+   * \brief Find the routes matching a destination.
+   * \param dest the destination address
+   * \param matches [out] the matching routes, in the order of addition
+   */
+  void Lookup (Ipv4Address dest, std::vector<Entry> &matches) const;
+
+private:
+  /**
+   * \brief A node of the trie: a prefix, the routes to this prefix and
+   * the subtries of the longer prefixes.
+   */
+  struct Node
+  {
+    uint32_t m_prefix;              //!< Prefix bits, zero past m_length
+    uint8_t m_length;               //!< Prefix length
+    Node *m_child[2];               //!< Subtries, by the bit following the prefix
+    std::vector<Entry> m_entries;   //!< Routes to this prefix, in the order of addition
+  };
+
+  /**
+   * \brief Create a node with no route and no child.
+   * \param prefix the prefix bits
+   * \param length the prefix length
+   * \return the node
+   */
+  static Node *CreateNode (uint32_t prefix, uint8_t length);
+
+  /**
+   * \brief Delete a subtrie.
+   * \param node the root of the subtrie
+   */
+  static void DeleteNode (Node *node);
+
+  /**
+   * \brief Unlink and delete a node which no longer holds routes, unless
+   * it still separates two subtries.
+   * \param link the pointer to the node in its parent
+   */
+  static void Prune (Node **link);
+
+  /// Copy constructor, not implemented
+  Ipv4RouteTrie (const Ipv4RouteTrie &);
+  /// Assignment operator, not implemented
+  Ipv4RouteTrie &operator= (const Ipv4RouteTrie &);
+
+  Node *m_root;                     //!< Root of the trie
+  std::vector<Entry> m_irregular;   //!< Routes with a non-contiguous mask
+  uint64_t m_order;                 //!< Rank of the next route added
+};
+
+} // namespace ns3
+
+#endif /* IPV4_ROUTE_TRIE_H */
@@ -24,6 +24,7 @@
                 << " [node " << m_ipv4->GetObject<Node> ()->GetId () << "] "; }
 
 #include <iomanip>
+#include <vector>
 #include "ns3/log.h"
 #include "ns3/names.h"
 #include "ns3/packet.h"
@@ -73,6 +74,7 @@ Ipv4StaticRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (make_pair (route,metric));
+  m_networkTrie.Add (route, metric);
 }
 
 void 
@@ -87,6 +89,7 @@ Ipv4StaticRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (make_pair (route,metric));
+  m_networkTrie.Add (route, metric);
 }
 
 void 
@@ -144,6 +147,7 @@ Ipv4StaticRouting::SetDefaultMulticastRoute (uint32_t outputInterface)
                                                         networkMask,
                                                         outputInterface);
   m_networkRoutes.push_back (make_pair (route,0));
+  m_networkTrie.Add (route, 0);
 }
 
 uint32_t 
@@ -239,55 +243,52 @@ Ipv4StaticRouting::LookupStatic (Ipv4Address dest, Ptr<NetDevice> oif)
       return rtentry;
     }
 
-
-  for (NetworkRoutesI i = m_networkRoutes.begin (); 
-       i != m_networkRoutes.end (); 
+  // The routes matching the destination, in routing table order
+  std::vector<Ipv4RouteTrie::Entry> matches;
+  m_networkTrie.Lookup (dest, matches);
+  for (std::vector<Ipv4RouteTrie::Entry>::const_iterator i = matches.begin (); 
+       i != matches.end (); 
        i++) 
     {
-      Ipv4RoutingTableEntry *j=i->first;
-      uint32_t metric =i->second;
+      Ipv4RoutingTableEntry *j=i->m_route;
+      uint32_t metric =i->m_metric;
       Ipv4Mask mask = (j)->GetDestNetworkMask ();
       uint16_t masklen = mask.GetPrefixLength ();
-      Ipv4Address entry = (j)->GetDestNetwork ();
-      NS_LOG_LOGIC ("Searching for route to " << dest << ", checking against route to " << entry << "/" << masklen);
-      if (mask.IsMatch (dest, entry)) 
+      NS_LOG_LOGIC ("Found global network route " << j << ", mask length " << masklen << ", metric " << metric);
+      if (oif != 0)
         {
-          NS_LOG_LOGIC ("Found global network route " << j << ", mask length " << masklen << ", metric " << metric);
-          if (oif != 0)
-            {
-              if (oif != m_ipv4->GetNetDevice (j->GetInterface ()))
-                {
-                  NS_LOG_LOGIC ("Not on requested interface, skipping");
-                  continue;
-                }
-            }
-          if (masklen < longest_mask) // Not interested if got shorter mask
+          if (oif != m_ipv4->GetNetDevice (j->GetInterface ()))
             {
-              NS_LOG_LOGIC ("Previous match longer, skipping");
+              NS_LOG_LOGIC ("Not on requested interface, skipping");
               continue;
             }
-          if (masklen > longest_mask) // Reset metric if longer masklen
-            {
-              shortest_metric = 0xffffffff;
-            }
-          longest_mask = masklen;
-          if (metric > shortest_metric)
-            {
-              NS_LOG_LOGIC ("Equal mask length, but previous metric shorter, skipping");
-              continue;
-            }
-          shortest_metric = metric;
-          Ipv4RoutingTableEntry* route = (j);
-          uint32_t interfaceIdx = route->GetInterface ();
-          rtentry = Create<Ipv4Route> ();
-          rtentry->SetDestination (route->GetDest ());
-          rtentry->SetSource (m_ipv4->SourceAddressSelection (interfaceIdx, route->GetDest ()));
-          rtentry->SetGateway (route->GetGateway ());
-          rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIdx));
-          if (masklen == 32)
-            {
-              break;
-            }
+        }
+      if (masklen < longest_mask) // Not interested if got shorter mask
+        {
+          NS_LOG_LOGIC ("Previous match longer, skipping");
+          continue;
+        }
+      if (masklen > longest_mask) // Reset metric if longer masklen
+        {
+          shortest_metric = 0xffffffff;
+        }
+      longest_mask = masklen;
+      if (metric > shortest_metric)
+        {
+          NS_LOG_LOGIC ("Equal mask length, but previous metric shorter, skipping");
+          continue;
+        }
+      shortest_metric = metric;
+      Ipv4RoutingTableEntry* route = (j);
+      uint32_t interfaceIdx = route->GetInterface ();
+      rtentry = Create<Ipv4Route> ();
+      rtentry->SetDestination (route->GetDest ());
+      rtentry->SetSource (m_ipv4->SourceAddressSelection (interfaceIdx, route->GetDest ()));
+      rtentry->SetGateway (route->GetGateway ());
+      rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIdx));
+      if (masklen == 32)
+        {
+          break;
         }
     }
   if (rtentry != 0)
@@ -447,6 +448,7 @@ Ipv4StaticRouting::RemoveRoute (uint32_t index)
     {
       if (tmp == index)
         {
+          m_networkTrie.Remove (j->first);
           delete j->first;
           m_networkRoutes.erase (j);
           return;
@@ -569,6 +571,7 @@ void
 Ipv4StaticRouting::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  m_networkTrie.Clear ();
   for (NetworkRoutesI j = m_networkRoutes.begin (); 
        j != m_networkRoutes.end (); 
        j = m_networkRoutes.erase (j)) 
@@ -613,6 +616,7 @@ Ipv4StaticRouting::NotifyInterfaceDown (uint32_t i)
     {
       if (it->first->GetInterface () == i)
         {
+          m_networkTrie.Remove (it->first);
           delete it->first;
           it = m_networkRoutes.erase (it);
         }
@@ -660,6 +664,7 @@ Ipv4StaticRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress
           && it->first->GetDestNetwork () == networkAddress
           && it->first->GetDestNetworkMask () == networkMask)
         {
+          m_networkTrie.Remove (it->first);
           delete it->first;
           it = m_networkRoutes.erase (it);
         }
@@ -31,6 +31,7 @@
 #include "ns3/ptr.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-route-trie.h"
 
 namespace ns3 {
 
@@ -418,6 +419,11 @@ private:
    */
   NetworkRoutes m_networkRoutes;
 
+  /**
+   * \brief the index of m_networkRoutes by destination.
+   */
+  Ipv4RouteTrie m_networkTrie;
+
   /**
    * \brief the forwarding table for multicast.
    */
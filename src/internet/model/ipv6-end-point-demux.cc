@@ -26,6 +26,25 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Ipv6EndPointDemux");
 
+bool
+Ipv6EndPointDemux::FourTuple::operator== (const FourTuple &other) const
+{
+  return m_localAddr == other.m_localAddr
+         && m_localPort == other.m_localPort
+         && m_peerAddr == other.m_peerAddr
+         && m_peerPort == other.m_peerPort;
+}
+
+size_t
+Ipv6EndPointDemux::FourTupleHash::operator() (const FourTuple &x) const
+{
+  Ipv6AddressHash addressHash;
+  size_t hash = addressHash (x.m_peerAddr);
+  hash = hash * 31 + addressHash (x.m_localAddr);
+  hash = hash * 31 + ((static_cast<uint32_t> (x.m_peerPort) << 16) | x.m_localPort);
+  return hash;
+}
+
 Ipv6EndPointDemux::Ipv6EndPointDemux ()
   : m_ephemeral (49152),
     m_portFirst (49152),
@@ -40,6 +59,7 @@ Ipv6EndPointDemux::~Ipv6EndPointDemux ()
   for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
     {
       Ipv6EndPoint *endPoint = *i;
+      endPoint->m_demux = 0;
       delete endPoint;
     }
   m_endPoints.clear ();
@@ -48,14 +68,7 @@ Ipv6EndPointDemux::~Ipv6EndPointDemux ()
 bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
 {
   NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
-    {
-      if ((*i)->GetLocalPort  () == port)
-        {
-          return true;
-        }
-    }
-  return false;
+  return m_localPorts.find (port) != m_localPorts.end ();
 }
 
 bool Ipv6EndPointDemux::LookupLocal (Ptr<NetDevice> boundNetDevice, Ipv6Address addr, uint16_t port)
@@ -83,7 +96,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate ()
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (Ipv6Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -98,7 +111,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address)
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -119,7 +132,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice, Ipv6Ad
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -129,7 +142,30 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice,
                                            Ipv6Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << boundNetDevice << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  // Only the endpoints in the same table entry can have the same four-tuple
+  EndPoints candidates;
+  if (peerAddress == Ipv6Address::GetAny () || peerPort == 0)
+    {
+      Listeners::iterator listeners = m_listeners.find (localPort);
+      if (listeners != m_listeners.end ())
+        {
+          candidates = listeners->second;
+        }
+    }
+  else
+    {
+      FourTuple key;
+      key.m_localAddr = localAddress;
+      key.m_localPort = localPort;
+      key.m_peerAddr = peerAddress;
+      key.m_peerPort = peerPort;
+      Connections::iterator connections = m_connections.find (key);
+      if (connections != m_connections.end ())
+        {
+          candidates = connections->second;
+        }
+    }
+  for (EndPointsI i = candidates.begin (); i != candidates.end (); i++)
     {
       if ((*i)->GetLocalPort () == localPort &&
           (*i)->GetLocalAddress () == localAddress &&
@@ -143,7 +179,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice,
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
 
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
 
@@ -157,6 +193,8 @@ void Ipv6EndPointDemux::DeAllocate (Ipv6EndPoint *endPoint)
     {
       if (*i == endPoint)
         {
+          Unindex (endPoint);
+          endPoint->m_demux = 0;
           delete endPoint;
           m_endPoints.erase (i);
           break;
@@ -181,7 +219,36 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
   EndPoints retval4; /* Exact match on all 4 */
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+
+  // The endpoints with a wildcard peer on this port, plus the ones with this
+  // peer and a local address which can match: the destination or Any.
+  EndPoints candidates;
+  Listeners::iterator listeners = m_listeners.find (dport);
+  if (listeners != m_listeners.end ())
+    {
+      candidates = listeners->second;
+    }
+  FourTuple key;
+  key.m_localAddr = daddr;
+  key.m_localPort = dport;
+  key.m_peerAddr = saddr;
+  key.m_peerPort = sport;
+  Connections::iterator connections = m_connections.find (key);
+  if (connections != m_connections.end ())
+    {
+      candidates.insert (candidates.end (), connections->second.begin (), connections->second.end ());
+    }
+  if (daddr != Ipv6Address::GetAny ())
+    {
+      key.m_localAddr = Ipv6Address::GetAny ();
+      connections = m_connections.find (key);
+      if (connections != m_connections.end ())
+        {
+          candidates.insert (candidates.end (), connections->second.begin (), connections->second.end ());
+        }
+    }
+
+  for (EndPointsI i = candidates.begin (); i != candidates.end (); i++)
     {
       Ipv6EndPoint* endP = *i;
 
@@ -250,16 +317,17 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
           continue;
         }
 
+      /* The peer address or port, or both, are wildcards which match */
+      bool remoteMatchesWildCard = !(remotePeerMatchesExact && remoteAddressMatchesExact);
+
       /* Now figure out which return list to add this one to */
       if (localAddressMatchesWildCard
-          && remotePeerMatchesWildCard
-          && remoteAddressMatchesWildCard)
+          && remoteMatchesWildCard)
         { /* Only local port matches exactly */
           retval1.push_back (endP);
         }
       if ((localAddressMatchesExact || (localAddressMatchesAllRouters))
-          && remotePeerMatchesWildCard
-          && remoteAddressMatchesWildCard)
+          && remoteMatchesWildCard)
         { /* Only local port and local address matches exactly */
           retval2.push_back (endP);
         }
@@ -328,6 +396,69 @@ Ipv6EndPoint* Ipv6EndPointDemux::SimpleLookup (Ipv6Address dst, uint16_t dport,
   return generic;
 }
 
+void Ipv6EndPointDemux::Insert (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  m_endPoints.push_back (endPoint);
+  endPoint->m_demux = this;
+  Index (endPoint);
+}
+
+void Ipv6EndPointDemux::Index (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  m_localPorts[endPoint->m_localPort]++;
+  if (endPoint->m_peerAddr == Ipv6Address::GetAny () || endPoint->m_peerPort == 0)
+    {
+      m_listeners[endPoint->m_localPort].push_back (endPoint);
+    }
+  else
+    {
+      FourTuple key;
+      key.m_localAddr = endPoint->m_localAddr;
+      key.m_localPort = endPoint->m_localPort;
+      key.m_peerAddr = endPoint->m_peerAddr;
+      key.m_peerPort = endPoint->m_peerPort;
+      m_connections[key].push_back (endPoint);
+    }
+}
+
+void Ipv6EndPointDemux::Unindex (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  std::map<uint16_t, uint32_t>::iterator port = m_localPorts.find (endPoint->m_localPort);
+  NS_ASSERT (port != m_localPorts.end ());
+  if (--port->second == 0)
+    {
+      m_localPorts.erase (port);
+    }
+  if (endPoint->m_peerAddr == Ipv6Address::GetAny () || endPoint->m_peerPort == 0)
+    {
+      Listeners::iterator listeners = m_listeners.find (endPoint->m_localPort);
+      NS_ASSERT (listeners != m_listeners.end ());
+      listeners->second.remove (endPoint);
+      if (listeners->second.empty ())
+        {
+          m_listeners.erase (listeners);
+        }
+    }
+  else
+    {
+      FourTuple key;
+      key.m_localAddr = endPoint->m_localAddr;
+      key.m_localPort = endPoint->m_localPort;
+      key.m_peerAddr = endPoint->m_peerAddr;
+      key.m_peerPort = endPoint->m_peerPort;
+      Connections::iterator connections = m_connections.find (key);
+      NS_ASSERT (connections != m_connections.end ());
+      connections->second.remove (endPoint);
+      if (connections->second.empty ())
+        {
+          m_connections.erase (connections);
+        }
+    }
+}
+
 uint16_t Ipv6EndPointDemux::AllocateEphemeralPort ()
 {
   NS_LOG_FUNCTION (this);
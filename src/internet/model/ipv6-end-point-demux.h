@@ -23,7 +23,9 @@
 
 #include <stdint.h>
 #include <list>
+#include <map>
 #include "ns3/ipv6-address.h"
+#include "ns3/sgi-hashmap.h"
 #include "ipv6-interface.h"
 
 namespace ns3 {
@@ -34,6 +36,10 @@ class Ipv6EndPoint;
  * \ingroup ipv6
  *
  * \brief Demultiplexer for end points.
+ *
+ * As in Ipv4EndPointDemux, the endpoints are indexed by local port, and
+ * either by their four-tuple when both a peer address and port are set, or
+ * by local port alone when the peer address or port is a wildcard.
  */
 class Ipv6EndPointDemux
 {
@@ -153,6 +159,73 @@ public:
   EndPoints GetEndPoints () const;
 
 private:
+  friend class Ipv6EndPoint;
+
+  /**
+   * \brief Local and peer addresses and ports of an endpoint.
+   */
+  struct FourTuple
+  {
+    Ipv6Address m_localAddr; //!< Local address
+    uint16_t m_localPort;    //!< Local port
+    Ipv6Address m_peerAddr;  //!< Peer address
+    uint16_t m_peerPort;     //!< Peer port
+
+    /**
+     * \brief Equal to operator.
+     * \param other the other four-tuple
+     * \returns true if the four-tuples are equal
+     */
+    bool operator== (const FourTuple &other) const;
+  };
+
+  /**
+   * \brief Hash function class for four-tuples.
+   */
+  struct FourTupleHash
+  {
+    /**
+     * \brief Returns the hash of a four-tuple.
+     * \param x the four-tuple
+     * \return the hash
+     */
+    size_t operator() (const FourTuple &x) const;
+  };
+
+  /**
+   * \brief Endpoints with both a peer address and port, by four-tuple.
+   */
+  typedef sgi::hash_map<FourTuple, EndPoints, FourTupleHash> Connections;
+
+  /**
+   * \brief Endpoints with a wildcard peer address or port, by local port.
+   */
+  typedef std::map<uint16_t, EndPoints> Listeners;
+
+  /**
+   * \brief Add an endpoint to the list and to the index.
+   * \param endPoint the endpoint
+   */
+  void Insert (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Add an endpoint to the index.
+   *
+   * Called by the endpoint after its addresses or ports change.
+   *
+   * \param endPoint the endpoint
+   */
+  void Index (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Remove an endpoint from the index.
+   *
+   * Called by the endpoint before its addresses or ports change.
+   *
+   * \param endPoint the endpoint
+   */
+  void Unindex (Ipv6EndPoint *endPoint);
+
   /**
    * \brief Allocate a ephemeral port.
    * \return a port
@@ -178,6 +251,21 @@ private:
    * \brief A list of IPv6 end points.
    */
   EndPoints m_endPoints;
+
+  /**
+   * \brief Number of endpoints on each local port.
+   */
+  std::map<uint16_t, uint32_t> m_localPorts;
+
+  /**
+   * \brief Endpoints with both a peer address and port, by four-tuple.
+   */
+  Connections m_connections;
+
+  /**
+   * \brief Endpoints with a wildcard peer address or port, by local port.
+   */
+  Listeners m_listeners;
 };
 
 } /* namespace ns3 */
@@ -338,7 +338,9 @@ void Ipv6ExtensionFragment::DoDispose ()
       it->second = 0;
     }
 
+  m_fragmentsTimer.Cancel ();
   m_fragments.clear ();
+  m_fragmentsExpiry.clear ();
   Ipv6Extension::DoDispose ();
 }
 
@@ -376,7 +378,7 @@ uint8_t Ipv6ExtensionFragment::Process (Ptr<Packet>& packet,
   uint32_t identification = fragmentHeader.GetIdentification ();
   Ipv6Address src = ipv6Header.GetSourceAddress ();
 
-  std::pair<Ipv6Address, uint32_t> fragmentsId = std::pair<Ipv6Address, uint32_t> (src, identification);
+  FragmentKey_t fragmentsId = FragmentKey_t (src, identification);
   Ptr<Fragments> fragments;
 
   Ipv6Header ipHeader = ipv6Header;
@@ -387,10 +389,20 @@ uint8_t Ipv6ExtensionFragment::Process (Ptr<Packet>& packet,
     {
       fragments = Create<Fragments> ();
       m_fragments.insert (std::make_pair (fragmentsId, fragments));
-      EventId timeout = Simulator::Schedule (Seconds (60),
-                                             &Ipv6ExtensionFragment::HandleFragmentsTimeout, this,
-                                             fragmentsId, ipHeader);
-      fragments->SetTimeoutEventId (timeout);
+
+      // All the packets have the same timeout: the new packet expires
+      // last, and only the timer of the first packet needs to be running.
+      FragmentsExpiry expiry;
+      expiry.m_expiration = Simulator::Now () + Seconds (60);
+      expiry.m_key = fragmentsId;
+      expiry.m_ipHeader = ipHeader;
+      fragments->SetExpiry (m_fragmentsExpiry.insert (m_fragmentsExpiry.end (), expiry));
+      if (m_fragmentsExpiry.size () == 1)
+        {
+          m_fragmentsTimer.Cancel ();
+          m_fragmentsTimer = Simulator::Schedule (Seconds (60),
+                                                  &Ipv6ExtensionFragment::ExpireFragments, this);
+        }
     }
   else
     {
@@ -409,7 +421,9 @@ uint8_t Ipv6ExtensionFragment::Process (Ptr<Packet>& packet,
   if (fragments->IsEntire ())
     {
       packet = fragments->GetPacket ();
-      fragments->CancelTimeout ();
+      // the timer is left running if the packet was the first to expire,
+      // ExpireFragments () then rearms it for the next one
+      m_fragmentsExpiry.erase (fragments->GetExpiry ());
       m_fragments.erase (fragmentsId);
       stopProcessing = false;
     }
@@ -594,7 +608,13 @@ void Ipv6ExtensionFragment::GetFragments (Ptr<Packet> packet, Ipv6Header ipv6Hea
 }
 
 
-void Ipv6ExtensionFragment::HandleFragmentsTimeout (std::pair<Ipv6Address, uint32_t> fragmentsId,
+size_t Ipv6ExtensionFragment::FragmentKeyHash::operator() (const FragmentKey_t &key) const
+{
+  Ipv6AddressHash addressHash;
+  return addressHash (key.first) * 31 + key.second;
+}
+
+void Ipv6ExtensionFragment::HandleFragmentsTimeout (FragmentKey_t fragmentsId,
                                                     Ipv6Header ipHeader)
 {
   Ptr<Fragments> fragments;
@@ -621,8 +641,28 @@ void Ipv6ExtensionFragment::HandleFragmentsTimeout (std::pair<Ipv6Address, uint3
   m_fragments.erase (fragmentsId);
 }
 
+void Ipv6ExtensionFragment::ExpireFragments ()
+{
+  NS_LOG_FUNCTION (this);
+
+  Time now = Simulator::Now ();
+  while (!m_fragmentsExpiry.empty () && m_fragmentsExpiry.front ().m_expiration <= now)
+    {
+      FragmentsExpiry expiry = m_fragmentsExpiry.front ();
+      m_fragmentsExpiry.pop_front ();
+      HandleFragmentsTimeout (expiry.m_key, expiry.m_ipHeader);
+    }
+
+  if (!m_fragmentsExpiry.empty ())
+    {
+      m_fragmentsTimer = Simulator::Schedule (m_fragmentsExpiry.front ().m_expiration - now,
+                                              &Ipv6ExtensionFragment::ExpireFragments, this);
+    }
+}
+
 Ipv6ExtensionFragment::Fragments::Fragments ()
-  : m_moreFragment (0)
+  : m_moreFragment (0),
+    m_overlap (false)
 {
 }
 
@@ -632,22 +672,43 @@ Ipv6ExtensionFragment::Fragments::~Fragments ()
 
 void Ipv6ExtensionFragment::Fragments::AddFragment (Ptr<Packet> fragment, uint16_t fragmentOffset, bool moreFragment)
 {
-  std::list<std::pair<Ptr<Packet>, uint16_t> >::iterator it;
+  std::multimap<uint16_t, Ptr<Packet> >::iterator it = m_packetFragments.upper_bound (fragmentOffset);
 
-  for (it = m_packetFragments.begin (); it != m_packetFragments.end (); it++)
+  if (it == m_packetFragments.end ())
     {
-      if (it->second > fragmentOffset)
-        {
-          break;
-        }
+      m_moreFragment = moreFragment;
     }
 
-  if (it == m_packetFragments.end ())
+  if (m_packetFragments.find (fragmentOffset) != m_packetFragments.end ())
     {
-      m_moreFragment = moreFragment;
+      m_overlap = true;
     }
 
-  m_packetFragments.insert (it, std::pair<Ptr<Packet>, uint16_t> (fragment, fragmentOffset));
+  m_packetFragments.insert (it, std::make_pair (fragmentOffset, fragment));
+
+  // merge the byte range of the fragment with the ranges it touches,
+  // and detect the ranges it overlaps
+  uint32_t start = fragmentOffset;
+  uint32_t end = start + fragment->GetSize ();
+  std::map<uint32_t, uint32_t>::iterator interval = m_intervals.upper_bound (start);
+  if (interval != m_intervals.begin ())
+    {
+      std::map<uint32_t, uint32_t>::iterator previous = interval;
+      previous--;
+      if (previous->second >= start)
+        {
+          m_overlap = m_overlap || previous->second > start;
+          start = previous->first;
+          interval = previous;
+        }
+    }
+  while (interval != m_intervals.end () && interval->first <= end)
+    {
+      m_overlap = m_overlap || (interval->first < end && interval->first >= fragmentOffset);
+      end = std::max (end, interval->second);
+      m_intervals.erase (interval++);
+    }
+  m_intervals[start] = end;
 }
 
 void Ipv6ExtensionFragment::Fragments::SetUnfragmentablePart (Ptr<Packet> unfragmentablePart)
@@ -657,34 +718,16 @@ void Ipv6ExtensionFragment::Fragments::SetUnfragmentablePart (Ptr<Packet> unfrag
 
 bool Ipv6ExtensionFragment::Fragments::IsEntire () const
 {
-  bool ret = !m_moreFragment && m_packetFragments.size () > 0;
-
-  if (ret)
-    {
-      uint16_t lastEndOffset = 0;
-
-      for (std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_packetFragments.begin (); it != m_packetFragments.end (); it++)
-        {
-          if (lastEndOffset != it->second)
-            {
-              ret = false;
-              break;
-            }
-
-          lastEndOffset += it->first->GetSize ();
-        }
-    }
-
-  return ret;
+  return !m_moreFragment && !m_overlap && m_intervals.size () == 1 && m_intervals.begin ()->first == 0;
 }
 
 Ptr<Packet> Ipv6ExtensionFragment::Fragments::GetPacket () const
 {
   Ptr<Packet> p =  m_unfragmentable->Copy ();
 
-  for (std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_packetFragments.begin (); it != m_packetFragments.end (); it++)
+  for (std::multimap<uint16_t, Ptr<Packet> >::const_iterator it = m_packetFragments.begin (); it != m_packetFragments.end (); it++)
     {
-      p->AddAtEnd (it->first);
+      p->AddAtEnd (it->second);
     }
 
   return p;
@@ -705,32 +748,29 @@ Ptr<Packet> Ipv6ExtensionFragment::Fragments::GetPartialPacket () const
 
   uint16_t lastEndOffset = 0;
 
-  for (std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_packetFragments.begin (); it != m_packetFragments.end (); it++)
+  for (std::multimap<uint16_t, Ptr<Packet> >::const_iterator it = m_packetFragments.begin (); it != m_packetFragments.end (); it++)
     {
-      if (lastEndOffset != it->second)
+      if (lastEndOffset != it->first)
         {
           break;
         }
-      p->AddAtEnd (it->first);
-      lastEndOffset += it->first->GetSize ();
+      p->AddAtEnd (it->second);
+      lastEndOffset += it->second->GetSize ();
     }
 
   return p;
 }
 
-void Ipv6ExtensionFragment::Fragments::SetTimeoutEventId (EventId event)
+void Ipv6ExtensionFragment::Fragments::SetExpiry (FragmentsExpiryList_t::iterator expiry)
 {
-  m_timeoutEventId = event;
-  return;
+  m_expiry = expiry;
 }
 
-void Ipv6ExtensionFragment::Fragments::CancelTimeout ()
+Ipv6ExtensionFragment::FragmentsExpiryList_t::iterator Ipv6ExtensionFragment::Fragments::GetExpiry () const
 {
-  m_timeoutEventId.Cancel ();
-  return;
+  return m_expiry;
 }
 
-
 NS_OBJECT_ENSURE_REGISTERED (Ipv6ExtensionRouting);
 
 TypeId Ipv6ExtensionRouting::GetTypeId ()
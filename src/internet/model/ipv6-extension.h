@@ -35,6 +35,7 @@
 #include "ns3/ipv6-address.h"
 #include "ns3/ipv6-l3-protocol.h"
 #include "ns3/traced-callback.h"
+#include "ns3/sgi-hashmap.h"
 
 
 namespace ns3 {
@@ -316,6 +317,22 @@ protected:
   virtual void DoDispose ();
 
 private:
+  /// Key identifying a fragmented packet: source address and identification
+  typedef std::pair<Ipv6Address, uint32_t> FragmentKey_t;
+
+  /**
+   * \brief A fragmented packet waiting for its reassembly timer.
+   */
+  struct FragmentsExpiry
+  {
+    Time m_expiration;      //!< Expiration time
+    FragmentKey_t m_key;    //!< Key of the fragmented packet
+    Ipv6Header m_ipHeader;  //!< Header of the first fragment received
+  };
+
+  /// Fragmented packets, by increasing expiration time
+  typedef std::list<FragmentsExpiry> FragmentsExpiryList_t;
+
   /**
    * \ingroup ipv6HeaderExt
    *
@@ -367,15 +384,16 @@ public:
     Ptr<Packet> GetPartialPacket () const;
 
     /**
-     * \brief Set the Timeout EventId.
-     * \param event The event.
+     * \brief Set the position of the packet in the expiration list.
+     * \param expiry the position
      */
-    void SetTimeoutEventId (EventId event);
+    void SetExpiry (FragmentsExpiryList_t::iterator expiry);
 
     /**
-     * \brief Cancel the timeout event
+     * \brief Get the position of the packet in the expiration list.
+     * \return the position
      */
-    void CancelTimeout ();
+    FragmentsExpiryList_t::iterator GetExpiry () const;
 
 private:
     /**
@@ -384,9 +402,21 @@ private:
     bool m_moreFragment;
 
     /**
-     * \brief The current fragments.
+     * \brief The current fragments, by offset.
      */
-    std::list<std::pair<Ptr<Packet>, uint16_t> > m_packetFragments;
+    std::multimap<uint16_t, Ptr<Packet> > m_packetFragments;
+
+    /**
+     * \brief The byte ranges received, as disjoint [start, end) intervals
+     * indexed by their start.  Intervals which touch are merged.
+     */
+    std::map<uint32_t, uint32_t> m_intervals;
+
+    /**
+     * \brief True if two fragments overlap, in which case the packet is
+     * never rebuilt (RFC 5722).
+     */
+    bool m_overlap;
 
     /**
      * \brief The unfragmentable part.
@@ -394,9 +424,9 @@ private:
     Ptr<Packet> m_unfragmentable;
 
     /**
-     * \brief Timeout handler event
+     * \brief The position of the packet in the expiration list.
      */
-    EventId m_timeoutEventId;
+    FragmentsExpiryList_t::iterator m_expiry;
   };
 
   /**
@@ -404,7 +434,13 @@ private:
    * \param key representing the packet fragments
    * \param ipHeader the IP header of the original packet
    */
-  void HandleFragmentsTimeout (std::pair<Ipv6Address, uint32_t> key, Ipv6Header ipHeader);
+  void HandleFragmentsTimeout (FragmentKey_t key, Ipv6Header ipHeader);
+
+  /**
+   * \brief Handle the fragments whose reassembly timer expired, and
+   * arm the timer for the next ones.
+   */
+  void ExpireFragments (void);
 
   /**
    * \brief Get the packet parts so far received.
@@ -423,15 +459,38 @@ private:
    */
   void CancelTimeout ();
 
+  /**
+   * \brief Hash function class for fragment keys.
+   */
+  struct FragmentKeyHash
+  {
+    /**
+     * \brief Returns the hash of a fragment key.
+     * \param key the key
+     * \return the hash
+     */
+    size_t operator() (const FragmentKey_t &key) const;
+  };
+
   /**
    * \brief Container for the packet fragments.
    */
-  typedef std::map<std::pair<Ipv6Address, uint32_t>, Ptr<Fragments> > MapFragments_t;
+  typedef sgi::hash_map<FragmentKey_t, Ptr<Fragments>, FragmentKeyHash> MapFragments_t;
 
   /**
    * \brief The hash of fragmented packets.
    */
   MapFragments_t m_fragments;
+
+  /**
+   * \brief The fragmented packets, by expiration time.
+   */
+  FragmentsExpiryList_t m_fragmentsExpiry;
+
+  /**
+   * \brief Expiration event of the first fragmented packet.
+   */
+  EventId m_fragmentsTimer;
 };
 
 /**
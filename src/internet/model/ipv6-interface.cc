@@ -78,6 +78,7 @@ void Ipv6Interface::DoDispose ()
   m_device = 0;
   m_tc = 0;
   m_ndCache = 0;
+  m_addressChangeCallback = MakeNullCallback<void> ();
   Object::DoDispose ();
 }
 
@@ -209,6 +210,10 @@ void Ipv6Interface::SetDown ()
   NS_LOG_FUNCTION_NOARGS ();
   m_ifup = false;
   m_addresses.clear ();
+  if (!m_addressChangeCallback.IsNull ())
+    {
+      m_addressChangeCallback ();
+    }
   m_ndCache->Flush ();
 }
 
@@ -242,6 +247,10 @@ bool Ipv6Interface::AddAddress (Ipv6InterfaceAddress iface)
 
       Ipv6Address solicited = Ipv6Address::MakeSolicitedAddress (iface.GetAddress ());
       m_addresses.push_back (std::make_pair (iface, solicited));
+      if (!m_addressChangeCallback.IsNull ())
+        {
+          m_addressChangeCallback ();
+        }
 
       if (!addr.IsAny () || !addr.IsLocalhost ())
         {
@@ -336,6 +345,10 @@ Ipv6InterfaceAddress Ipv6Interface::RemoveAddress (uint32_t index)
         {
           Ipv6InterfaceAddress iface = it->first;
           m_addresses.erase (it);
+          if (!m_addressChangeCallback.IsNull ())
+            {
+              m_addressChangeCallback ();
+            }
           return iface;
         }
 
@@ -363,6 +376,10 @@ Ipv6Interface::RemoveAddress(Ipv6Address address)
         {
           Ipv6InterfaceAddress iface = it->first;
           m_addresses.erase(it);
+          if (!m_addressChangeCallback.IsNull ())
+            {
+              m_addressChangeCallback ();
+            }
           return iface;
         }
     }
@@ -548,5 +565,11 @@ Ptr<NdiscCache> Ipv6Interface::GetNdiscCache () const
   return m_ndCache;
 }
 
+void Ipv6Interface::SetAddressChangeCallback (Callback<void> callback)
+{
+  NS_LOG_FUNCTION (this);
+  m_addressChangeCallback = callback;
+}
+
 } /* namespace ns3 */
 
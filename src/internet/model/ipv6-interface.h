@@ -24,6 +24,7 @@
 #include <list>
 #include "ns3/ptr.h"
 #include "ns3/object.h"
+#include "ns3/callback.h"
 #include "ipv6-interface-address.h"
 
 namespace ns3
@@ -271,6 +272,14 @@ public:
    */
   Ptr<NdiscCache> GetNdiscCache () const;
 
+  /**
+   * \brief Set the callback invoked after an address is added or removed.
+   *
+   * Ipv6L3Protocol uses it to keep its address index up to date.
+   * \param callback the callback
+   */
+  void SetAddressChangeCallback (Callback<void> callback);
+
 
 protected:
   /**
@@ -361,6 +370,11 @@ private:
    */
   Ptr<NdiscCache> m_ndCache;
 
+  /**
+   * \brief Called after an address is added or removed.
+   */
+  Callback<void> m_addressChangeCallback;
+
   /**
    * \brief Current hop limit.
    */
@@ -31,6 +31,7 @@
 #include "ns3/mac16-address.h"
 #include "ns3/mac64-address.h"
 #include "ns3/traffic-control-layer.h"
+#include "ns3/tso-tag.h"
 
 #include "loopback-net-device.h"
 #include "ipv6-l3-protocol.h"
@@ -152,6 +153,7 @@ void Ipv6L3Protocol::DoDispose ()
     }
   m_interfaces.clear ();
   m_reverseInterfacesContainer.clear ();
+  m_addresses.clear ();
 
   /* remove raw sockets */
   for (SocketList::iterator it = m_sockets.begin (); it != m_sockets.end (); ++it)
@@ -219,9 +221,25 @@ uint32_t Ipv6L3Protocol::AddIpv6Interface (Ptr<Ipv6Interface> interface)
   m_interfaces.push_back (interface);
   m_reverseInterfacesContainer[interface->GetDevice ()] = index;
   m_nInterfaces++;
+  interface->SetAddressChangeCallback (MakeCallback (&Ipv6L3Protocol::IndexAddresses, this));
+  IndexAddresses ();
   return index;
 }
 
+void Ipv6L3Protocol::IndexAddresses ()
+{
+  NS_LOG_FUNCTION (this);
+  m_addresses.clear ();
+  for (uint32_t i = 0; i < m_interfaces.size (); i++)
+    {
+      for (uint32_t j = 0; j < m_interfaces[i]->GetNAddresses (); j++)
+        {
+          // insert () keeps the first interface using an address
+          m_addresses.insert (std::make_pair (m_interfaces[i]->GetAddress (j).GetAddress (), i));
+        }
+    }
+}
+
 Ptr<Ipv6Interface> Ipv6L3Protocol::GetInterface (uint32_t index) const
 {
   NS_LOG_FUNCTION (this << index);
@@ -242,21 +260,11 @@ uint32_t Ipv6L3Protocol::GetNInterfaces () const
 int32_t Ipv6L3Protocol::GetInterfaceForAddress (Ipv6Address address) const
 {
   NS_LOG_FUNCTION (this << address);
-  int32_t index = 0;
 
-  for (Ipv6InterfaceList::const_iterator it = m_interfaces.begin (); it != m_interfaces.end (); it++)
+  Ipv6AddressIndex::const_iterator it = m_addresses.find (address);
+  if (it != m_addresses.end ())
     {
-      uint32_t j = 0;
-      uint32_t max = (*it)->GetNAddresses ();
-
-      for (j = 0; j < max; j++)
-        {
-          if ((*it)->GetAddress (j).GetAddress () == address)
-            {
-              return index;
-            }
-        }
-      index++;
+      return it->second;
     }
   return -1;
 }
@@ -287,6 +295,11 @@ Ptr<NetDevice> Ipv6L3Protocol::GetNetDevice (uint32_t i)
   return GetInterface (i)->GetDevice ();
 }
 
+size_t Ipv6L3Protocol::NetDeviceHash::operator() (Ptr<const NetDevice> device) const
+{
+  return reinterpret_cast<size_t> (PeekPointer (device)) / sizeof (void *);
+}
+
 int32_t Ipv6L3Protocol::GetInterfaceForDevice (Ptr<const NetDevice> device) const
 {
   NS_LOG_FUNCTION (this << device);
@@ -1053,30 +1066,23 @@ void Ipv6L3Protocol::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16
     }
 
 
-  for (uint32_t j = 0; j < GetNInterfaces (); j++)
+  for (uint32_t i = 0; i < GetNAddresses (interface); i++)
     {
-      if (j == interface || !m_strongEndSystemModel)
+      Ipv6Address addr = GetAddress (interface, i).GetAddress ();
+      if (addr.IsEqual (hdr.GetDestinationAddress ()))
         {
-          for (uint32_t i = 0; i < GetNAddresses (j); i++)
-            {
-              Ipv6InterfaceAddress iaddr = GetAddress (j, i);
-              Ipv6Address addr = iaddr.GetAddress ();
-              if (addr.IsEqual (hdr.GetDestinationAddress ()))
-                {
-                  if (j == interface)
-                    {
-                      NS_LOG_LOGIC ("For me (destination " << addr << " match)");
-                    }
-                  else
-                    {
-                      NS_LOG_LOGIC ("For me (destination " << addr << " match) on another interface " << hdr.GetDestinationAddress ());
-                    }
-                  LocalDeliver (packet, hdr, interface);
-                  return;
-                }
-              NS_LOG_LOGIC ("Address " << addr << " not a match");
-            }
+          NS_LOG_LOGIC ("For me (destination " << addr << " match)");
+          LocalDeliver (packet, hdr, interface);
+          return;
         }
+      NS_LOG_LOGIC ("Address " << addr << " not a match");
+    }
+
+  if (!m_strongEndSystemModel && GetInterfaceForAddress (hdr.GetDestinationAddress ()) != -1)
+    {
+      NS_LOG_LOGIC ("For me (destination match) on another interface " << hdr.GetDestinationAddress ());
+      LocalDeliver (packet, hdr, interface);
+      return;
     }
 
   if (!m_routingProtocol->RouteInput (packet, hdr, device,
@@ -1126,22 +1132,15 @@ void Ipv6L3Protocol::SendRealOut (Ptr<Ipv6Route> route, Ptr<Packet> packet, Ipv6
       targetMtu = dev->GetMtu ();
     }
 
-  if (packet->GetSize () > targetMtu + 40) /* 40 => size of IPv6 header */
+  // Super-segments are not fragmented: the devices send them as the
+  // frames they stand for
+  TsoTag tso;
+  if (packet->GetSize () > targetMtu + 40 /* 40 => size of IPv6 header */
+      && !packet->PeekPacketTag (tso))
     {
       // Router => drop
 
-      bool fromMe = false;
-      for (uint32_t i=0; i<GetNInterfaces(); i++ )
-        {
-          for (uint32_t j=0; j<GetNAddresses(i); j++ )
-            {
-              if (GetAddress(i,j).GetAddress() == ipHeader.GetSourceAddress())
-                {
-                  fromMe = true;
-                  break;
-                }
-            }
-        }
+      bool fromMe = GetInterfaceForAddress (ipHeader.GetSourceAddress ()) != -1;
       if (!fromMe)
         {
           Ptr<Icmpv6L4Protocol> icmpv6 = GetIcmpv6 ();
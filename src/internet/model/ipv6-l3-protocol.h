@@ -29,6 +29,7 @@
 #include "ns3/ipv6-address.h"
 #include "ns3/ipv6-header.h"
 #include "ns3/ipv6-pmtu-cache.h"
+#include "ns3/sgi-hashmap.h"
 
 class Ipv6L3ProtocolTestCase;
 
@@ -478,10 +479,28 @@ private:
    */
   typedef std::vector<Ptr<Ipv6Interface> > Ipv6InterfaceList;
 
+  /**
+   * \brief Hash function class for NetDevices.
+   */
+  struct NetDeviceHash
+  {
+    /**
+     * \brief Returns the hash of a NetDevice.
+     * \param device the NetDevice
+     * \return the hash
+     */
+    size_t operator() (Ptr<const NetDevice> device) const;
+  };
+
   /**
    * \brief Container of NetDevices registered to IPv6 and their interface indexes.
    */
-  typedef std::map<Ptr<const NetDevice>, uint32_t > Ipv6InterfaceReverseContainer;
+  typedef sgi::hash_map<Ptr<const NetDevice>, uint32_t, NetDeviceHash> Ipv6InterfaceReverseContainer;
+
+  /**
+   * \brief Container of addresses and the index of the first interface using them.
+   */
+  typedef sgi::hash_map<Ipv6Address, uint32_t, Ipv6AddressHash> Ipv6AddressIndex;
 
   /**
    * \brief Container of the IPv6 Raw Sockets.
@@ -520,6 +539,12 @@ private:
    */
   void CallTxTrace (const Ipv6Header & ipHeader, Ptr<Packet> packet, Ptr<Ipv6> ipv6, uint32_t interface);
 
+  /**
+   * \brief Rebuild the index of the addresses, after an address is added
+   * to or removed from an interface.
+   */
+  void IndexAddresses ();
+
   /**
    * \brief Callback to trace TX (transmission) packets.
    * \deprecated The non-const \c Ptr<Ipv6> argument is deprecated
@@ -701,6 +726,11 @@ private:
    */
   Ipv6InterfaceReverseContainer m_reverseInterfacesContainer;
 
+  /**
+   * \brief Interface of each address of the node.
+   */
+  Ipv6AddressIndex m_addresses;
+
   /**
    * \brief Number of IPv6 interfaces managed by the stack.
    */
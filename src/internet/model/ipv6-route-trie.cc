@@ -0,0 +1,427 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cstring>
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ipv6-route-trie.h"
+#include "ipv6-routing-table-entry.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Ipv6RouteTrie");
+
+/**
+ * \param address an address
+ * \param index a bit index, counted from the most significant bit
+ * \return the bit of the address at this index
+ */
+static uint32_t
+PrefixBit (const uint8_t address[16], uint8_t index)
+{
+  return (address[index / 8] >> (7 - index % 8)) & 1;
+}
+
+/**
+ * \param a an address
+ * \param b an address
+ * \param length the maximum length to compare
+ * \return the length of the common prefix of the two addresses, up to length
+ */
+static uint8_t
+CommonLength (const uint8_t a[16], const uint8_t b[16], uint8_t length)
+{
+  for (uint8_t i = 0; i < 16 && i * 8 < length; i++)
+    {
+      uint8_t diff = a[i] ^ b[i];
+      if (diff != 0)
+        {
+          uint8_t common = i * 8;
+          while ((diff & 0x80) == 0)
+            {
+              diff <<= 1;
+              common++;
+            }
+          return std::min (common, length);
+        }
+    }
+  return length;
+}
+
+/**
+ * \param address an address
+ * \param length a prefix length
+ * \param prefix [out] the first length bits of the address, followed by zeros
+ */
+static void
+CopyPrefix (const uint8_t address[16], uint8_t length, uint8_t prefix[16])
+{
+  for (uint8_t i = 0; i < 16; i++)
+    {
+      if (i * 8 + 8 <= length)
+        {
+          prefix[i] = address[i];
+        }
+      else if (i * 8 < length)
+        {
+          prefix[i] = address[i] & (0xff << (8 - length % 8));
+        }
+      else
+        {
+          prefix[i] = 0;
+        }
+    }
+}
+
+/**
+ * \param address an address
+ * \param prefix prefix bits, zero past length
+ * \param length the prefix length
+ * \return true if the address starts with the prefix
+ */
+static bool
+HasPrefix (const uint8_t address[16], const uint8_t prefix[16], uint8_t length)
+{
+  uint8_t bytes = length / 8;
+  if (std::memcmp (address, prefix, bytes) != 0)
+    {
+      return false;
+    }
+  return length % 8 == 0
+         || (address[bytes] & (0xff << (8 - length % 8)) & 0xff) == prefix[bytes];
+}
+
+/**
+ * \param route a route
+ * \param prefix [out] the destination prefix of the route, zero past its length
+ * \param length [out] the length of the destination prefix
+ * \return false if the prefix of the route has holes
+ */
+static bool
+GetRoutePrefix (const Ipv6RoutingTableEntry *route, uint8_t prefix[16], uint8_t &length)
+{
+  uint8_t mask[16];
+  route->GetDestNetworkPrefix ().GetBytes (mask);
+  length = 0;
+  bool ones = true;
+  for (uint8_t i = 0; i < 16; i++)
+    {
+      if (ones && mask[i] == 0xff)
+        {
+          length += 8;
+          continue;
+        }
+      uint8_t zeros = ~mask[i];
+      if (!ones && mask[i] != 0)
+        {
+          return false;
+        }
+      if (ones && (zeros & (zeros + 1)) != 0)
+        {
+          return false;
+        }
+      while (ones && (mask[i] & 0x80) != 0)
+        {
+          mask[i] <<= 1;
+          length++;
+        }
+      ones = false;
+    }
+  uint8_t address[16];
+  route->GetDestNetwork ().GetBytes (address);
+  CopyPrefix (address, length, prefix);
+  return true;
+}
+
+/**
+ * \param a an entry
+ * \param b an entry
+ * \return true if a comes before b in the routing table
+ */
+static bool
+RanksBefore (const Ipv6RouteTrie::Entry &a, const Ipv6RouteTrie::Entry &b)
+{
+  return a.m_order < b.m_order;
+}
+
+Ipv6RouteTrie::Ipv6RouteTrie ()
+  : m_root (0),
+    m_backOrder (0),
+    m_frontOrder (-1)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+Ipv6RouteTrie::~Ipv6RouteTrie ()
+{
+  NS_LOG_FUNCTION (this);
+  Clear ();
+}
+
+Ipv6RouteTrie::Node *
+Ipv6RouteTrie::CreateNode (const uint8_t prefix[16], uint8_t length)
+{
+  NS_LOG_FUNCTION (static_cast<uint32_t> (length));
+  Node *node = new Node;
+  CopyPrefix (prefix, length, node->m_prefix);
+  node->m_length = length;
+  node->m_child[0] = 0;
+  node->m_child[1] = 0;
+  return node;
+}
+
+void
+Ipv6RouteTrie::DeleteNode (Node *node)
+{
+  NS_LOG_FUNCTION (node);
+  if (node != 0)
+    {
+      DeleteNode (node->m_child[0]);
+      DeleteNode (node->m_child[1]);
+      delete node;
+    }
+}
+
+void
+Ipv6RouteTrie::Prune (Node **link)
+{
+  NS_LOG_FUNCTION (link);
+  Node *node = *link;
+  if (!node->m_entries.empty () || (node->m_child[0] != 0 && node->m_child[1] != 0))
+    {
+      return;
+    }
+  *link = node->m_child[0] != 0 ? node->m_child[0] : node->m_child[1];
+  delete node;
+}
+
+void
+Ipv6RouteTrie::Add (Ipv6RoutingTableEntry *route, uint32_t metric)
+{
+  NS_LOG_FUNCTION (this << route << metric);
+  Entry entry;
+  entry.m_route = route;
+  entry.m_metric = metric;
+  entry.m_order = m_backOrder++;
+  Insert (entry, false);
+}
+
+void
+Ipv6RouteTrie::AddFront (Ipv6RoutingTableEntry *route, uint32_t metric)
+{
+  NS_LOG_FUNCTION (this << route << metric);
+  Entry entry;
+  entry.m_route = route;
+  entry.m_metric = metric;
+  entry.m_order = m_frontOrder--;
+  Insert (entry, true);
+}
+
+void
+Ipv6RouteTrie::Insert (const Entry &entry, bool front)
+{
+  NS_LOG_FUNCTION (this << entry.m_route << front);
+  uint8_t prefix[16];
+  uint8_t length;
+  if (!GetRoutePrefix (entry.m_route, prefix, length))
+    {
+      NS_LOG_LOGIC ("Prefix " << entry.m_route->GetDestNetworkPrefix () << " has holes");
+      m_irregular.push_back (entry);
+      return;
+    }
+
+  Node **link = &m_root;
+  Node *node = *link;
+  while (node != 0)
+    {
+      uint8_t common = CommonLength (node->m_prefix, prefix, std::min (node->m_length, length));
+      if (common < node->m_length)
+        {
+          //
+          // The new prefix leaves the path of this node before its end: it
+          // either is a prefix of the node, or both branch off a shorter one.
+          //
+          Node *added = CreateNode (prefix, length);
+          if (common == length)
+            {
+              added->m_child[PrefixBit (node->m_prefix, common)] = node;
+              *link = added;
+            }
+          else
+            {
+              Node *branch = CreateNode (prefix, common);
+              branch->m_child[PrefixBit (node->m_prefix, common)] = node;
+              branch->m_child[PrefixBit (prefix, common)] = added;
+              *link = branch;
+            }
+          node = added;
+          break;
+        }
+      if (common == length)
+        {
+          break;
+        }
+      link = &node->m_child[PrefixBit (prefix, common)];
+      node = *link;
+    }
+  if (node == 0)
+    {
+      node = CreateNode (prefix, length);
+      *link = node;
+    }
+  node->m_entries.insert (front ? node->m_entries.begin () : node->m_entries.end (), entry);
+}
+
+Ipv6RouteTrie::Node **
+Ipv6RouteTrie::Find (Ipv6RoutingTableEntry *route, Node ***parent)
+{
+  NS_LOG_FUNCTION (this << route << parent);
+  uint8_t prefix[16];
+  uint8_t length;
+  GetRoutePrefix (route, prefix, length);
+
+  *parent = 0;
+  Node **link = &m_root;
+  while (*link != 0 && (*link)->m_length < length)
+    {
+      *parent = link;
+      link = &(*link)->m_child[PrefixBit (prefix, (*link)->m_length)];
+    }
+  if (*link == 0 || (*link)->m_length != length || std::memcmp ((*link)->m_prefix, prefix, 16) != 0)
+    {
+      return 0;
+    }
+  return link;
+}
+
+void
+Ipv6RouteTrie::Replace (Ipv6RoutingTableEntry *oldRoute, Ipv6RoutingTableEntry *newRoute)
+{
+  NS_LOG_FUNCTION (this << oldRoute << newRoute);
+  NS_ASSERT_MSG (oldRoute->GetDestNetwork () == newRoute->GetDestNetwork ()
+                 && oldRoute->GetDestNetworkPrefix () == newRoute->GetDestNetworkPrefix (),
+                 "Replacing a route by a route to another destination");
+  uint8_t prefix[16];
+  uint8_t length;
+  std::vector<Entry> *entries = &m_irregular;
+  if (GetRoutePrefix (oldRoute, prefix, length))
+    {
+      Node **parent;
+      Node **link = Find (oldRoute, &parent);
+      NS_ASSERT_MSG (link != 0, "Route not found");
+      entries = &(*link)->m_entries;
+    }
+  for (std::vector<Entry>::iterator i = entries->begin (); i != entries->end (); i++)
+    {
+      if (i->m_route == oldRoute)
+        {
+          i->m_route = newRoute;
+          return;
+        }
+    }
+  NS_ASSERT_MSG (false, "Route not found");
+}
+
+void
+Ipv6RouteTrie::Remove (Ipv6RoutingTableEntry *route)
+{
+  NS_LOG_FUNCTION (this << route);
+  uint8_t prefix[16];
+  uint8_t length;
+  if (!GetRoutePrefix (route, prefix, length))
+    {
+      for (std::vector<Entry>::iterator i = m_irregular.begin (); i != m_irregular.end (); i++)
+        {
+          if (i->m_route == route)
+            {
+              m_irregular.erase (i);
+              return;
+            }
+        }
+      NS_ASSERT_MSG (false, "Route not found");
+      return;
+    }
+
+  Node **parent;
+  Node **link = Find (route, &parent);
+  NS_ASSERT_MSG (link != 0, "Route not found");
+  std::vector<Entry> &entries = (*link)->m_entries;
+  for (std::vector<Entry>::iterator i = entries.begin (); i != entries.end (); i++)
+    {
+      if (i->m_route == route)
+        {
+          entries.erase (i);
+          Prune (link);
+          if (parent != 0)
+            {
+              Prune (parent);
+            }
+          return;
+        }
+    }
+  NS_ASSERT_MSG (false, "Route not found");
+}
+
+void
+Ipv6RouteTrie::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  DeleteNode (m_root);
+  m_root = 0;
+  m_irregular.clear ();
+}
+
+void
+Ipv6RouteTrie::Lookup (Ipv6Address dest, std::vector<Entry> &matches) const
+{
+  NS_LOG_FUNCTION (this << dest);
+  matches.clear ();
+  uint8_t address[16];
+  dest.GetBytes (address);
+  bool sorted = true;
+  for (const Node *node = m_root; node != 0; )
+    {
+      if (!HasPrefix (address, node->m_prefix, node->m_length))
+        {
+          break;
+        }
+      if (!node->m_entries.empty ())
+        {
+          sorted = sorted && (matches.empty () || matches.back ().m_order < node->m_entries.front ().m_order);
+          matches.insert (matches.end (), node->m_entries.begin (), node->m_entries.end ());
+        }
+      if (node->m_length == 128)
+        {
+          break;
+        }
+      node = node->m_child[PrefixBit (address, node->m_length)];
+    }
+  for (std::vector<Entry>::const_iterator i = m_irregular.begin (); i != m_irregular.end (); i++)
+    {
+      if (i->m_route->GetDestNetworkPrefix ().IsMatch (dest, i->m_route->GetDestNetwork ()))
+        {
+          sorted = false;
+          matches.push_back (*i);
+        }
+    }
+  if (!sorted)
+    {
+      std::sort (matches.begin (), matches.end (), &RanksBefore);
+    }
+}
+
+} // namespace ns3
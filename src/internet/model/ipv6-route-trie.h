@@ -0,0 +1,165 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IPV6_ROUTE_TRIE_H
+#define IPV6_ROUTE_TRIE_H
+
+#include <stdint.h>
+#include <vector>
+#include "ns3/ipv6-address.h"
+
+namespace ns3 {
+
+class Ipv6RoutingTableEntry;
+
+/**
+ * \ingroup ipv6Routing
+ *
+ * \brief An index of IPv6 unicast routes by destination prefix.
+ *
+ * This is the IPv6 counterpart of Ipv4RouteTrie: routes are stored in a
+ * path-compressed binary trie keyed by their 128-bit destination prefix,
+ * and Lookup () returns every route matching a destination in routing
+ * table order.  The routing protocols keep their route lists, which still
+ * define the route indices and the order of PrintRoutingTable (), and
+ * apply their own selection rules to the routes returned.
+ *
+ * The routing table order is the order of addition, except that routes
+ * added with AddFront () come before all the others, and that a route
+ * replaced with Replace () keeps the rank of the route it replaces.
+ *
+ * Routes whose prefix has holes cannot be placed in the trie; they are
+ * kept aside and checked one by one on every lookup.
+ */
+class Ipv6RouteTrie
+{
+public:
+  /**
+   * \brief A route stored in the index.
+   */
+  struct Entry
+  {
+    Ipv6RoutingTableEntry *m_route; //!< The route
+    uint32_t m_metric;              //!< Metric of the route
+    int64_t m_order;                //!< Rank of the route in the routing table
+  };
+
+  Ipv6RouteTrie ();
+  ~Ipv6RouteTrie ();
+
+  /**
+   * \brief Add a route after all the others.  The destination of the
+   * route must not be modified while it is in the index.
+   * \param route the route
+   * \param metric metric of the route
+   */
+  void Add (Ipv6RoutingTableEntry *route, uint32_t metric = 0);
+
+  /**
+   * \brief Add a route before all the others.
+   * \param route the route
+   * \param metric metric of the route
+   */
+  void AddFront (Ipv6RoutingTableEntry *route, uint32_t metric = 0);
+
+  /**
+   * \brief Replace a route by another route to the same destination.
+   * \param oldRoute the route previously added
+   * \param newRoute the route taking its place
+   */
+  void Replace (Ipv6RoutingTableEntry *oldRoute, Ipv6RoutingTableEntry *newRoute);
+
+  /**
+   * \brief Remove a route previously added.
+   * \param route the route
+   */
+  void Remove (Ipv6RoutingTableEntry *route);
+
+  /**
+   * \brief Remove all the routes.
+   */
+  void Clear (void);
+
+  /**
+   * \brief Find the routes matching a destination.
+   * \param dest the destination address
+   * \param matches [out] the matching routes, in routing table order
+   */
+  void Lookup (Ipv6Address dest, std::vector<Entry> &matches) const;
+
+private:
+  /**
+   * \brief A node of the trie: a prefix, the routes to this prefix and
+   * the subtries of the longer prefixes.
+   */
+  struct Node
+  {
+    uint8_t m_prefix[16];           //!< Prefix bits, zero past m_length
+    uint8_t m_length;               //!< Prefix length
+    Node *m_child[2];               //!< Subtries, by the bit following the prefix
+    std::vector<Entry> m_entries;   //!< Routes to this prefix, in routing table order
+  };
+
+  /**
+   * \brief Add a route.
+   * \param entry the route, with its metric and rank
+   * \param front true if the route comes before all the others
+   */
+  void Insert (const Entry &entry, bool front);
+
+  /**
+   * \brief Find the node of a route.
+   * \param route the route
+   * \param parent [out] the pointer to the parent of the node in its own parent, or 0
+   * \return the pointer to the node in its parent, or 0 if the route is not in the trie
+   */
+  Node **Find (Ipv6RoutingTableEntry *route, Node ***parent);
+
+  /**
+   * \brief Create a node with no route and no child.
+   * \param prefix the prefix bits
+   * \param length the prefix length
+   * \return the node
+   */
+  static Node *CreateNode (const uint8_t prefix[16], uint8_t length);
+
+  /**
+   * \brief Delete a subtrie.
+   * \param node the root of the subtrie
+   */
+  static void DeleteNode (Node *node);
+
+  /**
+   * \brief Unlink and delete a node which no longer holds routes, unless
+   * it still separates two subtries.
+   * \param link the pointer to the node in its parent
+   */
+  static void Prune (Node **link);
+
+  /// Copy constructor, not implemented
+  Ipv6RouteTrie (const Ipv6RouteTrie &);
+  /// Assignment operator, not implemented
+  Ipv6RouteTrie &operator= (const Ipv6RouteTrie &);
+
+  Node *m_root;                     //!< Root of the trie
+  std::vector<Entry> m_irregular;   //!< Routes with a prefix with holes
+  int64_t m_backOrder;              //!< Rank of the next route added with Add ()
+  int64_t m_frontOrder;             //!< Rank of the next route added with AddFront ()
+};
+
+} // namespace ns3
+
+#endif /* IPV6_ROUTE_TRIE_H */
@@ -19,6 +19,7 @@
  */
 
 #include <iomanip>
+#include <vector>
 #include "ns3/log.h"
 #include "ns3/node.h"
 #include "ns3/packet.h"
@@ -152,6 +153,7 @@ void Ipv6StaticRouting::AddNetworkRouteTo (Ipv6Address network, Ipv6Prefix netwo
   Ipv6RoutingTableEntry* route = new Ipv6RoutingTableEntry ();
   *route = Ipv6RoutingTableEntry::CreateNetworkRouteTo (network, networkPrefix, nextHop, interface);
   m_networkRoutes.push_back (std::make_pair (route, metric));
+  m_networkTrie.Add (route, metric);
 }
 
 void Ipv6StaticRouting::AddNetworkRouteTo (Ipv6Address network, Ipv6Prefix networkPrefix, Ipv6Address nextHop, uint32_t interface, Ipv6Address prefixToUse, uint32_t metric)
@@ -165,6 +167,7 @@ void Ipv6StaticRouting::AddNetworkRouteTo (Ipv6Address network, Ipv6Prefix netwo
   Ipv6RoutingTableEntry* route = new Ipv6RoutingTableEntry ();
   *route = Ipv6RoutingTableEntry::CreateNetworkRouteTo (network, networkPrefix, nextHop, interface, prefixToUse);
   m_networkRoutes.push_back (std::make_pair (route, metric));
+  m_networkTrie.Add (route, metric);
 }
 
 void Ipv6StaticRouting::AddNetworkRouteTo (Ipv6Address network, Ipv6Prefix networkPrefix, uint32_t interface, uint32_t metric)
@@ -173,6 +176,7 @@ void Ipv6StaticRouting::AddNetworkRouteTo (Ipv6Address network, Ipv6Prefix netwo
   Ipv6RoutingTableEntry* route = new Ipv6RoutingTableEntry ();
   *route = Ipv6RoutingTableEntry::CreateNetworkRouteTo (network, networkPrefix, interface);
   m_networkRoutes.push_back (std::make_pair (route, metric));
+  m_networkTrie.Add (route, metric);
 }
 
 void Ipv6StaticRouting::SetDefaultRoute (Ipv6Address nextHop, uint32_t interface, Ipv6Address prefixToUse, uint32_t metric)
@@ -197,6 +201,7 @@ void Ipv6StaticRouting::SetDefaultMulticastRoute (uint32_t outputInterface)
   Ipv6Prefix networkMask = Ipv6Prefix (8);
   *route = Ipv6RoutingTableEntry::CreateNetworkRouteTo (network, networkMask, outputInterface);
   m_networkRoutes.push_back (std::make_pair (route, 0));
+  m_networkTrie.Add (route, 0);
 }
 
 uint32_t Ipv6StaticRouting::GetNMulticastRoutes () const
@@ -265,13 +270,11 @@ bool Ipv6StaticRouting::HasNetworkDest (Ipv6Address network, uint32_t interfaceI
   NS_LOG_FUNCTION (this << network << interfaceIndex);
 
   /* in the network table */
-  for (NetworkRoutesI j = m_networkRoutes.begin (); j != m_networkRoutes.end (); j++)
+  std::vector<Ipv6RouteTrie::Entry> matches;
+  m_networkTrie.Lookup (network, matches);
+  for (std::vector<Ipv6RouteTrie::Entry>::const_iterator j = matches.begin (); j != matches.end (); j++)
     {
-      Ipv6RoutingTableEntry* rtentry = j->first;
-      Ipv6Prefix prefix = rtentry->GetDestNetworkPrefix ();
-      Ipv6Address entry = rtentry->GetDestNetwork ();
-
-      if (prefix.IsMatch (network, entry) && rtentry->GetInterface () == interfaceIndex)
+      if (j->m_route->GetInterface () == interfaceIndex)
         {
           return true;
         }
@@ -300,66 +303,63 @@ Ptr<Ipv6Route> Ipv6StaticRouting::LookupStatic (Ipv6Address dst, Ptr<NetDevice>
       return rtentry;
     }
 
-  for (NetworkRoutesI it = m_networkRoutes.begin (); it != m_networkRoutes.end (); it++)
+  /* the routes matching the destination, in routing table order */
+  std::vector<Ipv6RouteTrie::Entry> matches;
+  m_networkTrie.Lookup (dst, matches);
+  for (std::vector<Ipv6RouteTrie::Entry>::const_iterator it = matches.begin (); it != matches.end (); it++)
     {
-      Ipv6RoutingTableEntry* j = it->first;
-      uint32_t metric = it->second;
+      Ipv6RoutingTableEntry* j = it->m_route;
+      uint32_t metric = it->m_metric;
       Ipv6Prefix mask = j->GetDestNetworkPrefix ();
       uint16_t maskLen = mask.GetPrefixLength ();
-      Ipv6Address entry = j->GetDestNetwork ();
 
-      NS_LOG_LOGIC ("Searching for route to " << dst << ", mask length " << maskLen << ", metric " << metric);
+      NS_LOG_LOGIC ("Found global network route " << *j << ", mask length " << maskLen << ", metric " << metric);
 
-      if (mask.IsMatch (dst, entry))
+      /* if interface is given, check the route will output on this interface */
+      if (!interface || interface == m_ipv6->GetNetDevice (j->GetInterface ()))
         {
-          NS_LOG_LOGIC ("Found global network route " << *j << ", mask length " << maskLen << ", metric " << metric);
-
-          /* if interface is given, check the route will output on this interface */
-          if (!interface || interface == m_ipv6->GetNetDevice (j->GetInterface ()))
+          if (maskLen < longestMask)
             {
-              if (maskLen < longestMask)
-                {
-                  NS_LOG_LOGIC ("Previous match longer, skipping");
-                  continue;
-                }
+              NS_LOG_LOGIC ("Previous match longer, skipping");
+              continue;
+            }
 
-              if (maskLen > longestMask)
-                {
-                  shortestMetric = 0xffffffff;
-                }
+          if (maskLen > longestMask)
+            {
+              shortestMetric = 0xffffffff;
+            }
 
-              longestMask = maskLen;
-              if (metric > shortestMetric)
-                {
-                  NS_LOG_LOGIC ("Equal mask length, but previous metric shorter, skipping");
-                  continue;
-                }
+          longestMask = maskLen;
+          if (metric > shortestMetric)
+            {
+              NS_LOG_LOGIC ("Equal mask length, but previous metric shorter, skipping");
+              continue;
+            }
 
-              shortestMetric = metric;
-              Ipv6RoutingTableEntry* route = j;
-              uint32_t interfaceIdx = route->GetInterface ();
-              rtentry = Create<Ipv6Route> ();
+          shortestMetric = metric;
+          Ipv6RoutingTableEntry* route = j;
+          uint32_t interfaceIdx = route->GetInterface ();
+          rtentry = Create<Ipv6Route> ();
 
-              if (route->GetGateway ().IsAny ())
-                {
-                  rtentry->SetSource (m_ipv6->SourceAddressSelection (interfaceIdx, route->GetDest ()));
-                }
-              else if (route->GetDest ().IsAny ()) /* default route */
-                {
-                  rtentry->SetSource (m_ipv6->SourceAddressSelection (interfaceIdx, route->GetPrefixToUse ().IsAny () ? dst : route->GetPrefixToUse ()));
-                }
-              else
-                {
-                  rtentry->SetSource (m_ipv6->SourceAddressSelection (interfaceIdx, route->GetGateway ()));
-                }
+          if (route->GetGateway ().IsAny ())
+            {
+              rtentry->SetSource (m_ipv6->SourceAddressSelection (interfaceIdx, route->GetDest ()));
+            }
+          else if (route->GetDest ().IsAny ()) /* default route */
+            {
+              rtentry->SetSource (m_ipv6->SourceAddressSelection (interfaceIdx, route->GetPrefixToUse ().IsAny () ? dst : route->GetPrefixToUse ()));
+            }
+          else
+            {
+              rtentry->SetSource (m_ipv6->SourceAddressSelection (interfaceIdx, route->GetGateway ()));
+            }
 
-              rtentry->SetDestination (route->GetDest ());
-              rtentry->SetGateway (route->GetGateway ());
-              rtentry->SetOutputDevice (m_ipv6->GetNetDevice (interfaceIdx));
-              if (maskLen == 128)
-                {
-                  break;
-                }
+          rtentry->SetDestination (route->GetDest ());
+          rtentry->SetGateway (route->GetGateway ());
+          rtentry->SetOutputDevice (m_ipv6->GetNetDevice (interfaceIdx));
+          if (maskLen == 128)
+            {
+              break;
             }
         }
     }
@@ -375,6 +375,7 @@ void Ipv6StaticRouting::DoDispose ()
 {
   NS_LOG_FUNCTION_NOARGS ();
 
+  m_networkTrie.Clear ();
   for (NetworkRoutesI j = m_networkRoutes.begin ();  j != m_networkRoutes.end (); j = m_networkRoutes.erase (j))
     {
       delete j->first;
@@ -528,6 +529,7 @@ void Ipv6StaticRouting::RemoveRoute (uint32_t index)
     {
       if (tmp == index)
         {
+          m_networkTrie.Remove (it->first);
           delete it->first;
           m_networkRoutes.erase (it);
           return;
@@ -547,6 +549,7 @@ void Ipv6StaticRouting::RemoveRoute (Ipv6Address network, Ipv6Prefix prefix, uin
       if (network == rtentry->GetDest () && rtentry->GetInterface () == ifIndex
           && rtentry->GetPrefixToUse () == prefixToUse)
         {
+          m_networkTrie.Remove (it->first);
           delete it->first;
           m_networkRoutes.erase (it);
           return;
@@ -672,6 +675,7 @@ void Ipv6StaticRouting::NotifyInterfaceDown (uint32_t i)
     {
       if (it->first->GetInterface () == i)
         {
+          m_networkTrie.Remove (it->first);
           delete it->first;
           it = m_networkRoutes.erase (it);
         }
@@ -717,6 +721,7 @@ void Ipv6StaticRouting::NotifyRemoveAddress (uint32_t interface, Ipv6InterfaceAd
           && it->first->GetDestNetwork () == networkAddress
           && it->first->GetDestNetworkPrefix () == networkMask)
         {
+          m_networkTrie.Remove (it->first);
           delete it->first;
           it = m_networkRoutes.erase (it);
         }
@@ -761,6 +766,7 @@ void Ipv6StaticRouting::NotifyRemoveRoute (Ipv6Address dst, Ipv6Prefix mask, Ipv
 
           if (dst == entry && prefix == mask && rtentry->GetInterface () == interface)
             {
+              m_networkTrie.Remove (j->first);
               delete j->first;
               j = m_networkRoutes.erase (j);
             }
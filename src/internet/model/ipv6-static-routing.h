@@ -30,6 +30,7 @@
 #include "ns3/ipv6.h"
 #include "ns3/ipv6-header.h"
 #include "ns3/ipv6-routing-protocol.h"
+#include "ns3/ipv6-route-trie.h"
 
 namespace ns3 {
 
@@ -286,6 +287,11 @@ private:
    */
   NetworkRoutes m_networkRoutes;
 
+  /**
+   * \brief the index of m_networkRoutes by destination.
+   */
+  Ipv6RouteTrie m_networkTrie;
+
   /**
    * \brief the forwarding table for multicast.
    */
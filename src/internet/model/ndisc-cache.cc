@@ -45,11 +45,19 @@ TypeId NdiscCache::GetTypeId ()
                    UintegerValue (DEFAULT_UNRES_QLEN),
                    MakeUintegerAccessor (&NdiscCache::m_unresQlen),
                    MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxUnresolvedPackets",
+                   "Maximum number of packets pending an NA reply in all the entries "
+                   "of the cache.  Beyond this limit, a new packet replaces the oldest "
+                   "packet waiting for the same neighbor.",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&NdiscCache::m_maxUnresolvedPackets),
+                   MakeUintegerChecker<uint32_t> ())
   ;
   return tid;
 } 
 
 NdiscCache::NdiscCache ()
+  : m_unresolvedPackets (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -109,14 +117,10 @@ std::list<NdiscCache::Entry*> NdiscCache::LookupInverse (Address dst)
   NS_LOG_FUNCTION (this << dst);
 
   std::list<NdiscCache::Entry *> entryList;
-  for (CacheI i = m_ndCache.begin (); i != m_ndCache.end (); i++)
+  InverseCache::const_iterator it = m_inverseCache.find (dst);
+  if (it != m_inverseCache.end ())
     {
-      NdiscCache::Entry *entry = (*i).second;
-      if (entry->GetMacAddress () == dst)
-        {
-          NS_LOG_LOGIC ("Found an entry:" << (*i).first << " to " << (*i).second);
-          entryList.push_back (entry);
-        }
+      entryList.insert (entryList.end (), it->second.begin (), it->second.end ());
     }
   return entryList;
 }
@@ -137,15 +141,40 @@ void NdiscCache::Remove (NdiscCache::Entry* entry)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  for (CacheI i = m_ndCache.begin (); i != m_ndCache.end (); i++)
+  CacheI i = m_ndCache.find (entry->GetIpv6Address ());
+  if (i != m_ndCache.end () && (*i).second == entry)
     {
-      if ((*i).second == entry)
+      m_ndCache.erase (i);
+      UpdateInverse (entry, entry->GetMacAddress (), Address ());
+      entry->ClearWaitingPacket ();
+      delete entry;
+    }
+}
+
+void NdiscCache::UpdateInverse (NdiscCache::Entry *entry, const Address &oldAddress, const Address &newAddress)
+{
+  NS_LOG_FUNCTION (this << entry << oldAddress << newAddress);
+  if (!oldAddress.IsInvalid ())
+    {
+      InverseCache::iterator it = m_inverseCache.find (oldAddress);
+      NS_ASSERT (it != m_inverseCache.end ());
+      std::vector<NdiscCache::Entry *> &entries = it->second;
+      for (std::vector<NdiscCache::Entry *>::iterator j = entries.begin (); j != entries.end (); j++)
         {
-          m_ndCache.erase (i);
-          entry->ClearWaitingPacket ();
-          delete entry;
-          return;
+          if (*j == entry)
+            {
+              entries.erase (j);
+              break;
+            }
         }
+      if (entries.empty ())
+        {
+          m_inverseCache.erase (it);
+        }
+    }
+  if (!newAddress.IsInvalid ())
+    {
+      m_inverseCache[newAddress].push_back (entry);
     }
 }
 
@@ -159,6 +188,8 @@ void NdiscCache::Flush ()
     }
 
   m_ndCache.erase (m_ndCache.begin (), m_ndCache.end ());
+  m_inverseCache.clear ();
+  m_unresolvedPackets = 0;
 }
 
 void NdiscCache::SetUnresQlen (uint32_t unresQlen)
@@ -251,25 +282,37 @@ void NdiscCache::Entry::AddWaitingPacket (Ipv6PayloadHeaderPair p)
 {
   NS_LOG_FUNCTION (this << p.second << p.first);
 
-  if (m_waiting.size () >= m_ndCache->GetUnresQlen ())
+  if (m_waiting.size () >= m_ndCache->GetUnresQlen ()
+      || (m_ndCache->m_unresolvedPackets >= m_ndCache->m_maxUnresolvedPackets && !m_waiting.empty ()))
     {
       /* we store only m_unresQlen packet => first packet in first packet remove */
       /** \todo report packet as 'dropped' */
       m_waiting.pop_front ();
+      m_ndCache->m_unresolvedPackets--;
     }
   m_waiting.push_back (p);
+  m_ndCache->m_unresolvedPackets++;
 }
 
 void NdiscCache::Entry::ClearWaitingPacket ()
 {
   NS_LOG_FUNCTION_NOARGS ();
   /** \todo report packets as 'dropped' */
+  m_ndCache->m_unresolvedPackets -= m_waiting.size ();
   m_waiting.clear ();
 }
 
 void NdiscCache::Entry::FunctionReachableTimeout ()
 {
   NS_LOG_FUNCTION_NOARGS ();
+  Time reachable = m_ndCache->m_icmpv6->GetReachableTime ();
+  Time elapsed = Simulator::Now () - m_lastReachabilityConfirmation;
+  if (elapsed < reachable)
+    {
+      /* confirmed since the timer was started */
+      m_nudTimer.Schedule (reachable - elapsed);
+      return;
+    }
   this->MarkStale ();
 }
 
@@ -408,6 +451,12 @@ void NdiscCache::Entry::SetIpv6Address (Ipv6Address ipv6Address)
   m_ipv6Address = ipv6Address;
 }
 
+Ipv6Address NdiscCache::Entry::GetIpv6Address () const
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return m_ipv6Address;
+}
+
 Time NdiscCache::Entry::GetLastReachabilityConfirmation () const
 {
   NS_LOG_FUNCTION_NOARGS ();
@@ -434,12 +483,12 @@ void NdiscCache::Entry::UpdateReachableTimer ()
 
   if (m_state == REACHABLE)
     {
+      /* a running timer restarts itself for the remaining time when it expires */
       m_lastReachabilityConfirmation = Simulator::Now ();
-      if (m_nudTimer.IsRunning ())
+      if (!m_nudTimer.IsRunning ())
         {
-          m_nudTimer.Cancel ();
+          m_nudTimer.Schedule ();
         }
-      m_nudTimer.Schedule ();
     }
 }
 
@@ -497,6 +546,7 @@ void NdiscCache::Entry::MarkIncomplete (Ipv6PayloadHeaderPair p)
   if (p.first)
     {
       m_waiting.push_back (p);
+      m_ndCache->m_unresolvedPackets++;
     }
 }
 
@@ -504,7 +554,7 @@ std::list<NdiscCache::Ipv6PayloadHeaderPair> NdiscCache::Entry::MarkReachable (A
 {
   NS_LOG_FUNCTION (this << mac);
   m_state = REACHABLE;
-  m_macAddress = mac;
+  SetMacAddress (mac);
   return m_waiting;
 }
 
@@ -530,7 +580,7 @@ std::list<NdiscCache::Ipv6PayloadHeaderPair> NdiscCache::Entry::MarkStale (Addre
 {
   NS_LOG_FUNCTION (this << mac);
   m_state = STALE;
-  m_macAddress = mac;
+  SetMacAddress (mac);
   return m_waiting;
 }
 
@@ -592,6 +642,7 @@ Address NdiscCache::Entry::GetMacAddress () const
 void NdiscCache::Entry::SetMacAddress (Address mac)
 {
   NS_LOG_FUNCTION (this << mac << int(m_state));
+  m_ndCache->UpdateInverse (this, m_macAddress, mac);
   m_macAddress = mac;
 }
 
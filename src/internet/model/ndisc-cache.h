@@ -23,6 +23,7 @@
 
 #include <stdint.h>
 #include <list>
+#include <vector>
 
 #include "ns3/packet.h"
 #include "ns3/nstime.h"
@@ -45,6 +46,14 @@ class Icmpv6L4Protocol;
  * \ingroup ipv6
  *
  * \brief IPv6 Neighbor Discovery cache.
+ *
+ * The entries are indexed by MAC address too, so that LookupInverse ()
+ * does not scan the cache.  The reachable timer of an entry is not
+ * rescheduled by every confirmation of reachability: when it expires,
+ * it is restarted for the remaining time if the neighbor has been
+ * confirmed meanwhile.  Besides the UnresolvedQueueSize limit of each
+ * entry, the packets waiting in all the entries are limited by
+ * MaxUnresolvedPackets.
  */
 class NdiscCache : public Object
 {
@@ -342,6 +351,12 @@ public:
      */
     void SetIpv6Address (Ipv6Address ipv6Address);
 
+    /**
+     * \brief Get the IPv6 address.
+     * \return the IPv6 address
+     */
+    Ipv6Address GetIpv6Address () const;
+
 private:
     /**
      * \brief The IPv6 address.
@@ -412,6 +427,19 @@ private:
    */
   typedef sgi::hash_map<Ipv6Address, NdiscCache::Entry *, Ipv6AddressHash>::iterator CacheI;
 
+  /**
+   * \brief Neighbor Discovery Cache index by MAC address
+   */
+  typedef sgi::hash_map<Address, std::vector<NdiscCache::Entry *>, AddressHash> InverseCache;
+
+  /**
+   * \brief Move an entry in the index by MAC address.
+   * \param entry the entry
+   * \param oldAddress the MAC address the entry is indexed by, if valid
+   * \param newAddress the MAC address to index the entry by, if valid
+   */
+  void UpdateInverse (NdiscCache::Entry *entry, const Address &oldAddress, const Address &newAddress);
+
   /**
    * \brief Copy constructor.
    *
@@ -452,10 +480,25 @@ private:
    */
   Cache m_ndCache;
 
+  /**
+   * \brief The entries, by MAC address.
+   */
+  InverseCache m_inverseCache;
+
   /**
    * \brief Max number of packet stored in m_waiting.
    */
   uint32_t m_unresQlen;
+
+  /**
+   * \brief Max number of packets stored in the m_waiting of all the entries.
+   */
+  uint32_t m_maxUnresolvedPackets;
+
+  /**
+   * \brief Number of packets stored in the m_waiting of all the entries.
+   */
+  uint32_t m_unresolvedPackets;
 };
 
 } /* namespace ns3 */
@@ -19,6 +19,7 @@
  */
 
 #include <iomanip>
+#include <vector>
 #include "ripng.h"
 #include "ns3/log.h"
 #include "ns3/abort.h"
@@ -527,6 +528,7 @@ void RipNg::DoDispose ()
 {
   NS_LOG_FUNCTION (this);
 
+  m_routeTrie.Clear ();
   for (RoutesI j = m_routes.begin ();  j != m_routes.end (); j = m_routes.erase (j))
     {
       delete j->first;
@@ -572,54 +574,51 @@ Ptr<Ipv6Route> RipNg::Lookup (Ipv6Address dst, Ptr<NetDevice> interface)
       return rtentry;
     }
 
-  for (RoutesI it = m_routes.begin (); it != m_routes.end (); it++)
+  /* the routes matching the destination, in routing table order */
+  std::vector<Ipv6RouteTrie::Entry> matches;
+  m_routeTrie.Lookup (dst, matches);
+  for (std::vector<Ipv6RouteTrie::Entry>::const_iterator it = matches.begin (); it != matches.end (); it++)
     {
-      RipNgRoutingTableEntry* j = it->first;
+      RipNgRoutingTableEntry* j = static_cast<RipNgRoutingTableEntry*> (it->m_route);
 
       if (j->GetRouteStatus () == RipNgRoutingTableEntry::RIPNG_VALID)
         {
           Ipv6Prefix mask = j->GetDestNetworkPrefix ();
           uint16_t maskLen = mask.GetPrefixLength ();
-          Ipv6Address entry = j->GetDestNetwork ();
 
-          NS_LOG_LOGIC ("Searching for route to " << dst << ", mask length " << maskLen);
+          NS_LOG_LOGIC ("Found global network route " << j << ", mask length " << maskLen);
 
-          if (mask.IsMatch (dst, entry))
+          /* if interface is given, check the route will output on this interface */
+          if (!interface || interface == m_ipv6->GetNetDevice (j->GetInterface ()))
             {
-              NS_LOG_LOGIC ("Found global network route " << j << ", mask length " << maskLen);
-
-              /* if interface is given, check the route will output on this interface */
-              if (!interface || interface == m_ipv6->GetNetDevice (j->GetInterface ()))
+              if (maskLen < longestMask)
                 {
-                  if (maskLen < longestMask)
-                    {
-                      NS_LOG_LOGIC ("Previous match longer, skipping");
-                      continue;
-                    }
-
-                  longestMask = maskLen;
+                  NS_LOG_LOGIC ("Previous match longer, skipping");
+                  continue;
+                }
 
-                  Ipv6RoutingTableEntry* route = j;
-                  uint32_t interfaceIdx = route->GetInterface ();
-                  rtentry = Create<Ipv6Route> ();
+              longestMask = maskLen;
 
-                  if (route->GetGateway ().IsAny ())
-                    {
-                      rtentry->SetSource (m_ipv6->SourceAddressSelection (interfaceIdx, route->GetDest ()));
-                    }
-                  else if (route->GetDest ().IsAny ()) /* default route */
-                    {
-                      rtentry->SetSource (m_ipv6->SourceAddressSelection (interfaceIdx, route->GetPrefixToUse ().IsAny () ? dst : route->GetPrefixToUse ()));
-                    }
-                  else
-                    {
-                      rtentry->SetSource (m_ipv6->SourceAddressSelection (interfaceIdx, route->GetDest ()));
-                    }
+              Ipv6RoutingTableEntry* route = j;
+              uint32_t interfaceIdx = route->GetInterface ();
+              rtentry = Create<Ipv6Route> ();
 
-                  rtentry->SetDestination (route->GetDest ());
-                  rtentry->SetGateway (route->GetGateway ());
-                  rtentry->SetOutputDevice (m_ipv6->GetNetDevice (interfaceIdx));
+              if (route->GetGateway ().IsAny ())
+                {
+                  rtentry->SetSource (m_ipv6->SourceAddressSelection (interfaceIdx, route->GetDest ()));
+                }
+              else if (route->GetDest ().IsAny ()) /* default route */
+                {
+                  rtentry->SetSource (m_ipv6->SourceAddressSelection (interfaceIdx, route->GetPrefixToUse ().IsAny () ? dst : route->GetPrefixToUse ()));
                 }
+              else
+                {
+                  rtentry->SetSource (m_ipv6->SourceAddressSelection (interfaceIdx, route->GetDest ()));
+                }
+
+              rtentry->SetDestination (route->GetDest ());
+              rtentry->SetGateway (route->GetGateway ());
+              rtentry->SetOutputDevice (m_ipv6->GetNetDevice (interfaceIdx));
             }
         }
     }
@@ -646,6 +645,7 @@ void RipNg::AddNetworkRouteTo (Ipv6Address network, Ipv6Prefix networkPrefix, Ip
   route->SetRouteChanged (true);
 
   m_routes.push_back (std::make_pair (route, EventId ()));
+  m_routeTrie.Add (route);
 }
 
 void RipNg::AddNetworkRouteTo (Ipv6Address network, Ipv6Prefix networkPrefix, uint32_t interface)
@@ -658,6 +658,7 @@ void RipNg::AddNetworkRouteTo (Ipv6Address network, Ipv6Prefix networkPrefix, ui
   route->SetRouteChanged (true);
 
   m_routes.push_back (std::make_pair (route, EventId ()));
+  m_routeTrie.Add (route);
 }
 
 void RipNg::InvalidateRoute (RipNgRoutingTableEntry *route)
@@ -690,6 +691,7 @@ void RipNg::DeleteRoute (RipNgRoutingTableEntry *route)
     {
       if (it->first == route)
         {
+          m_routeTrie.Remove (route);
           delete route;
           m_routes.erase (it);
           return;
@@ -998,6 +1000,7 @@ void RipNg::HandleResponses (RipNgHeader hdr, Ipv6Address senderAddress, uint32_
                   if (senderAddress != it->first->GetGateway ())
                     {
                       RipNgRoutingTableEntry* route = new RipNgRoutingTableEntry (rteAddr, rtePrefix, senderAddress, incomingInterface, Ipv6Address::GetAny ());
+                      m_routeTrie.Replace (it->first, route);
                       delete it->first;
                       it->first = route;
                     }
@@ -1025,6 +1028,7 @@ void RipNg::HandleResponses (RipNgHeader hdr, Ipv6Address senderAddress, uint32_
                           route->SetRouteStatus (RipNgRoutingTableEntry::RIPNG_VALID);
                           route->SetRouteTag (iter->GetRouteTag ());
                           route->SetRouteChanged (true);
+                          m_routeTrie.Replace (it->first, route);
                           delete it->first;
                           it->first = route;
                           it->second.Cancel ();
@@ -1062,6 +1066,7 @@ void RipNg::HandleResponses (RipNgHeader hdr, Ipv6Address senderAddress, uint32_
           route->SetRouteStatus (RipNgRoutingTableEntry::RIPNG_VALID);
           route->SetRouteChanged (true);
           m_routes.push_front (std::make_pair (route, EventId ()));
+          m_routeTrie.AddFront (route);
           EventId invalidateEvent = Simulator::Schedule (m_timeoutDelay, &RipNg::InvalidateRoute, this, route);
           (m_routes.begin ())->second = invalidateEvent;
           changed = true;
@@ -28,6 +28,7 @@
 #include "ns3/inet6-socket-address.h"
 #include "ns3/ipv6-l3-protocol.h"
 #include "ns3/ipv6-routing-table-entry.h"
+#include "ns3/ipv6-route-trie.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/ripng-header.h"
 
@@ -378,6 +379,7 @@ private:
   void DeleteRoute (RipNgRoutingTableEntry *route);
 
   Routes m_routes; //!<  the forwarding table for network.
+  Ipv6RouteTrie m_routeTrie; //!< the index of m_routes by destination.
   Ptr<Ipv6> m_ipv6; //!< IPv6 reference
   Time m_startupDelay; //!< Random delay before protocol startup.
   Time m_minTriggeredUpdateDelay; //!< Min cooldown delay after a Triggered Update.
@@ -32,6 +32,32 @@ NS_LOG_COMPONENT_DEFINE ("TcpHeader");
 
 NS_OBJECT_ENSURE_REGISTERED (TcpHeader);
 
+/**
+ * \brief Read a 32-bit value in network order
+ * \param p the first byte of the value
+ * \return the value
+ */
+static uint32_t
+ReadNtohU32 (const uint8_t *p)
+{
+  return (static_cast<uint32_t> (p[0]) << 24) | (static_cast<uint32_t> (p[1]) << 16)
+         | (static_cast<uint32_t> (p[2]) << 8) | p[3];
+}
+
+/**
+ * \brief Write a 32-bit value in network order
+ * \param p the first byte of the value
+ * \param value the value
+ */
+static void
+WriteHtonU32 (uint8_t *p, uint32_t value)
+{
+  p[0] = (value >> 24) & 0xff;
+  p[1] = (value >> 16) & 0xff;
+  p[2] = (value >> 8) & 0xff;
+  p[3] = value & 0xff;
+}
+
 TcpHeader::TcpHeader ()
   : m_sourcePort (0),
     m_destinationPort (0),
@@ -43,7 +69,8 @@ TcpHeader::TcpHeader ()
     m_urgentPointer (0),
     m_calcChecksum (false),
     m_goodChecksum (true),
-    m_optionsLen (0)
+    m_optionsLen (0),
+    m_optionsParsed (true)
 {
 }
 
@@ -295,6 +322,11 @@ TcpHeader::Print (std::ostream &os)  const
 
   os << " Seq=" << m_sequenceNumber << " Ack=" << m_ackNumber << " Win=" << m_windowSize;
 
+  if (!m_optionsParsed)
+    {
+      ParseOptions ();
+    }
+
   TcpOptionList::const_iterator op;
 
   for (op = m_options.begin (); op != m_options.end (); ++op)
@@ -327,14 +359,8 @@ TcpHeader::Serialize (Buffer::Iterator start)  const
   // Serialize options if they exist
   // This implementation does not presently try to align options on word
   // boundaries using NOP options
-  uint32_t optionLen = 0;
-  TcpOptionList::const_iterator op;
-  for (op = m_options.begin (); op != m_options.end (); ++op)
-    {
-      optionLen += (*op)->GetSerializedSize ();
-      (*op)->Serialize (i);
-      i.Next ((*op)->GetSerializedSize ());
-    }
+  uint32_t optionLen = m_optionsLen;
+  i.Write (m_optionBytes, m_optionsLen);
 
   // padding to word alignment; add ENDs and/or pad values (they are the same)
   while (optionLen % 4)
@@ -372,56 +398,67 @@ TcpHeader::Deserialize (Buffer::Iterator start)
   i.Next (2);
   m_urgentPointer = i.ReadNtohU16 ();
 
-  // Deserialize options if they exist
+  // Deserialize options if they exist. The options are only copied and
+  // checked here; the TcpOption objects are created on demand.
   m_options.clear ();
+  m_optionsParsed = false;
   uint32_t optionLen = (m_length - 5) * 4;
   if (optionLen > m_maxOptionsLen)
     {
       NS_LOG_ERROR ("Illegal TCP option length " << optionLen << "; options discarded");
       return 20;
     }
-  while (optionLen)
+  i.Read (m_optionBytes, optionLen);
+  while (m_optionsLen < optionLen)
     {
-      uint8_t kind = i.PeekU8 ();
-      Ptr<TcpOption> op;
-      uint32_t optionSize;
-      if (TcpOption::IsKindKnown (kind))
-        {
-          op = TcpOption::CreateOption (kind);
-        }
-      else
+      uint8_t kind = m_optionBytes[m_optionsLen];
+      if (kind == TcpOption::END)
         {
-          op = TcpOption::CreateOption (TcpOption::UNKNOWN);
-          NS_LOG_WARN ("Option kind " << static_cast<int> (kind) << " unknown, skipping.");
-        }
-      optionSize = op->Deserialize (i);
-      if (optionSize != op->GetSerializedSize ())
-        {
-          NS_LOG_ERROR ("Option did not deserialize correctly");
+          // Keep the padding bytes, which are not parsed
+          m_optionsLen = optionLen;
           break;
         }
-      if (optionLen >= optionSize)
+
+      uint32_t optionSize = 1;
+      if (kind != TcpOption::NOP)
         {
-          optionLen -= optionSize;
-          i.Next (optionSize);
-          m_options.push_back (op);
-          m_optionsLen += optionSize;
+          optionSize = (m_optionsLen + 1u < optionLen) ? m_optionBytes[m_optionsLen + 1] : 0;
+          bool valid;
+          switch (kind)
+            {
+            case TcpOption::MSS:
+              valid = (optionSize == 4);
+              break;
+            case TcpOption::WINSCALE:
+              valid = (optionSize == 3);
+              break;
+            case TcpOption::SACKPERMITTED:
+              valid = (optionSize == 2);
+              break;
+            case TcpOption::TS:
+              valid = (optionSize == 10);
+              break;
+            case TcpOption::SACK:
+              valid = (optionSize >= 2 && optionSize <= 2 + TcpOptionSack::SackList::MAX_BLOCKS * 8
+                       && (optionSize - 2) % 8 == 0);
+              break;
+            default:
+              NS_LOG_WARN ("Option kind " << static_cast<int> (kind) << " unknown, skipping.");
+              valid = (optionSize >= 2);
+              break;
+            }
+          if (!valid)
+            {
+              NS_LOG_ERROR ("Option did not deserialize correctly");
+              break;
+            }
         }
-      else
+      if (m_optionsLen + optionSize > optionLen)
         {
           NS_LOG_ERROR ("Option exceeds TCP option space; option discarded");
           break;
         }
-      if (op->GetKind () == TcpOption::END)
-        {
-          while (optionLen)
-            {
-              // Discard padding bytes without adding to option list
-              i.Next (1);
-              --optionLen;
-              ++m_optionsLen;
-            }
-        }
+      m_optionsLen += optionSize;
     }
 
   if (m_length != CalculateHeaderLength ())
@@ -444,19 +481,65 @@ TcpHeader::Deserialize (Buffer::Iterator start)
 uint8_t
 TcpHeader::CalculateHeaderLength () const
 {
-  uint32_t len = 20;
-  TcpOptionList::const_iterator i;
+  // Option list may not include padding; need to pad up to word boundary
+  uint32_t len = 20 + 3 + m_optionsLen;
+  return len >> 2;
+}
 
-  for (i = m_options.begin (); i != m_options.end (); ++i)
+const uint8_t *
+TcpHeader::FindOption (uint8_t kind) const
+{
+  uint32_t offset = 0;
+  while (offset < m_optionsLen)
     {
-      len += (*i)->GetSerializedSize ();
+      const uint8_t *option = m_optionBytes + offset;
+      if (option[0] == kind)
+        {
+          return option;
+        }
+      if (option[0] == TcpOption::END)
+        {
+          break;
+        }
+      offset += (option[0] == TcpOption::NOP) ? 1 : option[1];
     }
-  // Option list may not include padding; need to pad up to word boundary
-  if (len % 4)
+
+  return 0;
+}
+
+void
+TcpHeader::ParseOptions (void) const
+{
+  Buffer buffer;
+  buffer.AddAtStart (m_optionsLen);
+  buffer.Begin ().Write (m_optionBytes, m_optionsLen);
+
+  m_options.clear ();
+  Buffer::Iterator i = buffer.Begin ();
+  uint32_t offset = 0;
+  while (offset < m_optionsLen)
     {
-      len += 4 - (len % 4);
+      uint8_t kind = m_optionBytes[offset];
+      Ptr<TcpOption> op;
+      if (TcpOption::IsKindKnown (kind))
+        {
+          op = TcpOption::CreateOption (kind);
+        }
+      else
+        {
+          op = TcpOption::CreateOption (TcpOption::UNKNOWN);
+        }
+      uint32_t optionSize = op->Deserialize (i);
+      m_options.push_back (op);
+      if (kind == TcpOption::END)
+        {
+          // Discard padding bytes without adding to option list
+          break;
+        }
+      i.Next (optionSize);
+      offset += optionSize;
     }
-  return len >> 2;
+  m_optionsParsed = true;
 }
 
 bool
@@ -472,11 +555,18 @@ TcpHeader::AppendOption (Ptr<const TcpOption> option)
 
       if (option->GetKind () != TcpOption::END)
         {
-          m_options.push_back (option);
-          m_optionsLen += option->GetSerializedSize ();
+          uint32_t optionSize = option->GetSerializedSize ();
+          Buffer buffer;
+          buffer.AddAtStart (optionSize);
+          option->Serialize (buffer.Begin ());
+          buffer.CopyData (m_optionBytes + m_optionsLen, optionSize);
+          m_optionsLen += optionSize;
+          m_length = CalculateHeaderLength ();
 
-          uint32_t totalLen = 20 + 3 + m_optionsLen;
-          m_length = totalLen >> 2;
+          if (m_optionsParsed)
+            {
+              m_options.push_back (option);
+            }
         }
 
       return true;
@@ -485,15 +575,102 @@ TcpHeader::AppendOption (Ptr<const TcpOption> option)
   return false;
 }
 
+bool
+TcpHeader::AppendOptionTimestamp (uint32_t timestamp, uint32_t echo)
+{
+  if (m_optionsLen + 10 > m_maxOptionsLen)
+    {
+      return false;
+    }
+
+  uint8_t *option = m_optionBytes + m_optionsLen;
+  option[0] = TcpOption::TS;
+  option[1] = 10;
+  WriteHtonU32 (option + 2, timestamp);
+  WriteHtonU32 (option + 6, echo);
+  m_optionsLen += 10;
+  m_length = CalculateHeaderLength ();
+  m_optionsParsed = false;
+
+  return true;
+}
+
+bool
+TcpHeader::GetOptionTimestamp (uint32_t &timestamp, uint32_t &echo) const
+{
+  const uint8_t *option = FindOption (TcpOption::TS);
+  if (option == 0)
+    {
+      return false;
+    }
+
+  timestamp = ReadNtohU32 (option + 2);
+  echo = ReadNtohU32 (option + 6);
+  return true;
+}
+
+bool
+TcpHeader::AppendOptionSack (const TcpOptionSack::SackList &list)
+{
+  uint32_t optionSize = 2 + static_cast<uint32_t> (list.size ()) * 8;
+  if (m_optionsLen + optionSize > m_maxOptionsLen)
+    {
+      return false;
+    }
+
+  uint8_t *option = m_optionBytes + m_optionsLen;
+  option[0] = TcpOption::SACK;
+  option[1] = static_cast<uint8_t> (optionSize);
+  option += 2;
+  for (TcpOptionSack::SackList::const_iterator it = list.begin (); it != list.end (); ++it)
+    {
+      WriteHtonU32 (option, it->first.GetValue ());   // Left edge of the block
+      WriteHtonU32 (option + 4, it->second.GetValue ());  // Right edge of the block
+      option += 8;
+    }
+  m_optionsLen += optionSize;
+  m_length = CalculateHeaderLength ();
+  m_optionsParsed = false;
+
+  return true;
+}
+
+bool
+TcpHeader::GetOptionSack (TcpOptionSack::SackList &list) const
+{
+  const uint8_t *option = FindOption (TcpOption::SACK);
+  if (option == 0)
+    {
+      return false;
+    }
+
+  list.clear ();
+  for (uint32_t offset = 2; offset < option[1]; offset += 8)
+    {
+      list.push_back (TcpOptionSack::SackBlock (SequenceNumber32 (ReadNtohU32 (option + offset)),
+                                                SequenceNumber32 (ReadNtohU32 (option + offset + 4))));
+    }
+  return true;
+}
+
 const TcpHeader::TcpOptionList&
 TcpHeader::GetOptionList () const
 {
+  if (!m_optionsParsed)
+    {
+      ParseOptions ();
+    }
   return m_options;
 }
 
 Ptr<const TcpOption>
 TcpHeader::GetOption(uint8_t kind) const
 {
+  if (!m_optionsParsed)
+    {
+      ParseOptions ();
+    }
+
   TcpOptionList::const_iterator i;
 
   for (i = m_options.begin (); i != m_options.end (); ++i)
@@ -510,17 +687,7 @@ TcpHeader::GetOption(uint8_t kind) const
 bool
 TcpHeader::HasOption (uint8_t kind) const
 {
-  TcpOptionList::const_iterator i;
-
-  for (i = m_options.begin (); i != m_options.end (); ++i)
-    {
-      if ((*i)->GetKind () == kind)
-        {
-          return true;
-        }
-    }
-
-  return false;
+  return FindOption (kind) != 0;
 }
 
 bool
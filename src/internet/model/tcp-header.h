@@ -24,6 +24,7 @@
 #include <stdint.h>
 #include "ns3/header.h"
 #include "ns3/tcp-option.h"
+#include "ns3/tcp-option-sack.h"
 #include "ns3/buffer.h"
 #include "ns3/tcp-socket-factory.h"
 #include "ns3/ipv4-address.h"
@@ -39,6 +40,12 @@ namespace ns3 {
  * This class has fields corresponding to those in a network TCP header
  * (port numbers, sequence and acknowledgement numbers, flags, etc) as well
  * as methods for serialization to and deserialization from a byte buffer.
+ *
+ * The options are stored inline, in their serialized form. The TcpOption
+ * objects returned by GetOption and GetOptionList are only created the first
+ * time they are requested after a deserialization, while the timestamp and
+ * SACK options, which are present in most segments, can be read and written
+ * without creating any object through the dedicated methods.
  */
 
 class TcpHeader : public Header
@@ -182,6 +189,9 @@ public:
 
   /**
    * \brief Get the option specified
+   *
+   * The options are converted into TcpOption objects on the first call.
+   *
    * \param kind the option to retrieve
    * \return Whether the header contains a specific kind of option, or 0
    */
@@ -189,6 +199,9 @@ public:
 
   /**
    * \brief Get the list of option in this header
+   *
+   * The options are converted into TcpOption objects on the first call.
+   *
    * \return a const reference to the option list
    */
   const TcpOptionList& GetOptionList (void) const;
@@ -219,6 +232,36 @@ public:
    */
   bool AppendOption (Ptr<const TcpOption> option);
 
+  /**
+   * \brief Get the values of the timestamp option, if present
+   * \param timestamp the timestamp value
+   * \param echo the timestamp echo reply
+   * \return true if the header has the option, false otherwise
+   */
+  bool GetOptionTimestamp (uint32_t &timestamp, uint32_t &echo) const;
+
+  /**
+   * \brief Append a timestamp option to the TCP header
+   * \param timestamp the timestamp value
+   * \param echo the timestamp echo reply
+   * \return true if option has been appended, false otherwise
+   */
+  bool AppendOptionTimestamp (uint32_t timestamp, uint32_t echo);
+
+  /**
+   * \brief Get the blocks of the SACK option, if present
+   * \param list the list to fill with the SACK blocks
+   * \return true if the header has the option, false otherwise
+   */
+  bool GetOptionSack (TcpOptionSack::SackList &list) const;
+
+  /**
+   * \brief Append a SACK option to the TCP header
+   * \param list the SACK blocks
+   * \return true if option has been appended, false otherwise
+   */
+  bool AppendOptionSack (const TcpOptionSack::SackList &list);
+
   /**
    * \brief Initialize the TCP checksum.
    *
@@ -332,6 +375,18 @@ private:
    */
   uint8_t CalculateHeaderLength () const;
 
+  /**
+   * \brief Find an option in the serialized options
+   * \param kind the option to find
+   * \return a pointer to the first byte of the option, or 0
+   */
+  const uint8_t * FindOption (uint8_t kind) const;
+
+  /**
+   * \brief Create the TcpOption objects of the serialized options
+   */
+  void ParseOptions (void) const;
+
   uint16_t m_sourcePort;        //!< Source port
   uint16_t m_destinationPort;   //!< Destination port
   SequenceNumber32 m_sequenceNumber;  //!< Sequence number
@@ -349,8 +404,10 @@ private:
   bool m_goodChecksum;    //!< Flag to indicate that checksum is correct
 
   static const uint8_t m_maxOptionsLen = 40;         //!< Maximum options length
-  TcpOptionList m_options;     //!< TcpOption present in the header
+  uint8_t m_optionBytes[m_maxOptionsLen]; //!< Serialized Tcp options
   uint8_t m_optionsLen;        //!< Tcp options length.
+  mutable TcpOptionList m_options;  //!< TcpOption present in the header, created on demand
+  mutable bool m_optionsParsed;     //!< True if m_options matches the serialized options
 };
 
 } // namespace ns3
@@ -108,7 +108,12 @@ TcpOptionSack::Deserialize (Buffer::Iterator start)
 
   uint8_t size = i.ReadU8 ();
   NS_LOG_LOGIC ("Size: " << static_cast<uint32_t> (size));
-  m_sackList.empty ();
+  if (size < 2 || size > 2 + SackList::MAX_BLOCKS * 8)
+    {
+      NS_LOG_WARN ("Malformed SACK option, wrong length");
+      return 0;
+    }
+  m_sackList.clear ();
   uint8_t sackCount = (size - 2) / 8;
   while (sackCount)
     {
@@ -132,6 +137,7 @@ void
 TcpOptionSack::AddSackBlock (SackBlock s)
 {
   NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (!m_sackList.full (), "A SACK option holds at most " << SackList::MAX_BLOCKS << " blocks");
   m_sackList.push_back (s);
 }
 
@@ -149,7 +155,7 @@ TcpOptionSack::ClearSackList (void)
   m_sackList.clear ();
 }
 
-TcpOptionSack::SackList
+const TcpOptionSack::SackList &
 TcpOptionSack::GetSackList (void) const
 {
   NS_LOG_FUNCTION (this);
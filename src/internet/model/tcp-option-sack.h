@@ -28,6 +28,7 @@
 
 #include "ns3/tcp-option.h"
 #include "ns3/sequence-number.h"
+#include "ns3/assert.h"
 
 namespace ns3 {
 
@@ -57,7 +58,160 @@ public:
   virtual TypeId GetInstanceTypeId (void) const;
 
   typedef std::pair<SequenceNumber32, SequenceNumber32> SackBlock; //!< SACK block definition
-  typedef std::list<SackBlock> SackList;                           //!< SACK list definition
+
+  /**
+   * \brief SACK list definition
+   *
+   * The 40 bytes of TCP options fit at most 4 SACK blocks, so the blocks are
+   * stored inline in a fixed-size array, in order to copy a SACK list
+   * without allocating memory. The interface is the subset of std::list used
+   * to manage the SACK blocks.
+   */
+  class SackList
+  {
+  public:
+    static const uint32_t MAX_BLOCKS = 4;   //!< Maximum number of SACK blocks
+
+    typedef SackBlock * iterator;               //!< Iterator on the SACK blocks
+    typedef const SackBlock * const_iterator;   //!< Const iterator on the SACK blocks
+
+    SackList ()
+      : m_size (0)
+    {
+    }
+
+    /**
+     * \brief Get an iterator on the first block
+     * \return the iterator
+     */
+    iterator begin (void)
+    {
+      return m_blocks;
+    }
+    /**
+     * \brief Get an iterator past the last block
+     * \return the iterator
+     */
+    iterator end (void)
+    {
+      return m_blocks + m_size;
+    }
+    /**
+     * \brief Get a const iterator on the first block
+     * \return the iterator
+     */
+    const_iterator begin (void) const
+    {
+      return m_blocks;
+    }
+    /**
+     * \brief Get a const iterator past the last block
+     * \return the iterator
+     */
+    const_iterator end (void) const
+    {
+      return m_blocks + m_size;
+    }
+    /**
+     * \brief Get the number of blocks
+     * \return the number of blocks
+     */
+    std::size_t size (void) const
+    {
+      return m_size;
+    }
+    /**
+     * \brief Check if the list is empty
+     * \return true if the list holds no block
+     */
+    bool empty (void) const
+    {
+      return m_size == 0;
+    }
+    /**
+     * \brief Check if the list is full
+     * \return true if the list holds MAX_BLOCKS blocks
+     */
+    bool full (void) const
+    {
+      return m_size == MAX_BLOCKS;
+    }
+    /**
+     * \brief Get the first block
+     * \return the first block
+     */
+    const SackBlock & front (void) const
+    {
+      NS_ASSERT (m_size > 0);
+      return m_blocks[0];
+    }
+    /**
+     * \brief Get the last block
+     * \return the last block
+     */
+    const SackBlock & back (void) const
+    {
+      NS_ASSERT (m_size > 0);
+      return m_blocks[m_size - 1];
+    }
+    /**
+     * \brief Add a block at the end of the list
+     * \param s the block
+     */
+    void push_back (const SackBlock &s)
+    {
+      NS_ASSERT_MSG (m_size < MAX_BLOCKS, "Too many SACK blocks");
+      m_blocks[m_size++] = s;
+    }
+    /**
+     * \brief Add a block at the beginning of the list
+     * \param s the block
+     */
+    void push_front (const SackBlock &s)
+    {
+      NS_ASSERT_MSG (m_size < MAX_BLOCKS, "Too many SACK blocks");
+      for (uint32_t i = m_size; i > 0; --i)
+        {
+          m_blocks[i] = m_blocks[i - 1];
+        }
+      m_blocks[0] = s;
+      ++m_size;
+    }
+    /**
+     * \brief Remove the last block
+     */
+    void pop_back (void)
+    {
+      NS_ASSERT (m_size > 0);
+      --m_size;
+    }
+    /**
+     * \brief Remove a block
+     * \param it an iterator on the block
+     * \return an iterator on the block following the removed one
+     */
+    iterator erase (iterator it)
+    {
+      NS_ASSERT (it >= begin () && it < end ());
+      for (iterator next = it + 1; next != end (); ++next)
+        {
+          *(next - 1) = *next;
+        }
+      --m_size;
+      return it;
+    }
+    /**
+     * \brief Remove all the blocks
+     */
+    void clear (void)
+    {
+      m_size = 0;
+    }
+
+  private:
+    SackBlock m_blocks[MAX_BLOCKS];   //!< The blocks
+    uint32_t m_size;                  //!< Number of blocks
+  };
 
   TcpOptionSack ();
   virtual ~TcpOptionSack ();
@@ -90,7 +244,7 @@ public:
    * \brief Get the SACK list
    * \return the SACK list
    */
-  SackList GetSackList (void) const;
+  const SackList & GetSackList (void) const;
 
   friend std::ostream & operator<< (std::ostream & os, TcpOptionSack const & sackOption);
 
@@ -155,8 +155,13 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
       if (maxSeq < tailSeq) tailSeq = maxSeq;
       if (tailSeq < headSeq) headSeq = tailSeq;
     }
-  // Remove overlapped bytes from packet
-  BufIterator i = m_data.begin ();
+  // Remove overlapped bytes from packet. The segments do not overlap, so
+  // only the last one starting at or before headSeq may reach past it
+  BufIterator i = m_data.upper_bound (headSeq);
+  if (i != m_data.begin ())
+    {
+      --i;
+    }
   while (i != m_data.end () && i->first <= tailSeq)
     {
       SequenceNumber32 lastByteSeq = i->first + SequenceNumber32 (i->second->GetSize ());
@@ -196,27 +201,22 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
   NS_ASSERT (m_data.find (headSeq) == m_data.end ()); // Shouldn't be there yet
   m_data [ headSeq ] = p;
 
-  if (headSeq > m_nextRxSeq)
-    {
-      // Generate a new SACK block
-      UpdateSackList (headSeq, tailSeq);
-    }
-
   NS_LOG_LOGIC ("Buffered packet of seqno=" << headSeq << " len=" << p->GetSize ());
   // Update variables
   m_size += p->GetSize ();      // Occupancy
-  for (i = m_data.begin (); i != m_data.end (); ++i)
+  std::pair<SequenceNumber32, SequenceNumber32> block = AddBlock (headSeq, tailSeq);
+  if (block.first > m_nextRxSeq)
     {
-      if (i->first < m_nextRxSeq)
-        {
-          continue;
-        }
-      else if (i->first > m_nextRxSeq)
-        {
-          break;
-        };
-      m_nextRxSeq = i->first + SequenceNumber32 (i->second->GetSize ());
-      m_availBytes += i->second->GetSize ();
+      // Generate a new SACK block
+      UpdateSackList (block.first, block.second);
+    }
+  else
+    {
+      // The hole before the block is filled: all of it is now in order
+      NS_ASSERT (block.first == m_nextRxSeq);
+      m_blocks.erase (block.first);
+      m_availBytes += static_cast<uint32_t> (block.second - m_nextRxSeq.Get ());
+      m_nextRxSeq = block.second;
       ClearSackList (m_nextRxSeq);
     }
   NS_LOG_LOGIC ("Updated buffer occupancy=" << m_size << " nextRxSeq=" << m_nextRxSeq);
@@ -227,6 +227,40 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
   return true;
 }
 
+std::pair<SequenceNumber32, SequenceNumber32>
+TcpRxBuffer::AddBlock (const SequenceNumber32 &head, const SequenceNumber32 &tail)
+{
+  NS_LOG_FUNCTION (this << head << tail);
+
+  SequenceNumber32 first = head;
+  SequenceNumber32 last = tail;
+
+  // Merge with the block before, if it reaches the range...
+  std::map<SequenceNumber32, SequenceNumber32>::iterator it = m_blocks.upper_bound (head);
+  if (it != m_blocks.begin ())
+    {
+      std::map<SequenceNumber32, SequenceNumber32>::iterator prev = it;
+      --prev;
+      if (prev->second >= head)
+        {
+          first = prev->first;
+          it = prev;
+        }
+    }
+  // ...and with all the blocks which start inside or right after it
+  while (it != m_blocks.end () && it->first <= tail)
+    {
+      if (it->second > last)
+        {
+          last = it->second;
+        }
+      m_blocks.erase (it++);
+    }
+
+  m_blocks[first] = last;
+  return std::make_pair (first, last);
+}
+
 uint32_t
 TcpRxBuffer::GetSackListSize () const
 {
@@ -271,65 +305,34 @@ TcpRxBuffer::UpdateSackList (const SequenceNumber32 &head, const SequenceNumber3
   //     following SACK blocks in the SACK option may be listed in
   //     arbitrary order.
 
-  m_sackList.push_front (current);
-
-  // We have inserted the block at the beginning of the list. Now, we should
-  // check if any existing blocks overlap with that.
-  bool updated = false;
+  // The block is the whole contiguous block of out-of-order data, so the
+  // blocks previously reported which it has absorbed are now subsets of it:
+  // remove them, and insert the block at the beginning of the list.
   TcpOptionSack::SackList::iterator it = m_sackList.begin ();
-  TcpOptionSack::SackBlock begin = *it;
-  TcpOptionSack::SackBlock merged;
-  ++it;
-
-  // Iterates until we examined all blocks in the list (maximum 4)
   while (it != m_sackList.end ())
     {
-      current = *it;
-
-      // This is a left merge:
-      // [current_first; current_second] [beg_first; beg_second]
-      if (begin.first == current.second)
-        {
-          NS_ASSERT (current.first < begin.second);
-          merged = TcpOptionSack::SackBlock (current.first, begin.second);
-          updated = true;
-        }
-      // while this is a right merge
-      // [begin_first; begin_second] [current_first; current_second]
-      else if (begin.second == current.first)
+      if (it->first >= head && it->second <= tail)
         {
-          NS_ASSERT (begin.first < current.second);
-          merged = TcpOptionSack::SackBlock (begin.first, current.second);
-          updated = true;
+          it = m_sackList.erase (it);
         }
-
-      // If we have merged the blocks (and the result is in merged) we should
-      // delete the current block (it), the first block, and insert the merged
-      // one at the beginning.
-      if (updated)
+      else
         {
-          m_sackList.erase (it);
-          m_sackList.pop_front ();
-          m_sackList.push_front (merged);
-          it = m_sackList.begin ();
-          begin = *it;
-          updated = false;
+          ++it;
         }
-
-      ++it;
     }
 
   // Since the maximum blocks that fits into a TCP header are 4, there's no
   // point on maintaining the others.
-  if (m_sackList.size () > 4)
+  if (m_sackList.full ())
     {
       m_sackList.pop_back ();
     }
 
+  m_sackList.push_front (current);
+
   // Please note that, if a block b is discarded and then a block contiguous
-  // to b is received, only that new block (without the b part) is reported.
-  // This is perfectly fine for the RFC point (a), given that we do not report any
-  // overlapping blocks shortly after.
+  // to b is received, the first block reported still covers b, since it is
+  // taken from the blocks of out-of-order data and not from this list.
 }
 
 void
@@ -354,7 +357,7 @@ TcpRxBuffer::ClearSackList (const SequenceNumber32 &seq)
     }
 }
 
-TcpOptionSack::SackList
+const TcpOptionSack::SackList &
 TcpRxBuffer::GetSackList () const
 {
   return m_sackList;
@@ -369,7 +372,7 @@ TcpRxBuffer::Extract (uint32_t maxSize)
   NS_LOG_LOGIC ("Requested to extract " << extractSize << " bytes from TcpRxBuffer of size=" << m_size);
   if (extractSize == 0) return nullptr;  // No contiguous block to return
   NS_ASSERT (m_data.size ()); // At least we have something to extract
-  Ptr<Packet> outPkt = Create<Packet> (); // The packet that contains all the data to return
+  Ptr<Packet> outPkt; // The packet that contains all the data to return
   BufIterator i;
   while (extractSize)
     { // Check the buffered data for delivery
@@ -379,7 +382,14 @@ TcpRxBuffer::Extract (uint32_t maxSize)
       uint32_t pktSize = i->second->GetSize ();
       if (pktSize <= extractSize)
         { // Whole packet is extracted
-          outPkt->AddAtEnd (i->second);
+          if (outPkt == nullptr)
+            { // Copy-on-write: the payload itself is not copied
+              outPkt = i->second->Copy ();
+            }
+          else
+            {
+              outPkt->AddAtEnd (i->second);
+            }
           m_data.erase (i);
           m_size -= pktSize;
           m_availBytes -= pktSize;
@@ -387,7 +397,15 @@ TcpRxBuffer::Extract (uint32_t maxSize)
         }
       else
         { // Partial is extracted and done
-          outPkt->AddAtEnd (i->second->CreateFragment (0, extractSize));
+          Ptr<Packet> part = i->second->CreateFragment (0, extractSize);
+          if (outPkt == nullptr)
+            {
+              outPkt = part;
+            }
+          else
+            {
+              outPkt->AddAtEnd (part);
+            }
           m_data[i->first + SequenceNumber32 (extractSize)] = i->second->CreateFragment (extractSize, pktSize - extractSize);
           m_data.erase (i);
           m_size -= extractSize;
@@ -400,6 +418,9 @@ TcpRxBuffer::Extract (uint32_t maxSize)
       NS_LOG_LOGIC ("Nothing extracted.");
       return nullptr;
     }
+  // The packet tags of the received segments stop at the TCP layer, as when
+  // the data was copied into a new packet
+  outPkt->RemoveAllPacketTags ();
   NS_LOG_LOGIC ("Extracted " << outPkt->GetSize ( ) << " bytes, bufsize=" << m_size
                              << ", num pkts in buffer=" << m_data.size ());
   return outPkt;
@@ -53,6 +53,14 @@ class Packet;
  * To store data, use Add; for retrieving a certain amount of ordered data, use
  * the method Extract.
  *
+ * Besides the segments, the buffer keeps the contiguous blocks of
+ * out-of-order data, ordered by sequence number: a segment is merged with
+ * its neighbours in logarithmic time, and when the hole before a block is
+ * filled, the next expected sequence jumps to the end of the whole block.
+ * The segments themselves are not merged, since ns-3 packets cannot be
+ * chained without copying their data; Extract hands over the head segment
+ * as it is when it fits in the requested size.
+ *
  * SACK list
  * ---------
  *
@@ -166,7 +174,7 @@ public:
    *
    * \return a list of isolated blocks
    */
-  TcpOptionSack::SackList GetSackList () const;
+  const TcpOptionSack::SackList & GetSackList () const;
 
   /**
    * \brief Get the size of Sack list
@@ -182,6 +190,17 @@ public:
   bool GotFin () const { return m_gotFin; }
 
 private:
+  /**
+   * \brief Add a range of data to the blocks of out-of-order data, merging
+   * it with the blocks it touches
+   *
+   * \param head first sequence number of the range
+   * \param tail sequence number following the range
+   * \return the block which contains the range
+   */
+  std::pair<SequenceNumber32, SequenceNumber32> AddBlock (const SequenceNumber32 &head,
+                                                           const SequenceNumber32 &tail);
+
   /**
    * \brief Update the sack list, with the block seq starting at the beginning
    *
@@ -197,6 +216,10 @@ private:
    * (or other) options, it is even less. For more detail about this function,
    * please see the source code and in-line comments.
    *
+   * The block is the whole contiguous block of out-of-order data which
+   * contains the last segment received, so that the blocks already in the
+   * list which are part of it are dropped.
+   *
    * \param head sequence number of the block at the beginning
    * \param tail sequence number of the block at the end
    */
@@ -226,6 +249,8 @@ private:
   uint32_t m_maxBuffer;                      //!< Upper bound of the number of data bytes in buffer (RCV.WND)
   uint32_t m_availBytes;                     //!< Number of bytes available to read, i.e. contiguous block at head
   std::map<SequenceNumber32, Ptr<Packet> > m_data; //!< Corresponding data (may be null)
+  /// Contiguous blocks of data beyond m_nextRxSeq, from their head to their tail
+  std::map<SequenceNumber32, SequenceNumber32> m_blocks;
 };
 
 } //namespace ns3
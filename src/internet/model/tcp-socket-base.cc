@@ -43,6 +43,7 @@
 #include "ns3/trace-source-accessor.h"
 #include "ns3/data-rate.h"
 #include "ns3/object.h"
+#include "ns3/tso-tag.h"
 #include "tcp-socket-base.h"
 #include "tcp-l4-protocol.h"
 #include "ipv4-end-point.h"
@@ -141,6 +142,12 @@ TcpSocketBase::GetTypeId (void)
                    BooleanValue (true),
                    MakeBooleanAccessor (&TcpSocketBase::m_limitedTx),
                    MakeBooleanChecker ())
+    .AddAttribute ("TsoSegments",
+                   "Maximum number of full segments of new data sent as one "
+                   "super-segment (segmentation offload emulation); 1 disables it",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&TcpSocketBase::m_tsoSegments),
+                   MakeUintegerChecker<uint32_t> (1))
     .AddAttribute ("EcnMode", "Determines the mode of ECN",
                    EnumValue (EcnMode_t::NoEcn),
                    MakeEnumAccessor (&TcpSocketBase::m_ecnMode),
@@ -326,6 +333,7 @@ TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
     m_sndWindShift (sock.m_sndWindShift),
     m_timestampEnabled (sock.m_timestampEnabled),
     m_timestampToEcho (sock.m_timestampToEcho),
+    m_tsoSegments (sock.m_tsoSegments),
     m_recover (sock.m_recover),
     m_retxThresh (sock.m_retxThresh),
     m_limitedTx (sock.m_limitedTx),
@@ -1284,10 +1292,10 @@ TcpSocketBase::DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
         }
 
       // When receiving a <SYN> or <SYN-ACK> we should adapt TS to the other end
-      if (tcpHeader.HasOption (TcpOption::TS) && m_timestampEnabled)
+      uint32_t timestamp, echo;
+      if (m_timestampEnabled && tcpHeader.GetOptionTimestamp (timestamp, echo))
         {
-          ProcessOptionTimestamp (tcpHeader.GetOption (TcpOption::TS),
-                                  tcpHeader.GetSequenceNumber ());
+          ProcessOptionTimestamp (timestamp, echo, tcpHeader.GetSequenceNumber ());
         }
       else
         {
@@ -1310,7 +1318,8 @@ TcpSocketBase::DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
       NS_ASSERT (!(tcpHeader.GetFlags () & TcpHeader::SYN));
       if (m_timestampEnabled)
         {
-          if (!tcpHeader.HasOption (TcpOption::TS))
+          uint32_t timestamp, echo;
+          if (!tcpHeader.GetOptionTimestamp (timestamp, echo))
             {
               // Ignoring segment without TS, RFC 7323
               NS_LOG_LOGIC ("At state " << TcpStateName[m_state] <<
@@ -1321,8 +1330,7 @@ TcpSocketBase::DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
             }
           else
             {
-              ProcessOptionTimestamp (tcpHeader.GetOption (TcpOption::TS),
-                                      tcpHeader.GetSequenceNumber ());
+              ProcessOptionTimestamp (timestamp, echo, tcpHeader.GetSequenceNumber ());
             }
         }
 
@@ -1509,22 +1517,12 @@ void
 TcpSocketBase::ReadOptions (const TcpHeader &tcpHeader, bool &scoreboardUpdated)
 {
   NS_LOG_FUNCTION (this << tcpHeader);
-  TcpHeader::TcpOptionList::const_iterator it;
-  const TcpHeader::TcpOptionList options = tcpHeader.GetOptionList ();
 
-  for (it = options.begin (); it != options.end (); ++it)
+  // Check only for ACK options here
+  TcpOptionSack::SackList sackList;
+  if (tcpHeader.GetOptionSack (sackList))
     {
-      const Ptr<const TcpOption> option = (*it);
-
-      // Check only for ACK options here
-      switch (option->GetKind ())
-        {
-        case TcpOption::SACK:
-          scoreboardUpdated = ProcessOptionSack (option);
-          break;
-        default:
-          continue;
-        }
+      scoreboardUpdated = ProcessOptionSack (sackList);
     }
 }
 
@@ -2888,6 +2886,13 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
 
   AddSocketTags (p);
 
+  if (sz > m_tcb->m_segmentSize)
+    {
+      // A super-segment: the devices model it as the segments it stands for
+      TsoTag tso ((sz + m_tcb->m_segmentSize - 1) / m_tcb->m_segmentSize, sz);
+      p->AddPacketTag (tso);
+    }
+
   if (m_closeOnEmpty && (remainingData == 0))
     {
       flags |= TcpHeader::FIN;
@@ -3076,6 +3081,14 @@ TcpSocketBase::SendPendingData (bool withAck)
             }
 
           uint32_t s = std::min (availableWindow, m_tcb->m_segmentSize);
+          if (m_tsoSegments > 1 && next == m_tcb->m_highTxMark
+              && availableWindow >= 2 * m_tcb->m_segmentSize)
+            {
+              // Segmentation offload: send the full segments of new data the
+              // window allows in one super-segment
+              uint32_t segments = std::min (availableWindow / m_tcb->m_segmentSize, m_tsoSegments);
+              s = segments * m_tcb->m_segmentSize;
+            }
 
           // (C.2) If any of the data octets sent in (C.1) are below HighData,
           //       HighRxt MUST be set to the highest sequence number of the
@@ -3230,6 +3243,11 @@ TcpSocketBase::ReceivedData (Ptr<Packet> p, const TcpHeader& tcpHeader)
   NS_LOG_DEBUG ("Data segment, seq=" << tcpHeader.GetSequenceNumber () <<
                 " pkt size=" << p->GetSize () );
 
+  // A super-segment counts as the segments it stands for. Its tag stops
+  // at the TCP layer.
+  TsoTag tso;
+  uint32_t segments = p->RemovePacketTag (tso) ? tso.GetSegments () : 1;
+
   // Put into Rx buffer
   SequenceNumber32 expectedSeq = m_rxBuffer->NextRxSequence ();
   if (!m_rxBuffer->Add (p, tcpHeader))
@@ -3283,7 +3301,8 @@ TcpSocketBase::ReceivedData (Ptr<Packet> p, const TcpHeader& tcpHeader)
     }
   else
     { // In-sequence packet: ACK if delayed ack count allows
-      if (++m_delAckCount >= m_delAckMaxCount)
+      m_delAckCount += segments;
+      if (m_delAckCount >= m_delAckMaxCount)
         {
           m_delAckEvent.Cancel ();
           m_delAckCount = 0;
@@ -3331,11 +3350,10 @@ TcpSocketBase::EstimateRtt (const TcpHeader& tcpHeader)
       RttHistory& h = m_history.front ();
       if (!h.retx && ackSeq >= (h.seq + SequenceNumber32 (h.count)))
         { // Ok to use this sample
-          if (m_timestampEnabled && tcpHeader.HasOption (TcpOption::TS))
+          uint32_t timestamp, echo;
+          if (m_timestampEnabled && tcpHeader.GetOptionTimestamp (timestamp, echo))
             {
-              Ptr<const TcpOptionTS> ts;
-              ts = DynamicCast<const TcpOptionTS> (tcpHeader.GetOption (TcpOption::TS));
-              m = TcpOptionTS::ElapsedTimeFromTsValue (ts->GetEcho ());
+              m = TcpOptionTS::ElapsedTimeFromTsValue (echo);
             }
           else
             {
@@ -3940,12 +3958,10 @@ TcpSocketBase::AddOptionWScale (TcpHeader &header)
 }
 
 bool
-TcpSocketBase::ProcessOptionSack (const Ptr<const TcpOption> option)
+TcpSocketBase::ProcessOptionSack (const TcpOptionSack::SackList &list)
 {
-  NS_LOG_FUNCTION (this << option);
+  NS_LOG_FUNCTION (this);
 
-  Ptr<const TcpOptionSack> s = DynamicCast<const TcpOptionSack> (option);
-  TcpOptionSack::SackList list = s->GetSackList ();
   return m_txBuffer->Update (list);
 }
 
@@ -3980,7 +3996,7 @@ TcpSocketBase::AddOptionSack (TcpHeader& header)
   uint8_t optionLenAvail = header.GetMaxOptionLength () - header.GetOptionLength ();
   uint8_t allowedSackBlocks = (optionLenAvail - 2) / 8;
 
-  TcpOptionSack::SackList sackList = m_rxBuffer->GetSackList ();
+  const TcpOptionSack::SackList &sackList = m_rxBuffer->GetSackList ();
   if (allowedSackBlocks == 0 || sackList.empty ())
     {
       NS_LOG_LOGIC ("No space available or sack list empty, not adding sack blocks");
@@ -3988,44 +4004,42 @@ TcpSocketBase::AddOptionSack (TcpHeader& header)
     }
 
   // Append the allowed number of SACK blocks
-  Ptr<TcpOptionSack> option = CreateObject<TcpOptionSack> ();
-  TcpOptionSack::SackList::iterator i;
+  TcpOptionSack::SackList option;
+  TcpOptionSack::SackList::const_iterator i;
   for (i = sackList.begin (); allowedSackBlocks > 0 && i != sackList.end (); ++i)
     {
-      option->AddSackBlock (*i);
+      option.push_back (*i);
       allowedSackBlocks--;
     }
 
-  header.AppendOption (option);
-  NS_LOG_INFO (m_node->GetId () << " Add option SACK " << *option);
+  header.AppendOptionSack (option);
+  NS_LOG_INFO (m_node->GetId () << " Add option SACK with " << option.size () << " blocks");
 }
 
 void
-TcpSocketBase::ProcessOptionTimestamp (const Ptr<const TcpOption> option,
+TcpSocketBase::ProcessOptionTimestamp (uint32_t timestamp, uint32_t echo,
                                        const SequenceNumber32 &seq)
 {
-  NS_LOG_FUNCTION (this << option);
-
-  Ptr<const TcpOptionTS> ts = DynamicCast<const TcpOptionTS> (option);
+  NS_LOG_FUNCTION (this << timestamp << echo << seq);
 
   // This is valid only when no overflow occurs. It happens
   // when a connection last longer than 50 days.
-  if (m_tcb->m_rcvTimestampValue > ts->GetTimestamp ())
+  if (m_tcb->m_rcvTimestampValue > timestamp)
     {
       // Do not save a smaller timestamp (probably there is reordering)
       return;
     }
 
-  m_tcb->m_rcvTimestampValue = ts->GetTimestamp ();
-  m_tcb->m_rcvTimestampEchoReply = ts->GetEcho ();
+  m_tcb->m_rcvTimestampValue = timestamp;
+  m_tcb->m_rcvTimestampEchoReply = echo;
 
   if (seq == m_rxBuffer->NextRxSequence () && seq <= m_highTxAck)
     {
-      m_timestampToEcho = ts->GetTimestamp ();
+      m_timestampToEcho = timestamp;
     }
 
   NS_LOG_INFO (m_node->GetId () << " Got timestamp=" <<
-               m_timestampToEcho << " and Echo="     << ts->GetEcho ());
+               m_timestampToEcho << " and Echo="     << echo);
 }
 
 void
@@ -4033,14 +4047,10 @@ TcpSocketBase::AddOptionTimestamp (TcpHeader& header)
 {
   NS_LOG_FUNCTION (this << header);
 
-  Ptr<TcpOptionTS> option = CreateObject<TcpOptionTS> ();
-
-  option->SetTimestamp (TcpOptionTS::NowToTsValue ());
-  option->SetEcho (m_timestampToEcho);
-
-  header.AppendOption (option);
+  uint32_t timestamp = TcpOptionTS::NowToTsValue ();
+  header.AppendOptionTimestamp (timestamp, m_timestampToEcho);
   NS_LOG_INFO (m_node->GetId () << " Add option TS, ts=" <<
-               option->GetTimestamp () << " echo=" << m_timestampToEcho);
+               timestamp << " echo=" << m_timestampToEcho);
 }
 
 void TcpSocketBase::UpdateWindowSize (const TcpHeader &header)
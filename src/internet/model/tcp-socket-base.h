@@ -32,6 +32,7 @@
 #include "ns3/data-rate.h"
 #include "ns3/node.h"
 #include "ns3/tcp-socket-state.h"
+#include "ns3/tcp-option-sack.h"
 
 namespace ns3 {
 
@@ -1105,10 +1106,10 @@ protected:
   /**
    * \brief Read the SACK option
    *
-   * \param option SACK option from the header
+   * \param list SACK blocks of the option from the header
    * \returns true in case of an update to the SACKed blocks
    */
-  bool ProcessOptionSack (const Ptr<const TcpOption> option);
+  bool ProcessOptionSack (const TcpOptionSack::SackList &list);
 
   /**
    * \brief Add the SACK PERMITTED option to the header
@@ -1131,10 +1132,11 @@ protected:
    * to utilize later to calculate RTT.
    *
    * \see EstimateRtt
-   * \param option Option from the segment
+   * \param timestamp Timestamp value of the option from the segment
+   * \param echo Timestamp echo reply of the option from the segment
    * \param seq Sequence number of the segment
    */
-  void ProcessOptionTimestamp (const Ptr<const TcpOption> option,
+  void ProcessOptionTimestamp (uint32_t timestamp, uint32_t echo,
                                const SequenceNumber32 &seq);
   /**
    * \brief Add the timestamp option to the header
@@ -1241,6 +1243,7 @@ protected:
   uint8_t m_sndWindShift      {0};    //!< Window shift to apply to incoming segments
   bool     m_timestampEnabled {true}; //!< Timestamp option enabled
   uint32_t m_timestampToEcho  {0};    //!< Timestamp to echo
+  uint32_t m_tsoSegments      {1};    //!< Max segments per super-segment (1: no segmentation offload)
 
   EventId m_sendPendingDataEvent {}; //!< micro-delay event to send pending data
 
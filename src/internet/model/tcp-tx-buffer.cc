@@ -294,7 +294,7 @@ TcpTxBuffer::GetNewSegment (uint32_t numBytes)
   NS_ASSERT (it != m_appList.end ());
 
   m_appList.erase (it);
-  m_sentList.insert (m_sentList.end (), item);
+  IndexItem (m_sentList.insert (m_sentList.end (), item));
   m_sentSize += item->m_packet->GetSize ();
 
   return item;
@@ -308,36 +308,33 @@ TcpTxBuffer::GetTransmittedSegment (uint32_t numBytes, const SequenceNumber32 &s
   NS_ASSERT (numBytes <= m_sentSize);
   NS_ASSERT (m_sentList.size () >= 1);
 
-  auto it = m_sentList.begin ();
   bool listEdited = false;
   uint32_t s = numBytes;
 
   // Avoid to merge different packet for this retransmission if flags are
   // different.
-  for (; it != m_sentList.end(); ++it)
+  SentIndex::const_iterator start = m_sentIndex.find (seq);
+  if (start != m_sentIndex.end ())
     {
-      if ((*it)->m_startSeq == seq)
+      PacketList::iterator it = start->second;
+      auto next = it;
+      next++;
+      if (next != m_sentList.end ())
         {
-          auto next = it;
-          next++;
-          if (next != m_sentList.end ())
+          // Next is not sacked... there is the possibility to merge
+          if (! (*next)->m_sacked)
             {
-              // Next is not sacked... there is the possibility to merge
-              if (! (*next)->m_sacked)
-                {
-                  s = std::min(s, (*it)->m_packet->GetSize () + (*next)->m_packet->GetSize ());
-                }
-              else
-                {
-                  // Next is sacked... better to retransmit only the first segment
-                  s = std::min(s, (*it)->m_packet->GetSize ());
-                }
+              s = std::min(s, (*it)->m_packet->GetSize () + (*next)->m_packet->GetSize ());
             }
           else
             {
+              // Next is sacked... better to retransmit only the first segment
               s = std::min(s, (*it)->m_packet->GetSize ());
             }
-          break;
+        }
+      else
+        {
+          s = std::min(s, (*it)->m_packet->GetSize ());
         }
     }
 
@@ -347,6 +344,7 @@ TcpTxBuffer::GetTransmittedSegment (uint32_t numBytes, const SequenceNumber32 &s
     {
       m_retrans += item->m_packet->GetSize ();
       item->m_retrans = true;
+      ReindexItem (item);
     }
 
   return item;
@@ -398,7 +396,7 @@ TcpTxBuffer::SplitItems (TcpTxItem *t1, TcpTxItem *t2, uint32_t size) const
 TcpTxItem*
 TcpTxBuffer::GetPacketFromList (PacketList &list, const SequenceNumber32 &listStartFrom,
                                 uint32_t numBytes, const SequenceNumber32 &seq,
-                                bool *listEdited) const
+                                bool *listEdited)
 {
   NS_LOG_FUNCTION (this << numBytes << seq);
 
@@ -434,12 +432,25 @@ TcpTxBuffer::GetPacketFromList (PacketList &list, const SequenceNumber32 &listSt
   TcpTxItem *outItem = nullptr;
   PacketList::iterator it = list.begin ();
   SequenceNumber32 beginOfCurrentPacket = listStartFrom;
+  bool indexed = &list == &m_sentList;
+
+  if (indexed)
+    {
+      // Skip the items before the one which contains seq
+      SentIndex::const_iterator start = m_sentIndex.upper_bound (seq);
+      if (start != m_sentIndex.begin ())
+        {
+          --start;
+          it = start->second;
+          beginOfCurrentPacket = start->first;
+        }
+    }
 
   while (it != list.end ())
     {
       currentItem = *it;
       currentPacket = currentItem->m_packet;
-      NS_ASSERT_MSG (list != m_sentList || currentItem->m_startSeq >= m_firstByteSeq,
+      NS_ASSERT_MSG (!indexed || currentItem->m_startSeq >= m_firstByteSeq,
                      "start: " << m_firstByteSeq << " currentItem start: " <<
                      currentItem->m_startSeq);
 
@@ -466,10 +477,19 @@ TcpTxBuffer::GetPacketFromList (PacketList &list, const SequenceNumber32 &listSt
                            " and now we recurse because packet ends at "
                                         << beginOfCurrentPacket + currentPacket->GetSize ());
               TcpTxItem *firstPart = new TcpTxItem ();
+              if (indexed)
+                {
+                  UnindexItem (currentItem);
+                }
               SplitItems (firstPart, currentItem, seq - beginOfCurrentPacket);
 
               // insert firstPart before currentItem
-              list.insert (it, firstPart);
+              PacketList::iterator firstIt = list.insert (it, firstPart);
+              if (indexed)
+                {
+                  IndexItem (firstIt);
+                  IndexItem (it);
+                }
               if (listEdited)
                 {
                   *listEdited = true;
@@ -532,10 +552,19 @@ TcpTxBuffer::GetPacketFromList (PacketList &list, const SequenceNumber32 &listSt
               // the end is inside the current packet, but it isn't exactly
               // the packet end. Just fragment, fix the list, and return.
               TcpTxItem *firstPart = new TcpTxItem ();
+              if (indexed)
+                {
+                  UnindexItem (currentItem);
+                }
               SplitItems (firstPart, currentItem, numBytes);
 
               // insert firstPart before currentItem
-              list.insert (it, firstPart);
+              PacketList::iterator firstIt = list.insert (it, firstPart);
+              if (indexed)
+                {
+                  IndexItem (firstIt);
+                  IndexItem (it);
+                }
               if (listEdited)
                 {
                   *listEdited = true;
@@ -563,7 +592,15 @@ TcpTxBuffer::GetPacketFromList (PacketList &list, const SequenceNumber32 &listSt
           TcpTxItem *next = (*it); // Please remember we have incremented it
                                    // in the previous if
 
+          if (indexed)
+            {
+              UnindexItem (next);
+            }
           MergeItems (currentItem, next);
+          if (indexed)
+            {
+              ReindexItem (currentItem);
+            }
           list.erase (it);
 
           delete next;
@@ -693,6 +730,7 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
 
           RemoveFromCounts (item, pktSize);
 
+          UnindexItem (item);
           i = m_sentList.erase (i);
           NS_LOG_INFO ("Removed " << *item << " lost: " << m_lostOut <<
                        " retrans: " << m_retrans << " sacked: " << m_sackedOut <<
@@ -704,8 +742,10 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
           pktSize -= offset;
           NS_LOG_INFO (*item);
           // PacketTags are preserved when fragmenting
+          UnindexItem (item);
           item->m_packet = item->m_packet->CreateFragment (offset, pktSize);
           item->m_startSeq += offset;
+          IndexItem (i);
           m_size -= offset;
           m_sentSize -= offset;
           m_firstByteSeq += offset;
@@ -735,6 +775,7 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
           // when adding Reno dupacks in the count.
           head->m_sacked = false;
           m_sackedOut -= head->m_packet->GetSize ();
+          ReindexItem (head);
           NS_LOG_INFO ("Moving the SACK flag from the HEAD to another segment");
           AddRenoSack ();
           MarkHeadAsLost ();
@@ -768,15 +809,23 @@ TcpTxBuffer::Update (const TcpOptionSack::SackList &list)
 
   for (auto option_it = list.begin (); option_it != list.end (); ++option_it)
     {
-      PacketList::iterator item_it = m_sentList.begin ();
-      SequenceNumber32 beginOfCurrentPacket = m_firstByteSeq;
-
       if (m_firstByteSeq + m_sentSize < (*option_it).first && !modified)
         {
           NS_LOG_INFO ("Not updating scoreboard, the option block is outside the sent list");
           return false;
         }
 
+      // Start from the first item which begins inside the block: the ones
+      // before cannot be covered by it
+      PacketList::iterator item_it = m_sentList.end ();
+      SequenceNumber32 beginOfCurrentPacket = m_firstByteSeq;
+      SentIndex::const_iterator start = m_sentIndex.lower_bound ((*option_it).first);
+      if (start != m_sentIndex.end ())
+        {
+          item_it = start->second;
+          beginOfCurrentPacket = start->first;
+        }
+
       while (item_it != m_sentList.end ())
         {
           uint32_t pktSize = (*item_it)->m_packet->GetSize ();
@@ -806,6 +855,7 @@ TcpTxBuffer::Update (const TcpOptionSack::SackList &list)
 
                   (*item_it)->m_sacked = true;
                   m_sackedOut += (*item_it)->m_packet->GetSize ();
+                  ReindexItem (*item_it);
 
                   if (m_highestSack.first == m_sentList.end()
                       || m_highestSack.second <= beginOfCurrentPacket + pktSize)
@@ -852,45 +902,46 @@ void
 TcpTxBuffer::UpdateLostCount ()
 {
   NS_LOG_FUNCTION (this);
-  uint32_t sacked = 0;
-  SequenceNumber32 beginOfCurrentPacket = m_highestSack.second;
   if (m_highestSack.first == m_sentList.end ())
     {
       NS_LOG_INFO ("Status before the update: " << *this <<
-                   ", will start from the latest sent item");
+                   ", no sacked item");
+      return;
     }
-  else
+  NS_LOG_INFO ("Status before the update: " << *this <<
+               ", will start from item " << *(*m_highestSack.first));
+
+  // Going back from the highest sacked item, the items after the
+  // m_dupAckThresh-th sacked one are lost. The head is not counted.
+  SequenceNumber32 head = m_sentList.front ()->m_startSeq;
+  SequenceNumber32 limit = (*m_highestSack.first)->m_startSeq;
+  SequenceSet::const_iterator sackedIt = m_sackedSeqs.upper_bound (limit);
+  uint32_t sacked = 0;
+  while (sacked < m_dupAckThresh && sackedIt != m_sackedSeqs.begin ()
+         && head < *(--sackedIt))
     {
-      NS_LOG_INFO ("Status before the update: " << *this <<
-                   ", will start from item " << *(*m_highestSack.first));
+      limit = *sackedIt;
+      sacked++;
     }
 
-  for (auto it = m_highestSack.first; it != m_sentList.begin(); --it)
+  if (sacked >= m_dupAckThresh)
     {
-      TcpTxItem *item = *it;
-      if (item->m_sacked)
+      SequenceSet::const_iterator it = m_unmarkedSeqs.upper_bound (head);
+      while (it != m_unmarkedSeqs.end () && *it <= limit)
         {
-          sacked++;
-        }
-
-      if (sacked >= m_dupAckThresh)
-        {
-          if (!item->m_sacked && !item->m_lost)
-            {
-              item->m_lost = true;
-              m_lostOut += item->m_packet->GetSize ();
-            }
+          TcpTxItem *item = *(m_sentIndex.find (*it)->second);
+          ++it;
+          item->m_lost = true;
+          m_lostOut += item->m_packet->GetSize ();
+          ReindexItem (item);
         }
-      beginOfCurrentPacket -= item->m_packet->GetSize ();
-    }
 
-  if (sacked >= m_dupAckThresh)
-    {
       TcpTxItem *item = *m_sentList.begin ();
       if (!item->m_lost)
         {
           item->m_lost = true;
           m_lostOut += item->m_packet->GetSize ();
+          ReindexItem (item);
         }
     }
   NS_LOG_INFO ("Status after the update: " << *this);
@@ -902,37 +953,24 @@ TcpTxBuffer::IsLost (const SequenceNumber32 &seq) const
 {
   NS_LOG_FUNCTION (this << seq);
 
-  SequenceNumber32 beginOfCurrentPacket = m_firstByteSeq;
-  PacketList::const_iterator it;
-
   if (seq >= m_highestSack.second)
     {
       return false;
     }
 
-  // In theory, using a map and hints when inserting elements can improve
-  // performance
-  for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
-    {
-      // Search for the right iterator before calling IsLost()
-      if (beginOfCurrentPacket >= seq)
-        {
-          if ((*it)->m_lost == true)
-            {
-              NS_LOG_INFO ("seq=" << seq << " is lost because of lost flag");
-              return true;
-            }
-
-          if ((*it)->m_sacked == true)
-            {
-              NS_LOG_INFO ("seq=" << seq << " is not lost because of sacked flag");
-              return false;
-            }
-        }
+  // The first item at or after seq which is lost or sacked decides
+  SequenceSet::const_iterator lost = m_lostSeqs.lower_bound (seq);
+  SequenceSet::const_iterator sacked = m_sackedSeqs.lower_bound (seq);
 
-      beginOfCurrentPacket += (*it)->m_packet->GetSize ();
+  if (lost != m_lostSeqs.end () && (sacked == m_sackedSeqs.end () || *lost <= *sacked))
+    {
+      NS_LOG_INFO ("seq=" << seq << " is lost because of lost flag");
+      return true;
+    }
+  if (sacked != m_sackedSeqs.end ())
+    {
+      NS_LOG_INFO ("seq=" << seq << " is not lost because of sacked flag");
     }
-
   return false;
 }
 
@@ -954,35 +992,11 @@ TcpTxBuffer::NextSeg (SequenceNumber32 *seq, bool isRecovery) const
    *
    *     (1.c) IsLost (S2) returns true.
    */
-  PacketList::const_iterator it;
-  TcpTxItem *item;
-  SequenceNumber32 seqPerRule3;
-  bool isSeqPerRule3Valid = false;
-  SequenceNumber32 beginOfCurrentPkt = m_firstByteSeq;
-
-  for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
+  if (!m_lostRtxSeqs.empty ())
     {
-      item = *it;
-
-      // Condition 1.a , 1.b , and 1.c
-      if (item->m_retrans == false && item->m_sacked == false)
-        {
-          if (item->m_lost)
-            {
-              NS_LOG_INFO("IsLost, returning" << beginOfCurrentPkt);
-              *seq = beginOfCurrentPkt;
-              return true;
-            }
-          else if (seqPerRule3.GetValue () == 0 && isRecovery)
-            {
-              NS_LOG_INFO ("Saving for rule 3 the seq " << beginOfCurrentPkt);
-              isSeqPerRule3Valid = true;
-              seqPerRule3 = beginOfCurrentPkt;
-            }
-        }
-
-      // Nothing found, iterate
-      beginOfCurrentPkt += item->m_packet->GetSize ();
+      NS_LOG_INFO("IsLost, returning" << *m_lostRtxSeqs.begin ());
+      *seq = *m_lostRtxSeqs.begin ();
+      return true;
     }
 
   /* (2) If no sequence number 'S2' per rule (1) exists but there
@@ -1008,10 +1022,10 @@ TcpTxBuffer::NextSeg (SequenceNumber32 *seq, bool isRecovery) const
    *     (specifically excluding step (1.c)), then one segment of up to
    *     SMSS octets starting with S3 SHOULD be returned.
    */
-  if (isSeqPerRule3Valid)
+  if (isRecovery && !m_rescueSeqs.empty ())
     {
-      NS_LOG_INFO ("Rule3 valid. " << seqPerRule3);
-      *seq = seqPerRule3;
+      NS_LOG_INFO ("Rule3 valid. " << *m_rescueSeqs.begin ());
+      *seq = *m_rescueSeqs.begin ();
       return true;
     }
 
@@ -1180,9 +1194,13 @@ TcpTxBuffer::ResetRenoSack ()
   NS_LOG_FUNCTION (this);
 
   m_sackedOut = 0;
-  for (auto it = m_sentList.begin (); it != m_sentList.end (); ++it)
+  SequenceSet sacked;
+  sacked.swap (m_sackedSeqs);
+  for (auto it = sacked.begin (); it != sacked.end (); ++it)
     {
-      (*it)->m_sacked = false;
+      TcpTxItem *item = *(m_sentIndex.find (*it)->second);
+      item->m_sacked = false;
+      ReindexItem (item);
     }
 
   m_highestSack = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
@@ -1194,6 +1212,8 @@ TcpTxBuffer::ResetSentList ()
   NS_LOG_FUNCTION (this);
   TcpTxItem *item;
 
+  ClearIndex ();
+
   // Keep the head items; they will then marked as lost
   while (m_sentList.size () > 0)
     {
@@ -1218,6 +1238,7 @@ TcpTxBuffer::ResetLastSegmentSent ()
     {
       TcpTxItem *item = m_sentList.back ();
 
+      UnindexItem (item);
       m_sentList.pop_back ();
       m_sentSize -= item->m_packet->GetSize ();
       if (item->m_retrans)
@@ -1269,6 +1290,7 @@ TcpTxBuffer::SetSentListLost (bool resetSack)
         }
 
       (*it)->m_retrans = false;
+      ReindexItem (*it);
     }
 
   NS_LOG_INFO ("Set sent list lost, status: " << *this);
@@ -1303,6 +1325,7 @@ TcpTxBuffer::DeleteRetransmittedFlagFromHead ()
     {
       m_sentList.front ()->m_retrans = false;
       m_retrans -= m_sentList.front ()->m_packet->GetSize ();
+      ReindexItem (m_sentList.front ());
     }
   ConsistencyCheck ();
 }
@@ -1332,6 +1355,7 @@ TcpTxBuffer::MarkHeadAsLost ()
           m_sentList.front()->m_lost = true;
           m_lostOut += m_sentList.front ()->m_packet->GetSize ();
         }
+      ReindexItem (m_sentList.front ());
     }
   ConsistencyCheck ();
 }
@@ -1358,6 +1382,7 @@ TcpTxBuffer::AddRenoSack (void)
     {
       (*it)->m_sacked = true;
       m_sackedOut += (*it)->m_packet->GetSize ();
+      ReindexItem (*it);
       m_highestSack = std::make_pair (it, (*it)->m_startSeq);
       NS_LOG_INFO ("Added a Reno SACK, status: " << *this);
     }
@@ -1370,6 +1395,94 @@ TcpTxBuffer::AddRenoSack (void)
   ConsistencyCheck ();
 }
 
+void
+TcpTxBuffer::IndexItem (PacketList::iterator it)
+{
+  NS_LOG_FUNCTION (this << **it);
+  bool inserted = m_sentIndex.insert (std::make_pair ((*it)->m_startSeq, it)).second;
+  NS_ASSERT_MSG (inserted, "Two sent items start at " << (*it)->m_startSeq);
+  NS_UNUSED (inserted);
+  ReindexItem (*it);
+}
+
+void
+TcpTxBuffer::UnindexItem (const TcpTxItem *item)
+{
+  NS_LOG_FUNCTION (this << *item);
+  SequenceNumber32 seq = item->m_startSeq;
+  m_sentIndex.erase (seq);
+  m_sackedSeqs.erase (seq);
+  m_lostSeqs.erase (seq);
+  m_unmarkedSeqs.erase (seq);
+  m_lostRtxSeqs.erase (seq);
+  m_rescueSeqs.erase (seq);
+}
+
+void
+TcpTxBuffer::ReindexItem (const TcpTxItem *item)
+{
+  NS_LOG_FUNCTION (this << *item);
+  SequenceNumber32 seq = item->m_startSeq;
+  NS_ASSERT (m_sentIndex.find (seq) != m_sentIndex.end ());
+
+  if (item->m_sacked)
+    {
+      m_sackedSeqs.insert (seq);
+    }
+  else
+    {
+      m_sackedSeqs.erase (seq);
+    }
+
+  if (item->m_lost)
+    {
+      m_lostSeqs.insert (seq);
+    }
+  else
+    {
+      m_lostSeqs.erase (seq);
+    }
+
+  if (!item->m_sacked && !item->m_lost)
+    {
+      m_unmarkedSeqs.insert (seq);
+    }
+  else
+    {
+      m_unmarkedSeqs.erase (seq);
+    }
+
+  if (!item->m_sacked && !item->m_retrans && item->m_lost)
+    {
+      m_lostRtxSeqs.insert (seq);
+    }
+  else
+    {
+      m_lostRtxSeqs.erase (seq);
+    }
+
+  if (!item->m_sacked && !item->m_retrans && !item->m_lost)
+    {
+      m_rescueSeqs.insert (seq);
+    }
+  else
+    {
+      m_rescueSeqs.erase (seq);
+    }
+}
+
+void
+TcpTxBuffer::ClearIndex ()
+{
+  NS_LOG_FUNCTION (this);
+  m_sentIndex.clear ();
+  m_sackedSeqs.clear ();
+  m_lostSeqs.clear ();
+  m_unmarkedSeqs.clear ();
+  m_lostRtxSeqs.clear ();
+  m_rescueSeqs.clear ();
+}
+
 void
 TcpTxBuffer::ConsistencyCheck () const
 {
@@ -1406,6 +1519,24 @@ TcpTxBuffer::ConsistencyCheck () const
                  " stored lost: " << m_lostOut);
   NS_ASSERT_MSG (retrans == m_retrans, " Counted retrans: " << retrans <<
                  " stored retrans: " << m_retrans);
+
+  NS_ASSERT_MSG (m_sentIndex.size () == m_sentList.size (), "Indexed items: " <<
+                 m_sentIndex.size () << " sent items: " << m_sentList.size ());
+  for (auto it = m_sentList.begin (); it != m_sentList.end (); ++it)
+    {
+      const TcpTxItem *item = *it;
+      SequenceNumber32 seq = item->m_startSeq;
+      auto indexed = m_sentIndex.find (seq);
+      NS_ASSERT_MSG (indexed != m_sentIndex.end () && *indexed->second == item,
+                     "Item " << *item << " not indexed");
+      NS_ASSERT_MSG ((m_sackedSeqs.count (seq) == 1) == item->m_sacked
+                     && (m_lostSeqs.count (seq) == 1) == item->m_lost
+                     && (m_unmarkedSeqs.count (seq) == 1) == (!item->m_sacked && !item->m_lost)
+                     && (m_lostRtxSeqs.count (seq) == 1) == (!item->m_sacked && !item->m_retrans && item->m_lost)
+                     && (m_rescueSeqs.count (seq) == 1) == (!item->m_sacked && !item->m_retrans && !item->m_lost),
+                     "Item " << *item << " not in the right scoreboard sets");
+      NS_UNUSED (indexed);
+    }
 }
 
 std::ostream &
@@ -22,6 +22,8 @@
 #ifndef TCP_TX_BUFFER_H
 #define TCP_TX_BUFFER_H
 
+#include <map>
+#include <set>
 #include "ns3/object.h"
 #include "ns3/traced-value.h"
 #include "ns3/sequence-number.h"
@@ -105,6 +107,15 @@ public:
  * documentation) and maintaining the scoreboard is a matter of travelling the
  * list and set the SACK flag on the corresponding segment sent.
  *
+ * To avoid walking the list from its head for each SACK block and for each
+ * question about the scoreboard, the sent items are also indexed by their
+ * first sequence number in balanced trees: one with all the sent items,
+ * and one for each group of items that the scoreboard looks for (sacked,
+ * lost, neither sacked nor lost, and the candidates for the rules 1 and 3
+ * of NextSeg). Update, IsLost, NextSeg and UpdateLostCount only visit the
+ * items they change, or do a logarithmic search, so that the processing of
+ * an ACK does not grow with the number of segments in flight.
+ *
  * Item properties
  * ---------------
  *
@@ -410,6 +421,35 @@ private:
   friend std::ostream & operator<< (std::ostream & os, TcpTxBuffer const & tcpTxBuf);
 
   typedef std::list<TcpTxItem*> PacketList; //!< container for data stored in the buffer
+  typedef std::map<SequenceNumber32, PacketList::iterator> SentIndex; //!< sent items, by first sequence number
+  typedef std::set<SequenceNumber32> SequenceSet; //!< first sequence numbers of a group of sent items
+
+  /**
+   * \brief Add a sent item to the index
+   * \param it Iterator to the item, in the sent list
+   */
+  void IndexItem (PacketList::iterator it);
+
+  /**
+   * \brief Remove a sent item from the index
+   *
+   * To be called before the first sequence number of the item changes, or
+   * the item leaves the sent list.
+   *
+   * \param item Item to remove
+   */
+  void UnindexItem (const TcpTxItem *item);
+
+  /**
+   * \brief Update the groups of a sent item after its flags changed
+   * \param item Item to update
+   */
+  void ReindexItem (const TcpTxItem *item);
+
+  /**
+   * \brief Remove all the sent items from the index
+   */
+  void ClearIndex ();
 
   /**
    * \brief Update the lost count
@@ -426,8 +466,10 @@ private:
    * The {New}Reno cases, for now, are managed in TcpSocketBase through the
    * call to MarkHeadAsLost.
    * This function is, therefore, called after a SACK option has been received,
-   * and updates the lost count. It can be probably optimized by not walking
-   * the entire list, but a subset.
+   * and updates the lost count. Instead of walking the list backwards from the
+   * highest sacked item, it counts "Dupack thresh" items back in the index of
+   * the sacked items, and then marks the items which are neither sacked nor
+   * lost before that point.
    *
    */
   void UpdateLostCount ();
@@ -560,7 +602,7 @@ private:
    */
   TcpTxItem* GetPacketFromList (PacketList &list, const SequenceNumber32 &startingSeq,
                                 uint32_t numBytes, const SequenceNumber32 &requestedSeq,
-                                bool *listEdited = nullptr) const;
+                                bool *listEdited = nullptr);
 
   /**
    * \brief Merge two TcpTxItem
@@ -608,6 +650,13 @@ private:
   TracedValue<SequenceNumber32> m_firstByteSeq; //!< Sequence number of the first byte in data (SND.UNA)
   std::pair <PacketList::const_iterator, SequenceNumber32> m_highestSack; //!< Highest SACK byte
 
+  SentIndex m_sentIndex;       //!< Index of the sent list
+  SequenceSet m_sackedSeqs;    //!< Items marked as sacked
+  SequenceSet m_lostSeqs;      //!< Items marked as lost
+  SequenceSet m_unmarkedSeqs;  //!< Items neither sacked nor lost
+  SequenceSet m_lostRtxSeqs;   //!< Lost items, neither sacked nor retransmitted (NextSeg rule 1)
+  SequenceSet m_rescueSeqs;    //!< Items neither sacked, lost nor retransmitted (NextSeg rule 3)
+
   uint32_t m_lostOut   {0}; //!< Number of lost bytes
   uint32_t m_sackedOut {0}; //!< Number of sacked bytes
   uint32_t m_retrans   {0}; //!< Number of retransmitted bytes
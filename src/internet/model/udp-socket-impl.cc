@@ -513,61 +513,9 @@ UdpSocketImpl::DoSendTo (Ptr<Packet> p, Ipv4Address dest, uint16_t port, uint8_t
       return -1;
     }
 
-  uint8_t priority = GetPriority ();
-  if (tos)
-    {
-      SocketIpTosTag ipTosTag;
-      ipTosTag.SetTos (tos);
-      // This packet may already have a SocketIpTosTag (see BUG 2440)
-      p->ReplacePacketTag (ipTosTag);
-      priority = IpTos2Priority (tos);
-    }
-
-  if (priority)
-    {
-      SocketPriorityTag priorityTag;
-      priorityTag.SetPriority (priority);
-      p->ReplacePacketTag (priorityTag);
-    }
-
+  AddSendTags (p, dest, tos);
   Ptr<Ipv4> ipv4 = m_node->GetObject<Ipv4> ();
 
-  // Locally override the IP TTL for this socket
-  // We cannot directly modify the TTL at this stage, so we set a Packet tag
-  // The destination can be either multicast, unicast/anycast, or
-  // either all-hosts broadcast or limited (subnet-directed) broadcast.
-  // For the latter two broadcast types, the TTL will later be set to one
-  // irrespective of what is set in these socket options.  So, this tagging
-  // may end up setting the TTL of a limited broadcast packet to be
-  // the same as a unicast, but it will be fixed further down the stack
-  if (m_ipMulticastTtl != 0 && dest.IsMulticast ())
-    {
-      SocketIpTtlTag tag;
-      tag.SetTtl (m_ipMulticastTtl);
-      p->AddPacketTag (tag);
-    }
-  else if (IsManualIpTtl () && GetIpTtl () != 0 && !dest.IsMulticast () && !dest.IsBroadcast ())
-    {
-      SocketIpTtlTag tag;
-      tag.SetTtl (GetIpTtl ());
-      p->AddPacketTag (tag);
-    }
-  {
-    SocketSetDontFragmentTag tag;
-    bool found = p->RemovePacketTag (tag);
-    if (!found)
-      {
-        if (m_mtuDiscover)
-          {
-            tag.Enable ();
-          }
-        else
-          {
-            tag.Disable ();
-          }
-        p->AddPacketTag (tag);
-      }
-  }
   //
   // If dest is set to the limited broadcast address (all ones),
   // convert it to send a copy of the packet out of every 
@@ -667,6 +615,162 @@ UdpSocketImpl::DoSendTo (Ptr<Packet> p, Ipv4Address dest, uint16_t port, uint8_t
   return 0;
 }
 
+void
+UdpSocketImpl::AddSendTags (Ptr<Packet> p, Ipv4Address dest, uint8_t tos)
+{
+  NS_LOG_FUNCTION (this << p << dest << (uint16_t) tos);
+  uint8_t priority = GetPriority ();
+  if (tos)
+    {
+      SocketIpTosTag ipTosTag;
+      ipTosTag.SetTos (tos);
+      // This packet may already have a SocketIpTosTag (see BUG 2440)
+      p->ReplacePacketTag (ipTosTag);
+      priority = IpTos2Priority (tos);
+    }
+
+  if (priority)
+    {
+      SocketPriorityTag priorityTag;
+      priorityTag.SetPriority (priority);
+      p->ReplacePacketTag (priorityTag);
+    }
+
+  // Locally override the IP TTL for this socket
+  // We cannot directly modify the TTL at this stage, so we set a Packet tag
+  // The destination can be either multicast, unicast/anycast, or
+  // either all-hosts broadcast or limited (subnet-directed) broadcast.
+  // For the latter two broadcast types, the TTL will later be set to one
+  // irrespective of what is set in these socket options.  So, this tagging
+  // may end up setting the TTL of a limited broadcast packet to be
+  // the same as a unicast, but it will be fixed further down the stack
+  if (m_ipMulticastTtl != 0 && dest.IsMulticast ())
+    {
+      SocketIpTtlTag tag;
+      tag.SetTtl (m_ipMulticastTtl);
+      p->AddPacketTag (tag);
+    }
+  else if (IsManualIpTtl () && GetIpTtl () != 0 && !dest.IsMulticast () && !dest.IsBroadcast ())
+    {
+      SocketIpTtlTag tag;
+      tag.SetTtl (GetIpTtl ());
+      p->AddPacketTag (tag);
+    }
+  {
+    SocketSetDontFragmentTag tag;
+    bool found = p->RemovePacketTag (tag);
+    if (!found)
+      {
+        if (m_mtuDiscover)
+          {
+            tag.Enable ();
+          }
+        else
+          {
+            tag.Disable ();
+          }
+        p->AddPacketTag (tag);
+      }
+  }
+}
+
+int
+UdpSocketImpl::DoSendBatchTo (const std::vector<Ptr<Packet> > &packets, Ipv4Address dest, uint16_t port, uint8_t tos)
+{
+  NS_LOG_FUNCTION (this << packets.size () << dest << port << (uint16_t) tos);
+  if (packets.empty ())
+    {
+      return 0;
+    }
+  if (m_endPoint == 0)
+    {
+      if (Bind () == -1)
+        {
+          NS_ASSERT (m_endPoint == 0);
+          return -1;
+        }
+      NS_ASSERT (m_endPoint != 0);
+    }
+
+  Ptr<Ipv4> ipv4 = m_node->GetObject<Ipv4> ();
+  int sent = 0;
+  if (m_shutdownSend || dest.IsBroadcast ()
+      || m_endPoint->GetLocalAddress () != Ipv4Address::GetAny ()
+      || ipv4->GetRoutingProtocol () == 0)
+    {
+      // No route to share: DoSendTo handles these cases packet by packet
+      for (std::vector<Ptr<Packet> >::const_iterator i = packets.begin (); i != packets.end (); i++)
+        {
+          if (DoSendTo (*i, dest, port, tos) < 0)
+            {
+              break;
+            }
+          sent++;
+        }
+      return sent == 0 ? -1 : sent;
+    }
+
+  Ipv4Header header;
+  header.SetDestination (dest);
+  header.SetProtocol (UdpL4Protocol::PROT_NUMBER);
+  Ptr<NetDevice> oif = m_boundnetdevice; //specify non-zero if bound to a specific device
+  Ptr<NetDevice> checkedDevice;
+  uint32_t bytes = 0;
+  for (std::vector<Ptr<Packet> >::const_iterator i = packets.begin (); i != packets.end (); i++)
+    {
+      Ptr<Packet> p = *i;
+      if (p->GetSize () > GetTxAvailable ())
+        {
+          m_errno = ERROR_MSGSIZE;
+          break;
+        }
+      AddSendTags (p, dest, tos);
+
+      // The route is looked up for each packet, as by Send (): the routing
+      // protocol may pick a route per packet, e.g., random ECMP, and count
+      // the packets sent on each route.
+      Socket::SocketErrno errno_;
+      Ptr<Ipv4Route> route = ipv4->GetRoutingProtocol ()->RouteOutput (p, header, oif, errno_);
+      if (route == 0)
+        {
+          NS_LOG_LOGIC ("No route to destination");
+          m_errno = errno_;
+          break;
+        }
+      // the broadcast addresses only depend on the output device
+      if (!m_allowBroadcast && route->GetOutputDevice () != checkedDevice)
+        {
+          bool broadcast = false;
+          uint32_t outputIfIndex = ipv4->GetInterfaceForDevice (route->GetOutputDevice ());
+          uint32_t ifNAddr = ipv4->GetNAddresses (outputIfIndex);
+          for (uint32_t addrI = 0; addrI < ifNAddr; ++addrI)
+            {
+              if (dest == ipv4->GetAddress (outputIfIndex, addrI).GetBroadcast ())
+                {
+                  broadcast = true;
+                  break;
+                }
+            }
+          if (broadcast)
+            {
+              m_errno = ERROR_OPNOTSUPP;
+              break;
+            }
+          checkedDevice = route->GetOutputDevice ();
+        }
+
+      m_udp->Send (p->Copy (), route->GetSource (), dest,
+                   m_endPoint->GetLocalPort (), port, route);
+      bytes += p->GetSize ();
+      sent++;
+    }
+  if (bytes > 0)
+    {
+      NotifyDataSent (bytes);
+    }
+  return sent == 0 ? -1 : sent;
+}
+
 int
 UdpSocketImpl::DoSendTo (Ptr<Packet> p, Ipv6Address dest, uint16_t port)
 {
@@ -824,6 +928,35 @@ UdpSocketImpl::SendTo (Ptr<Packet> p, uint32_t flags, const Address &address)
   return -1;
 }
 
+int
+UdpSocketImpl::SendBatch (const std::vector<Ptr<Packet> > &packets, uint32_t flags)
+{
+  NS_LOG_FUNCTION (this << packets.size () << flags);
+
+  if (!m_connected)
+    {
+      m_errno = ERROR_NOTCONN;
+      return -1;
+    }
+  if (Ipv4Address::IsMatchingType (m_defaultAddress))
+    {
+      return DoSendBatchTo (packets, Ipv4Address::ConvertFrom (m_defaultAddress), m_defaultPort, GetIpTos ());
+    }
+  return Socket::SendBatch (packets, flags);
+}
+
+int
+UdpSocketImpl::SendBatchTo (const std::vector<Ptr<Packet> > &packets, uint32_t flags, const Address &address)
+{
+  NS_LOG_FUNCTION (this << packets.size () << flags << address);
+  if (InetSocketAddress::IsMatchingType (address))
+    {
+      InetSocketAddress transport = InetSocketAddress::ConvertFrom (address);
+      return DoSendBatchTo (packets, transport.GetIpv4 (), transport.GetPort (), transport.GetTos ());
+    }
+  return Socket::SendBatchTo (packets, flags, address);
+}
+
 uint32_t
 UdpSocketImpl::GetRxAvailable (void) const
 {
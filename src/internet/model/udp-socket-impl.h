@@ -105,6 +105,8 @@ public:
   virtual uint32_t GetTxAvailable (void) const;
   virtual int Send (Ptr<Packet> p, uint32_t flags);
   virtual int SendTo (Ptr<Packet> p, uint32_t flags, const Address &address);
+  virtual int SendBatch (const std::vector<Ptr<Packet> > &packets, uint32_t flags);
+  virtual int SendBatchTo (const std::vector<Ptr<Packet> > &packets, uint32_t flags, const Address &address);
   virtual uint32_t GetRxAvailable (void) const;
   virtual Ptr<Packet> Recv (uint32_t maxSize, uint32_t flags);
   virtual Ptr<Packet> RecvFrom (uint32_t maxSize, uint32_t flags,
@@ -209,6 +211,28 @@ private:
    * \returns 0 on success, -1 on failure
    */
   int DoSendTo (Ptr<Packet> p, Ipv6Address daddr, uint16_t dport);
+  /**
+   * \brief Send a train of packets to a specific destination and port (IPv4)
+   *
+   * The unicast packets share the checks of the socket state and one
+   * notification of the data sent.  The route is looked up for each
+   * packet, since the routing protocol may choose it per packet, and the
+   * broadcast check is only repeated when the output device changes.
+   *
+   * \param packets packets
+   * \param daddr destination address
+   * \param dport destination port
+   * \param tos ToS
+   * \returns the number of packets sent, or -1 if none could be sent
+   */
+  int DoSendBatchTo (const std::vector<Ptr<Packet> > &packets, Ipv4Address daddr, uint16_t dport, uint8_t tos);
+  /**
+   * \brief Add the tags carrying the socket options to a packet (IPv4)
+   * \param p packet
+   * \param daddr destination address
+   * \param tos ToS
+   */
+  void AddSendTags (Ptr<Packet> p, Ipv4Address daddr, uint8_t tos);
 
   /**
    * \brief Called by the L3 protocol when it received an ICMP packet to pass on to TCP.
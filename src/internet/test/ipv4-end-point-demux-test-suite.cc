@@ -0,0 +1,180 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/ipv4-interface-address.h"
+#include "../model/ipv4-end-point-demux.h"
+#include "../model/ipv4-end-point.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the endpoints found by Ipv4EndPointDemux, while the
+ * endpoints are allocated, connected and released.
+ */
+class Ipv4EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv4EndPointDemuxTestCase ();
+  virtual ~Ipv4EndPointDemuxTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Look up an endpoint for a packet received on the test interface.
+   * \param daddr destination address
+   * \param dport destination port
+   * \param saddr source address
+   * \param sport source port
+   * \return the endpoint found, or 0
+   */
+  Ipv4EndPoint *Lookup (Ipv4Address daddr, uint16_t dport, Ipv4Address saddr, uint16_t sport);
+
+  Ipv4EndPointDemux m_demux;        //!< Demux under test
+  Ptr<Ipv4Interface> m_interface;   //!< Incoming interface
+};
+
+Ipv4EndPointDemuxTestCase::Ipv4EndPointDemuxTestCase ()
+  : TestCase ("Check the endpoints found by Ipv4EndPointDemux")
+{
+}
+
+Ipv4EndPointDemuxTestCase::~Ipv4EndPointDemuxTestCase ()
+{
+}
+
+Ipv4EndPoint *
+Ipv4EndPointDemuxTestCase::Lookup (Ipv4Address daddr, uint16_t dport, Ipv4Address saddr, uint16_t sport)
+{
+  Ipv4EndPointDemux::EndPoints endPoints = m_demux.Lookup (daddr, dport, saddr, sport, m_interface);
+  return endPoints.empty () ? 0 : endPoints.front ();
+}
+
+void
+Ipv4EndPointDemuxTestCase::DoRun (void)
+{
+  m_interface = CreateObject<Ipv4Interface> ();
+  m_interface->AddAddress (Ipv4InterfaceAddress (Ipv4Address ("10.1.1.1"), Ipv4Mask ("255.255.255.0")));
+
+  Ipv4Address local ("10.1.1.1");
+  Ipv4Address peer1 ("10.1.1.2");
+  Ipv4Address peer2 ("10.1.1.3");
+
+  // A listener on the local address takes precedence over the one on any address
+  Ipv4EndPoint *listener = m_demux.Allocate (0, 80);
+  NS_TEST_ASSERT_MSG_NE (listener, 0, "Listener not allocated");
+  Ipv4EndPoint *boundListener = m_demux.Allocate (0, local, 80);
+  NS_TEST_ASSERT_MSG_NE (boundListener, 0, "Listener not allocated");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 80, peer2, 1000), boundListener, "Bound listener not found");
+  m_demux.DeAllocate (boundListener);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 80, peer2, 1000), listener, "Listener not found");
+
+  // Connections forked from the listener
+  Ipv4EndPoint *connection1 = m_demux.Allocate (0, local, 80, peer1, 1000);
+  Ipv4EndPoint *connection2 = m_demux.Allocate (0, local, 80, peer1, 1001);
+  NS_TEST_ASSERT_MSG_NE (connection1, 0, "Connection not allocated");
+  NS_TEST_ASSERT_MSG_NE (connection2, 0, "Connection not allocated");
+  NS_TEST_EXPECT_MSG_EQ (m_demux.Allocate (0, local, 80, peer1, 1000), 0, "Duplicated connection allocated");
+  NS_TEST_EXPECT_MSG_EQ (m_demux.Allocate (0, 80), 0, "Duplicated listener allocated");
+
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 80, peer1, 1000), connection1, "Connection not found");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 80, peer1, 1001), connection2, "Connection not found");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 80, peer2, 1000), listener, "Listener not found");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 81, peer1, 1000), 0, "Endpoint found on a free port");
+
+  // An endpoint connected after its allocation
+  Ipv4EndPoint *client = m_demux.Allocate ();
+  NS_TEST_ASSERT_MSG_NE (client, 0, "Client not allocated");
+  uint16_t clientPort = client->GetLocalPort ();
+  NS_TEST_EXPECT_MSG_EQ (m_demux.LookupPortLocal (clientPort), true, "Ephemeral port not in use");
+  client->SetPeer (peer2, 8080);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, clientPort, peer2, 8080), client, "Client not found on any address");
+  client->SetLocalAddress (local);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, clientPort, peer2, 8080), client, "Client not found on its address");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, clientPort, peer1, 8080), 0, "Client found for another peer");
+
+  // An endpoint on the network part of the interface address receives
+  // the packets to the subnet
+  Ipv4EndPoint *subnet = m_demux.Allocate (0, Ipv4Address ("10.1.1.0"), 9);
+  NS_TEST_ASSERT_MSG_NE (subnet, 0, "Subnet endpoint not allocated");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (Ipv4Address ("10.1.1.255"), 9, peer1, 1000), subnet, "Subnet endpoint not found");
+  subnet->SetPeer (peer1, 1000);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (Ipv4Address ("10.1.1.255"), 9, peer1, 1000), subnet, "Subnet endpoint not found");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (Ipv4Address ("10.1.1.255"), 9, peer2, 1000), 0, "Subnet endpoint found for another peer");
+
+  // Endpoints connected to a peer with a wildcard port or address, as a UDP
+  // socket connected with a peer port 0
+  Ipv4EndPoint *anyPort = m_demux.Allocate (0, local, 5000, peer1, 0);
+  Ipv4EndPoint *anyAddress = m_demux.Allocate (0, local, 5001, Ipv4Address::GetAny (), 1000);
+  NS_TEST_ASSERT_MSG_NE (anyPort, 0, "Endpoint with a wildcard peer port not allocated");
+  NS_TEST_ASSERT_MSG_NE (anyAddress, 0, "Endpoint with a wildcard peer address not allocated");
+  NS_TEST_EXPECT_MSG_EQ (m_demux.Allocate (0, local, 5000, peer1, 0), 0, "Duplicated endpoint allocated");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 5000, peer1, 1234), anyPort, "Endpoint with a wildcard peer port not found");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 5000, peer2, 1234), 0, "Endpoint found for another peer");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 5001, peer2, 1000), anyAddress, "Endpoint with a wildcard peer address not found");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 5001, peer2, 1001), 0, "Endpoint found for another peer port");
+  anyPort->SetPeer (peer1, 1234);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 5000, peer1, 1234), anyPort, "Reconnected endpoint not found");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 5000, peer1, 1235), 0, "Reconnected endpoint found for another peer port");
+  m_demux.DeAllocate (anyPort);
+  m_demux.DeAllocate (anyAddress);
+
+  // Released endpoints are no longer found, and free their ports
+  m_demux.DeAllocate (connection1);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 80, peer1, 1000), listener, "Listener not found");
+  m_demux.DeAllocate (client);
+  NS_TEST_EXPECT_MSG_EQ (m_demux.LookupPortLocal (clientPort), false, "Released port still in use");
+  m_demux.DeAllocate (connection2);
+  m_demux.DeAllocate (listener);
+  m_demux.DeAllocate (subnet);
+  NS_TEST_EXPECT_MSG_EQ (m_demux.LookupPortLocal (80), false, "Released port still in use");
+  NS_TEST_EXPECT_MSG_EQ (m_demux.GetAllEndPoints ().size (), 0, "Endpoints left after releasing all of them");
+
+  // Ephemeral ports skip the ones in use
+  Ipv4EndPoint *bound = m_demux.Allocate (0, clientPort + 1);
+  Ipv4EndPoint *next = m_demux.Allocate ();
+  NS_TEST_ASSERT_MSG_NE (next, 0, "Client not allocated");
+  NS_TEST_EXPECT_MSG_EQ (next->GetLocalPort (), clientPort + 2, "Ephemeral port in use allocated");
+  m_demux.DeAllocate (bound);
+  m_demux.DeAllocate (next);
+
+  m_interface = 0;
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Ipv4EndPointDemux TestSuite
+ */
+class Ipv4EndPointDemuxTestSuite : public TestSuite
+{
+public:
+  Ipv4EndPointDemuxTestSuite ();
+};
+
+Ipv4EndPointDemuxTestSuite::Ipv4EndPointDemuxTestSuite ()
+  : TestSuite ("ipv4-end-point-demux", UNIT)
+{
+  AddTestCase (new Ipv4EndPointDemuxTestCase, TestCase::QUICK);
+}
+
+static Ipv4EndPointDemuxTestSuite g_ipv4EndPointDemuxTestSuite; //!< Static variable for test initialization
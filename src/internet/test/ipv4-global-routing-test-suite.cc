@@ -14,9 +14,12 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <set>
+#include <sstream>
 #include <vector>
 #include "ns3/boolean.h"
 #include "ns3/config.h"
+#include "ns3/enum.h"
 #include "ns3/inet-socket-address.h"
 #include "ns3/internet-stack-helper.h"
 #include "ns3/ipv4-address-helper.h"
@@ -37,10 +40,12 @@
 #include "ns3/simple-channel.h"
 #include "ns3/socket-factory.h"
 #include "ns3/udp-socket-factory.h"
+#include "ns3/udp-header.h"
 #include "ns3/ipv4-l3-protocol.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/ipv4-global-routing.h"
+#include "ns3/global-router-interface.h"
 #include "ns3/bridge-helper.h"
 
 using namespace ns3;
@@ -1244,6 +1249,453 @@ Ipv4GlobalRoutingSlash32TestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief IPv4 incremental GlobalRouting test
+ *
+ * Apply the same sequence of interface changes to a grid of routers twice,
+ * once with GlobalRoutingIncremental set and once without, and check that
+ * every routing table is the same after each change.
+ */
+class Ipv4GlobalRoutingIncrementalTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingIncrementalTestCase ();
+  virtual ~Ipv4GlobalRoutingIncrementalTestCase ();
+
+private:
+  /**
+   * \brief Print the global routing tables of all the nodes
+   * \param nodes The nodes.
+   * \return the routing tables, one route per line
+   */
+  std::string DumpRoutes (NodeContainer nodes);
+
+  /**
+   * \brief Apply the interface changes, recomputing the routes after each one
+   * \param incremental The GlobalRoutingIncremental value to use.
+   * \return the routing tables after each change
+   */
+  std::vector<std::string> RunEvents (bool incremental);
+
+  virtual void DoRun (void);
+
+  NodeContainer m_nodes; //!< Routers and hosts.
+  std::vector<std::pair<Ptr<Ipv4>, uint32_t> > m_events; //!< Interfaces to toggle, in order.
+};
+
+Ipv4GlobalRoutingIncrementalTestCase::Ipv4GlobalRoutingIncrementalTestCase ()
+  : TestCase ("Incremental global routing matches a full recomputation")
+{
+}
+
+Ipv4GlobalRoutingIncrementalTestCase::~Ipv4GlobalRoutingIncrementalTestCase ()
+{
+}
+
+std::string
+Ipv4GlobalRoutingIncrementalTestCase::DumpRoutes (NodeContainer nodes)
+{
+  std::ostringstream oss;
+  for (NodeContainer::Iterator n = nodes.Begin (); n != nodes.End (); n++)
+    {
+      Ptr<Ipv4GlobalRouting> routing = (*n)->GetObject<GlobalRouter> ()->GetRoutingProtocol ();
+      oss << "node " << (*n)->GetId () << std::endl;
+      for (uint32_t i = 0; i < routing->GetNRoutes (); i++)
+        {
+          oss << *routing->GetRoute (i) << std::endl;
+        }
+    }
+  return oss.str ();
+}
+
+std::vector<std::string>
+Ipv4GlobalRoutingIncrementalTestCase::RunEvents (bool incremental)
+{
+  Config::SetGlobal ("GlobalRoutingIncremental", BooleanValue (incremental));
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+
+  std::vector<std::string> tables;
+  tables.push_back (DumpRoutes (m_nodes));
+  for (uint32_t i = 0; i < m_events.size (); i++)
+    {
+      Ptr<Ipv4> ipv4 = m_events[i].first;
+      uint32_t interface = m_events[i].second;
+      if (ipv4->IsUp (interface))
+        {
+          ipv4->SetDown (interface);
+        }
+      else
+        {
+          ipv4->SetUp (interface);
+        }
+      Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+      tables.push_back (DumpRoutes (m_nodes));
+    }
+  return tables;
+}
+
+// Network topology
+//
+//   h0     h1
+//   |      |
+//   n0 --- n1 --- n2
+//   |      |      |
+//   n3 --- n4 --- n5
+//   |      |      |
+//   n6 --- n7 --- n8
+//
+// All links are point-to-point.  Links are taken down and brought back
+// up one side at a time, both on and off the shortest paths, and the
+// metric of the n4 -- n5 link is raised so that some paths are unique.
+// Last, h1 alone loses its only link, then gets it back.
+//
+void
+Ipv4GlobalRoutingIncrementalTestCase::DoRun (void)
+{
+  // The routes are recomputed explicitly after each change
+  Config::SetDefault ("ns3::Ipv4GlobalRouting::RespondToInterfaceEvents", BooleanValue (false));
+
+  m_nodes.Create (11);
+  InternetStackHelper internet;
+  internet.Install (m_nodes);
+
+  SimpleNetDeviceHelper devHelper;
+  devHelper.SetNetDevicePointToPointMode (true);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.0.0.0", "255.255.255.252");
+
+  std::vector<std::pair<uint32_t, uint32_t> > links;
+  for (uint32_t i = 0; i < 9; i++)
+    {
+      if (i % 3 != 2)
+        {
+          links.push_back (std::make_pair (i, i + 1));
+        }
+      if (i < 6)
+        {
+          links.push_back (std::make_pair (i, i + 3));
+        }
+    }
+  links.push_back (std::make_pair (9, 0));
+  links.push_back (std::make_pair (10, 1));
+
+  std::vector<std::pair<Ptr<Ipv4>, uint32_t> > ends[2];
+  for (uint32_t i = 0; i < links.size (); i++)
+    {
+      NodeContainer pair (m_nodes.Get (links[i].first), m_nodes.Get (links[i].second));
+      NetDeviceContainer devices = devHelper.Install (pair);
+      ipv4.Assign (devices);
+      ipv4.NewNetwork ();
+      for (uint32_t j = 0; j < 2; j++)
+        {
+          Ptr<Ipv4> ip = pair.Get (j)->GetObject<Ipv4> ();
+          ends[j].push_back (std::make_pair (ip, ip->GetInterfaceForDevice (devices.Get (j))));
+        }
+    }
+  // n4 -- n5 is the eighth link
+  ends[0][7].first->SetMetric (ends[0][7].second, 3);
+  ends[1][7].first->SetMetric (ends[1][7].second, 3);
+
+  uint32_t order[] = { 0, 7, 2, 11, 5, 9, 1, 12 };
+  for (uint32_t i = 0; i < sizeof (order) / sizeof (order[0]); i++)
+    {
+      m_events.push_back (ends[0][order[i]]);
+      m_events.push_back (ends[1][order[i]]);
+    }
+  for (uint32_t i = 0; i < sizeof (order) / sizeof (order[0]); i++)
+    {
+      m_events.push_back (ends[1][order[i]]);
+      m_events.push_back (ends[0][order[i]]);
+    }
+  // h1 -- n1 is the last link
+  uint32_t isolated = m_events.size () + 1;
+  m_events.push_back (ends[0][13]);
+  m_events.push_back (ends[0][13]);
+
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  std::vector<std::string> incremental = RunEvents (true);
+  std::vector<std::string> full = RunEvents (false);
+  Config::SetGlobal ("GlobalRoutingIncremental", BooleanValue (false));
+
+  NS_TEST_ASSERT_MSG_EQ (incremental.size (), full.size (), "Different number of events");
+  for (uint32_t i = 0; i < full.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (incremental[i], full[i], "Routes differ after event " << i);
+    }
+  // h1, the last node, keeps no route once it has no link
+  std::string noRoute = "node 10\n";
+  NS_TEST_EXPECT_MSG_EQ (incremental[isolated].substr (incremental[isolated].size () - noRoute.size ()), noRoute,
+                         "An isolated router kept its routes");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Tests the flow hash and flowlet ECMP modes of Ipv4GlobalRouting,
+ * and random ECMP on the packets of a batch
+ */
+class Ipv4GlobalRoutingEcmpTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingEcmpTestCase ();
+  virtual ~Ipv4GlobalRoutingEcmpTestCase ();
+
+private:
+  /**
+   * \brief Route a UDP packet forwarded by the first router
+   * \param sport The source port of the packet.
+   * \param size The size of the packet payload.
+   * \return the output device, or 0 if the packet is not routed
+   */
+  Ptr<NetDevice> Forward (uint16_t sport, uint32_t size);
+
+  /**
+   * \brief Receive the route of a forwarded packet
+   * \param route The route.
+   * \param p The packet.
+   * \param header The IPv4 header of the packet.
+   */
+  void ForwardCallback (Ptr<Ipv4Route> route, Ptr<const Packet> p, const Ipv4Header &header);
+
+  /**
+   * \brief Get the number of bytes routed to the output device of a route
+   * \param device The output device.
+   * \return the number of bytes
+   */
+  uint64_t GetBytes (Ptr<NetDevice> device);
+
+  /**
+   * \brief Send a burst of packets of one flow, and check that they all
+   * follow the least loaded route
+   */
+  void SendFlowlet (void);
+
+  /**
+   * \brief Send a batch of packets on a UDP socket with random ECMP, and
+   * check that each packet is routed and counted on its own
+   */
+  void SendBatch (void);
+
+  virtual void DoRun (void);
+
+  Ptr<Ipv4> m_ipv4;                       //!< IPv4 of the first router.
+  Ptr<Ipv4GlobalRouting> m_routing;       //!< Global routing of the first router.
+  Ptr<NetDevice> m_inputDevice;           //!< Device receiving the forwarded packets.
+  Ipv4Address m_destination;              //!< Destination of the packets.
+  Ptr<Ipv4Route> m_route;                 //!< Route of the last packet.
+  std::set<Ptr<NetDevice> > m_flowlets;   //!< Devices used by the flowlets.
+};
+
+Ipv4GlobalRoutingEcmpTestCase::Ipv4GlobalRoutingEcmpTestCase ()
+  : TestCase ("Flow hash and flowlet ECMP routing")
+{
+}
+
+Ipv4GlobalRoutingEcmpTestCase::~Ipv4GlobalRoutingEcmpTestCase ()
+{
+}
+
+void
+Ipv4GlobalRoutingEcmpTestCase::ForwardCallback (Ptr<Ipv4Route> route, Ptr<const Packet> p, const Ipv4Header &header)
+{
+  m_route = route;
+}
+
+Ptr<NetDevice>
+Ipv4GlobalRoutingEcmpTestCase::Forward (uint16_t sport, uint32_t size)
+{
+  Ptr<Packet> p = Create<Packet> (size);
+  UdpHeader udp;
+  udp.SetSourcePort (sport);
+  udp.SetDestinationPort (9);
+  p->AddHeader (udp);
+  Ipv4Header header;
+  header.SetSource (Ipv4Address ("10.9.9.9"));
+  header.SetDestination (m_destination);
+  header.SetProtocol (17);
+  header.SetPayloadSize (p->GetSize ());
+
+  m_route = 0;
+  m_routing->RouteInput (p, header, m_inputDevice,
+                         MakeCallback (&Ipv4GlobalRoutingEcmpTestCase::ForwardCallback, this),
+                         Ipv4RoutingProtocol::MulticastForwardCallback (),
+                         Ipv4RoutingProtocol::LocalDeliverCallback (),
+                         Ipv4RoutingProtocol::ErrorCallback ());
+  return m_route == 0 ? 0 : m_route->GetOutputDevice ();
+}
+
+uint64_t
+Ipv4GlobalRoutingEcmpTestCase::GetBytes (Ptr<NetDevice> device)
+{
+  uint32_t interface = m_ipv4->GetInterfaceForDevice (device);
+  // the routes to the middle routers go through their address on the link
+  Ipv4Address gateway (m_ipv4->GetAddress (interface, 0).GetLocal ().Get () + 1);
+  return m_routing->GetNextHopBytes (interface, gateway);
+}
+
+void
+Ipv4GlobalRoutingEcmpTestCase::SendFlowlet (void)
+{
+  Ptr<NetDevice> leastLoaded = 0;
+  uint64_t minBytes = 0;
+  for (uint32_t i = 1; i <= 4; i++)
+    {
+      Ptr<NetDevice> device = m_ipv4->GetNetDevice (i);
+      if (leastLoaded == 0 || GetBytes (device) < minBytes)
+        {
+          leastLoaded = device;
+          minBytes = GetBytes (device);
+        }
+    }
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (Forward (1000, 1000), leastLoaded, "Flowlet not on the least loaded route");
+    }
+  m_flowlets.insert (leastLoaded);
+}
+
+void
+Ipv4GlobalRoutingEcmpTestCase::SendBatch (void)
+{
+  m_routing->SetAttribute ("RandomEcmpRouting", BooleanValue (true));
+  uint64_t before[5];
+  for (uint32_t i = 1; i <= 4; i++)
+    {
+      before[i] = m_routing->GetNextHopPackets (i, Ipv4Address (m_ipv4->GetAddress (i, 0).GetLocal ().Get () + 1));
+    }
+  Ptr<Socket> socket = m_ipv4->GetObject<UdpSocketFactory> ()->CreateSocket ();
+  socket->Connect (InetSocketAddress (m_destination, 9));
+  std::vector<Ptr<Packet> > batch;
+  for (uint32_t i = 0; i < 40; i++)
+    {
+      batch.push_back (Create<Packet> (100));
+    }
+  NS_TEST_EXPECT_MSG_EQ (socket->SendBatch (batch, 0), 40, "The batch was not sent");
+  socket->Close ();
+
+  uint64_t packets = 0;
+  std::set<uint32_t> used;
+  for (uint32_t i = 1; i <= 4; i++)
+    {
+      uint64_t sent = m_routing->GetNextHopPackets (i, Ipv4Address (m_ipv4->GetAddress (i, 0).GetLocal ().Get () + 1)) - before[i];
+      packets += sent;
+      if (sent > 0)
+        {
+          used.insert (i);
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (packets, 40, "Not all the packets of the batch counted");
+  NS_TEST_EXPECT_MSG_GT (used.size (), 1, "The packets of the batch share one route");
+  m_routing->SetAttribute ("RandomEcmpRouting", BooleanValue (false));
+}
+
+// Network topology
+//
+//   n0 --- n1 --- n5 --- n6
+//   |             |
+//   +----- n2 ----+
+//   |             |
+//   +----- n3 ----+
+//   |             |
+//   +----- n4 ----+
+//
+// All links are point-to-point.  n0 reaches n6 through four routes of
+// equal cost, via n1, n2, n3 and n4.
+//
+void
+Ipv4GlobalRoutingEcmpTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (7);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+
+  SimpleNetDeviceHelper devHelper;
+  devHelper.SetNetDevicePointToPointMode (true);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.0.0.0", "255.255.255.252");
+  uint32_t links[][2] = { { 0, 1 }, { 0, 2 }, { 0, 3 }, { 0, 4 }, { 1, 5 }, { 2, 5 }, { 3, 5 }, { 4, 5 }, { 5, 6 } };
+  Ipv4InterfaceContainer interfaces;
+  for (uint32_t i = 0; i < sizeof (links) / sizeof (links[0]); i++)
+    {
+      NodeContainer pair (nodes.Get (links[i][0]), nodes.Get (links[i][1]));
+      interfaces = ipv4.Assign (devHelper.Install (pair));
+      ipv4.NewNetwork ();
+    }
+  m_destination = interfaces.GetAddress (1);
+
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  m_ipv4 = nodes.Get (0)->GetObject<Ipv4> ();
+  m_routing = nodes.Get (0)->GetObject<GlobalRouter> ()->GetRoutingProtocol ();
+  m_inputDevice = m_ipv4->GetNetDevice (1);
+
+  // By default, all the flows take the first route
+  NS_TEST_EXPECT_MSG_EQ (Forward (1000, 100), m_ipv4->GetNetDevice (1), "Unexpected route");
+  NS_TEST_EXPECT_MSG_EQ (Forward (1001, 100), m_ipv4->GetNetDevice (1), "Unexpected route");
+
+  // Each flow keeps its route, and the flows use all the routes
+  m_routing->SetAttribute ("EcmpMode", EnumValue (Ipv4GlobalRouting::ECMP_FLOW_HASH));
+  std::vector<Ptr<NetDevice> > routes;
+  std::set<Ptr<NetDevice> > used;
+  for (uint16_t sport = 0; sport < 256; sport++)
+    {
+      Ptr<NetDevice> device = Forward (sport, 100);
+      NS_TEST_ASSERT_MSG_NE (device, 0, "No route for flow " << sport);
+      NS_TEST_EXPECT_MSG_EQ (Forward (sport, 100), device, "Flow " << sport << " changed route");
+      routes.push_back (device);
+      used.insert (device);
+    }
+  NS_TEST_EXPECT_MSG_EQ (used.size (), 4, "Not all the routes used");
+
+  uint64_t packets = 0;
+  for (uint32_t i = 1; i <= 4; i++)
+    {
+      Ipv4Address gateway (m_ipv4->GetAddress (i, 0).GetLocal ().Get () + 1);
+      packets += m_routing->GetNextHopPackets (i, gateway);
+    }
+  NS_TEST_EXPECT_MSG_EQ (packets, 2 + 2 * 256, "Unexpected number of packets counted");
+
+  // Another seed spreads the flows differently
+  m_routing->SetAttribute ("EcmpHashSeed", UintegerValue (1));
+  uint32_t moved = 0;
+  for (uint16_t sport = 0; sport < 256; sport++)
+    {
+      if (Forward (sport, 100) != routes[sport])
+        {
+          moved++;
+        }
+    }
+  NS_TEST_EXPECT_MSG_GT (moved, 0, "The seed does not change the routes");
+
+  // A flow sent in bursts separated by more than the flowlet timeout
+  // moves to the least loaded route at each burst
+  m_routing->SetAttribute ("EcmpMode", EnumValue (Ipv4GlobalRouting::ECMP_FLOWLET));
+  m_routing->SetAttribute ("FlowletTimeout", TimeValue (MilliSeconds (1)));
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      Simulator::Schedule (MilliSeconds (2 * i), &Ipv4GlobalRoutingEcmpTestCase::SendFlowlet, this);
+    }
+  // The packets of a batch are routed one by one, hence spread by random ECMP
+  Simulator::Schedule (MilliSeconds (50), &Ipv4GlobalRoutingEcmpTestCase::SendBatch, this);
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_flowlets.size (), 4, "The flowlets did not use all the routes");
+
+  m_ipv4 = 0;
+  m_routing = 0;
+  m_inputDevice = 0;
+  m_route = 0;
+  m_flowlets.clear ();
+  Simulator::Destroy ();
+}
+
 /**
  * \ingroup internet-test
  * \ingroup tests
@@ -1267,6 +1719,8 @@ Ipv4GlobalRoutingTestSuite::Ipv4GlobalRoutingTestSuite ()
     AddTestCase (new TwoBridgeTest, TestCase::QUICK);
     AddTestCase (new Ipv4DynamicGlobalRoutingTestCase, TestCase::QUICK);
     AddTestCase (new Ipv4GlobalRoutingSlash32TestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingIncrementalTestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingEcmpTestCase, TestCase::QUICK);
   }
 
 static Ipv4GlobalRoutingTestSuite g_globalRoutingTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,169 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <list>
+#include <vector>
+#include "ns3/test.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/ipv4-route-trie.h"
+#include "ns3/ipv4-routing-table-entry.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check that Ipv4RouteTrie finds the same routes, in the same
+ * order, as a scan of the routing table.
+ */
+class Ipv4RouteTrieTestCase : public TestCase
+{
+public:
+  Ipv4RouteTrieTestCase ();
+  virtual ~Ipv4RouteTrieTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Draw an address close to the ones already in use, so that
+   * the prefixes nest and share bits.
+   * \return the address
+   */
+  uint32_t DrawAddress (void);
+
+  /**
+   * \brief Compare the trie with the routing table for a destination.
+   * \param dest the destination
+   */
+  void CheckLookup (Ipv4Address dest);
+
+  Ptr<UniformRandomVariable> m_random;         //!< Random variable
+  std::list<Ipv4RoutingTableEntry *> m_routes; //!< Routing table, in order of addition
+  Ipv4RouteTrie m_trie;                         //!< Index under test
+};
+
+Ipv4RouteTrieTestCase::Ipv4RouteTrieTestCase ()
+  : TestCase ("Check the routes found by Ipv4RouteTrie against a scan of the routing table")
+{
+}
+
+Ipv4RouteTrieTestCase::~Ipv4RouteTrieTestCase ()
+{
+}
+
+uint32_t
+Ipv4RouteTrieTestCase::DrawAddress (void)
+{
+  // 10.0.0.0/16, with the low bits of the third byte and the last byte varying
+  return 0x0a000000 | (m_random->GetInteger (0, 3) << 8) | m_random->GetInteger (0, 255);
+}
+
+void
+Ipv4RouteTrieTestCase::CheckLookup (Ipv4Address dest)
+{
+  std::vector<Ipv4RouteTrie::Entry> matches;
+  m_trie.Lookup (dest, matches);
+
+  uint32_t n = 0;
+  for (std::list<Ipv4RoutingTableEntry *>::const_iterator i = m_routes.begin (); i != m_routes.end (); i++)
+    {
+      if ((*i)->GetDestNetworkMask ().IsMatch (dest, (*i)->GetDestNetwork ()))
+        {
+          NS_TEST_ASSERT_MSG_LT (n, matches.size (), "Route " << **i << " not found for " << dest);
+          NS_TEST_EXPECT_MSG_EQ (matches[n].m_route, *i, "Unexpected route for " << dest << " at rank " << n);
+          n++;
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (matches.size (), n, "Too many routes found for " << dest);
+}
+
+void
+Ipv4RouteTrieTestCase::DoRun (void)
+{
+  m_random = CreateObject<UniformRandomVariable> ();
+  m_random->SetStream (1);
+
+  for (uint32_t round = 0; round < 2000; round++)
+    {
+      if (m_routes.empty () || m_random->GetInteger (0, 2) != 0)
+        {
+          Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
+          uint32_t length = m_random->GetInteger (0, 32);
+          if (length >= 16)
+            {
+              length = 16 + m_random->GetInteger (0, 16);
+            }
+          uint32_t mask = length == 0 ? 0 : 0xffffffff << (32 - length);
+          if (m_random->GetInteger (0, 19) == 0)
+            {
+              // a mask with holes
+              mask = 0xff00ff00;
+            }
+          *route = Ipv4RoutingTableEntry::CreateNetworkRouteTo (Ipv4Address (DrawAddress ()),
+                                                                Ipv4Mask (mask),
+                                                                m_random->GetInteger (1, 4));
+          m_routes.push_back (route);
+          m_trie.Add (route, round);
+        }
+      else
+        {
+          std::list<Ipv4RoutingTableEntry *>::iterator i = m_routes.begin ();
+          std::advance (i, m_random->GetInteger (0, m_routes.size () - 1));
+          m_trie.Remove (*i);
+          delete *i;
+          m_routes.erase (i);
+        }
+      CheckLookup (Ipv4Address (DrawAddress ()));
+      CheckLookup (Ipv4Address ("192.168.0.1"));
+    }
+
+  for (uint32_t dest = 0x0a000000; dest < 0x0a000400; dest++)
+    {
+      CheckLookup (Ipv4Address (dest));
+    }
+
+  while (!m_routes.empty ())
+    {
+      m_trie.Remove (m_routes.front ());
+      delete m_routes.front ();
+      m_routes.pop_front ();
+    }
+  std::vector<Ipv4RouteTrie::Entry> matches;
+  m_trie.Lookup (Ipv4Address ("10.0.0.1"), matches);
+  NS_TEST_EXPECT_MSG_EQ (matches.size (), 0, "Routes left after removing all of them");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Ipv4RouteTrie TestSuite
+ */
+class Ipv4RouteTrieTestSuite : public TestSuite
+{
+public:
+  Ipv4RouteTrieTestSuite ();
+};
+
+Ipv4RouteTrieTestSuite::Ipv4RouteTrieTestSuite ()
+  : TestSuite ("ipv4-route-trie", UNIT)
+{
+  AddTestCase (new Ipv4RouteTrieTestCase, TestCase::QUICK);
+}
+
+static Ipv4RouteTrieTestSuite g_ipv4RouteTrieTestSuite; //!< Static variable for test initialization
@@ -82,9 +82,13 @@ Ipv4L3ProtocolTestCase::DoRun (void)
   interface->AddAddress (ifaceAddr4);
   uint32_t num = interface->GetNAddresses ();
   NS_TEST_ASSERT_MSG_EQ (num, 4, "Should find 4 interfaces??");
+  NS_TEST_ASSERT_MSG_EQ (ipv4->GetInterfaceForAddress ("10.30.0.1"), 0,
+                         "Address added to the interface not found");
   interface->RemoveAddress (2);
   num = interface->GetNAddresses ();
   NS_TEST_ASSERT_MSG_EQ (num, 3, "Should find 3 interfaces??");
+  NS_TEST_ASSERT_MSG_EQ (ipv4->GetInterfaceForAddress ("10.30.0.1"), -1,
+                         "Address removed from the interface still found");
   Ipv4InterfaceAddress output = interface->GetAddress (2);
   NS_TEST_ASSERT_MSG_EQ (ifaceAddr4, output,
                          "The addresses should be identical");
@@ -116,6 +120,10 @@ Ipv4L3ProtocolTestCase::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (true, result, "Unable to remove Address??");
   num = interface->GetNAddresses ();
   NS_TEST_ASSERT_MSG_EQ (num, 1, "Should find 1 addresses??");
+  NS_TEST_ASSERT_MSG_EQ (ipv4->GetInterfaceForAddress ("192.168.0.2"), -1,
+                         "Removed address still found");
+  NS_TEST_ASSERT_MSG_EQ (ipv4->GetInterfaceForAddress ("192.168.0.1"), 0,
+                         "Remaining address not found");
 
   /* Remove a non-existent Address */
   result = ipv4->RemoveAddress (index, Ipv4Address ("189.0.0.1"));
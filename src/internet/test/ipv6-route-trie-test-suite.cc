@@ -0,0 +1,201 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <list>
+#include <vector>
+#include "ns3/test.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/ipv6-route-trie.h"
+#include "ns3/ipv6-routing-table-entry.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check that Ipv6RouteTrie finds the same routes, in the same
+ * order, as a scan of the routing table.
+ */
+class Ipv6RouteTrieTestCase : public TestCase
+{
+public:
+  Ipv6RouteTrieTestCase ();
+  virtual ~Ipv6RouteTrieTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Draw an address close to the ones already in use, so that
+   * the prefixes nest and share bits.
+   * \return the address
+   */
+  Ipv6Address DrawAddress (void);
+
+  /**
+   * \brief Draw a route to a random destination.
+   * \return the route
+   */
+  Ipv6RoutingTableEntry *DrawRoute (void);
+
+  /**
+   * \brief Compare the trie with the routing table for a destination.
+   * \param dest the destination
+   */
+  void CheckLookup (Ipv6Address dest);
+
+  Ptr<UniformRandomVariable> m_random;         //!< Random variable
+  std::list<Ipv6RoutingTableEntry *> m_routes; //!< Routing table
+  Ipv6RouteTrie m_trie;                         //!< Index under test
+};
+
+Ipv6RouteTrieTestCase::Ipv6RouteTrieTestCase ()
+  : TestCase ("Check the routes found by Ipv6RouteTrie against a scan of the routing table")
+{
+}
+
+Ipv6RouteTrieTestCase::~Ipv6RouteTrieTestCase ()
+{
+}
+
+Ipv6Address
+Ipv6RouteTrieTestCase::DrawAddress (void)
+{
+  // 2001:db8::/32, with a few bits varying in the middle and at the end
+  uint8_t bytes[16] = { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+  bytes[7] = m_random->GetInteger (0, 3) << 6;
+  bytes[8] = m_random->GetInteger (0, 1);
+  bytes[15] = m_random->GetInteger (0, 255);
+  return Ipv6Address (bytes);
+}
+
+Ipv6RoutingTableEntry *
+Ipv6RouteTrieTestCase::DrawRoute (void)
+{
+  uint32_t length = m_random->GetInteger (0, 128);
+  if (length >= 32)
+    {
+      length = 56 + m_random->GetInteger (0, 72);
+    }
+  Ipv6Prefix prefix (length);
+  if (m_random->GetInteger (0, 19) == 0)
+    {
+      // a prefix with holes
+      prefix = Ipv6Prefix ("ffff:0:ffff::");
+    }
+  Ipv6RoutingTableEntry *route = new Ipv6RoutingTableEntry ();
+  *route = Ipv6RoutingTableEntry::CreateNetworkRouteTo (DrawAddress (), prefix, m_random->GetInteger (1, 4));
+  return route;
+}
+
+void
+Ipv6RouteTrieTestCase::CheckLookup (Ipv6Address dest)
+{
+  std::vector<Ipv6RouteTrie::Entry> matches;
+  m_trie.Lookup (dest, matches);
+
+  uint32_t n = 0;
+  for (std::list<Ipv6RoutingTableEntry *>::const_iterator i = m_routes.begin (); i != m_routes.end (); i++)
+    {
+      if ((*i)->GetDestNetworkPrefix ().IsMatch (dest, (*i)->GetDestNetwork ()))
+        {
+          NS_TEST_ASSERT_MSG_LT (n, matches.size (), "Route " << **i << " not found for " << dest);
+          NS_TEST_EXPECT_MSG_EQ (matches[n].m_route, *i, "Unexpected route for " << dest << " at rank " << n);
+          n++;
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (matches.size (), n, "Too many routes found for " << dest);
+}
+
+void
+Ipv6RouteTrieTestCase::DoRun (void)
+{
+  m_random = CreateObject<UniformRandomVariable> ();
+  m_random->SetStream (1);
+
+  for (uint32_t round = 0; round < 2000; round++)
+    {
+      uint32_t action = m_routes.empty () ? 0 : m_random->GetInteger (0, 5);
+      if (action <= 1)
+        {
+          Ipv6RoutingTableEntry *route = DrawRoute ();
+          m_routes.push_back (route);
+          m_trie.Add (route, round);
+        }
+      else if (action == 2)
+        {
+          Ipv6RoutingTableEntry *route = DrawRoute ();
+          m_routes.push_front (route);
+          m_trie.AddFront (route, round);
+        }
+      else
+        {
+          std::list<Ipv6RoutingTableEntry *>::iterator i = m_routes.begin ();
+          std::advance (i, m_random->GetInteger (0, m_routes.size () - 1));
+          if (action == 3)
+            {
+              Ipv6RoutingTableEntry *route = new Ipv6RoutingTableEntry (**i);
+              m_trie.Replace (*i, route);
+              delete *i;
+              *i = route;
+            }
+          else
+            {
+              m_trie.Remove (*i);
+              delete *i;
+              m_routes.erase (i);
+            }
+        }
+      CheckLookup (DrawAddress ());
+      CheckLookup (Ipv6Address ("2001:db9::1"));
+    }
+
+  for (uint32_t i = 0; i < 500; i++)
+    {
+      CheckLookup (DrawAddress ());
+    }
+
+  while (!m_routes.empty ())
+    {
+      m_trie.Remove (m_routes.front ());
+      delete m_routes.front ();
+      m_routes.pop_front ();
+    }
+  std::vector<Ipv6RouteTrie::Entry> matches;
+  m_trie.Lookup (Ipv6Address ("2001:db8::1"), matches);
+  NS_TEST_EXPECT_MSG_EQ (matches.size (), 0, "Routes left after removing all of them");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Ipv6RouteTrie TestSuite
+ */
+class Ipv6RouteTrieTestSuite : public TestSuite
+{
+public:
+  Ipv6RouteTrieTestSuite ();
+};
+
+Ipv6RouteTrieTestSuite::Ipv6RouteTrieTestSuite ()
+  : TestSuite ("ipv6-route-trie", UNIT)
+{
+  AddTestCase (new Ipv6RouteTrieTestCase, TestCase::QUICK);
+}
+
+static Ipv6RouteTrieTestSuite g_ipv6RouteTrieTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,208 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/mac48-address.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv6-header.h"
+#include "ns3/arp-cache.h"
+#include "ns3/ndisc-cache.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the entries found by MAC address in ArpCache, and the
+ * limit on the packets pending in all its entries.
+ */
+class ArpCacheTestCase : public TestCase
+{
+public:
+  ArpCacheTestCase ();
+  virtual ~ArpCacheTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ArpCacheTestCase::ArpCacheTestCase ()
+  : TestCase ("Check the inverse lookups and the pending packets of ArpCache")
+{
+}
+
+ArpCacheTestCase::~ArpCacheTestCase ()
+{
+}
+
+void
+ArpCacheTestCase::DoRun (void)
+{
+  Ptr<ArpCache> cache = CreateObject<ArpCache> ();
+  cache->SetAttribute ("PendingQueueSize", UintegerValue (3));
+  cache->SetAttribute ("MaxPendingPackets", UintegerValue (4));
+  Address mac1 = Mac48Address ("00:00:00:00:00:01");
+  Address mac2 = Mac48Address ("00:00:00:00:00:02");
+
+  // A router with two addresses, and a host
+  ArpCache::Entry *router1 = cache->Add (Ipv4Address ("10.0.0.1"));
+  ArpCache::Entry *router2 = cache->Add (Ipv4Address ("10.0.0.2"));
+  ArpCache::Entry *host = cache->Add (Ipv4Address ("10.0.0.3"));
+  router1->SetMacAddress (mac1);
+  router1->MarkPermanent ();
+  router2->SetMacAddress (mac1);
+  router2->MarkPermanent ();
+  NS_TEST_EXPECT_MSG_EQ (cache->LookupInverse (mac1).size (), 2, "Router entries not found");
+  NS_TEST_EXPECT_MSG_EQ (cache->LookupInverse (mac2).size (), 0, "Unexpected entry found");
+
+  // The host resolves to mac2; its packets are pending meanwhile
+  Ipv4Header header;
+  host->MarkDead ();
+  host->MarkWaitReply (ArpCache::Ipv4PayloadHeaderPair (Create<Packet> (), header));
+  NS_TEST_EXPECT_MSG_EQ (host->UpdateWaitReply (ArpCache::Ipv4PayloadHeaderPair (Create<Packet> (), header)), true, "Packet not queued");
+  NS_TEST_EXPECT_MSG_EQ (host->UpdateWaitReply (ArpCache::Ipv4PayloadHeaderPair (Create<Packet> (), header)), true, "Packet not queued");
+  NS_TEST_EXPECT_MSG_EQ (host->UpdateWaitReply (ArpCache::Ipv4PayloadHeaderPair (Create<Packet> (), header)), false, "Entry queue limit exceeded");
+  host->MarkAlive (mac2);
+  NS_TEST_EXPECT_MSG_EQ (cache->LookupInverse (mac2).size (), 1, "Host entry not found");
+  NS_TEST_EXPECT_MSG_EQ (cache->LookupInverse (mac2).front (), host, "Unexpected entry found");
+
+  // The cache limit applies to all the entries
+  ArpCache::Entry *other = cache->Add (Ipv4Address ("10.0.0.4"));
+  other->MarkWaitReply (ArpCache::Ipv4PayloadHeaderPair (Create<Packet> (), header));
+  NS_TEST_EXPECT_MSG_EQ (other->UpdateWaitReply (ArpCache::Ipv4PayloadHeaderPair (Create<Packet> (), header)), false, "Cache queue limit exceeded");
+  host->ClearPendingPacket ();
+  NS_TEST_EXPECT_MSG_EQ (other->UpdateWaitReply (ArpCache::Ipv4PayloadHeaderPair (Create<Packet> (), header)), true, "Packet not queued");
+
+  // A moved address and removed entries are no longer found
+  router2->SetMacAddress (mac2);
+  NS_TEST_EXPECT_MSG_EQ (cache->LookupInverse (mac1).size (), 1, "Moved entry still found");
+  NS_TEST_EXPECT_MSG_EQ (cache->LookupInverse (mac2).size (), 2, "Moved entry not found");
+  cache->Remove (host);
+  cache->Remove (other);
+  NS_TEST_EXPECT_MSG_EQ (cache->LookupInverse (mac2).size (), 1, "Removed entry still found");
+  NS_TEST_EXPECT_MSG_EQ (cache->Lookup (Ipv4Address ("10.0.0.3")), 0, "Removed entry still found");
+  cache->Flush ();
+  NS_TEST_EXPECT_MSG_EQ (cache->LookupInverse (mac1).size (), 0, "Entry found after a flush");
+
+  cache->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the entries found by MAC address in NdiscCache, and the
+ * limit on the packets waiting in all its entries.
+ */
+class NdiscCacheTestCase : public TestCase
+{
+public:
+  NdiscCacheTestCase ();
+  virtual ~NdiscCacheTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+NdiscCacheTestCase::NdiscCacheTestCase ()
+  : TestCase ("Check the inverse lookups and the waiting packets of NdiscCache")
+{
+}
+
+NdiscCacheTestCase::~NdiscCacheTestCase ()
+{
+}
+
+void
+NdiscCacheTestCase::DoRun (void)
+{
+  Ptr<NdiscCache> cache = CreateObject<NdiscCache> ();
+  cache->SetAttribute ("UnresolvedQueueSize", UintegerValue (3));
+  cache->SetAttribute ("MaxUnresolvedPackets", UintegerValue (4));
+  Address mac1 = Mac48Address ("00:00:00:00:00:01");
+  Address mac2 = Mac48Address ("00:00:00:00:00:02");
+
+  NdiscCache::Entry *router1 = cache->Add (Ipv6Address ("2001:db8::1"));
+  NdiscCache::Entry *router2 = cache->Add (Ipv6Address ("fe80::1"));
+  NdiscCache::Entry *host = cache->Add (Ipv6Address ("2001:db8::3"));
+  router1->SetMacAddress (mac1);
+  router1->MarkPermanent ();
+  router2->SetMacAddress (mac1);
+  router2->MarkPermanent ();
+  NS_TEST_EXPECT_MSG_EQ (cache->LookupInverse (mac1).size (), 2, "Router entries not found");
+  NS_TEST_EXPECT_MSG_EQ (cache->LookupInverse (mac2).size (), 0, "Unexpected entry found");
+
+  // The waiting packets of all the entries are limited
+  Ipv6Header header;
+  host->MarkIncomplete (NdiscCache::Ipv6PayloadHeaderPair (Create<Packet> (1), header));
+  host->AddWaitingPacket (NdiscCache::Ipv6PayloadHeaderPair (Create<Packet> (2), header));
+  host->AddWaitingPacket (NdiscCache::Ipv6PayloadHeaderPair (Create<Packet> (3), header));
+  host->AddWaitingPacket (NdiscCache::Ipv6PayloadHeaderPair (Create<Packet> (4), header));
+  std::list<NdiscCache::Ipv6PayloadHeaderPair> waiting = host->MarkStale (mac2);
+  NS_TEST_EXPECT_MSG_EQ (waiting.size (), 3, "Entry queue limit exceeded");
+  NS_TEST_EXPECT_MSG_EQ (waiting.front ().first->GetSize (), 2, "Oldest packet not dropped");
+
+  NdiscCache::Entry *other = cache->Add (Ipv6Address ("2001:db8::4"));
+  other->MarkIncomplete (NdiscCache::Ipv6PayloadHeaderPair (Create<Packet> (1), header));
+  other->AddWaitingPacket (NdiscCache::Ipv6PayloadHeaderPair (Create<Packet> (2), header));
+  waiting = other->MarkStale (mac2);
+  NS_TEST_EXPECT_MSG_EQ (waiting.size (), 1, "Cache queue limit exceeded");
+  NS_TEST_EXPECT_MSG_EQ (waiting.front ().first->GetSize (), 2, "Oldest packet not replaced");
+
+  host->ClearWaitingPacket ();
+  other->AddWaitingPacket (NdiscCache::Ipv6PayloadHeaderPair (Create<Packet> (3), header));
+  waiting = other->MarkStale (mac2);
+  NS_TEST_EXPECT_MSG_EQ (waiting.size (), 2, "Packet not queued");
+
+  // Entries are found by their current MAC address
+  NS_TEST_EXPECT_MSG_EQ (cache->LookupInverse (mac2).size (), 2, "Host entries not found");
+  router2->SetMacAddress (mac2);
+  NS_TEST_EXPECT_MSG_EQ (cache->LookupInverse (mac1).size (), 1, "Moved entry still found");
+  NS_TEST_EXPECT_MSG_EQ (cache->LookupInverse (mac2).size (), 3, "Moved entry not found");
+  cache->Remove (host);
+  NS_TEST_EXPECT_MSG_EQ (cache->LookupInverse (mac2).size (), 2, "Removed entry still found");
+  NS_TEST_EXPECT_MSG_EQ (cache->Lookup (Ipv6Address ("2001:db8::3")), 0, "Removed entry still found");
+  cache->Flush ();
+  NS_TEST_EXPECT_MSG_EQ (cache->LookupInverse (mac2).size (), 0, "Entry found after a flush");
+
+  cache->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief ArpCache and NdiscCache TestSuite
+ */
+class NeighborCacheTestSuite : public TestSuite
+{
+public:
+  NeighborCacheTestSuite ();
+};
+
+NeighborCacheTestSuite::NeighborCacheTestSuite ()
+  : TestSuite ("neighbor-cache", UNIT)
+{
+  AddTestCase (new ArpCacheTestCase, TestCase::QUICK);
+  AddTestCase (new NdiscCacheTestCase, TestCase::QUICK);
+}
+
+static NeighborCacheTestSuite g_neighborCacheTestSuite; //!< Static variable for test initialization
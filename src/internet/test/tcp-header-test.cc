@@ -24,6 +24,8 @@
 #include "ns3/tcp-header.h"
 #include "ns3/buffer.h"
 #include "ns3/tcp-option-rfc793.h"
+#include "ns3/tcp-option-ts.h"
+#include "ns3/tcp-option-sack.h"
 
 using namespace ns3;
 
@@ -351,6 +353,83 @@ TcpHeaderWithRFC793OptionTestCase::DoTeardown ()
 
 }
 
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP header with timestamp and SACK options test.
+ *
+ * The options appended without creating any TcpOption object must be
+ * read back, after a serialization and a deserialization, both without
+ * creating any object and as TcpOption objects.
+ */
+class TcpHeaderWithTsSackOptionTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   * \param name Test description.
+   */
+  TcpHeaderWithTsSackOptionTestCase (std::string name);
+
+private:
+  virtual void DoRun (void);
+};
+
+TcpHeaderWithTsSackOptionTestCase::TcpHeaderWithTsSackOptionTestCase (std::string name)
+  : TestCase (name)
+{
+}
+
+void
+TcpHeaderWithTsSackOptionTestCase::DoRun (void)
+{
+  TcpHeader source;
+  TcpOptionSack::SackList blocks;
+  blocks.push_back (TcpOptionSack::SackBlock (SequenceNumber32 (3001), SequenceNumber32 (4001)));
+  blocks.push_back (TcpOptionSack::SackBlock (SequenceNumber32 (1001), SequenceNumber32 (2001)));
+  blocks.push_back (TcpOptionSack::SackBlock (SequenceNumber32 (5001), SequenceNumber32 (6001)));
+
+  NS_TEST_ASSERT_MSG_EQ (source.AppendOptionTimestamp (0xdeadbeef, 12345), true, "TS option not appended");
+  NS_TEST_ASSERT_MSG_EQ (source.AppendOptionSack (blocks), true, "SACK option not appended");
+  NS_TEST_ASSERT_MSG_EQ (source.GetOptionLength (), 36, "Wrong option length");
+  NS_TEST_ASSERT_MSG_EQ (source.GetLength (), 14, "Wrong header length");
+
+  blocks.push_back (TcpOptionSack::SackBlock (SequenceNumber32 (7001), SequenceNumber32 (8001)));
+  NS_TEST_ASSERT_MSG_EQ (source.AppendOptionSack (blocks), false, "Options exceed 40 bytes");
+
+  Buffer buffer;
+  buffer.AddAtStart (source.GetSerializedSize ());
+  source.Serialize (buffer.Begin ());
+
+  TcpHeader destination;
+  NS_TEST_ASSERT_MSG_EQ (destination.Deserialize (buffer.Begin ()), 56, "Wrong deserialized size");
+  NS_TEST_ASSERT_MSG_EQ (destination.HasOption (TcpOption::TS), true, "TS option not found");
+  NS_TEST_ASSERT_MSG_EQ (destination.HasOption (TcpOption::SACK), true, "SACK option not found");
+  NS_TEST_ASSERT_MSG_EQ (destination.HasOption (TcpOption::MSS), false, "MSS option found");
+
+  uint32_t timestamp, echo;
+  NS_TEST_ASSERT_MSG_EQ (destination.GetOptionTimestamp (timestamp, echo), true, "TS option not read");
+  NS_TEST_ASSERT_MSG_EQ (timestamp, 0xdeadbeef, "Wrong timestamp");
+  NS_TEST_ASSERT_MSG_EQ (echo, 12345, "Wrong echo");
+
+  TcpOptionSack::SackList list;
+  NS_TEST_ASSERT_MSG_EQ (destination.GetOptionSack (list), true, "SACK option not read");
+  NS_TEST_ASSERT_MSG_EQ (list.size (), 3, "Wrong number of SACK blocks");
+  NS_TEST_ASSERT_MSG_EQ (list.front ().first, SequenceNumber32 (3001), "Wrong first SACK block");
+  NS_TEST_ASSERT_MSG_EQ (list.back ().second, SequenceNumber32 (6001), "Wrong last SACK block");
+
+  Ptr<const TcpOptionTS> ts = DynamicCast<const TcpOptionTS> (destination.GetOption (TcpOption::TS));
+  NS_TEST_ASSERT_MSG_NE (ts, 0, "TS option object not created");
+  NS_TEST_ASSERT_MSG_EQ (ts->GetTimestamp (), 0xdeadbeef, "Wrong timestamp in the option object");
+  NS_TEST_ASSERT_MSG_EQ (ts->GetEcho (), 12345, "Wrong echo in the option object");
+
+  Ptr<const TcpOptionSack> sack = DynamicCast<const TcpOptionSack> (destination.GetOption (TcpOption::SACK));
+  NS_TEST_ASSERT_MSG_NE (sack, 0, "SACK option object not created");
+  NS_TEST_ASSERT_MSG_EQ (sack->GetNumSackBlocks (), 3, "Wrong number of SACK blocks in the option object");
+  NS_TEST_ASSERT_MSG_EQ (destination.GetOptionList ().size (), 2, "Wrong number of option objects");
+}
+
 /**
  * \ingroup internet-test
  * \ingroup tests
@@ -435,6 +514,7 @@ public:
   {
     AddTestCase (new TcpHeaderGetSetTestCase ("GetSet test cases"), TestCase::QUICK);
     AddTestCase (new TcpHeaderWithRFC793OptionTestCase ("Test for options in RFC 793"), TestCase::QUICK);
+    AddTestCase (new TcpHeaderWithTsSackOptionTestCase ("Test for timestamp and SACK options"), TestCase::QUICK);
     AddTestCase (new TcpHeaderFlagsToString ("Test flags to string function"), TestCase::QUICK);
   }
 
@@ -18,6 +18,7 @@
 #include "ns3/test.h"
 #include "ns3/packet.h"
 #include "ns3/log.h"
+#include "ns3/socket.h"
 
 #include "ns3/tcp-rx-buffer.h"
 
@@ -44,6 +45,13 @@ private:
    * \brief Test the SACK list update.
    */
   void TestUpdateSACKList ();
+
+  /**
+   * \brief Test the SACK blocks taken from the out-of-order data, when
+   * there are more blocks than the SACK list can hold, and the data
+   * extracted once the holes are filled.
+   */
+  void TestOutOfOrderBlocks ();
 };
 
 TcpRxBufferTestCase::TcpRxBufferTestCase ()
@@ -55,6 +63,7 @@ void
 TcpRxBufferTestCase::DoRun ()
 {
   TestUpdateSACKList ();
+  TestOutOfOrderBlocks ();
 }
 
 void
@@ -338,6 +347,92 @@ TcpRxBufferTestCase::TestUpdateSACKList ()
                          "SACK list should contain no element");
 }
 
+void
+TcpRxBufferTestCase::TestOutOfOrderBlocks ()
+{
+  TcpRxBuffer rxBuf;
+  TcpOptionSack::SackList sackList;
+  TcpOptionSack::SackList::iterator it;
+  Ptr<Packet> p = Create<Packet> (100);
+  TcpHeader h;
+
+  rxBuf.SetNextRxSequence (SequenceNumber32 (101));
+  rxBuf.SetMaxBufferSize (10000);
+
+  // Six isolated blocks: the SACK list keeps the four newest ones
+  for (uint32_t seq = 301; seq <= 1301; seq += 200)
+    {
+      h.SetSequenceNumber (SequenceNumber32 (seq));
+      rxBuf.Add (p, h);
+    }
+  sackList = rxBuf.GetSackList ();
+  NS_TEST_ASSERT_MSG_EQ (sackList.size (), 4,
+                         "SACK list should contain four element");
+  NS_TEST_ASSERT_MSG_EQ (sackList.front ().first, SequenceNumber32 (1301),
+                         "SACK block different than expected");
+
+  // Fill the hole between two blocks no longer in the list: the whole
+  // block is reported first
+  h.SetSequenceNumber (SequenceNumber32 (401));
+  rxBuf.Add (p, h);
+
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.NextRxSequence (), SequenceNumber32 (101),
+                         "Sequence number differs from expected");
+  sackList = rxBuf.GetSackList ();
+  NS_TEST_ASSERT_MSG_EQ (sackList.size (), 4,
+                         "SACK list should contain four element");
+  it = sackList.begin ();
+  NS_TEST_ASSERT_MSG_EQ (it->first, SequenceNumber32 (301),
+                         "SACK block different than expected");
+  NS_TEST_ASSERT_MSG_EQ (it->second, SequenceNumber32 (601),
+                         "SACK block different than expected");
+  ++it;
+  NS_TEST_ASSERT_MSG_EQ (it->first, SequenceNumber32 (1301),
+                         "SACK block different than expected");
+
+  // A segment covering a block and overlapping the next one is trimmed,
+  // and merges both of them
+  h.SetSequenceNumber (SequenceNumber32 (651));
+  rxBuf.Add (Create<Packet> (300), h);
+
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.Size (), 850,
+                         "Buffer occupancy differs from expected");
+  sackList = rxBuf.GetSackList ();
+  it = sackList.begin ();
+  NS_TEST_ASSERT_MSG_EQ (it->first, SequenceNumber32 (651),
+                         "SACK block different than expected");
+  NS_TEST_ASSERT_MSG_EQ (it->second, SequenceNumber32 (1001),
+                         "SACK block different than expected");
+
+  // Fill the first hole: the next sequence jumps to the end of the block
+  Ptr<Packet> tagged = Create<Packet> (200);
+  SocketIpTtlTag tag;
+  tag.SetTtl (64);
+  tagged->AddPacketTag (tag);
+  h.SetSequenceNumber (SequenceNumber32 (101));
+  rxBuf.Add (tagged, h);
+
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.NextRxSequence (), SequenceNumber32 (601),
+                         "Sequence number differs from expected");
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.Available (), 500,
+                         "Available bytes differ from expected");
+  sackList = rxBuf.GetSackList ();
+  NS_TEST_ASSERT_MSG_EQ (sackList.size (), 3,
+                         "SACK list should contain three element");
+
+  // Extract a segment and a half, then the rest of the in-order data
+  Ptr<Packet> out = rxBuf.Extract (300);
+  NS_TEST_ASSERT_MSG_EQ (out->GetSize (), 300, "Extracted size differs from expected");
+  NS_TEST_ASSERT_MSG_EQ (out->PeekPacketTag (tag), false, "Packet tags of a segment extracted");
+  NS_TEST_ASSERT_MSG_EQ (tagged->PeekPacketTag (tag), true, "Packet tags of the received segment removed");
+  out = rxBuf.Extract (1000);
+  NS_TEST_ASSERT_MSG_EQ (out->GetSize (), 200, "Extracted size differs from expected");
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.Available (), 0, "Available bytes differ from expected");
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.Extract (1000), 0, "Extracted data out of order");
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.Size (), 550,
+                         "Buffer occupancy differs from expected");
+}
+
 void
 TcpRxBufferTestCase::DoTeardown ()
 {
@@ -54,6 +54,7 @@
 #include "ns3/ipv6-address-helper.h"
 
 #include <string>
+#include <vector>
 #include <limits>
 
 using namespace ns3;
@@ -111,6 +112,76 @@ UdpSocketLoopbackTest::DoRun ()
   NS_TEST_EXPECT_MSG_EQ (m_receivedPacket->GetSize (), 246, "first socket should not receive it (it is bound specifically to the second interface's address");
 }
 
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief UDP Socket batched send and receive over IPv4 loopback Test
+ */
+class UdpSocketBatchTest : public TestCase
+{
+public:
+  UdpSocketBatchTest ();
+  virtual void DoRun (void);
+};
+
+UdpSocketBatchTest::UdpSocketBatchTest ()
+  : TestCase ("UDP batched send and receive test")
+{
+}
+
+void
+UdpSocketBatchTest::DoRun ()
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.Install (node);
+
+  Ptr<SocketFactory> socketFactory = node->GetObject<UdpSocketFactory> ();
+  Ptr<Socket> rxSocket = socketFactory->CreateSocket ();
+  rxSocket->Bind (InetSocketAddress (Ipv4Address::GetAny (), 80));
+
+  std::vector<Ptr<Packet> > packets;
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      packets.push_back (Create<Packet> (100 + i));
+    }
+
+  Ptr<Socket> txSocket = socketFactory->CreateSocket ();
+  NS_TEST_EXPECT_MSG_EQ (txSocket->SendBatch (packets, 0), -1, "SendBatch should fail on a socket not connected");
+  NS_TEST_EXPECT_MSG_EQ (txSocket->GetErrno (), Socket::ERROR_NOTCONN, "SendBatch should fail with ERROR_NOTCONN");
+  txSocket->Connect (InetSocketAddress ("127.0.0.1", 80));
+  NS_TEST_EXPECT_MSG_EQ (txSocket->SendBatch (packets, 0), 5, "SendBatch should send the whole train");
+
+  // A packet too large stops the train
+  std::vector<Ptr<Packet> > oversized;
+  oversized.push_back (Create<Packet> (200));
+  oversized.push_back (Create<Packet> (70000));
+  oversized.push_back (Create<Packet> (201));
+  NS_TEST_EXPECT_MSG_EQ (txSocket->SendBatchTo (oversized, 0, InetSocketAddress ("127.0.0.1", 80)), 1,
+                         "SendBatchTo should stop at the packet too large");
+  NS_TEST_EXPECT_MSG_EQ (txSocket->GetErrno (), Socket::ERROR_MSGSIZE, "SendBatchTo should fail with ERROR_MSGSIZE");
+  Simulator::Run ();
+
+  std::vector<Ptr<Packet> > received;
+  std::vector<Address> from;
+  NS_TEST_EXPECT_MSG_EQ (rxSocket->RecvBatchFrom (received, from, 4, 0), 4, "RecvBatchFrom should stop at maxPackets");
+  NS_TEST_ASSERT_MSG_EQ (from.size (), 4, "RecvBatchFrom should return one address per packet");
+  Address local;
+  txSocket->GetSockName (local);
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (received[i]->GetSize (), 100 + i, "Packets should be received in order");
+      NS_TEST_EXPECT_MSG_EQ (InetSocketAddress::ConvertFrom (from[i]).GetPort (),
+                             InetSocketAddress::ConvertFrom (local).GetPort (), "Wrong source port");
+    }
+  NS_TEST_EXPECT_MSG_EQ (rxSocket->RecvBatch (received, 10), 2, "RecvBatch should return the packets left");
+  NS_TEST_EXPECT_MSG_EQ (received[0]->GetSize (), 104, "Packets should be received in order");
+  NS_TEST_EXPECT_MSG_EQ (received[1]->GetSize (), 200, "Packets should be received in order");
+  NS_TEST_EXPECT_MSG_EQ (rxSocket->RecvBatch (received, 10), 0, "RecvBatch should return no packet once drained");
+  Simulator::Destroy ();
+}
+
 /**
  * \ingroup internet-test
  * \ingroup tests
@@ -721,6 +792,7 @@ public:
   {
     AddTestCase (new UdpSocketImplTest, TestCase::QUICK);
     AddTestCase (new UdpSocketLoopbackTest, TestCase::QUICK);
+    AddTestCase (new UdpSocketBatchTest, TestCase::QUICK);
     AddTestCase (new Udp6SocketImplTest, TestCase::QUICK);
     AddTestCase (new Udp6SocketLoopbackTest, TestCase::QUICK);
   }
@@ -397,6 +397,96 @@ AsciiTraceHelper::DefaultReceiveSinkWithContext (Ptr<OutputStreamWrapper> stream
   *stream->GetStream () << "r " << Simulator::Now ().GetSeconds () << " " << context << " " << *p << std::endl;
 }
 
+BinaryTraceHelper::BinaryTraceHelper ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+BinaryTraceHelper::~BinaryTraceHelper ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+Ptr<BinaryTraceFile>
+BinaryTraceHelper::CreateFile (std::string filename, uint32_t snapLen)
+{
+  NS_LOG_FUNCTION (filename << snapLen);
+
+  Ptr<BinaryTraceFile> file = Create<BinaryTraceFile> ();
+  file->Open (filename, std::ios::out);
+  NS_ABORT_MSG_IF (file->Fail (), "Unable to Open " << filename);
+
+  file->Init (snapLen);
+  NS_ABORT_MSG_IF (file->Fail (), "Unable to Init " << filename);
+
+  //
+  // As for the pcap and ascii helpers, the lifetime of the file is managed
+  // by the callbacks it gets bound to.
+  //
+  return file;
+}
+
+std::string
+BinaryTraceHelper::GetFilenameFromDevice (std::string prefix, Ptr<NetDevice> device, bool useObjectNames)
+{
+  NS_LOG_FUNCTION (prefix << device << useObjectNames);
+
+  //
+  // Reuse the ascii naming rules, only swapping the extension.
+  //
+  AsciiTraceHelper asciiTraceHelper;
+  std::string filename = asciiTraceHelper.GetFilenameFromDevice (prefix, device, useObjectNames);
+  return filename.substr (0, filename.size () - 3) + ".btr";
+}
+
+BinaryTraceHelper::SinkFunction
+BinaryTraceHelper::GetDefaultSink (BinaryTraceFile::EventType event)
+{
+  NS_LOG_FUNCTION (event);
+  switch (event)
+    {
+    case BinaryTraceFile::ENQUEUE:
+      return &DefaultEnqueueSink;
+    case BinaryTraceFile::DEQUEUE:
+      return &DefaultDequeueSink;
+    case BinaryTraceFile::DROP:
+      return &DefaultDropSink;
+    case BinaryTraceFile::RECEIVE:
+      return &DefaultReceiveSink;
+    default:
+      NS_FATAL_ERROR ("BinaryTraceHelper::GetDefaultSink(): Unknown event type " << event);
+    }
+  return 0;
+}
+
+void
+BinaryTraceHelper::DefaultEnqueueSink (Ptr<BinaryTraceFile> file, uint32_t nodeId, uint32_t deviceId, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (file << nodeId << deviceId << p);
+  file->Write (Simulator::Now (), nodeId, deviceId, BinaryTraceFile::ENQUEUE, p);
+}
+
+void
+BinaryTraceHelper::DefaultDequeueSink (Ptr<BinaryTraceFile> file, uint32_t nodeId, uint32_t deviceId, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (file << nodeId << deviceId << p);
+  file->Write (Simulator::Now (), nodeId, deviceId, BinaryTraceFile::DEQUEUE, p);
+}
+
+void
+BinaryTraceHelper::DefaultDropSink (Ptr<BinaryTraceFile> file, uint32_t nodeId, uint32_t deviceId, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (file << nodeId << deviceId << p);
+  file->Write (Simulator::Now (), nodeId, deviceId, BinaryTraceFile::DROP, p);
+}
+
+void
+BinaryTraceHelper::DefaultReceiveSink (Ptr<BinaryTraceFile> file, uint32_t nodeId, uint32_t deviceId, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (file << nodeId << deviceId << p);
+  file->Write (Simulator::Now (), nodeId, deviceId, BinaryTraceFile::RECEIVE, p);
+}
+
 void 
 PcapHelperForDevice::EnablePcap (std::string prefix, Ptr<NetDevice> nd, bool promiscuous, bool explicitFilename)
 {
@@ -650,5 +740,107 @@ AsciiTraceHelperForDevice::EnableAsciiImpl (
     }
 }
 
-} // namespace ns3
+//
+// Public API
+//
+void
+BinaryTraceHelperForDevice::EnableBinaryTrace (std::string prefix, Ptr<NetDevice> nd, bool explicitFilename)
+{
+  EnableBinaryTraceInternal (Ptr<BinaryTraceFile> (), prefix, nd, explicitFilename);
+}
+
+//
+// Public API
+//
+void
+BinaryTraceHelperForDevice::EnableBinaryTrace (Ptr<BinaryTraceFile> file, Ptr<NetDevice> nd)
+{
+  EnableBinaryTraceInternal (file, std::string (), nd, false);
+}
 
+//
+// Public API
+//
+void
+BinaryTraceHelperForDevice::EnableBinaryTrace (std::string prefix, NetDeviceContainer d)
+{
+  EnableBinaryTraceImpl (Ptr<BinaryTraceFile> (), prefix, d);
+}
+
+//
+// Public API
+//
+void
+BinaryTraceHelperForDevice::EnableBinaryTrace (Ptr<BinaryTraceFile> file, NetDeviceContainer d)
+{
+  EnableBinaryTraceImpl (file, std::string (), d);
+}
+
+//
+// Private API
+//
+void
+BinaryTraceHelperForDevice::EnableBinaryTraceImpl (Ptr<BinaryTraceFile> file, std::string prefix, NetDeviceContainer d)
+{
+  for (NetDeviceContainer::Iterator i = d.Begin (); i != d.End (); ++i)
+    {
+      Ptr<NetDevice> dev = *i;
+      EnableBinaryTraceInternal (file, prefix, dev, false);
+    }
+}
+
+//
+// Public API
+//
+void
+BinaryTraceHelperForDevice::EnableBinaryTrace (std::string prefix, NodeContainer n)
+{
+  EnableBinaryTraceImpl (Ptr<BinaryTraceFile> (), prefix, n);
+}
+
+//
+// Public API
+//
+void
+BinaryTraceHelperForDevice::EnableBinaryTrace (Ptr<BinaryTraceFile> file, NodeContainer n)
+{
+  EnableBinaryTraceImpl (file, std::string (), n);
+}
+
+//
+// Private API
+//
+void
+BinaryTraceHelperForDevice::EnableBinaryTraceImpl (Ptr<BinaryTraceFile> file, std::string prefix, NodeContainer n)
+{
+  NetDeviceContainer devs;
+  for (NodeContainer::Iterator i = n.Begin (); i != n.End (); ++i)
+    {
+      Ptr<Node> node = *i;
+      for (uint32_t j = 0; j < node->GetNDevices (); ++j)
+        {
+          devs.Add (node->GetDevice (j));
+        }
+    }
+  EnableBinaryTraceImpl (file, prefix, devs);
+}
+
+//
+// Public API
+//
+void
+BinaryTraceHelperForDevice::EnableBinaryTraceAll (std::string prefix)
+{
+  EnableBinaryTraceImpl (Ptr<BinaryTraceFile> (), prefix, NodeContainer::GetGlobal ());
+}
+
+//
+// Public API
+//
+void
+BinaryTraceHelperForDevice::EnableBinaryTraceAll (Ptr<BinaryTraceFile> file)
+{
+  EnableBinaryTraceImpl (file, std::string (), NodeContainer::GetGlobal ());
+}
+
+} // namespace ns3
@@ -25,6 +25,7 @@
 #include "ns3/simulator.h"
 #include "ns3/pcap-file-wrapper.h"
 #include "ns3/output-stream-wrapper.h"
+#include "ns3/binary-trace-file.h"
 
 namespace ns3 {
 
@@ -545,6 +546,135 @@ AsciiTraceHelper::HookDefaultReceiveSinkWithContext (
                  << tracename << "\"");
 }
 
+/**
+ * \brief Manage binary trace files for device models
+ *
+ * The binary traces carry the same events as the ascii traces ('+', '-',
+ * 'd' and 'r') but store each of them as a fixed-size BinaryTraceFile
+ * record instead of a printed packet, which is much cheaper to write and
+ * to post-process.  Since each record holds the node and device ids, no
+ * trace context is needed even when many devices share a single file.
+ */
+
+class BinaryTraceHelper
+{
+public:
+  /**
+   * Signature of the default binary trace sinks, once the file, node id
+   * and device id have been bound.
+   */
+  typedef void (* SinkFunction)(Ptr<BinaryTraceFile> file, uint32_t nodeId, uint32_t deviceId, Ptr<const Packet> p);
+
+  /**
+   * @brief Create a binary trace helper.
+   */
+  BinaryTraceHelper ();
+
+  /**
+   * @brief Destroy a binary trace helper.
+   */
+  ~BinaryTraceHelper ();
+
+  /**
+   * @brief Let the binary trace helper figure out a reasonable filename to
+   * use for a binary trace file associated with a device.
+   *
+   * @param prefix prefix string
+   * @param device NetDevice
+   * @param useObjectNames use node and device names instead of indexes
+   * @returns file name
+   */
+  std::string GetFilenameFromDevice (std::string prefix, Ptr<NetDevice> device, bool useObjectNames = true);
+
+  /**
+   * @brief Create and initialize a binary trace file.
+   *
+   * @param filename file name
+   * @param snapLen maximum number of packet bytes stored with each record
+   * @returns a smart pointer to the binary trace file
+   */
+  Ptr<BinaryTraceFile> CreateFile (std::string filename, uint32_t snapLen = BinaryTraceFile::SNAPLEN_DEFAULT);
+
+  /**
+   * @brief Hook a trace source to the default trace sink of an event type.
+   *
+   * @param object object
+   * @param traceName trace source name
+   * @param file binary trace file
+   * @param event the event type recorded by the sink
+   * @param nodeId the node id stored in the records
+   * @param deviceId the device id stored in the records
+   */
+  template <typename T>
+  void HookDefaultSink (Ptr<T> object, std::string traceName, Ptr<BinaryTraceFile> file,
+                        BinaryTraceFile::EventType event, uint32_t nodeId, uint32_t deviceId);
+
+  /**
+   * @param event an event type
+   * @returns the default trace sink recording events of this type
+   */
+  static SinkFunction GetDefaultSink (BinaryTraceFile::EventType event);
+
+  /**
+   * @brief Basic Enqueue default trace sink, the binary counterpart of
+   * AsciiTraceHelper::DefaultEnqueueSinkWithoutContext.
+   *
+   * @param file the binary trace file
+   * @param nodeId the node id
+   * @param deviceId the device id
+   * @param p the packet
+   */
+  static void DefaultEnqueueSink (Ptr<BinaryTraceFile> file, uint32_t nodeId, uint32_t deviceId, Ptr<const Packet> p);
+
+  /**
+   * @brief Basic Dequeue default trace sink, the binary counterpart of
+   * AsciiTraceHelper::DefaultDequeueSinkWithoutContext.
+   *
+   * @param file the binary trace file
+   * @param nodeId the node id
+   * @param deviceId the device id
+   * @param p the packet
+   */
+  static void DefaultDequeueSink (Ptr<BinaryTraceFile> file, uint32_t nodeId, uint32_t deviceId, Ptr<const Packet> p);
+
+  /**
+   * @brief Basic Drop default trace sink, the binary counterpart of
+   * AsciiTraceHelper::DefaultDropSinkWithoutContext.
+   *
+   * @param file the binary trace file
+   * @param nodeId the node id
+   * @param deviceId the device id
+   * @param p the packet
+   */
+  static void DefaultDropSink (Ptr<BinaryTraceFile> file, uint32_t nodeId, uint32_t deviceId, Ptr<const Packet> p);
+
+  /**
+   * @brief Basic Receive default trace sink, the binary counterpart of
+   * AsciiTraceHelper::DefaultReceiveSinkWithoutContext.
+   *
+   * @param file the binary trace file
+   * @param nodeId the node id
+   * @param deviceId the device id
+   * @param p the packet
+   */
+  static void DefaultReceiveSink (Ptr<BinaryTraceFile> file, uint32_t nodeId, uint32_t deviceId, Ptr<const Packet> p);
+};
+
+template <typename T> void
+BinaryTraceHelper::HookDefaultSink (
+  Ptr<T> object,
+  std::string tracename,
+  Ptr<BinaryTraceFile> file,
+  BinaryTraceFile::EventType event,
+  uint32_t nodeId,
+  uint32_t deviceId)
+{
+  bool result =
+    object->TraceConnectWithoutContext (tracename, MakeBoundCallback (GetDefaultSink (event), file, nodeId, deviceId));
+  NS_ASSERT_MSG (result == true, "BinaryTraceHelper::HookDefaultSink():  Unable to hook \""
+                 << tracename << "\"");
+}
+
 /**
  * \brief Base class providing common user-level pcap operations for helpers
  * representing net devices.
@@ -865,6 +995,139 @@ private:
   void EnableAsciiImpl (Ptr<OutputStreamWrapper> stream, std::string prefix, Ptr<NetDevice> nd, bool explicitFilename);
 };
 
+/**
+ * \brief Base class providing common user-level binary trace operations for
+ * helpers representing net devices.
+ */
+class BinaryTraceHelperForDevice
+{
+public:
+  /**
+   * @brief Construct a BinaryTraceHelperForDevice.
+   */
+  BinaryTraceHelperForDevice () {}
+
+  /**
+   * @brief Destroy a BinaryTraceHelperForDevice.
+   */
+  virtual ~BinaryTraceHelperForDevice () {}
+
+  /**
+   * @brief Enable binary trace output on the indicated net device.
+   *
+   * The implementation is expected to use a provided Ptr<BinaryTraceFile>
+   * if it is non-null.  If the file is null, the implementation is expected
+   * to use a provided prefix to construct a new file name for each net
+   * device, as for the ascii traces.
+   *
+   * @param file A BinaryTraceFile representing an existing file to use
+   *             when writing trace data.
+   * @param prefix Filename prefix to use for binary trace files.
+   * @param nd Net device for which you want to enable tracing
+   * @param explicitFilename Treat the prefix as an explicit filename if true
+   */
+  virtual void EnableBinaryTraceInternal (Ptr<BinaryTraceFile> file,
+                                          std::string prefix,
+                                          Ptr<NetDevice> nd,
+                                          bool explicitFilename) = 0;
+
+  /**
+   * @brief Enable binary trace output on the indicated net device.
+   *
+   * @param prefix Filename prefix to use for binary trace files.
+   * @param nd Net device for which you want to enable tracing.
+   * @param explicitFilename Treat the prefix as an explicit filename if true
+   */
+  void EnableBinaryTrace (std::string prefix, Ptr<NetDevice> nd, bool explicitFilename = false);
+
+  /**
+   * @brief Enable binary trace output on the indicated net device.
+   *
+   * @param file A BinaryTraceFile representing an existing file to use
+   *             when writing trace data.
+   * @param nd Net device for which you want to enable tracing.
+   */
+  void EnableBinaryTrace (Ptr<BinaryTraceFile> file, Ptr<NetDevice> nd);
+
+  /**
+   * @brief Enable binary trace output on each device in the container which
+   * is of the appropriate type.
+   *
+   * @param prefix Filename prefix to use for binary trace files.
+   * @param d container of devices
+   */
+  void EnableBinaryTrace (std::string prefix, NetDeviceContainer d);
+
+  /**
+   * @brief Enable binary trace output on each device in the container which
+   * is of the appropriate type.
+   *
+   * @param file A BinaryTraceFile representing an existing file to use
+   *             when writing trace data.
+   * @param d container of devices
+   */
+  void EnableBinaryTrace (Ptr<BinaryTraceFile> file, NetDeviceContainer d);
+
+  /**
+   * @brief Enable binary trace output on each device (which is of the
+   * appropriate type) in the nodes provided in the container.
+   *
+   * @param prefix Filename prefix to use for binary trace files.
+   * @param n container of nodes.
+   */
+  void EnableBinaryTrace (std::string prefix, NodeContainer n);
+
+  /**
+   * @brief Enable binary trace output on each device (which is of the
+   * appropriate type) in the nodes provided in the container.
+   *
+   * @param file A BinaryTraceFile representing an existing file to use
+   *             when writing trace data.
+   * @param n container of nodes.
+   */
+  void EnableBinaryTrace (Ptr<BinaryTraceFile> file, NodeContainer n);
+
+  /**
+   * @brief Enable binary trace output on each device (which is of the
+   * appropriate type) in the set of all nodes created in the simulation.
+   *
+   * @param prefix Filename prefix to use for binary trace files.
+   */
+  void EnableBinaryTraceAll (std::string prefix);
+
+  /**
+   * @brief Enable binary trace output on each device (which is of the
+   * appropriate type) in the set of all nodes created in the simulation.
+   *
+   * @param file A BinaryTraceFile representing an existing file to use
+   *             when writing trace data.
+   */
+  void EnableBinaryTraceAll (Ptr<BinaryTraceFile> file);
+
+private:
+  /**
+   * @brief Enable binary trace output on each device in the container which
+   * is of the appropriate type (implementation).
+   *
+   * @param file A BinaryTraceFile representing an existing file to use
+   *             when writing trace data.
+   * @param prefix Filename prefix to use for binary trace files.
+   * @param d container of devices
+   */
+  void EnableBinaryTraceImpl (Ptr<BinaryTraceFile> file, std::string prefix, NetDeviceContainer d);
+
+  /**
+   * @brief Enable binary trace output on each device (which is of the
+   * appropriate type) in the nodes provided in the container (implementation).
+   *
+   * @param file A BinaryTraceFile representing an existing file to use
+   *             when writing trace data.
+   * @param prefix Filename prefix to use for binary trace files.
+   * @param n container of nodes.
+   */
+  void EnableBinaryTraceImpl (Ptr<BinaryTraceFile> file, std::string prefix, NodeContainer n);
+};
+
 } // namespace ns3
 
 #endif /* TRACE_HELPER_H */
@@ -199,6 +199,21 @@ bool operator != (const Address &a, const Address &b)
 {
   return !(a == b);
 }
+size_t
+AddressHash::operator() (Address const &x) const
+{
+  // FNV-1a over the address bytes; equal addresses have the same bytes
+  uint8_t buffer[Address::MAX_SIZE];
+  uint32_t len = x.CopyTo (buffer);
+  uint32_t hash = 2166136261U;
+  for (uint32_t i = 0; i < len; i++)
+    {
+      hash ^= buffer[i];
+      hash *= 16777619U;
+    }
+  return hash;
+}
+
 bool operator < (const Address &a, const Address &b)
 {
   if (a.m_type < b.m_type)
@@ -277,6 +277,22 @@ private:
 
 ATTRIBUTE_HELPER_HEADER (Address);
 
+/**
+ * \ingroup address
+ *
+ * \brief Class providing a hash for Address
+ */
+class AddressHash
+{
+public:
+  /**
+   * Returns the hash of the address
+   * \param x the address
+   * \return the hash
+   */
+  size_t operator() (Address const &x) const;
+};
+
 bool operator == (const Address &a, const Address &b);
 bool operator != (const Address &a, const Address &b);
 bool operator < (const Address &a, const Address &b);
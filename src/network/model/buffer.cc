@@ -20,6 +20,8 @@
 #include "buffer.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
+#include <algorithm>
+#include <cstring>
 
 #define LOG_INTERNAL_STATE(y)                                                                    \
   NS_LOG_LOGIC (y << "start="<<m_start<<", end="<<m_end<<", zero start="<<m_zeroAreaStart<<              \
@@ -43,6 +45,63 @@ static struct Zeroes
   const uint32_t size;  //!< buffer size
 } g_zeroes; //!< Zero-filled buffer
 
+/**
+ * \ingroup packet
+ * \brief Add up a contiguous run of bytes for the Internet checksum.
+ *
+ * The bytes are summed four at a time in native byte order into a 64-bit
+ * accumulator; by the byte order independence of the one's complement sum
+ * (RFC 1071) the folded result only needs to be converted once at the end
+ * to match the little-endian 16-bit words read by Buffer::Iterator::ReadU16.
+ *
+ * \param data the bytes to add up
+ * \param len the number of bytes
+ * \param odd true if the first byte sits at an odd offset from the start
+ *        of the checksummed region
+ * \returns the folded 16-bit partial sum
+ */
+uint32_t
+ChecksumAddBytes (const uint8_t *data, uint32_t len, bool odd)
+{
+  uint64_t sum = 0;
+  while (len >= 4)
+    {
+      uint32_t word;
+      memcpy (&word, data, 4);
+      sum += word;
+      data += 4;
+      len -= 4;
+    }
+  if (len >= 2)
+    {
+      uint16_t word;
+      memcpy (&word, data, 2);
+      sum += word;
+      data += 2;
+      len -= 2;
+    }
+  if (len)
+    {
+      uint8_t last[2] = { *data, 0 };
+      uint16_t word;
+      memcpy (&word, last, 2);
+      sum += word;
+    }
+  while (sum >> 16)
+    {
+      sum = (sum & 0xffff) + (sum >> 16);
+    }
+
+  uint16_t folded = static_cast<uint16_t> (sum);
+  uint8_t bytes[2];
+  memcpy (bytes, &folded, 2);
+  if (odd)
+    {
+      return (bytes[0] << 8) | bytes[1];
+    }
+  return bytes[0] | (bytes[1] << 8);
+}
+
 }
 
 namespace ns3 {
@@ -1140,14 +1199,28 @@ uint16_t
 Buffer::Iterator::CalculateIpChecksum (uint16_t size, uint32_t initialChecksum)
 {
   NS_LOG_FUNCTION (this << size << initialChecksum);
-  /* see RFC 1071 to understand this code. */
-  uint32_t sum = initialChecksum;
+  NS_ASSERT_MSG (m_current >= m_dataStart &&
+                 m_current + size <= m_dataEnd,
+                 GetReadErrorMessage ());
 
-  for (int j = 0; j < size/2; j++)
-    sum += ReadU16 ();
+  /* see RFC 1071 to understand this code. */
+  uint64_t sum = initialChecksum;
+  uint32_t end = m_current + size;
 
-  if (size & 1)
-    sum += ReadU8 ();
+  /* the bytes before the virtual zero area */
+  if (m_current < m_zeroStart)
+    {
+      uint32_t stop = std::min (end, m_zeroStart);
+      sum += ChecksumAddBytes (&m_data[m_current], stop - m_current, false);
+    }
+  /* the virtual zero area adds nothing; then the bytes after it */
+  uint32_t start = std::max (m_current, m_zeroEnd);
+  if (start < end)
+    {
+      sum += ChecksumAddBytes (&m_data[start - (m_zeroEnd - m_zeroStart)],
+                               end - start, (start - m_current) & 1);
+    }
+  m_current = end;
 
   while (sum >> 16)
     sum = (sum & 0xffff) + (sum >> 16);
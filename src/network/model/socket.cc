@@ -212,6 +212,69 @@ Socket::RecvFrom (uint8_t* buf, uint32_t size, uint32_t flags,
   return p->GetSize ();
 }
 
+int
+Socket::SendBatch (const std::vector<Ptr<Packet> > &packets, uint32_t flags)
+{
+  NS_LOG_FUNCTION (this << packets.size () << flags);
+  int sent = 0;
+  for (std::vector<Ptr<Packet> >::const_iterator i = packets.begin (); i != packets.end (); i++)
+    {
+      if (Send (*i, flags) < 0)
+        {
+          return sent == 0 ? -1 : sent;
+        }
+      sent++;
+    }
+  return sent;
+}
+
+int
+Socket::SendBatchTo (const std::vector<Ptr<Packet> > &packets, uint32_t flags,
+                     const Address &toAddress)
+{
+  NS_LOG_FUNCTION (this << packets.size () << flags << toAddress);
+  int sent = 0;
+  for (std::vector<Ptr<Packet> >::const_iterator i = packets.begin (); i != packets.end (); i++)
+    {
+      if (SendTo (*i, flags, toAddress) < 0)
+        {
+          return sent == 0 ? -1 : sent;
+        }
+      sent++;
+    }
+  return sent;
+}
+
+uint32_t
+Socket::RecvBatchFrom (std::vector<Ptr<Packet> > &packets,
+                       std::vector<Address> &fromAddresses,
+                       uint32_t maxPackets, uint32_t flags)
+{
+  NS_LOG_FUNCTION (this << maxPackets << flags);
+  packets.clear ();
+  fromAddresses.clear ();
+  while (packets.size () < maxPackets)
+    {
+      Address from;
+      Ptr<Packet> p = RecvFrom (std::numeric_limits<uint32_t>::max (), flags, from);
+      if (p == 0)
+        {
+          break;
+        }
+      packets.push_back (p);
+      fromAddresses.push_back (from);
+    }
+  return packets.size ();
+}
+
+uint32_t
+Socket::RecvBatch (std::vector<Ptr<Packet> > &packets, uint32_t maxPackets)
+{
+  NS_LOG_FUNCTION (this << maxPackets);
+  std::vector<Address> fromAddresses;
+  return RecvBatchFrom (packets, fromAddresses, maxPackets, 0);
+}
+
 
 void 
 Socket::NotifyConnectionSucceeded (void)
@@ -30,6 +30,7 @@
 #include "ns3/net-device.h"
 #include "address.h"
 #include <stdint.h>
+#include <vector>
 #include "ns3/inet-socket-address.h"
 #include "ns3/inet6-socket-address.h"
 
@@ -473,6 +474,58 @@ public:
   virtual Ptr<Packet> RecvFrom (uint32_t maxSize, uint32_t flags,
                                 Address &fromAddress) = 0;
 
+  /**
+   * \brief Send a train of packets to the remote host.
+   *
+   * This function matches the semantics of the sendmmsg() function of
+   * Linux: the packets are sent in order, as by as many calls to
+   * Send (), and the sending stops at the first packet which cannot be
+   * sent.  Subclasses may override it to process the train at once,
+   * e.g., to check the socket state only once.  The
+   * default implementation calls Send () for each packet.
+   *
+   * \param packets the packets to send
+   * \param flags Socket control flags
+   * \returns the number of packets accepted for transmission, or -1
+   *          if the first packet cannot be sent; GetErrno () returns the
+   *          error which stopped the sending
+   */
+  virtual int SendBatch (const std::vector<Ptr<Packet> > &packets, uint32_t flags);
+
+  /**
+   * \brief Send a train of packets to a specified peer.
+   *
+   * This method has the semantics of SendBatch (), with the packets sent
+   * as by SendTo ().
+   *
+   * \param packets the packets to send
+   * \param flags Socket control flags
+   * \param toAddress IP Address of remote host
+   * \returns the number of packets accepted for transmission, or -1
+   *          if the first packet cannot be sent
+   */
+  virtual int SendBatchTo (const std::vector<Ptr<Packet> > &packets, uint32_t flags,
+                           const Address &toAddress);
+
+  /**
+   * \brief Read several packets from the socket.
+   *
+   * This function matches the semantics of the recvmmsg() function of
+   * Linux, without waiting: it returns the packets which RecvFrom ()
+   * would return one by one, up to maxPackets.  The default
+   * implementation calls RecvFrom () for each packet.
+   *
+   * \param packets output parameter receiving the packets, in order
+   * \param fromAddresses output parameter receiving the address of the
+   *        sender of each packet
+   * \param maxPackets maximum number of packets to read
+   * \param flags Socket control flags
+   * \returns the number of packets read
+   */
+  virtual uint32_t RecvBatchFrom (std::vector<Ptr<Packet> > &packets,
+                                  std::vector<Address> &fromAddresses,
+                                  uint32_t maxPackets, uint32_t flags);
+
   /////////////////////////////////////////////////////////////////////
   //   The remainder of these public methods are overloaded methods  //
   //   or variants of Send() and Recv(), and they are non-virtual    //
@@ -586,6 +639,18 @@ public:
    */
   int RecvFrom (uint8_t* buf, uint32_t size, uint32_t flags,
                 Address &fromAddress);
+
+  /**
+   * \brief Read several packets from the socket.
+   *
+   * Overloaded version of RecvBatchFrom () which drops the addresses
+   * of the senders.
+   *
+   * \param packets output parameter receiving the packets, in order
+   * \param maxPackets maximum number of packets to read
+   * \returns the number of packets read
+   */
+  uint32_t RecvBatch (std::vector<Ptr<Packet> > &packets, uint32_t maxPackets);
   /**
    * \brief Get socket address.
    * \param address the address name this socket is associated with.
@@ -0,0 +1,158 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/binary-trace-file.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("binary-trace-file-test-suite");
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Check that records written to a binary trace file are read back
+ * unchanged, with and without captured packet bytes.
+ */
+class BinaryTraceFileRoundTripTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   * \param snapLen snap length of the file under test
+   */
+  BinaryTraceFileRoundTripTestCase (uint32_t snapLen);
+  virtual ~BinaryTraceFileRoundTripTestCase ();
+
+private:
+  virtual void DoSetup (void);
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  uint32_t m_snapLen;         //!< Snap length
+  std::string m_testFilename; //!< File name
+};
+
+BinaryTraceFileRoundTripTestCase::BinaryTraceFileRoundTripTestCase (uint32_t snapLen)
+  : TestCase ("Check that BinaryTraceFile records survive a write and read round trip"),
+    m_snapLen (snapLen)
+{
+}
+
+BinaryTraceFileRoundTripTestCase::~BinaryTraceFileRoundTripTestCase ()
+{
+}
+
+void
+BinaryTraceFileRoundTripTestCase::DoSetup (void)
+{
+  std::stringstream filename;
+  uint32_t n = rand ();
+  filename << n;
+  m_testFilename = CreateTempDirFilename (filename.str () + ".btr");
+}
+
+void
+BinaryTraceFileRoundTripTestCase::DoTeardown (void)
+{
+  if (remove (m_testFilename.c_str ()))
+    {
+      NS_LOG_ERROR ("Failed to delete file " << m_testFilename);
+    }
+}
+
+void
+BinaryTraceFileRoundTripTestCase::DoRun (void)
+{
+  uint8_t payload[64];
+  for (uint32_t i = 0; i < sizeof (payload); ++i)
+    {
+      payload[i] = i;
+    }
+  Ptr<Packet> big = Create<Packet> (payload, sizeof (payload));
+  Ptr<Packet> small = Create<Packet> (payload, 4);
+
+  BinaryTraceFile out;
+  out.Open (m_testFilename, std::ios::out);
+  NS_TEST_ASSERT_MSG_EQ (out.Fail (), false, "Open (" << m_testFilename << ", \"std::ios::out\") returns error");
+  out.Init (m_snapLen);
+  out.Write (MicroSeconds (1234), 3, 1, BinaryTraceFile::ENQUEUE, big);
+  out.Write (Seconds (2), 7, 0, BinaryTraceFile::RECEIVE, small);
+  NS_TEST_ASSERT_MSG_EQ (out.Fail (), false, "Write must not fail");
+  out.Close ();
+
+  BinaryTraceFile in;
+  in.Open (m_testFilename, std::ios::in);
+  NS_TEST_ASSERT_MSG_EQ (in.Fail (), false, "Open (" << m_testFilename << ", \"std::ios::in\") returns error");
+  NS_TEST_EXPECT_MSG_EQ (in.GetSnapLen (), m_snapLen, "Snap length not preserved");
+
+  BinaryTraceFile::Record record;
+  uint8_t data[64];
+  uint32_t readLen;
+
+  in.Read (record, data, sizeof (data), readLen);
+  NS_TEST_ASSERT_MSG_EQ (in.Fail (), false, "First record must be readable");
+  NS_TEST_EXPECT_MSG_EQ (record.m_timeNs, 1234000, "Wrong time");
+  NS_TEST_EXPECT_MSG_EQ (record.m_nodeId, 3, "Wrong node id");
+  NS_TEST_EXPECT_MSG_EQ (record.m_deviceId, 1, "Wrong device id");
+  NS_TEST_EXPECT_MSG_EQ (static_cast<uint32_t> (record.m_event), BinaryTraceFile::ENQUEUE, "Wrong event");
+  NS_TEST_EXPECT_MSG_EQ (record.m_uid, big->GetUid (), "Wrong uid");
+  NS_TEST_EXPECT_MSG_EQ (record.m_size, sizeof (payload), "Wrong size");
+  NS_TEST_EXPECT_MSG_EQ (readLen, std::min<uint32_t> (m_snapLen, sizeof (payload)), "Wrong captured length");
+  for (uint32_t i = 0; i < readLen; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (static_cast<uint32_t> (data[i]), i, "Wrong captured byte " << i);
+    }
+
+  in.Read (record, data, sizeof (data), readLen);
+  NS_TEST_ASSERT_MSG_EQ (in.Fail (), false, "Second record must be readable");
+  NS_TEST_EXPECT_MSG_EQ (record.m_timeNs, 2000000000, "Wrong time");
+  NS_TEST_EXPECT_MSG_EQ (record.m_nodeId, 7, "Wrong node id");
+  NS_TEST_EXPECT_MSG_EQ (static_cast<uint32_t> (record.m_event), BinaryTraceFile::RECEIVE, "Wrong event");
+  NS_TEST_EXPECT_MSG_EQ (record.m_size, 4, "Wrong size");
+  NS_TEST_EXPECT_MSG_EQ (readLen, std::min<uint32_t> (m_snapLen, 4), "Wrong captured length");
+
+  in.Read (record, data, sizeof (data), readLen);
+  NS_TEST_EXPECT_MSG_EQ (in.Eof (), true, "Only two records were written");
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Binary trace file TestSuite
+ */
+class BinaryTraceFileTestSuite : public TestSuite
+{
+public:
+  BinaryTraceFileTestSuite ();
+};
+
+BinaryTraceFileTestSuite::BinaryTraceFileTestSuite ()
+  : TestSuite ("binary-trace-file", UNIT)
+{
+  AddTestCase (new BinaryTraceFileRoundTripTestCase (0), TestCase::QUICK);
+  AddTestCase (new BinaryTraceFileRoundTripTestCase (16), TestCase::QUICK);
+}
+
+static BinaryTraceFileTestSuite binaryTraceFileTestSuite; //!< Static variable for test initialization
@@ -378,6 +378,90 @@ BufferTest::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (val1, val2, "Bad ReadNtohU16()");
 }
 
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Check Buffer::Iterator::CalculateIpChecksum against a plain 16-bit word
+ * sum, for every alignment around the virtual zero area.
+ */
+class BufferChecksumTest : public TestCase {
+private:
+  /**
+   * Reference checksum, computed one word at a time.
+   * \param i iterator at the start of the region
+   * \param size the region size
+   * \param initial the initial checksum
+   * \returns the checksum
+   */
+  uint16_t ReferenceChecksum (Buffer::Iterator i, uint16_t size, uint32_t initial);
+public:
+  virtual void DoRun (void);
+  BufferChecksumTest ();
+};
+
+BufferChecksumTest::BufferChecksumTest ()
+  : TestCase ("Buffer checksum")
+{
+}
+
+uint16_t
+BufferChecksumTest::ReferenceChecksum (Buffer::Iterator i, uint16_t size, uint32_t initial)
+{
+  uint32_t sum = initial;
+  for (int j = 0; j < size / 2; j++)
+    {
+      sum += i.ReadU16 ();
+    }
+  if (size & 1)
+    {
+      sum += i.ReadU8 ();
+    }
+  while (sum >> 16)
+    {
+      sum = (sum & 0xffff) + (sum >> 16);
+    }
+  return ~sum;
+}
+
+void
+BufferChecksumTest::DoRun (void)
+{
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
+  uint32_t layouts[][3] = { { 0, 0, 37 }, { 13, 0, 0 }, { 7, 10, 9 }, { 8, 11, 24 }, { 0, 5, 3 } };
+  for (uint32_t l = 0; l < sizeof (layouts) / sizeof (layouts[0]); l++)
+    {
+      uint32_t zero = layouts[l][1];
+      Buffer buffer (zero);
+      buffer.AddAtStart (layouts[l][0]);
+      buffer.AddAtEnd (layouts[l][2]);
+      Buffer::Iterator w = buffer.Begin ();
+      for (uint32_t j = 0; j < layouts[l][0]; j++)
+        {
+          w.WriteU8 (rand->GetInteger (0, 255));
+        }
+      w.Next (zero);
+      for (uint32_t j = 0; j < layouts[l][2]; j++)
+        {
+          w.WriteU8 (rand->GetInteger (0, 255));
+        }
+
+      uint32_t total = buffer.GetSize ();
+      for (uint32_t start = 0; start <= total; start++)
+        {
+          for (uint32_t size = 0; start + size <= total; size++)
+            {
+              Buffer::Iterator i = buffer.Begin ();
+              i.Next (start);
+              uint16_t expected = ReferenceChecksum (i, size, 0x1234);
+              uint16_t got = i.CalculateIpChecksum (size, 0x1234);
+              NS_TEST_ASSERT_MSG_EQ (got, expected, "Bad checksum for layout " << l << " start " << start << " size " << size);
+              NS_TEST_ASSERT_MSG_EQ (i.GetDistanceFrom (buffer.Begin ()), start + size, "Checksum must consume the region");
+            }
+        }
+    }
+}
+
 /**
  * \ingroup network-test
  * \ingroup tests
@@ -394,6 +478,7 @@ BufferTestSuite::BufferTestSuite ()
   : TestSuite ("buffer", UNIT)
 {
   AddTestCase (new BufferTest, TestCase::QUICK);
+  AddTestCase (new BufferChecksumTest, TestCase::QUICK);
 }
 
 static BufferTestSuite g_bufferTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,110 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstring>
+
+#include "ns3/test.h"
+#include "ns3/crc32.h"
+#include "ns3/random-variable-stream.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Check CRC32Calculate against the check value of the standard
+ * and against a bitwise implementation, for all lengths and alignments.
+ */
+class Crc32TestCase : public TestCase
+{
+public:
+  Crc32TestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Bitwise CRC-32, used as reference.
+   * \param data the input
+   * \param length the input length
+   * \returns the CRC-32
+   */
+  static uint32_t Reference (const uint8_t *data, int length);
+};
+
+Crc32TestCase::Crc32TestCase ()
+  : TestCase ("Check CRC32Calculate against a bitwise reference")
+{
+}
+
+uint32_t
+Crc32TestCase::Reference (const uint8_t *data, int length)
+{
+  uint32_t crc = 0xffffffff;
+  for (int i = 0; i < length; i++)
+    {
+      crc ^= data[i];
+      for (int bit = 0; bit < 8; bit++)
+        {
+          crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+  return ~crc;
+}
+
+void
+Crc32TestCase::DoRun (void)
+{
+  const char *check = "123456789";
+  NS_TEST_ASSERT_MSG_EQ (CRC32Calculate ((const uint8_t *)check, strlen (check)), 0xCBF43926, "Bad CRC-32 check value");
+  NS_TEST_ASSERT_MSG_EQ (CRC32Calculate ((const uint8_t *)check, 0), 0, "Bad CRC-32 of empty input");
+
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
+  uint8_t data[1600];
+  for (uint32_t i = 0; i < sizeof (data); i++)
+    {
+      data[i] = rand->GetInteger (0, 255);
+    }
+  for (int offset = 0; offset < 8; offset++)
+    {
+      for (int length = 0; length < 100; length++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (CRC32Calculate (data + offset, length), Reference (data + offset, length),
+                                 "Bad CRC-32 for offset " << offset << " length " << length);
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (CRC32Calculate (data, sizeof (data)), Reference (data, sizeof (data)), "Bad CRC-32 of a full frame");
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief CRC-32 TestSuite
+ */
+class Crc32TestSuite : public TestSuite
+{
+public:
+  Crc32TestSuite ();
+};
+
+Crc32TestSuite::Crc32TestSuite ()
+  : TestSuite ("crc32", UNIT)
+{
+  AddTestCase (new Crc32TestCase, TestCase::QUICK);
+}
+
+static Crc32TestSuite g_crc32TestSuite; //!< Static variable for test initialization
@@ -25,6 +25,9 @@
  *         James P.G. Sterbenz <jpgs@ittc.ku.edu>, director 
  */
 
+#include <cstdio>
+#include <fstream>
+
 #include "ns3/test.h"
 #include "ns3/simple-net-device.h"
 #include "ns3/simple-channel.h"
@@ -37,6 +40,7 @@
 #include "ns3/error-model.h"
 #include "ns3/pointer.h"
 #include "ns3/double.h"
+#include "ns3/boolean.h"
 #include "ns3/string.h"
 #include "ns3/rng-seed-manager.h"
 
@@ -262,6 +266,133 @@ BurstErrorModelSimple::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (m_drops, 260 , "Wrong number of drops.");
 }
 
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Check that the GeometricSkip mode of RateErrorModel and BurstErrorModel
+ * loses packets at the configured rate.
+ */
+class GeometricSkipErrorModelTest : public TestCase
+{
+public:
+  GeometricSkipErrorModelTest ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Count the packets corrupted by an error model.
+   * \param em The error model.
+   * \param packets The number of packets to submit.
+   * \param size The packet size.
+   * \return The number of corrupted packets.
+   */
+  uint32_t CountLosses (Ptr<ErrorModel> em, uint32_t packets, uint32_t size);
+};
+
+GeometricSkipErrorModelTest::GeometricSkipErrorModelTest ()
+  : TestCase ("Loss rate of error models drawing geometric gaps")
+{
+}
+
+uint32_t
+GeometricSkipErrorModelTest::CountLosses (Ptr<ErrorModel> em, uint32_t packets, uint32_t size)
+{
+  Ptr<Packet> p = Create<Packet> (size);
+  uint32_t losses = 0;
+  for (uint32_t i = 0; i < packets; i++)
+    {
+      if (em->IsCorrupt (p))
+        {
+          losses++;
+        }
+    }
+  return losses;
+}
+
+void
+GeometricSkipErrorModelTest::DoRun (void)
+{
+  RngSeedManager::SetSeed (1);
+  RngSeedManager::SetRun (3);
+
+  Ptr<RateErrorModel> em = CreateObject<RateErrorModel> ();
+  em->SetAttribute ("GeometricSkip", BooleanValue (true));
+  em->SetUnit (RateErrorModel::ERROR_UNIT_PACKET);
+  em->SetRate (0.05);
+  em->AssignStreams (10);
+  // 100000 packets at 5%: the standard deviation is about 69 losses
+  NS_TEST_EXPECT_MSG_EQ_TOL (CountLosses (em, 100000, 100), 5000, 350, "Wrong packet loss count");
+
+  // 1e-4 byte error rate on 500 byte packets: 1 - (1 - 1e-4)^500 ~= 4.877%
+  em->SetUnit (RateErrorModel::ERROR_UNIT_BYTE);
+  em->SetRate (1e-4);
+  NS_TEST_EXPECT_MSG_EQ_TOL (CountLosses (em, 100000, 500), 4877, 350, "Wrong byte unit loss count");
+
+  em->SetRate (0);
+  NS_TEST_EXPECT_MSG_EQ (CountLosses (em, 1000, 500), 0, "No loss expected at rate 0");
+  em->SetRate (1);
+  NS_TEST_EXPECT_MSG_EQ (CountLosses (em, 1000, 500), 1000, "All packets lost at rate 1");
+
+  // Bursts start with probability 1% and last 1 to 4 packets; overlapping
+  // bursts make the expected loss rate slightly lower than 2.5%
+  Ptr<BurstErrorModel> burst = CreateObject<BurstErrorModel> ();
+  burst->SetAttribute ("GeometricSkip", BooleanValue (true));
+  burst->SetBurstRate (0.01);
+  burst->AssignStreams (20);
+  NS_TEST_EXPECT_MSG_EQ_TOL (CountLosses (burst, 100000, 100), 2470, 250, "Wrong burst loss count");
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Check that TraceErrorModel replays the loss pattern of its file.
+ */
+class TraceErrorModelTest : public TestCase
+{
+public:
+  TraceErrorModelTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TraceErrorModelTest::TraceErrorModelTest ()
+  : TestCase ("TraceErrorModel replays a loss pattern file")
+{
+}
+
+void
+TraceErrorModelTest::DoRun (void)
+{
+  std::string fileName = CreateTempDirFilename ("loss-pattern.txt");
+  std::ofstream file (fileName.c_str ());
+  file << "# loss pattern\n0010 1\n1 # two lost\n";
+  file.close ();
+
+  Ptr<TraceErrorModel> em = CreateObject<TraceErrorModel> ();
+  em->SetAttribute ("FileName", StringValue (fileName));
+  NS_TEST_ASSERT_MSG_EQ (em->GetPatternSize (), 6, "Wrong pattern size");
+
+  Ptr<Packet> p = Create<Packet> (100);
+  bool expected[] = { false, false, true, false, true, true, false, false };
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (em->IsCorrupt (p), expected[i], "Wrong decision for packet " << i);
+    }
+
+  em->Reset ();
+  em->SetAttribute ("Loop", BooleanValue (false));
+  for (uint32_t i = 0; i < 6; i++)
+    {
+      em->IsCorrupt (p);
+    }
+  NS_TEST_EXPECT_MSG_EQ (em->IsCorrupt (p), false, "No loss expected past the end of the pattern");
+
+  remove (fileName.c_str ());
+}
+
 /**
  * \ingroup network-test
  * \ingroup tests
@@ -283,6 +414,8 @@ ErrorModelTestSuite::ErrorModelTestSuite ()
 {
   AddTestCase (new ErrorModelSimple, TestCase::QUICK);
   AddTestCase (new BurstErrorModelSimple, TestCase::QUICK);
+  AddTestCase (new GeometricSkipErrorModelTest, TestCase::QUICK);
+  AddTestCase (new TraceErrorModelTest, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
@@ -0,0 +1,205 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "ns3/packet.h"
+#include "ns3/fatal-impl.h"
+#include "binary-trace-file.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("BinaryTraceFile");
+
+const uint32_t MAGIC = 0x6e733362;            /**< Magic number identifying a binary trace file ("ns3b") */
+const uint16_t VERSION_MAJOR = 1;             /**< Major version of supported binary trace format */
+const uint16_t VERSION_MINOR = 0;             /**< Minor version of supported binary trace format */
+
+BinaryTraceFile::BinaryTraceFile ()
+  : m_file ()
+{
+  NS_LOG_FUNCTION (this);
+  //
+  // Records are read and written as a single block, so the fixed record
+  // must not contain any padding.
+  //
+  NS_ASSERT (sizeof (Record) == 32);
+  m_fileHeader.m_magicNumber = MAGIC;
+  m_fileHeader.m_versionMajor = VERSION_MAJOR;
+  m_fileHeader.m_versionMinor = VERSION_MINOR;
+  m_fileHeader.m_snapLen = SNAPLEN_DEFAULT;
+  FatalImpl::RegisterStream (&m_file);
+}
+
+BinaryTraceFile::~BinaryTraceFile ()
+{
+  NS_LOG_FUNCTION (this);
+  FatalImpl::UnregisterStream (&m_file);
+  Close ();
+}
+
+bool
+BinaryTraceFile::Fail (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_file.fail ();
+}
+
+bool
+BinaryTraceFile::Eof (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_file.eof ();
+}
+
+void
+BinaryTraceFile::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_file.close ();
+}
+
+uint32_t
+BinaryTraceFile::GetSnapLen (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_fileHeader.m_snapLen;
+}
+
+char
+BinaryTraceFile::GetEventChar (uint8_t event)
+{
+  NS_LOG_FUNCTION (static_cast<uint32_t> (event));
+  switch (event)
+    {
+    case ENQUEUE:
+      return '+';
+    case DEQUEUE:
+      return '-';
+    case DROP:
+      return 'd';
+    case RECEIVE:
+      return 'r';
+    default:
+      return '?';
+    }
+}
+
+void
+BinaryTraceFile::Open (std::string const &filename, std::ios::openmode mode)
+{
+  NS_LOG_FUNCTION (this << filename << mode);
+  NS_ASSERT ((mode & std::ios::app) == 0);
+  NS_ASSERT (!m_file.fail ());
+
+  mode |= std::ios::binary;
+
+  m_filename = filename;
+  m_file.open (filename.c_str (), mode);
+  if ((mode & std::ios::in) == 0)
+    {
+      return;
+    }
+
+  //
+  // Read and verify the file header.  We only deal with files written with
+  // the byte order of this host.
+  //
+  m_file.read ((char *)&m_fileHeader.m_magicNumber, sizeof(m_fileHeader.m_magicNumber));
+  m_file.read ((char *)&m_fileHeader.m_versionMajor, sizeof(m_fileHeader.m_versionMajor));
+  m_file.read ((char *)&m_fileHeader.m_versionMinor, sizeof(m_fileHeader.m_versionMinor));
+  m_file.read ((char *)&m_fileHeader.m_snapLen, sizeof(m_fileHeader.m_snapLen));
+
+  if (m_fileHeader.m_magicNumber != MAGIC
+      || m_fileHeader.m_versionMajor != VERSION_MAJOR
+      || m_fileHeader.m_versionMinor != VERSION_MINOR)
+    {
+      m_file.setstate (std::ios::failbit);
+    }
+
+  if (m_file.fail ())
+    {
+      m_file.close ();
+    }
+}
+
+void
+BinaryTraceFile::Init (uint32_t snapLen)
+{
+  NS_LOG_FUNCTION (this << snapLen);
+
+  //
+  // The captured length is stored in 16 bits in every record.
+  //
+  m_fileHeader.m_snapLen = std::min<uint32_t> (snapLen, 0xffff);
+  m_scratch.resize (m_fileHeader.m_snapLen);
+
+  m_file.seekp (0, std::ios::beg);
+  m_file.write ((const char *)&m_fileHeader.m_magicNumber, sizeof(m_fileHeader.m_magicNumber));
+  m_file.write ((const char *)&m_fileHeader.m_versionMajor, sizeof(m_fileHeader.m_versionMajor));
+  m_file.write ((const char *)&m_fileHeader.m_versionMinor, sizeof(m_fileHeader.m_versionMinor));
+  m_file.write ((const char *)&m_fileHeader.m_snapLen, sizeof(m_fileHeader.m_snapLen));
+}
+
+void
+BinaryTraceFile::Write (Time t, uint32_t nodeId, uint32_t deviceId, EventType event, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (this << t << nodeId << deviceId << event << p);
+
+  Record record;
+  record.m_timeNs = t.GetNanoSeconds ();
+  record.m_uid = p->GetUid ();
+  record.m_nodeId = nodeId;
+  record.m_deviceId = deviceId;
+  record.m_size = p->GetSize ();
+  record.m_event = event;
+  record.m_reserved = 0;
+  record.m_capLen = static_cast<uint16_t> (std::min (m_fileHeader.m_snapLen, record.m_size));
+
+  m_file.write ((const char *)&record, sizeof (record));
+  if (record.m_capLen)
+    {
+      p->CopyData (&m_scratch[0], record.m_capLen);
+      m_file.write ((const char *)&m_scratch[0], record.m_capLen);
+    }
+}
+
+void
+BinaryTraceFile::Read (Record &record, uint8_t * const data, uint32_t maxBytes, uint32_t &readLen)
+{
+  NS_LOG_FUNCTION (this << &record << &data << maxBytes << readLen);
+
+  readLen = 0;
+  m_file.read ((char *)&record, sizeof (record));
+  if (m_file.fail ())
+    {
+      return;
+    }
+
+  //
+  // Copy as much of the captured bytes as fits in the caller's buffer and
+  // skip the rest so that the next read starts on a record boundary.
+  //
+  readLen = std::min<uint32_t> (record.m_capLen, maxBytes);
+  m_file.read ((char *)data, readLen);
+  if (record.m_capLen > readLen)
+    {
+      m_file.seekg (record.m_capLen - readLen, std::ios::cur);
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,170 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef BINARY_TRACE_FILE_H
+#define BINARY_TRACE_FILE_H
+
+#include <string>
+#include <fstream>
+#include <vector>
+#include <stdint.h>
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/simple-ref-count.h"
+
+namespace ns3 {
+
+class Packet;
+
+/**
+ * \brief A compact binary alternative to the ascii device traces
+ *
+ * The ascii traces written by AsciiTraceHelper print every packet with
+ * Packet::Print, which is expensive to produce and to parse back.  A binary
+ * trace file instead stores one fixed-size record per event, holding the
+ * event time, the node and device ids, the event type, the packet uid and
+ * the packet size.  Optionally, the first snapLen bytes of the serialized
+ * packet (typically its headers) follow each record.
+ *
+ * The file starts with a file header holding a magic number, a version and
+ * the snap length.  All fields are written in the native byte order of the
+ * writing host; a file written on a host of different endianness is
+ * rejected when opened for reading.
+ *
+ * This class uses a basic ns-3 reference counting base class so that it
+ * can be bound to trace sinks, like OutputStreamWrapper.
+ */
+class BinaryTraceFile : public SimpleRefCount<BinaryTraceFile>
+{
+public:
+  static const uint32_t SNAPLEN_DEFAULT = 0;   /**< By default, only the fixed record is stored */
+
+  /**
+   * Type of the event which produced a record.  The values match the
+   * characters used by the ascii traces when converted back to text.
+   */
+  enum EventType
+  {
+    ENQUEUE = 0,  /**< Packet enqueued in the transmit queue ('+') */
+    DEQUEUE,      /**< Packet dequeued from the transmit queue ('-') */
+    DROP,         /**< Packet dropped ('d') */
+    RECEIVE       /**< Packet received ('r') */
+  };
+
+  /**
+   * Fixed part of every record, as stored in the file.
+   */
+  struct Record
+  {
+    int64_t m_timeNs;   //!< Simulation time of the event, in nanoseconds
+    uint64_t m_uid;     //!< Packet uid
+    uint32_t m_nodeId;  //!< Node id
+    uint32_t m_deviceId; //!< Device index on the node
+    uint32_t m_size;    //!< Packet size in bytes
+    uint8_t m_event;    //!< EventType
+    uint8_t m_reserved; //!< Reserved, always zero
+    uint16_t m_capLen;  //!< Number of captured packet bytes following the record
+  };
+
+  BinaryTraceFile ();
+  ~BinaryTraceFile ();
+
+  /**
+   * \return true if the 'fail' bit is set in the underlying iostream, false otherwise.
+   */
+  bool Fail (void) const;
+  /**
+   * \return true if the 'eof' bit is set in the underlying iostream, false otherwise.
+   */
+  bool Eof (void) const;
+
+  /**
+   * Create a new binary trace file or open an existing one.  The file is
+   * always opened in binary mode.  When opened for reading, the file header
+   * is read and validated, and the read position is left on the first record.
+   *
+   * \param filename String containing the name of the file.
+   * \param mode the access mode for the file.
+   */
+  void Open (std::string const &filename, std::ios::openmode mode);
+
+  /**
+   * Close the underlying file.
+   */
+  void Close (void);
+
+  /**
+   * Write the file header.  The file must have been previously opened with
+   * write permissions.
+   *
+   * \param snapLen Maximum number of packet bytes stored after each record.
+   * Zero (the default) only stores the fixed record.
+   */
+  void Init (uint32_t snapLen = SNAPLEN_DEFAULT);
+
+  /**
+   * \brief Write a record for a packet event
+   *
+   * \param t       Event time
+   * \param nodeId  Node id
+   * \param deviceId Device index on the node
+   * \param event   Event type
+   * \param p       Packet
+   */
+  void Write (Time t, uint32_t nodeId, uint32_t deviceId, EventType event, Ptr<const Packet> p);
+
+  /**
+   * \brief Read the next record from the file
+   *
+   * \param record      [out] Fixed part of the record
+   * \param data        [out] Buffer receiving the captured packet bytes
+   * \param maxBytes    Allocated data buffer size
+   * \param readLen     [out] Number of packet bytes copied into data
+   */
+  void Read (Record &record, uint8_t * const data, uint32_t maxBytes, uint32_t &readLen);
+
+  /**
+   * \returns the snap length of the file
+   */
+  uint32_t GetSnapLen (void) const;
+
+  /**
+   * \param event an event type
+   * \returns the character used for this event in the ascii traces
+   */
+  static char GetEventChar (uint8_t event);
+
+private:
+  /**
+   * \brief Binary trace file header
+   */
+  struct FileHeader
+  {
+    uint32_t m_magicNumber;   //!< Magic number identifying this as a binary trace file
+    uint16_t m_versionMajor;  //!< Major version identifying the version of the format
+    uint16_t m_versionMinor;  //!< Minor version identifying the version of the format
+    uint32_t m_snapLen;       //!< Maximum number of packet bytes stored per record
+  };
+
+  std::string m_filename;         //!< file name
+  std::fstream m_file;            //!< file stream
+  FileHeader m_fileHeader;        //!< file header
+  std::vector<uint8_t> m_scratch; //!< buffer reused to copy captured packet bytes
+};
+
+} // namespace ns3
+
+#endif /* BINARY_TRACE_FILE_H */
@@ -32,7 +32,7 @@ namespace ns3 {
 /**
  * Table of CRC-32 values.
  */
-static uint32_t crc32table[256] = {
+static const uint32_t crc32table[256] = {
 0x00000000,0x77073096,0xEE0E612C,0x990951BA,0x076DC419,0x706AF48F,0xE963A535,0x9E6495A3,
 0x0EDB8832,0x79DCB8A4,0xE0D5E91E,0x97D2D988,0x09B64C2B,0x7EB17CBD,0xE7B82D07,0x90BF1D91,
 0x1DB71064,0x6AB020F2,0xF3B97148,0x84BE41DE,0x1ADAD47D,0x6DDDE4EB,0xF4D4B551,0x83D385C7,
@@ -67,12 +67,61 @@ static uint32_t crc32table[256] = {
 0xB3667A2E,0xC4614AB8,0x5D681B02,0x2A6F2B94,0xB40BBE37,0xC30C8EA1,0x5A05DF1B,0x2D02EF8D 
 };
 
+/**
+ * Tables for the slice-by-8 CRC-32 algorithm.  Table 0 is crc32table; table
+ * k gives the CRC of a byte followed by k zero bytes, so that eight input
+ * bytes can be folded into the CRC with eight independent lookups.
+ */
+struct Crc32SliceTables
+{
+  Crc32SliceTables ()
+  {
+    for (uint32_t i = 0; i < 256; i++)
+      {
+        table[0][i] = crc32table[i];
+      }
+    for (uint32_t k = 1; k < 8; k++)
+      {
+        for (uint32_t i = 0; i < 256; i++)
+          {
+            uint32_t prev = table[k - 1][i];
+            table[k][i] = (prev >> 8) ^ crc32table[prev & 0xFF];
+          }
+      }
+  }
+  uint32_t table[8][256]; //!< slice-by-8 tables
+};
+
+/**
+ * \returns the slice-by-8 tables, built on first use.
+ */
+static const Crc32SliceTables &
+GetCrc32SliceTables (void)
+{
+  static const Crc32SliceTables tables;
+  return tables;
+}
+
 uint32_t
 CRC32Calculate (const uint8_t *data, int length)
 {
+  const uint32_t (*t)[256] = GetCrc32SliceTables ().table;
   uint32_t crc = 0xffffffff;
 
-  while (length--)
+  //
+  // The words are assembled byte by byte so that the result does not depend
+  // on the host byte order; compilers turn this into plain loads.
+  //
+  while (length >= 8)
+    {
+      uint32_t one = crc ^ (data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24));
+      uint32_t two = data[4] | (data[5] << 8) | (data[6] << 16) | ((uint32_t)data[7] << 24);
+      crc = t[7][one & 0xFF] ^ t[6][(one >> 8) & 0xFF] ^ t[5][(one >> 16) & 0xFF] ^ t[4][one >> 24]
+        ^ t[3][two & 0xFF] ^ t[2][(two >> 8) & 0xFF] ^ t[1][(two >> 16) & 0xFF] ^ t[0][two >> 24];
+      data += 8;
+      length -= 8;
+    }
+  while (length-- > 0)
     {
       crc = (crc >> 8) ^ crc32table[(crc & 0xFF) ^ *data++];
     }
@@ -80,4 +129,3 @@ CRC32Calculate (const uint8_t *data, int length)
 }
 
 } // namespace ns3
-
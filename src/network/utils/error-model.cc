@@ -61,6 +61,8 @@
  */
 
 #include <cmath>
+#include <fstream>
+#include <limits>
 
 #include "error-model.h"
 
@@ -77,6 +79,34 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("ErrorModel");
 
+/**
+ * Draw the number of failures before the first success of a sequence of
+ * Bernoulli trials, by inversion of the geometric distribution.
+ *
+ * \param ranvar a Uniform(0,1) random variable
+ * \param p the success probability of each trial
+ * \returns the number of failures, or the largest uint64_t if p is zero
+ */
+static uint64_t
+DrawGeometricGap (Ptr<RandomVariableStream> ranvar, double p)
+{
+  if (p <= 0)
+    {
+      return std::numeric_limits<uint64_t>::max ();
+    }
+  if (p >= 1)
+    {
+      return 0;
+    }
+  // 1 - u lies in (0,1], so that the logarithm is always defined
+  double gap = std::floor (std::log (1.0 - ranvar->GetValue ()) / std::log1p (-p));
+  if (gap >= static_cast<double> (std::numeric_limits<uint64_t>::max ()))
+    {
+      return std::numeric_limits<uint64_t>::max ();
+    }
+  return static_cast<uint64_t> (gap);
+}
+
 NS_OBJECT_ENSURE_REGISTERED (ErrorModel);
 
 TypeId ErrorModel::GetTypeId (void)
@@ -168,12 +198,22 @@ TypeId RateErrorModel::GetTypeId (void)
                    StringValue ("ns3::UniformRandomVariable[Min=0.0|Max=1.0]"),
                    MakePointerAccessor (&RateErrorModel::m_ranvar),
                    MakePointerChecker<RandomVariableStream> ())
+    .AddAttribute ("GeometricSkip",
+                   "If true, draw the number of error-free units until the next "
+                   "error at once instead of drawing RanVar for every packet. "
+                   "RanVar must then be Uniform(0,1).",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RateErrorModel::m_geometricSkip),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
 
 
 RateErrorModel::RateErrorModel ()
+  : m_geometricSkip (false),
+    m_gapValid (false),
+    m_gap (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -195,6 +235,7 @@ RateErrorModel::SetUnit (enum ErrorUnit error_unit)
 { 
   NS_LOG_FUNCTION (this << error_unit);
   m_unit = error_unit; 
+  m_gapValid = false;
 }
 
 double
@@ -209,6 +250,7 @@ RateErrorModel::SetRate (double rate)
 { 
   NS_LOG_FUNCTION (this << rate);
   m_rate = rate;
+  m_gapValid = false;
 }
 
 void 
@@ -234,6 +276,34 @@ RateErrorModel::DoCorrupt (Ptr<Packet> p)
     {
       return false;
     }
+  if (m_geometricSkip)
+    {
+      // The units in a packet are errored independently, so the packet is
+      // corrupt if the next error falls within it.  The geometric
+      // distribution being memoryless, the following gap is drawn afresh
+      // from the end of the corrupted packet.
+      uint64_t units = 1;
+      if (m_unit == ERROR_UNIT_BYTE)
+        {
+          units = p->GetSize ();
+        }
+      else if (m_unit == ERROR_UNIT_BIT)
+        {
+          units = 8 * static_cast<uint64_t> (p->GetSize ());
+        }
+      if (!m_gapValid)
+        {
+          m_gap = DrawGeometricGap (m_ranvar, m_rate);
+          m_gapValid = true;
+        }
+      if (m_gap >= units)
+        {
+          m_gap -= units;
+          return false;
+        }
+      m_gapValid = false;
+      return true;
+    }
   switch (m_unit) 
     {
     case ERROR_UNIT_PACKET:
@@ -278,7 +348,7 @@ void
 RateErrorModel::DoReset (void) 
 { 
   NS_LOG_FUNCTION (this);
-  /* re-initialize any state; no-op for now */ 
+  m_gapValid = false;
 }
 
 
@@ -306,12 +376,24 @@ TypeId BurstErrorModel::GetTypeId (void)
                    StringValue ("ns3::UniformRandomVariable[Min=1|Max=4]"),
                    MakePointerAccessor (&BurstErrorModel::m_burstSize),
                    MakePointerChecker<RandomVariableStream> ())
+    .AddAttribute ("GeometricSkip",
+                   "If true, draw the number of packets until the next error "
+                   "event at once instead of drawing BurstStart for every packet. "
+                   "BurstStart must then be Uniform(0,1).",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&BurstErrorModel::m_geometricSkip),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
 
 
-BurstErrorModel::BurstErrorModel () : m_counter (0), m_currentBurstSz (0)
+BurstErrorModel::BurstErrorModel ()
+  : m_counter (0),
+    m_currentBurstSz (0),
+    m_geometricSkip (false),
+    m_gapValid (false),
+    m_gap (0)
 {
 
 }
@@ -333,6 +415,7 @@ BurstErrorModel::SetBurstRate (double rate)
 {
   NS_LOG_FUNCTION (this << rate);
   m_burstRate = rate;
+  m_gapValid = false;
 }
 
 void
@@ -366,9 +449,30 @@ BurstErrorModel::DoCorrupt (Ptr<Packet> p)
     {
       return false;
     }
-  double ranVar = m_burstStart ->GetValue();
+  bool burstStart;
+  if (m_geometricSkip)
+    {
+      if (!m_gapValid)
+        {
+          m_gap = DrawGeometricGap (m_burstStart, m_burstRate);
+          m_gapValid = true;
+        }
+      burstStart = (m_gap == 0);
+      if (burstStart)
+        {
+          m_gapValid = false;
+        }
+      else
+        {
+          m_gap--;
+        }
+    }
+  else
+    {
+      burstStart = (m_burstStart->GetValue () < m_burstRate);
+    }
 
-  if (ranVar < m_burstRate)
+  if (burstStart)
     {
       // get a new burst size for the new error event
       m_currentBurstSz = m_burstSize->GetInteger();     
@@ -407,6 +511,7 @@ BurstErrorModel::DoReset (void)
   NS_LOG_FUNCTION (this);
   m_counter = 0;
   m_currentBurstSz = 0;
+  m_gapValid = false;
 
 }
 
@@ -593,6 +698,117 @@ BinaryErrorModel::DoReset (void)
   m_counter = 0;
 }
 
+//
+// TraceErrorModel
+//
+
+NS_OBJECT_ENSURE_REGISTERED (TraceErrorModel);
+
+TypeId TraceErrorModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TraceErrorModel")
+    .SetParent<ErrorModel> ()
+    .SetGroupName("Network")
+    .AddConstructor<TraceErrorModel> ()
+    .AddAttribute ("FileName",
+                   "The file holding the loss pattern, one '0' or '1' per packet.",
+                   StringValue (""),
+                   MakeStringAccessor (&TraceErrorModel::SetFileName,
+                                       &TraceErrorModel::GetFileName),
+                   MakeStringChecker ())
+    .AddAttribute ("Loop",
+                   "Whether the loss pattern is replayed from its start once exhausted.",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&TraceErrorModel::m_loop),
+                   MakeBooleanChecker ())
+  ;
+  return tid;
+}
+
+TraceErrorModel::TraceErrorModel ()
+  : m_next (0),
+    m_loop (true)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TraceErrorModel::~TraceErrorModel ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+TraceErrorModel::SetFileName (std::string fileName)
+{
+  NS_LOG_FUNCTION (this << fileName);
+  m_fileName = fileName;
+  m_pattern.clear ();
+  m_next = 0;
+  if (fileName.empty ())
+    {
+      return;
+    }
+
+  std::ifstream file (fileName.c_str ());
+  if (!file.is_open ())
+    {
+      NS_FATAL_ERROR ("TraceErrorModel: cannot open loss pattern file " << fileName);
+    }
+  std::string line;
+  while (std::getline (file, line))
+    {
+      for (std::string::const_iterator c = line.begin (); c != line.end () && *c != '#'; ++c)
+        {
+          if (*c == '0' || *c == '1')
+            {
+              m_pattern.push_back (*c == '1');
+            }
+        }
+    }
+  NS_LOG_DEBUG ("Loaded " << m_pattern.size () << " packets from " << fileName);
+}
+
+std::string
+TraceErrorModel::GetFileName (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_fileName;
+}
+
+uint64_t
+TraceErrorModel::GetPatternSize (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_pattern.size ();
+}
+
+bool
+TraceErrorModel::DoCorrupt (Ptr<Packet> p)
+{
+  NS_LOG_FUNCTION (this << p);
+  if (!IsEnabled () || m_pattern.empty ())
+    {
+      return false;
+    }
+  if (m_next == m_pattern.size ())
+    {
+      if (!m_loop)
+        {
+          return false;
+        }
+      m_next = 0;
+    }
+  return m_pattern[m_next++];
+}
+
+void
+TraceErrorModel::DoReset (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_next = 0;
+}
+
+
 
 
 
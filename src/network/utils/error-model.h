@@ -64,6 +64,8 @@
 #define ERROR_MODEL_H
 
 #include <list>
+#include <string>
+#include <vector>
 #include "ns3/object.h"
 #include "ns3/random-variable-stream.h"
 
@@ -174,8 +176,16 @@ private:
  * unit (which may be per-bit, per-byte, and per-packet).
  * Users can optionally provide a RandomVariableStream object; the default
  * is to use a Uniform(0,1) distribution.
-
- * Reset() on this model will do nothing
+ *
+ * By default one random variate is drawn for every packet.  When the
+ * GeometricSkip attribute is set, the model instead draws the number of
+ * error-free units until the next error from the geometric distribution
+ * and counts packets down against it, so that only one variate is drawn
+ * per error.  The loss process has the same distribution, but the
+ * decision variable must then be Uniform(0,1), and the sequence of lost
+ * packets differs from the default mode for a given seed.
+
+ * Reset() on this model will discard the pending error-free gap, if any
  *
  * IsCorrupt() will not modify the packet data buffer
  */
@@ -260,6 +270,10 @@ private:
   double m_rate; //!< Error rate
 
   Ptr<RandomVariableStream> m_ranvar; //!< rng stream
+
+  bool m_geometricSkip;   //!< True if the gap to the next error is drawn at once
+  bool m_gapValid;        //!< True if m_gap holds a drawn gap
+  uint64_t m_gap;         //!< Number of error-free units before the next error
 };
 
 
@@ -293,6 +307,11 @@ private:
  * total number of packets that has been dropped does not exceed the 
  * burst size.
  *
+ * When the GeometricSkip attribute is set, the model does not draw the
+ * decision variable for every packet; it draws the number of packets until
+ * the next error event from the geometric distribution instead, as
+ * RateErrorModel does.
+ *
  * IsCorrupt() will not modify the packet data buffer
  */
 class BurstErrorModel : public ErrorModel
@@ -351,6 +370,9 @@ private:
   uint32_t m_counter;
   uint32_t m_currentBurstSz;                  //!< the current burst size
 
+  bool m_geometricSkip;   //!< True if the gap to the next error event is drawn at once
+  bool m_gapValid;        //!< True if m_gap holds a drawn gap
+  uint64_t m_gap;         //!< Number of packets before the next error event
 };
 
 
@@ -482,5 +504,60 @@ private:
 
 };
 
+/**
+ * \brief Corrupt packets following a loss pattern read from a file
+ *
+ * The file holds one character per packet received by the model: '1'
+ * corrupts the packet and '0' lets it through.  Any other character is
+ * ignored, and '#' starts a comment running to the end of the line, so
+ * that traces captured from a real link can be annotated and wrapped.
+ *
+ * The pattern is loaded once, packed one bit per packet, when the FileName
+ * attribute is set, so the per-packet cost is a single bit lookup.  When
+ * the end of the pattern is reached, it is replayed from the start if the
+ * Loop attribute is set; otherwise no further packet is corrupted.
+ *
+ * Reset() on this model will restart the pattern from its first packet
+ *
+ * IsCorrupt() will not modify the packet data buffer
+ */
+class TraceErrorModel : public ErrorModel
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  TraceErrorModel ();
+  virtual ~TraceErrorModel ();
+
+  /**
+   * Load the loss pattern from a file.  Aborts the simulation if the file
+   * cannot be read.
+   *
+   * \param fileName the name of the file holding the loss pattern
+   */
+  void SetFileName (std::string fileName);
+  /**
+   * \return the name of the file the loss pattern was loaded from
+   */
+  std::string GetFileName (void) const;
+  /**
+   * \return the number of packets in the loss pattern
+   */
+  uint64_t GetPatternSize (void) const;
+
+private:
+  virtual bool DoCorrupt (Ptr<Packet> p);
+  virtual void DoReset (void);
+
+  std::string m_fileName;       //!< name of the loss pattern file
+  std::vector<bool> m_pattern;  //!< loss pattern, one entry per packet
+  uint64_t m_next;              //!< index of the entry for the next packet
+  bool m_loop;                  //!< True if the pattern is replayed at its end
+};
+
+
 } // namespace ns3
 #endif
@@ -0,0 +1,138 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "tso-tag.h"
+#include "ns3/error-model.h"
+#include "ns3/packet.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TsoTag");
+
+NS_OBJECT_ENSURE_REGISTERED (TsoTag);
+
+TypeId
+TsoTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TsoTag")
+    .SetParent<Tag> ()
+    .SetGroupName ("Network")
+    .AddConstructor<TsoTag> ()
+  ;
+  return tid;
+}
+TypeId
+TsoTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+uint32_t
+TsoTag::GetSerializedSize (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return 8;
+}
+void
+TsoTag::Serialize (TagBuffer buf) const
+{
+  NS_LOG_FUNCTION (this << &buf);
+  buf.WriteU32 (m_segments);
+  buf.WriteU32 (m_payloadSize);
+}
+void
+TsoTag::Deserialize (TagBuffer buf)
+{
+  NS_LOG_FUNCTION (this << &buf);
+  m_segments = buf.ReadU32 ();
+  m_payloadSize = buf.ReadU32 ();
+}
+void
+TsoTag::Print (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this << &os);
+  os << "Segments=" << m_segments << " PayloadSize=" << m_payloadSize;
+}
+TsoTag::TsoTag ()
+  : Tag (),
+    m_segments (1),
+    m_payloadSize (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TsoTag::TsoTag (uint32_t segments, uint32_t payloadSize)
+  : Tag (),
+    m_segments (segments),
+    m_payloadSize (payloadSize)
+{
+  NS_LOG_FUNCTION (this << segments << payloadSize);
+}
+
+void
+TsoTag::SetSegments (uint32_t segments)
+{
+  NS_LOG_FUNCTION (this << segments);
+  m_segments = segments;
+}
+uint32_t
+TsoTag::GetSegments (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_segments;
+}
+
+void
+TsoTag::SetPayloadSize (uint32_t payloadSize)
+{
+  NS_LOG_FUNCTION (this << payloadSize);
+  m_payloadSize = payloadSize;
+}
+uint32_t
+TsoTag::GetPayloadSize (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_payloadSize;
+}
+
+uint32_t
+TsoTag::GetWireSize (uint32_t packetSize) const
+{
+  NS_LOG_FUNCTION (this << packetSize);
+  NS_ASSERT (m_segments >= 1 && packetSize >= m_payloadSize);
+  return packetSize + (m_segments - 1) * (packetSize - m_payloadSize);
+}
+
+bool
+TsoTag::IsCorrupt (Ptr<ErrorModel> em, Ptr<Packet> packet)
+{
+  NS_LOG_FUNCTION (em << packet);
+  uint32_t frames = 1;
+  Ptr<RateErrorModel> rateModel = DynamicCast<RateErrorModel> (em);
+  TsoTag tso;
+  if (rateModel != 0 && rateModel->GetUnit () == RateErrorModel::ERROR_UNIT_PACKET
+      && packet->PeekPacketTag (tso))
+    {
+      frames = tso.GetSegments ();
+    }
+  bool corrupt = false;
+  for (uint32_t i = 0; i < frames && !corrupt; ++i)
+    {
+      corrupt = em->IsCorrupt (packet);
+    }
+  return corrupt;
+}
+
+} // namespace ns3
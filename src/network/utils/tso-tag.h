@@ -0,0 +1,115 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef TSO_TAG_H
+#define TSO_TAG_H
+
+#include "ns3/tag.h"
+#include "ns3/ptr.h"
+
+namespace ns3 {
+
+class ErrorModel;
+class Packet;
+
+/**
+ * \ingroup packet
+ *
+ * \brief Packet tag of a super-segment, which stands for several
+ * segments of the same flow sent back to back (segmentation offload).
+ *
+ * The transport protocol which builds the super-segment adds this tag,
+ * the network layer does not fragment it, and it travels the links as a
+ * single packet.  The devices which know the tag model it as the train of
+ * frames it stands for: each segment repeats the headers of the
+ * super-segment, which adds to its transmission time, and the receive error
+ * model accounts for all of them (see IsCorrupt).  The receiving transport protocol
+ * processes the whole super-segment at once, like receive offload would.
+ */
+class TsoTag : public Tag
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (TagBuffer buf) const;
+  virtual void Deserialize (TagBuffer buf);
+  virtual void Print (std::ostream &os) const;
+  TsoTag ();
+
+  /**
+   * \brief Constructs a TsoTag
+   * \param segments number of segments in the super-segment
+   * \param payloadSize payload bytes of the super-segment, headers excluded
+   */
+  TsoTag (uint32_t segments, uint32_t payloadSize);
+  /**
+   * \brief Set the number of segments in the super-segment
+   * \param segments the number of segments
+   */
+  void SetSegments (uint32_t segments);
+  /**
+   * \brief Get the number of segments in the super-segment
+   * \returns the number of segments
+   */
+  uint32_t GetSegments (void) const;
+  /**
+   * \brief Set the payload size of the super-segment
+   * \param payloadSize payload bytes, headers excluded
+   */
+  void SetPayloadSize (uint32_t payloadSize);
+  /**
+   * \brief Get the payload size of the super-segment
+   * \returns payload bytes, headers excluded
+   */
+  uint32_t GetPayloadSize (void) const;
+  /**
+   * \brief Get the number of bytes of the frames the super-segment stands for
+   *
+   * All the bytes of the packet beyond the payload, for instance the
+   * transport, network and link headers, are repeated in every segment.
+   *
+   * \param packetSize size of the super-segment, with its headers
+   * \returns the size of all the segments, with their headers
+   */
+  uint32_t GetWireSize (uint32_t packetSize) const;
+
+  /**
+   * \brief Check a received packet, possibly a super-segment, against an
+   * error model
+   *
+   * A super-segment is lost as soon as one of the frames it stands for is
+   * corrupted.  A RateErrorModel in packets draws once per frame.  The
+   * other models draw once on the whole packet: a RateErrorModel in bytes
+   * or bits already accounts for all its bytes, and the models which count
+   * the packets, such as ReceiveListErrorModel, see a single packet.
+   *
+   * \param em the error model
+   * \param packet the received packet
+   * \returns true if the packet is corrupted
+   */
+  static bool IsCorrupt (Ptr<ErrorModel> em, Ptr<Packet> packet);
+private:
+  uint32_t m_segments;    //!< Number of segments
+  uint32_t m_payloadSize; //!< Payload bytes
+};
+
+} // namespace ns3
+
+#endif /* TSO_TAG_H */
@@ -216,6 +216,60 @@ PointToPointHelper::EnableAsciiInternal (
   Config::Connect (oss.str (), MakeBoundCallback (&AsciiTraceHelper::DefaultDropSinkWithContext, stream));
 }
 
+void 
+PointToPointHelper::EnableBinaryTraceInternal (
+  Ptr<BinaryTraceFile> file, 
+  std::string prefix, 
+  Ptr<NetDevice> nd,
+  bool explicitFilename)
+{
+  //
+  // We can only deal with devices of type PointToPointNetDevice.
+  //
+  Ptr<PointToPointNetDevice> device = nd->GetObject<PointToPointNetDevice> ();
+  if (device == 0)
+    {
+      NS_LOG_INFO ("PointToPointHelper::EnableBinaryTraceInternal(): Device " << device << 
+                   " not of type ns3::PointToPointNetDevice");
+      return;
+    }
+
+  BinaryTraceHelper binaryTraceHelper;
+
+  //
+  // If we are not provided a BinaryTraceFile, we are expected to create one
+  // using the usual trace filename conventions.  Unlike the ascii traces,
+  // the records carry the node and device ids, so the same sinks are used
+  // whether or not the file is shared between devices.
+  //
+  if (file == 0)
+    {
+      std::string filename;
+      if (explicitFilename)
+        {
+          filename = prefix;
+        }
+      else
+        {
+          filename = binaryTraceHelper.GetFilenameFromDevice (prefix, device);
+        }
+      file = binaryTraceHelper.CreateFile (filename);
+    }
+
+  uint32_t nodeid = nd->GetNode ()->GetId ();
+  uint32_t deviceid = nd->GetIfIndex ();
+
+  binaryTraceHelper.HookDefaultSink<PointToPointNetDevice> (device, "MacRx", file, BinaryTraceFile::RECEIVE, nodeid, deviceid);
+
+  Ptr<Queue<Packet> > queue = device->GetQueue ();
+  binaryTraceHelper.HookDefaultSink<Queue<Packet> > (queue, "Enqueue", file, BinaryTraceFile::ENQUEUE, nodeid, deviceid);
+  binaryTraceHelper.HookDefaultSink<Queue<Packet> > (queue, "Drop", file, BinaryTraceFile::DROP, nodeid, deviceid);
+  binaryTraceHelper.HookDefaultSink<Queue<Packet> > (queue, "Dequeue", file, BinaryTraceFile::DEQUEUE, nodeid, deviceid);
+
+  // PhyRxDrop trace source for "d" event
+  binaryTraceHelper.HookDefaultSink<PointToPointNetDevice> (device, "PhyRxDrop", file, BinaryTraceFile::DROP, nodeid, deviceid);
+}
+
 NetDeviceContainer 
 PointToPointHelper::Install (NodeContainer c)
 {
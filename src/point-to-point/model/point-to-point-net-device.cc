@@ -22,6 +22,7 @@
 #include "ns3/mac48-address.h"
 #include "ns3/llc-snap-header.h"
 #include "ns3/error-model.h"
+#include "ns3/tso-tag.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/uinteger.h"
 #include "ns3/pointer.h"
@@ -284,7 +285,16 @@ PointToPointNetDevice::TransmitStart (Ptr<Packet> p)
   m_currentPkt = p;
   m_phyTxBeginTrace (m_currentPkt);
 
-  Time txTime = m_bps.CalculateBytesTxTime (p->GetSize ());
+  //
+  // A super-segment takes as long as the frames it stands for.
+  //
+  uint32_t wireSize = p->GetSize ();
+  TsoTag tso;
+  if (p->PeekPacketTag (tso))
+    {
+      wireSize = tso.GetWireSize (wireSize);
+    }
+  Time txTime = m_bps.CalculateBytesTxTime (wireSize);
   Time txCompleteTime = txTime + m_tInterframeGap;
 
   NS_LOG_LOGIC ("Schedule TransmitCompleteEvent in " << txCompleteTime.GetSeconds () << "sec");
@@ -370,7 +380,13 @@ PointToPointNetDevice::Receive (Ptr<Packet> packet)
   NS_LOG_FUNCTION (this << packet);
   uint16_t protocol = 0;
 
-  if (m_receiveErrorModel && m_receiveErrorModel->IsCorrupt (packet) ) 
+  bool corrupt = false;
+  if (m_receiveErrorModel)
+    {
+      corrupt = TsoTag::IsCorrupt (m_receiveErrorModel, packet);
+    }
+
+  if (corrupt)
     {
       // 
       // If we have an error model and it indicates that it is time to lose a
@@ -24,6 +24,8 @@
 #include "ns3/point-to-point-net-device.h"
 #include "ns3/point-to-point-channel.h"
 #include "ns3/net-device-queue-interface.h"
+#include "ns3/tso-tag.h"
+#include "ns3/error-model.h"
 
 using namespace ns3;
 
@@ -101,6 +103,126 @@ PointToPointTest::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \brief Test class for the transmission of super-segments
+ *
+ * It sends a packet and a super-segment of the same size over a
+ * PointToPointChannel, and checks that the super-segment takes as long
+ * as the frames it stands for.  It then checks that an error model which
+ * counts the received packets counts a super-segment once.
+ */
+class PointToPointTsoTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointTsoTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Send a packet of 1000 bytes to the device specified
+   *
+   * \param device NetDevice to send to
+   * \param segments number of segments of the packet, 1 for a plain packet
+   */
+  void SendPacket (Ptr<PointToPointNetDevice> device, uint32_t segments);
+
+  /**
+   * \brief Record the arrival of a packet
+   *
+   * \param device the receiving device
+   * \param packet the packet
+   * \param protocol the protocol number
+   * \param from the sender address
+   * \return true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  std::vector<Time> m_arrivals; //!< Arrival times
+};
+
+PointToPointTsoTest::PointToPointTsoTest ()
+  : TestCase ("PointToPoint super-segments")
+{
+}
+
+void
+PointToPointTsoTest::SendPacket (Ptr<PointToPointNetDevice> device, uint32_t segments)
+{
+  Ptr<Packet> p = Create<Packet> (1000);
+  if (segments > 1)
+    {
+      p->AddPacketTag (TsoTag (segments, 960));
+    }
+  device->Send (p, device->GetBroadcast (), 0x800);
+}
+
+bool
+PointToPointTsoTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from)
+{
+  m_arrivals.push_back (Simulator::Now ());
+  return true;
+}
+
+void
+PointToPointTsoTest::DoRun (void)
+{
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+
+  devA->Attach (channel);
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+  devA->SetDataRate (DataRate ("8Mbps"));
+  devB->Attach (channel);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+
+  a->AddDevice (devA);
+  b->AddDevice (devB);
+  devB->SetReceiveCallback (MakeCallback (&PointToPointTsoTest::Receive, this));
+
+  Ptr<NetDeviceQueueInterface> ifaceA = CreateObject<NetDeviceQueueInterface> ();
+  devA->AggregateObject (ifaceA);
+  ifaceA->CreateTxQueues ();
+  Ptr<NetDeviceQueueInterface> ifaceB = CreateObject<NetDeviceQueueInterface> ();
+  devB->AggregateObject (ifaceB);
+  ifaceB->CreateTxQueues ();
+
+  Simulator::Schedule (Seconds (1.0), &PointToPointTsoTest::SendPacket, this, devA, 1);
+  Simulator::Schedule (Seconds (2.0), &PointToPointTsoTest::SendPacket, this, devA, 4);
+
+  // The second packet received from now on is dropped: the packet sent
+  // after the super-segment
+  Ptr<ReceiveListErrorModel> errors = CreateObject<ReceiveListErrorModel> ();
+  std::list<uint32_t> dropped;
+  dropped.push_back (1);
+  errors->SetList (dropped);
+  Simulator::Schedule (Seconds (2.5), &PointToPointNetDevice::SetReceiveErrorModel, devB, errors);
+  Simulator::Schedule (Seconds (3.0), &PointToPointTsoTest::SendPacket, this, devA, 4);
+  Simulator::Schedule (Seconds (4.0), &PointToPointTsoTest::SendPacket, this, devA, 1);
+
+  Simulator::Run ();
+
+  // 1 byte per microsecond; the PPP header adds 2 bytes to the packet, and
+  // each of the 3 more segments repeats its 42 bytes of headers
+  NS_TEST_ASSERT_MSG_EQ (m_arrivals.size (), 3, "Unexpected number of packets received");
+  NS_TEST_EXPECT_MSG_EQ (m_arrivals[0], Seconds (1.0) + MicroSeconds (1002), "Unexpected arrival of the packet");
+  NS_TEST_EXPECT_MSG_EQ (m_arrivals[1], Seconds (2.0) + MicroSeconds (1002 + 3 * 42), "Unexpected arrival of the super-segment");
+  NS_TEST_EXPECT_MSG_EQ (m_arrivals[2], Seconds (3.0) + MicroSeconds (1002 + 3 * 42), "The super-segment was counted as several packets");
+
+  Simulator::Destroy ();
+}
+
 /**
  * \brief TestSuite for PointToPoint module
  */
@@ -117,6 +239,7 @@ PointToPointTestSuite::PointToPointTestSuite ()
   : TestSuite ("devices-point-to-point", UNIT)
 {
   AddTestCase (new PointToPointTest, TestCase::QUICK);
+  AddTestCase (new PointToPointTsoTest, TestCase::QUICK);
 }
 
 static PointToPointTestSuite g_pointToPointTestSuite; //!< The testsuite
@@ -22,6 +22,7 @@
 #include "ns3/test.h"
 #include "ns3/simulator.h"
 #include "ns3/fq-codel-queue-disc.h"
+#include "ns3/codel-queue-disc.h"
 #include "ns3/ipv4-header.h"
 #include "ns3/ipv4-packet-filter.h"
 #include "ns3/ipv4-queue-disc-item.h"
@@ -120,12 +121,12 @@ FqCoDelQueueDiscNoSuitableFilter::DoRun (void)
   Address dest;
   item = Create<Ipv6QueueDiscItem> (p, dest, 0, ipv6Header);
   queueDisc->Enqueue (item);
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetNQueueDiscClasses (), 0, "no flow queue should have been created");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetNFlowQueues (), 0, "no flow queue should have been created");
 
   p = Create<Packet> (reinterpret_cast<const uint8_t*> ("hello, world"), 12);
   item = Create<Ipv6QueueDiscItem> (p, dest, 0, ipv6Header);
   queueDisc->Enqueue (item);
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetNQueueDiscClasses (), 0, "no flow queue should have been created");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetNFlowQueues (), 0, "no flow queue should have been created");
 
   Simulator::Destroy ();
 }
@@ -181,20 +182,20 @@ FqCoDelQueueDiscIPFlowsSeparationAndPacketLimit::DoRun (void)
   AddPacket (queueDisc, hdr);
   AddPacket (queueDisc, hdr);
   NS_TEST_ASSERT_MSG_EQ (queueDisc->QueueDisc::GetNPackets (), 3, "unexpected number of packets in the queue disc");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 3, "unexpected number of packets in the flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (0), 3, "unexpected number of packets in the flow queue");
 
   // Add two packets from the second flow
   hdr.SetDestination (Ipv4Address ("10.10.1.7"));
   // Add the first packet
   AddPacket (queueDisc, hdr);
   NS_TEST_ASSERT_MSG_EQ (queueDisc->QueueDisc::GetNPackets (), 4, "unexpected number of packets in the queue disc");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 3, "unexpected number of packets in the flow queue");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (1)->GetQueueDisc ()->GetNPackets (), 1, "unexpected number of packets in the flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (0), 3, "unexpected number of packets in the flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (1), 1, "unexpected number of packets in the flow queue");
   // Add the second packet that causes two packets to be dropped from the fat flow (max backlog = 300, threshold = 150)
   AddPacket (queueDisc, hdr);
   NS_TEST_ASSERT_MSG_EQ (queueDisc->QueueDisc::GetNPackets (), 3, "unexpected number of packets in the queue disc");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 1, "unexpected number of packets in the flow queue");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (1)->GetQueueDisc ()->GetNPackets (), 2, "unexpected number of packets in the flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (0), 1, "unexpected number of packets in the flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (1), 2, "unexpected number of packets in the flow queue");
 
   Simulator::Destroy ();
 }
@@ -248,82 +249,80 @@ FqCoDelQueueDiscDeficit::DoRun (void)
   // Add a packet from the first flow
   AddPacket (queueDisc, hdr);
   NS_TEST_ASSERT_MSG_EQ (queueDisc->QueueDisc::GetNPackets (), 1, "unexpected number of packets in the queue disc");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 1, "unexpected number of packets in the first flow queue");
-  Ptr<FqCoDelFlow> flow1 = StaticCast<FqCoDelFlow> (queueDisc->GetQueueDiscClass (0));
-  NS_TEST_ASSERT_MSG_EQ (flow1->GetDeficit (), static_cast<int32_t> (queueDisc->GetQuantum ()), "the deficit of the first flow must equal the quantum");
-  NS_TEST_ASSERT_MSG_EQ (flow1->GetStatus (), FqCoDelFlow::NEW_FLOW, "the first flow must be in the list of new queues");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (0), 1, "unexpected number of packets in the first flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueDeficit (0), static_cast<int32_t> (queueDisc->GetQuantum ()), "the deficit of the first flow must equal the quantum");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueStatus (0), FqCoDelQueueDisc::NEW_FLOW, "the first flow must be in the list of new queues");
   // Dequeue a packet
   queueDisc->Dequeue ();
   NS_TEST_ASSERT_MSG_EQ (queueDisc->QueueDisc::GetNPackets (), 0, "unexpected number of packets in the queue disc");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 0, "unexpected number of packets in the first flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (0), 0, "unexpected number of packets in the first flow queue");
   // the deficit for the first flow becomes 90 - (100+20) = -30
-  NS_TEST_ASSERT_MSG_EQ (flow1->GetDeficit (), -30, "unexpected deficit for the first flow");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueDeficit (0), -30, "unexpected deficit for the first flow");
 
   // Add two packets from the first flow
   AddPacket (queueDisc, hdr);
   AddPacket (queueDisc, hdr);
   NS_TEST_ASSERT_MSG_EQ (queueDisc->QueueDisc::GetNPackets (), 2, "unexpected number of packets in the queue disc");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 2, "unexpected number of packets in the first flow queue");
-  NS_TEST_ASSERT_MSG_EQ (flow1->GetStatus (), FqCoDelFlow::NEW_FLOW, "the first flow must still be in the list of new queues");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (0), 2, "unexpected number of packets in the first flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueStatus (0), FqCoDelQueueDisc::NEW_FLOW, "the first flow must still be in the list of new queues");
 
   // Add two packets from the second flow
   hdr.SetDestination (Ipv4Address ("10.10.1.10"));
   AddPacket (queueDisc, hdr);
   AddPacket (queueDisc, hdr);
   NS_TEST_ASSERT_MSG_EQ (queueDisc->QueueDisc::GetNPackets (), 4, "unexpected number of packets in the queue disc");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 2, "unexpected number of packets in the first flow queue");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (1)->GetQueueDisc ()->GetNPackets (), 2, "unexpected number of packets in the second flow queue");
-  Ptr<FqCoDelFlow> flow2 = StaticCast<FqCoDelFlow> (queueDisc->GetQueueDiscClass (1));
-  NS_TEST_ASSERT_MSG_EQ (flow2->GetDeficit (), static_cast<int32_t> (queueDisc->GetQuantum ()), "the deficit of the second flow must equal the quantum");
-  NS_TEST_ASSERT_MSG_EQ (flow2->GetStatus (), FqCoDelFlow::NEW_FLOW, "the second flow must be in the list of new queues");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (0), 2, "unexpected number of packets in the first flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (1), 2, "unexpected number of packets in the second flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueDeficit (1), static_cast<int32_t> (queueDisc->GetQuantum ()), "the deficit of the second flow must equal the quantum");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueStatus (1), FqCoDelQueueDisc::NEW_FLOW, "the second flow must be in the list of new queues");
 
   // Dequeue a packet (from the second flow, as the first flow has a negative deficit)
   queueDisc->Dequeue ();
   NS_TEST_ASSERT_MSG_EQ (queueDisc->QueueDisc::GetNPackets (), 3, "unexpected number of packets in the queue disc");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 2, "unexpected number of packets in the first flow queue");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (1)->GetQueueDisc ()->GetNPackets (), 1, "unexpected number of packets in the second flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (0), 2, "unexpected number of packets in the first flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (1), 1, "unexpected number of packets in the second flow queue");
   // the first flow got a quantum of deficit (-30+90=60) and has been moved to the end of the list of old queues
-  NS_TEST_ASSERT_MSG_EQ (flow1->GetDeficit (), 60, "unexpected deficit for the first flow");
-  NS_TEST_ASSERT_MSG_EQ (flow1->GetStatus (), FqCoDelFlow::OLD_FLOW, "the first flow must be in the list of old queues");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueDeficit (0), 60, "unexpected deficit for the first flow");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueStatus (0), FqCoDelQueueDisc::OLD_FLOW, "the first flow must be in the list of old queues");
   // the second flow has a negative deficit (-30) and is still in the list of new queues
-  NS_TEST_ASSERT_MSG_EQ (flow2->GetDeficit (), -30, "unexpected deficit for the second flow");
-  NS_TEST_ASSERT_MSG_EQ (flow2->GetStatus (), FqCoDelFlow::NEW_FLOW, "the second flow must be in the list of new queues");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueDeficit (1), -30, "unexpected deficit for the second flow");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueStatus (1), FqCoDelQueueDisc::NEW_FLOW, "the second flow must be in the list of new queues");
 
   // Dequeue a packet (from the first flow, as the second flow has a negative deficit)
   queueDisc->Dequeue ();
   NS_TEST_ASSERT_MSG_EQ (queueDisc->QueueDisc::GetNPackets (), 2, "unexpected number of packets in the queue disc");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 1, "unexpected number of packets in the first flow queue");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (1)->GetQueueDisc ()->GetNPackets (), 1, "unexpected number of packets in the second flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (0), 1, "unexpected number of packets in the first flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (1), 1, "unexpected number of packets in the second flow queue");
   // the first flow has a negative deficit (60-(100+20)= -60) and stays in the list of old queues
-  NS_TEST_ASSERT_MSG_EQ (flow1->GetDeficit (), -60, "unexpected deficit for the first flow");
-  NS_TEST_ASSERT_MSG_EQ (flow1->GetStatus (), FqCoDelFlow::OLD_FLOW, "the first flow must be in the list of old queues");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueDeficit (0), -60, "unexpected deficit for the first flow");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueStatus (0), FqCoDelQueueDisc::OLD_FLOW, "the first flow must be in the list of old queues");
   // the second flow got a quantum of deficit (-30+90=60) and has been moved to the end of the list of old queues
-  NS_TEST_ASSERT_MSG_EQ (flow2->GetDeficit (), 60, "unexpected deficit for the second flow");
-  NS_TEST_ASSERT_MSG_EQ (flow2->GetStatus (), FqCoDelFlow::OLD_FLOW, "the second flow must be in the list of new queues");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueDeficit (1), 60, "unexpected deficit for the second flow");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueStatus (1), FqCoDelQueueDisc::OLD_FLOW, "the second flow must be in the list of new queues");
 
   // Dequeue a packet (from the second flow, as the first flow has a negative deficit)
   queueDisc->Dequeue ();
   NS_TEST_ASSERT_MSG_EQ (queueDisc->QueueDisc::GetNPackets (), 1, "unexpected number of packets in the queue disc");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 1, "unexpected number of packets in the first flow queue");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (1)->GetQueueDisc ()->GetNPackets (), 0, "unexpected number of packets in the second flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (0), 1, "unexpected number of packets in the first flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (1), 0, "unexpected number of packets in the second flow queue");
   // the first flow got a quantum of deficit (-60+90=30) and has been moved to the end of the list of old queues
-  NS_TEST_ASSERT_MSG_EQ (flow1->GetDeficit (), 30, "unexpected deficit for the first flow");
-  NS_TEST_ASSERT_MSG_EQ (flow1->GetStatus (), FqCoDelFlow::OLD_FLOW, "the first flow must be in the list of old queues");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueDeficit (0), 30, "unexpected deficit for the first flow");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueStatus (0), FqCoDelQueueDisc::OLD_FLOW, "the first flow must be in the list of old queues");
   // the second flow has a negative deficit (60-(100+20)= -60)
-  NS_TEST_ASSERT_MSG_EQ (flow2->GetDeficit (), -60, "unexpected deficit for the second flow");
-  NS_TEST_ASSERT_MSG_EQ (flow2->GetStatus (), FqCoDelFlow::OLD_FLOW, "the second flow must be in the list of new queues");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueDeficit (1), -60, "unexpected deficit for the second flow");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueStatus (1), FqCoDelQueueDisc::OLD_FLOW, "the second flow must be in the list of new queues");
 
   // Dequeue a packet (from the first flow, as the second flow has a negative deficit)
   queueDisc->Dequeue ();
   NS_TEST_ASSERT_MSG_EQ (queueDisc->QueueDisc::GetNPackets (), 0, "unexpected number of packets in the queue disc");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 0, "unexpected number of packets in the first flow queue");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (1)->GetQueueDisc ()->GetNPackets (), 0, "unexpected number of packets in the second flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (0), 0, "unexpected number of packets in the first flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (1), 0, "unexpected number of packets in the second flow queue");
   // the first flow has a negative deficit (30-(100+20)= -90)
-  NS_TEST_ASSERT_MSG_EQ (flow1->GetDeficit (), -90, "unexpected deficit for the first flow");
-  NS_TEST_ASSERT_MSG_EQ (flow1->GetStatus (), FqCoDelFlow::OLD_FLOW, "the first flow must be in the list of old queues");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueDeficit (0), -90, "unexpected deficit for the first flow");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueStatus (0), FqCoDelQueueDisc::OLD_FLOW, "the first flow must be in the list of old queues");
   // the second flow got a quantum of deficit (-60+90=30) and has been moved to the end of the list of old queues
-  NS_TEST_ASSERT_MSG_EQ (flow2->GetDeficit (), 30, "unexpected deficit for the second flow");
-  NS_TEST_ASSERT_MSG_EQ (flow2->GetStatus (), FqCoDelFlow::OLD_FLOW, "the second flow must be in the list of new queues");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueDeficit (1), 30, "unexpected deficit for the second flow");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueStatus (1), FqCoDelQueueDisc::OLD_FLOW, "the second flow must be in the list of new queues");
 
   // Dequeue a packet
   queueDisc->Dequeue ();
@@ -333,10 +332,10 @@ FqCoDelQueueDiscDeficit::DoRun (void)
   // reconsidered, but it has a null deficit, hence it gets another quantum of deficit (0+90=90). Then, the first
   // flow is reconsidered again, now it has a positive deficit and hence it is selected. But, it is empty and
   // therefore is set to inactive, too.
-  NS_TEST_ASSERT_MSG_EQ (flow1->GetDeficit (), 90, "unexpected deficit for the first flow");
-  NS_TEST_ASSERT_MSG_EQ (flow1->GetStatus (), FqCoDelFlow::INACTIVE, "the first flow must be inactive");
-  NS_TEST_ASSERT_MSG_EQ (flow2->GetDeficit (), 30, "unexpected deficit for the second flow");
-  NS_TEST_ASSERT_MSG_EQ (flow2->GetStatus (), FqCoDelFlow::INACTIVE, "the second flow must be inactive");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueDeficit (0), 90, "unexpected deficit for the first flow");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueStatus (0), FqCoDelQueueDisc::INACTIVE, "the first flow must be inactive");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueDeficit (1), 30, "unexpected deficit for the second flow");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueStatus (1), FqCoDelQueueDisc::INACTIVE, "the second flow must be inactive");
 
   Simulator::Destroy ();
 }
@@ -397,32 +396,32 @@ FqCoDelQueueDiscTCPFlowsSeparation::DoRun (void)
   AddPacket (queueDisc, hdr, tcpHdr);
   AddPacket (queueDisc, hdr, tcpHdr);
   NS_TEST_ASSERT_MSG_EQ (queueDisc->QueueDisc::GetNPackets (), 3, "unexpected number of packets in the queue disc");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 3, "unexpected number of packets in the first flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (0), 3, "unexpected number of packets in the first flow queue");
 
   // Add a packet from the second flow
   tcpHdr.SetSourcePort (8);
   AddPacket (queueDisc, hdr, tcpHdr);
   NS_TEST_ASSERT_MSG_EQ (queueDisc->QueueDisc::GetNPackets (), 4, "unexpected number of packets in the queue disc");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 3, "unexpected number of packets in the first flow queue");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (1)->GetQueueDisc ()->GetNPackets (), 1, "unexpected number of packets in the second flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (0), 3, "unexpected number of packets in the first flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (1), 1, "unexpected number of packets in the second flow queue");
 
   // Add a packet from the third flow
   tcpHdr.SetDestinationPort (28);
   AddPacket (queueDisc, hdr, tcpHdr);
   NS_TEST_ASSERT_MSG_EQ (queueDisc->QueueDisc::GetNPackets (), 5, "unexpected number of packets in the queue disc");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 3, "unexpected number of packets in the first flow queue");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (1)->GetQueueDisc ()->GetNPackets (), 1, "unexpected number of packets in the second flow queue");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (2)->GetQueueDisc ()->GetNPackets (), 1, "unexpected number of packets in the third flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (0), 3, "unexpected number of packets in the first flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (1), 1, "unexpected number of packets in the second flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (2), 1, "unexpected number of packets in the third flow queue");
 
   // Add two packets from the fourth flow
   tcpHdr.SetSourcePort (7);
   AddPacket (queueDisc, hdr, tcpHdr);
   AddPacket (queueDisc, hdr, tcpHdr);
   NS_TEST_ASSERT_MSG_EQ (queueDisc->QueueDisc::GetNPackets (), 7, "unexpected number of packets in the queue disc");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 3, "unexpected number of packets in the first flow queue");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (1)->GetQueueDisc ()->GetNPackets (), 1, "unexpected number of packets in the second flow queue");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (2)->GetQueueDisc ()->GetNPackets (), 1, "unexpected number of packets in the third flow queue");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (3)->GetQueueDisc ()->GetNPackets (), 2, "unexpected number of packets in the third flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (0), 3, "unexpected number of packets in the first flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (1), 1, "unexpected number of packets in the second flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (2), 1, "unexpected number of packets in the third flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (3), 2, "unexpected number of packets in the third flow queue");
 
   Simulator::Destroy ();
 }
@@ -483,32 +482,128 @@ FqCoDelQueueDiscUDPFlowsSeparation::DoRun (void)
   AddPacket (queueDisc, hdr, udpHdr);
   AddPacket (queueDisc, hdr, udpHdr);
   NS_TEST_ASSERT_MSG_EQ (queueDisc->QueueDisc::GetNPackets (), 3, "unexpected number of packets in the queue disc");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 3, "unexpected number of packets in the first flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (0), 3, "unexpected number of packets in the first flow queue");
 
   // Add a packet from the second flow
   udpHdr.SetSourcePort (8);
   AddPacket (queueDisc, hdr, udpHdr);
   NS_TEST_ASSERT_MSG_EQ (queueDisc->QueueDisc::GetNPackets (), 4, "unexpected number of packets in the queue disc");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 3, "unexpected number of packets in the first flow queue");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (1)->GetQueueDisc ()->GetNPackets (), 1, "unexpected number of packets in the second flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (0), 3, "unexpected number of packets in the first flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (1), 1, "unexpected number of packets in the second flow queue");
 
   // Add a packet from the third flow
   udpHdr.SetDestinationPort (28);
   AddPacket (queueDisc, hdr, udpHdr);
   NS_TEST_ASSERT_MSG_EQ (queueDisc->QueueDisc::GetNPackets (), 5, "unexpected number of packets in the queue disc");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 3, "unexpected number of packets in the first flow queue");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (1)->GetQueueDisc ()->GetNPackets (), 1, "unexpected number of packets in the second flow queue");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (2)->GetQueueDisc ()->GetNPackets (), 1, "unexpected number of packets in the third flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (0), 3, "unexpected number of packets in the first flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (1), 1, "unexpected number of packets in the second flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (2), 1, "unexpected number of packets in the third flow queue");
 
   // Add two packets from the fourth flow
   udpHdr.SetSourcePort (7);
   AddPacket (queueDisc, hdr, udpHdr);
   AddPacket (queueDisc, hdr, udpHdr);
   NS_TEST_ASSERT_MSG_EQ (queueDisc->QueueDisc::GetNPackets (), 7, "unexpected number of packets in the queue disc");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 3, "unexpected number of packets in the first flow queue");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (1)->GetQueueDisc ()->GetNPackets (), 1, "unexpected number of packets in the second flow queue");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (2)->GetQueueDisc ()->GetNPackets (), 1, "unexpected number of packets in the third flow queue");
-  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (3)->GetQueueDisc ()->GetNPackets (), 2, "unexpected number of packets in the third flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (0), 3, "unexpected number of packets in the first flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (1), 1, "unexpected number of packets in the second flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (2), 1, "unexpected number of packets in the third flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetFlowQueueNPackets (3), 2, "unexpected number of packets in the third flow queue");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * This class checks that a flow queue drops the same packets as a CoDel queue disc
+ */
+class FqCoDelQueueDiscCoDelEquivalence : public TestCase
+{
+public:
+  FqCoDelQueueDiscCoDelEquivalence ();
+  virtual ~FqCoDelQueueDiscCoDelEquivalence ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Enqueue a copy of the same packet in both queue discs
+   */
+  void Enqueue (void);
+  /**
+   * Dequeue a packet from both queue discs and compare them
+   */
+  void Dequeue (void);
+
+  Ptr<FqCoDelQueueDisc> m_fqCoDel;   //!< FqCoDel queue disc
+  Ptr<CoDelQueueDisc> m_coDel;       //!< CoDel queue disc
+  Ipv4Header m_hdr;                  //!< Header of the packets
+  uint32_t m_dequeued;               //!< Number of packets dequeued
+};
+
+FqCoDelQueueDiscCoDelEquivalence::FqCoDelQueueDiscCoDelEquivalence ()
+  : TestCase ("Test that a flow queue runs the CoDel algorithm of CoDelQueueDisc"),
+    m_dequeued (0)
+{
+}
+
+FqCoDelQueueDiscCoDelEquivalence::~FqCoDelQueueDiscCoDelEquivalence ()
+{
+}
+
+void
+FqCoDelQueueDiscCoDelEquivalence::Enqueue (void)
+{
+  Ptr<Packet> p = Create<Packet> (1000);
+  Address dest;
+  m_fqCoDel->Enqueue (Create<Ipv4QueueDiscItem> (p->Copy (), dest, 0, m_hdr));
+  m_coDel->Enqueue (Create<Ipv4QueueDiscItem> (p->Copy (), dest, 0, m_hdr));
+}
+
+void
+FqCoDelQueueDiscCoDelEquivalence::Dequeue (void)
+{
+  Ptr<QueueDiscItem> fqItem = m_fqCoDel->Dequeue ();
+  Ptr<QueueDiscItem> item = m_coDel->Dequeue ();
+  NS_TEST_ASSERT_MSG_EQ ((fqItem == 0), (item == 0), "only one of the queue discs returned a packet");
+  if (item != 0)
+    {
+      NS_TEST_EXPECT_MSG_EQ (fqItem->GetPacket ()->GetUid (), item->GetPacket ()->GetUid (),
+                             "the queue discs returned different packets");
+      m_dequeued++;
+    }
+}
+
+void
+FqCoDelQueueDiscCoDelEquivalence::DoRun (void)
+{
+  m_fqCoDel = CreateObject<FqCoDelQueueDisc> ();
+  m_fqCoDel->SetQuantum (1500);
+  m_fqCoDel->Initialize ();
+  m_coDel = CreateObjectWithAttributes<CoDelQueueDisc> ("MaxSize", StringValue ("10240p"));
+  m_coDel->Initialize ();
+
+  m_hdr.SetPayloadSize (1000);
+  m_hdr.SetSource (Ipv4Address ("10.10.1.1"));
+  m_hdr.SetDestination (Ipv4Address ("10.10.1.2"));
+  m_hdr.SetProtocol (7);
+
+  // packets arrive twice as fast as they leave for two periods of one
+  // second, separated by a pause
+  for (uint32_t i = 0; i < 6000; i++)
+    {
+      if (i < 1000 || (i >= 2000 && i < 3000))
+        {
+          Simulator::Schedule (MicroSeconds (1000 * i), &FqCoDelQueueDiscCoDelEquivalence::Enqueue, this);
+          Simulator::Schedule (MicroSeconds (1000 * i + 300), &FqCoDelQueueDiscCoDelEquivalence::Enqueue, this);
+        }
+      Simulator::Schedule (MicroSeconds (1000 * i + 500), &FqCoDelQueueDiscCoDelEquivalence::Dequeue, this);
+    }
+  Simulator::Run ();
+
+  uint32_t drops = m_coDel->GetStats ().GetNDroppedPackets (CoDelQueueDisc::TARGET_EXCEEDED_DROP);
+  NS_TEST_EXPECT_MSG_GT (drops, 0, "CoDel should have dropped packets");
+  NS_TEST_EXPECT_MSG_EQ (m_fqCoDel->GetStats ().GetNDroppedPackets (FqCoDelQueueDisc::TARGET_EXCEEDED_DROP), drops,
+                         "the flow queue should have dropped as many packets as CoDel");
+  NS_TEST_EXPECT_MSG_EQ (m_dequeued + drops, 4000, "unexpected number of packets dequeued");
+  NS_TEST_EXPECT_MSG_EQ (m_fqCoDel->GetNPackets (), 0, "the queue disc should be empty");
 
   Simulator::Destroy ();
 }
@@ -527,6 +622,7 @@ FqCoDelQueueDiscTestSuite::FqCoDelQueueDiscTestSuite ()
   AddTestCase (new FqCoDelQueueDiscDeficit, TestCase::QUICK);
   AddTestCase (new FqCoDelQueueDiscTCPFlowsSeparation, TestCase::QUICK);
   AddTestCase (new FqCoDelQueueDiscUDPFlowsSeparation, TestCase::QUICK);
+  AddTestCase (new FqCoDelQueueDiscCoDelEquivalence, TestCase::QUICK);
 }
 
 static FqCoDelQueueDiscTestSuite fqCoDelQueueDiscTestSuite;
@@ -21,7 +21,8 @@
 
 #include "ns3/log.h"
 #include "ns3/string.h"
-#include "ns3/queue.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
 #include "fq-codel-queue-disc.h"
 #include "codel-queue-disc.h"
 #include "ns3/net-device-queue-interface.h"
@@ -30,68 +31,65 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("FqCoDelQueueDisc");
 
-NS_OBJECT_ENSURE_REGISTERED (FqCoDelFlow);
-
-TypeId FqCoDelFlow::GetTypeId (void)
-{
-  static TypeId tid = TypeId ("ns3::FqCoDelFlow")
-    .SetParent<QueueDiscClass> ()
-    .SetGroupName ("TrafficControl")
-    .AddConstructor<FqCoDelFlow> ()
-  ;
-  return tid;
-}
-
-FqCoDelFlow::FqCoDelFlow ()
-  : m_deficit (0),
-    m_status (INACTIVE)
-{
-  NS_LOG_FUNCTION (this);
-}
-
-FqCoDelFlow::~FqCoDelFlow ()
+/**
+ * Performs a reciprocal divide, similar to the
+ * Linux kernel reciprocal_divide function
+ * \param A numerator
+ * \param R reciprocal of the denominator B
+ * \return the value of A/B
+ */
+static inline uint32_t ReciprocalDivide (uint32_t A, uint32_t R)
 {
-  NS_LOG_FUNCTION (this);
+  return (uint32_t)(((uint64_t)A * R) >> 32);
 }
 
-void
-FqCoDelFlow::SetDeficit (uint32_t deficit)
+/**
+ * Return the CoDel time representation of a time
+ * \param t the time
+ * \return the time in CoDel time representation
+ */
+static inline uint32_t Time2CoDel (Time t)
 {
-  NS_LOG_FUNCTION (this << deficit);
-  m_deficit = deficit;
-}
-
-int32_t
-FqCoDelFlow::GetDeficit (void) const
-{
-  NS_LOG_FUNCTION (this);
-  return m_deficit;
+  return static_cast<uint32_t>(t.GetNanoSeconds () >> CODEL_SHIFT);
 }
 
-void
-FqCoDelFlow::IncreaseDeficit (int32_t deficit)
+/**
+ * Check if CoDel time a is successive to b
+ * \param a left operand
+ * \param b right operand
+ * \return true if a is greater than b
+ */
+static inline bool CoDelTimeAfter (uint32_t a, uint32_t b)
 {
-  NS_LOG_FUNCTION (this << deficit);
-  m_deficit += deficit;
+  return ((int)(a) - (int)(b) > 0);
 }
 
-void
-FqCoDelFlow::SetStatus (FlowStatus status)
+/**
+ * Check if CoDel time a is successive or equal to b
+ * \param a left operand
+ * \param b right operand
+ * \return true if a is greater than or equal to b
+ */
+static inline bool CoDelTimeAfterEq (uint32_t a, uint32_t b)
 {
-  NS_LOG_FUNCTION (this);
-  m_status = status;
+  return ((int)(a) - (int)(b) >= 0);
 }
 
-FqCoDelFlow::FlowStatus
-FqCoDelFlow::GetStatus (void) const
+/**
+ * Check if CoDel time a is preceding b
+ * \param a left operand
+ * \param b right operand
+ * \return true if a is less than to b
+ */
+static inline bool CoDelTimeBefore (uint32_t a, uint32_t b)
 {
-  NS_LOG_FUNCTION (this);
-  return m_status;
+  return ((int)(a) - (int)(b) < 0);
 }
 
-
 NS_OBJECT_ENSURE_REGISTERED (FqCoDelQueueDisc);
 
+const uint32_t FqCoDelQueueDisc::NONE;
+
 TypeId FqCoDelQueueDisc::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::FqCoDelQueueDisc")
@@ -108,6 +106,11 @@ TypeId FqCoDelQueueDisc::GetTypeId (void)
                    StringValue ("5ms"),
                    MakeStringAccessor (&FqCoDelQueueDisc::m_target),
                    MakeStringChecker ())
+    .AddAttribute ("MinBytes",
+                   "The CoDel algorithm minbytes parameter for each FQCoDel queue",
+                   UintegerValue (1500),
+                   MakeUintegerAccessor (&FqCoDelQueueDisc::m_minBytes),
+                   MakeUintegerChecker<uint32_t> ())
     .AddAttribute ("MaxSize",
                    "The maximum number of packets accepted by this queue disc",
                    QueueSizeValue (QueueSize ("10240p")),
@@ -135,9 +138,14 @@ TypeId FqCoDelQueueDisc::GetTypeId (void)
 
 FqCoDelQueueDisc::FqCoDelQueueDisc ()
   : QueueDisc (QueueDiscSizePolicy::MULTIPLE_QUEUES, QueueSizeUnit::PACKETS),
-    m_quantum (0)
+    m_quantum (0),
+    m_codelInterval (0),
+    m_codelTarget (0),
+    m_freePacketNodes (NONE)
 {
   NS_LOG_FUNCTION (this);
+  m_newFlows.m_head = m_newFlows.m_tail = NONE;
+  m_oldFlows.m_head = m_oldFlows.m_tail = NONE;
 }
 
 FqCoDelQueueDisc::~FqCoDelQueueDisc ()
@@ -145,6 +153,19 @@ FqCoDelQueueDisc::~FqCoDelQueueDisc ()
   NS_LOG_FUNCTION (this);
 }
 
+void
+FqCoDelQueueDisc::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_flowQueues.clear ();
+  m_flowsIndices.clear ();
+  m_packetNodes.clear ();
+  m_freePacketNodes = NONE;
+  m_newFlows.m_head = m_newFlows.m_tail = NONE;
+  m_oldFlows.m_head = m_oldFlows.m_tail = NONE;
+  QueueDisc::DoDispose ();
+}
+
 void
 FqCoDelQueueDisc::SetQuantum (uint32_t quantum)
 {
@@ -158,6 +179,129 @@ FqCoDelQueueDisc::GetQuantum (void) const
   return m_quantum;
 }
 
+std::size_t
+FqCoDelQueueDisc::GetNFlowQueues (void) const
+{
+  return m_flowQueues.size ();
+}
+
+uint32_t
+FqCoDelQueueDisc::GetFlowQueueNPackets (std::size_t i) const
+{
+  NS_ASSERT (i < m_flowQueues.size ());
+  return m_flowQueues[i].m_nPackets;
+}
+
+uint32_t
+FqCoDelQueueDisc::GetFlowQueueNBytes (std::size_t i) const
+{
+  NS_ASSERT (i < m_flowQueues.size ());
+  return m_flowQueues[i].m_nBytes;
+}
+
+int32_t
+FqCoDelQueueDisc::GetFlowQueueDeficit (std::size_t i) const
+{
+  NS_ASSERT (i < m_flowQueues.size ());
+  return m_flowQueues[i].m_deficit;
+}
+
+FqCoDelQueueDisc::FlowStatus
+FqCoDelQueueDisc::GetFlowQueueStatus (std::size_t i) const
+{
+  NS_ASSERT (i < m_flowQueues.size ());
+  return m_flowQueues[i].m_status;
+}
+
+void
+FqCoDelQueueDisc::PushFlow (FlowList &list, uint32_t flow)
+{
+  NS_LOG_FUNCTION (this << flow);
+  m_flowQueues[flow].m_next = NONE;
+  if (list.m_tail == NONE)
+    {
+      list.m_head = flow;
+    }
+  else
+    {
+      m_flowQueues[list.m_tail].m_next = flow;
+    }
+  list.m_tail = flow;
+}
+
+uint32_t
+FqCoDelQueueDisc::PopFlow (FlowList &list)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (list.m_head != NONE);
+  uint32_t flow = list.m_head;
+  list.m_head = m_flowQueues[flow].m_next;
+  if (list.m_head == NONE)
+    {
+      list.m_tail = NONE;
+    }
+  m_flowQueues[flow].m_next = NONE;
+  return flow;
+}
+
+void
+FqCoDelQueueDisc::PushPacket (uint32_t flow, Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << flow << item);
+  uint32_t node = m_freePacketNodes;
+  if (node == NONE)
+    {
+      node = m_packetNodes.size ();
+      m_packetNodes.push_back (PacketNode ());
+    }
+  else
+    {
+      m_freePacketNodes = m_packetNodes[node].m_next;
+    }
+  m_packetNodes[node].m_item = item;
+  m_packetNodes[node].m_next = NONE;
+
+  Flow &f = m_flowQueues[flow];
+  if (f.m_tail == NONE)
+    {
+      f.m_head = node;
+    }
+  else
+    {
+      m_packetNodes[f.m_tail].m_next = node;
+    }
+  f.m_tail = node;
+  f.m_nPackets++;
+  f.m_nBytes += item->GetSize ();
+  PacketEnqueued (item);
+}
+
+Ptr<QueueDiscItem>
+FqCoDelQueueDisc::PopPacket (uint32_t flow)
+{
+  NS_LOG_FUNCTION (this << flow);
+  Flow &f = m_flowQueues[flow];
+  if (f.m_head == NONE)
+    {
+      return 0;
+    }
+  uint32_t node = f.m_head;
+  Ptr<QueueDiscItem> item = m_packetNodes[node].m_item;
+  f.m_head = m_packetNodes[node].m_next;
+  if (f.m_head == NONE)
+    {
+      f.m_tail = NONE;
+    }
+  m_packetNodes[node].m_item = 0;
+  m_packetNodes[node].m_next = m_freePacketNodes;
+  m_freePacketNodes = node;
+
+  f.m_nPackets--;
+  f.m_nBytes -= item->GetSize ();
+  PacketDequeued (item);
+  return item;
+}
+
 bool
 FqCoDelQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
 {
@@ -185,33 +329,50 @@ FqCoDelQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
         }
     }
 
-  Ptr<FqCoDelFlow> flow;
-  if (m_flowsIndices.find (h) == m_flowsIndices.end ())
+  uint32_t flow = m_flowsIndices[h];
+  if (flow == NONE)
     {
       NS_LOG_DEBUG ("Creating a new flow queue with index " << h);
-      flow = m_flowFactory.Create<FqCoDelFlow> ();
-      Ptr<QueueDisc> qd = m_queueDiscFactory.Create<QueueDisc> ();
-      qd->Initialize ();
-      flow->SetQueueDisc (qd);
-      AddQueueDiscClass (flow);
-
-      m_flowsIndices[h] = GetNQueueDiscClasses () - 1;
+      Flow f;
+      f.m_head = f.m_tail = NONE;
+      f.m_nPackets = 0;
+      f.m_nBytes = 0;
+      f.m_deficit = 0;
+      f.m_status = INACTIVE;
+      f.m_next = NONE;
+      f.m_count = 0;
+      f.m_lastCount = 0;
+      f.m_firstAboveTime = 0;
+      f.m_dropNext = 0;
+      f.m_recInvSqrt = ~0U >> REC_INV_SQRT_SHIFT;
+      f.m_dropping = false;
+      flow = m_flowQueues.size ();
+      m_flowQueues.push_back (f);
+      m_flowsIndices[h] = flow;
     }
-  else
+
+  if (m_flowQueues[flow].m_status == INACTIVE)
     {
-      flow = StaticCast<FqCoDelFlow> (GetQueueDiscClass (m_flowsIndices[h]));
+      m_flowQueues[flow].m_status = NEW_FLOW;
+      m_flowQueues[flow].m_deficit = m_quantum;
+      PushFlow (m_newFlows, flow);
     }
 
-  if (flow->GetStatus () == FqCoDelFlow::INACTIVE)
+  // each flow queue accepts as many packets, or bytes, as the whole queue disc
+  QueueSize maxSize = GetMaxSize ();
+  bool flowFull = (maxSize.GetUnit () == QueueSizeUnit::BYTES)
+    ? m_flowQueues[flow].m_nBytes + item->GetSize () > maxSize.GetValue ()
+    : m_flowQueues[flow].m_nPackets + 1 > maxSize.GetValue ();
+  if (flowFull)
     {
-      flow->SetStatus (FqCoDelFlow::NEW_FLOW);
-      flow->SetDeficit (m_quantum);
-      m_newFlows.push_back (flow);
+      NS_LOG_LOGIC ("Flow queue full -- dropping pkt");
+      DropBeforeEnqueue (item, OVERLIMIT_DROP);
+      return false;
     }
 
-  flow->GetQueueDisc ()->Enqueue (item);
+  PushPacket (flow, item);
 
-  NS_LOG_DEBUG ("Packet enqueued into flow " << h << "; flow index " << m_flowsIndices[h]);
+  NS_LOG_DEBUG ("Packet enqueued into flow " << h << "; flow index " << flow);
 
   if (GetCurrentSize () > GetMaxSize ())
     {
@@ -221,28 +382,163 @@ FqCoDelQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
   return true;
 }
 
+bool
+FqCoDelQueueDisc::OkToDrop (uint32_t flow, Ptr<QueueDiscItem> item, uint32_t now)
+{
+  NS_LOG_FUNCTION (this << flow);
+  Flow &f = m_flowQueues[flow];
+
+  if (!item)
+    {
+      f.m_firstAboveTime = 0;
+      return false;
+    }
+
+  uint32_t sojournTime = Time2CoDel (Simulator::Now () - item->GetTimeStamp ());
+
+  if (CoDelTimeBefore (sojournTime, m_codelTarget) || f.m_nBytes < m_minBytes)
+    {
+      // went below so we'll stay below for at least interval
+      f.m_firstAboveTime = 0;
+      return false;
+    }
+  bool okToDrop = false;
+  if (f.m_firstAboveTime == 0)
+    {
+      // just went above from below. If we stay above
+      // for at least interval we'll say it's ok to drop
+      f.m_firstAboveTime = now + m_codelInterval;
+    }
+  else if (CoDelTimeAfter (now, f.m_firstAboveTime))
+    {
+      okToDrop = true;
+    }
+  return okToDrop;
+}
+
+void
+FqCoDelQueueDisc::NewtonStep (uint32_t flow)
+{
+  NS_LOG_FUNCTION (this << flow);
+  Flow &f = m_flowQueues[flow];
+  uint32_t invsqrt = ((uint32_t) f.m_recInvSqrt) << REC_INV_SQRT_SHIFT;
+  uint32_t invsqrt2 = ((uint64_t) invsqrt * invsqrt) >> 32;
+  uint64_t val = (3ll << 32) - ((uint64_t) f.m_count * invsqrt2);
+
+  val >>= 2; /* avoid overflow */
+  val = (val * invsqrt) >> (32 - 2 + 1);
+  f.m_recInvSqrt = static_cast<uint16_t>(val >> REC_INV_SQRT_SHIFT);
+}
+
+uint32_t
+FqCoDelQueueDisc::ControlLaw (uint32_t flow, uint32_t t) const
+{
+  NS_LOG_FUNCTION (this << flow << t);
+  return t + ReciprocalDivide (m_codelInterval, m_flowQueues[flow].m_recInvSqrt << REC_INV_SQRT_SHIFT);
+}
+
+Ptr<QueueDiscItem>
+FqCoDelQueueDisc::CoDelDequeue (uint32_t flow)
+{
+  NS_LOG_FUNCTION (this << flow);
+  Flow &f = m_flowQueues[flow];
+
+  Ptr<QueueDiscItem> item = PopPacket (flow);
+  if (!item)
+    {
+      // Leave dropping state when queue is empty
+      f.m_dropping = false;
+      return 0;
+    }
+  uint32_t now = Time2CoDel (Simulator::Now ());
+
+  bool okToDrop = OkToDrop (flow, item, now);
+
+  if (f.m_dropping)
+    {
+      if (!okToDrop)
+        {
+          // sojourn time fell below target - leave dropping state
+          f.m_dropping = false;
+        }
+      else if (CoDelTimeAfterEq (now, f.m_dropNext))
+        {
+          while (f.m_dropping && CoDelTimeAfterEq (now, f.m_dropNext))
+            {
+              // It's time for the next drop. Drop the current packet and
+              // dequeue the next. The dequeue might take us out of dropping
+              // state. If not, schedule the next drop.
+              NS_LOG_LOGIC ("Sojourn time is still above target and it's time for next drop; dropping " << item);
+              DropAfterDequeue (item, TARGET_EXCEEDED_DROP);
+
+              ++f.m_count;
+              NewtonStep (flow);
+              item = PopPacket (flow);
+
+              if (!OkToDrop (flow, item, now))
+                {
+                  // leave dropping state
+                  f.m_dropping = false;
+                }
+              else
+                {
+                  // schedule the next drop
+                  f.m_dropNext = ControlLaw (flow, f.m_dropNext);
+                }
+            }
+        }
+    }
+  else if (okToDrop)
+    {
+      // Drop the first packet and enter dropping state unless the queue is empty
+      NS_LOG_LOGIC ("Sojourn time goes above target, dropping the first packet " << item << " and entering the dropping state");
+      DropAfterDequeue (item, TARGET_EXCEEDED_DROP);
+
+      item = PopPacket (flow);
+
+      OkToDrop (flow, item, now);
+      f.m_dropping = true;
+      // if min went above target close to when we last went below it
+      // assume that the drop rate that controlled the queue on the
+      // last cycle is a good starting point to control it now.
+      int delta = f.m_count - f.m_lastCount;
+      if (delta > 1 && CoDelTimeBefore (now - f.m_dropNext, 16 * m_codelInterval))
+        {
+          f.m_count = delta;
+          NewtonStep (flow);
+        }
+      else
+        {
+          f.m_count = 1;
+          f.m_recInvSqrt = ~0U >> REC_INV_SQRT_SHIFT;
+        }
+      f.m_lastCount = f.m_count;
+      f.m_dropNext = ControlLaw (flow, now);
+    }
+  return item;
+}
+
 Ptr<QueueDiscItem>
 FqCoDelQueueDisc::DoDequeue (void)
 {
   NS_LOG_FUNCTION (this);
 
-  Ptr<FqCoDelFlow> flow;
+  uint32_t flow = NONE;
   Ptr<QueueDiscItem> item;
 
   do
     {
       bool found = false;
 
-      while (!found && !m_newFlows.empty ())
+      while (!found && m_newFlows.m_head != NONE)
         {
-          flow = m_newFlows.front ();
+          flow = m_newFlows.m_head;
 
-          if (flow->GetDeficit () <= 0)
+          if (m_flowQueues[flow].m_deficit <= 0)
             {
-              flow->IncreaseDeficit (m_quantum);
-              flow->SetStatus (FqCoDelFlow::OLD_FLOW);
-              m_oldFlows.push_back (flow);
-              m_newFlows.pop_front ();
+              m_flowQueues[flow].m_deficit += m_quantum;
+              m_flowQueues[flow].m_status = OLD_FLOW;
+              PushFlow (m_oldFlows, PopFlow (m_newFlows));
             }
           else
             {
@@ -251,15 +547,14 @@ FqCoDelQueueDisc::DoDequeue (void)
             }
         }
 
-      while (!found && !m_oldFlows.empty ())
+      while (!found && m_oldFlows.m_head != NONE)
         {
-          flow = m_oldFlows.front ();
+          flow = m_oldFlows.m_head;
 
-          if (flow->GetDeficit () <= 0)
+          if (m_flowQueues[flow].m_deficit <= 0)
             {
-              flow->IncreaseDeficit (m_quantum);
-              m_oldFlows.push_back (flow);
-              m_oldFlows.pop_front ();
+              m_flowQueues[flow].m_deficit += m_quantum;
+              PushFlow (m_oldFlows, PopFlow (m_oldFlows));
             }
           else
             {
@@ -274,21 +569,20 @@ FqCoDelQueueDisc::DoDequeue (void)
           return 0;
         }
 
-      item = flow->GetQueueDisc ()->Dequeue ();
+      item = CoDelDequeue (flow);
 
       if (!item)
         {
           NS_LOG_DEBUG ("Could not get a packet from the selected flow queue");
-          if (!m_newFlows.empty ())
+          if (m_newFlows.m_head != NONE)
             {
-              flow->SetStatus (FqCoDelFlow::OLD_FLOW);
-              m_oldFlows.push_back (flow);
-              m_newFlows.pop_front ();
+              m_flowQueues[flow].m_status = OLD_FLOW;
+              PushFlow (m_oldFlows, PopFlow (m_newFlows));
             }
           else
             {
-              flow->SetStatus (FqCoDelFlow::INACTIVE);
-              m_oldFlows.pop_front ();
+              m_flowQueues[flow].m_status = INACTIVE;
+              PopFlow (m_oldFlows);
             }
         }
       else
@@ -297,7 +591,7 @@ FqCoDelQueueDisc::DoDequeue (void)
         }
     } while (item == 0);
 
-  flow->IncreaseDeficit (item->GetSize () * -1);
+  m_flowQueues[flow].m_deficit -= item->GetSize ();
 
   return item;
 }
@@ -336,12 +630,9 @@ FqCoDelQueueDisc::InitializeParams (void)
       NS_LOG_DEBUG ("Setting the quantum to the MTU of the device: " << m_quantum);
     }
 
-  m_flowFactory.SetTypeId ("ns3::FqCoDelFlow");
-
-  m_queueDiscFactory.SetTypeId ("ns3::CoDelQueueDisc");
-  m_queueDiscFactory.Set ("MaxSize", QueueSizeValue (GetMaxSize ()));
-  m_queueDiscFactory.Set ("Interval", StringValue (m_interval));
-  m_queueDiscFactory.Set ("Target", StringValue (m_target));
+  m_codelInterval = Time2CoDel (Time (m_interval));
+  m_codelTarget = Time2CoDel (Time (m_target));
+  m_flowsIndices.assign (m_flows, NONE);
 }
 
 uint32_t
@@ -350,13 +641,11 @@ FqCoDelQueueDisc::FqCoDelDrop (void)
   NS_LOG_FUNCTION (this);
 
   uint32_t maxBacklog = 0, index = 0;
-  Ptr<QueueDisc> qd;
 
   /* Queue is full! Find the fat flow and drop packet(s) from it */
-  for (uint32_t i = 0; i < GetNQueueDiscClasses (); i++)
+  for (uint32_t i = 0; i < m_flowQueues.size (); i++)
     {
-      qd = GetQueueDiscClass (i)->GetQueueDisc ();
-      uint32_t bytes = qd->GetNBytes ();
+      uint32_t bytes = m_flowQueues[i].m_nBytes;
       if (bytes > maxBacklog)
         {
           maxBacklog = bytes;
@@ -366,12 +655,11 @@ FqCoDelQueueDisc::FqCoDelDrop (void)
 
   /* Our goal is to drop half of this fat flow backlog */
   uint32_t len = 0, count = 0, threshold = maxBacklog >> 1;
-  qd = GetQueueDiscClass (index)->GetQueueDisc ();
   Ptr<QueueDiscItem> item;
 
   do
     {
-      item = qd->GetInternalQueue (0)->Dequeue ();
+      item = PopPacket (index);
       DropAfterDequeue (item, OVERLIMIT_DROP);
       len += item->GetSize ();
     } while (++count < m_dropBatchSize && len < threshold);
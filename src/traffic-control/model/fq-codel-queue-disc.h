@@ -23,19 +23,25 @@
 #define FQ_CODEL_QUEUE_DISC
 
 #include "ns3/queue-disc.h"
-#include "ns3/object-factory.h"
-#include <list>
-#include <map>
+#include <vector>
 
 namespace ns3 {
 
 /**
  * \ingroup traffic-control
  *
- * \brief A flow queue used by the FqCoDel queue disc
+ * \brief A FqCoDel packet queue disc
+ *
+ * The flow queues are not queue disc classes: each flow queue is an entry
+ * of a flat array, holding its deficit, its status, the state of its CoDel
+ * instance and the indices of its first and last packets in a pool of
+ * packet nodes shared by all the flow queues.  The lists of new and old
+ * flows are linked through the flow queues themselves, so that the DRR
+ * scheduler neither allocates nor searches, and classifying a packet only
+ * takes an array access.  The CoDel algorithm run on each flow queue is
+ * the one of CoDelQueueDisc.
  */
-
-class FqCoDelFlow : public QueueDiscClass {
+class FqCoDelQueueDisc : public QueueDisc {
 public:
   /**
    * \brief Get the type ID.
@@ -43,15 +49,15 @@ public:
    */
   static TypeId GetTypeId (void);
   /**
-   * \brief FqCoDelFlow constructor
+   * \brief FqCoDelQueueDisc constructor
    */
-  FqCoDelFlow ();
+  FqCoDelQueueDisc ();
 
-  virtual ~FqCoDelFlow ();
+  virtual ~FqCoDelQueueDisc ();
 
   /**
    * \enum FlowStatus
-   * \brief Used to determine the status of this flow queue
+   * \brief Used to determine the status of a flow queue
    */
   enum FlowStatus
     {
@@ -60,58 +66,6 @@ public:
       OLD_FLOW
     };
 
-  /**
-   * \brief Set the deficit for this flow
-   * \param deficit the deficit for this flow
-   */
-  void SetDeficit (uint32_t deficit);
-  /**
-   * \brief Get the deficit for this flow
-   * \return the deficit for this flow
-   */
-  int32_t GetDeficit (void) const;
-  /**
-   * \brief Increase the deficit for this flow
-   * \param deficit the amount by which the deficit is to be increased
-   */
-  void IncreaseDeficit (int32_t deficit);
-  /**
-   * \brief Set the status for this flow
-   * \param status the status for this flow
-   */
-  void SetStatus (FlowStatus status);
-  /**
-   * \brief Get the status of this flow
-   * \return the status of this flow
-   */
-  FlowStatus GetStatus (void) const;
-
-private:
-  int32_t m_deficit;    //!< the deficit for this flow
-  FlowStatus m_status;  //!< the status of this flow
-};
-
-
-/**
- * \ingroup traffic-control
- *
- * \brief A FqCoDel packet queue disc
- */
-
-class FqCoDelQueueDisc : public QueueDisc {
-public:
-  /**
-   * \brief Get the type ID.
-   * \return the object TypeId
-   */
-  static TypeId GetTypeId (void);
-  /**
-   * \brief FqCoDelQueueDisc constructor
-   */
-  FqCoDelQueueDisc ();
-
-  virtual ~FqCoDelQueueDisc ();
-
    /**
     * \brief Set the quantum value.
     *
@@ -126,11 +80,90 @@ public:
     */
    uint32_t GetQuantum (void) const;
 
+  /**
+   * \brief Get the number of flow queues created so far.  Flow queues are
+   * created when they receive their first packet and are numbered in the
+   * order of creation.
+   * \return the number of flow queues
+   */
+  std::size_t GetNFlowQueues (void) const;
+
+  /**
+   * \brief Get the number of packets in a flow queue
+   * \param i the index of the flow queue
+   * \return the number of packets
+   */
+  uint32_t GetFlowQueueNPackets (std::size_t i) const;
+
+  /**
+   * \brief Get the number of bytes in a flow queue
+   * \param i the index of the flow queue
+   * \return the number of bytes
+   */
+  uint32_t GetFlowQueueNBytes (std::size_t i) const;
+
+  /**
+   * \brief Get the deficit of a flow queue
+   * \param i the index of the flow queue
+   * \return the deficit
+   */
+  int32_t GetFlowQueueDeficit (std::size_t i) const;
+
+  /**
+   * \brief Get the status of a flow queue
+   * \param i the index of the flow queue
+   * \return the status
+   */
+  FlowStatus GetFlowQueueStatus (std::size_t i) const;
+
   // Reasons for dropping packets
   static constexpr const char* UNCLASSIFIED_DROP = "Unclassified drop";  //!< No packet filter able to classify packet
   static constexpr const char* OVERLIMIT_DROP = "Overlimit drop";        //!< Overlimit dropped packets
+  static constexpr const char* TARGET_EXCEEDED_DROP = "Target exceeded drop";  //!< Sojourn time above target in a flow queue
 
 private:
+  /// Index marking the end of a list of flow queues or packet nodes
+  static const uint32_t NONE = 0xffffffff;
+
+  /**
+   * \brief A packet in a flow queue
+   */
+  struct PacketNode
+  {
+    Ptr<QueueDiscItem> m_item;  //!< The packet, or 0 if the node is free
+    uint32_t m_next;            //!< Next packet of the flow queue, or next free node
+  };
+
+  /**
+   * \brief A flow queue, with the state of its CoDel instance
+   */
+  struct Flow
+  {
+    uint32_t m_head;            //!< First packet node, or NONE
+    uint32_t m_tail;            //!< Last packet node, or NONE
+    uint32_t m_nPackets;        //!< Number of packets
+    uint32_t m_nBytes;          //!< Number of bytes
+    int32_t m_deficit;          //!< Deficit
+    FlowStatus m_status;        //!< Status
+    uint32_t m_next;            //!< Next flow queue in the list of new or old flows, or NONE
+    uint32_t m_count;           //!< CoDel: number of packets dropped since entering drop state
+    uint32_t m_lastCount;       //!< CoDel: last number of packets dropped since entering drop state
+    uint32_t m_firstAboveTime;  //!< CoDel: time to declare sojourn time above target
+    uint32_t m_dropNext;        //!< CoDel: time to drop next packet
+    uint16_t m_recInvSqrt;      //!< CoDel: reciprocal inverse square root
+    bool m_dropping;            //!< CoDel: true if in dropping state
+  };
+
+  /**
+   * \brief A list of flow queues, linked through Flow::m_next
+   */
+  struct FlowList
+  {
+    uint32_t m_head;  //!< First flow queue, or NONE
+    uint32_t m_tail;  //!< Last flow queue, or NONE
+  };
+
+  virtual void DoDispose (void);
   virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
   virtual Ptr<QueueDiscItem> DoDequeue (void);
   virtual bool CheckConfig (void);
@@ -142,20 +175,87 @@ private:
    */
   uint32_t FqCoDelDrop (void);
 
+  /**
+   * \brief Append a packet to a flow queue
+   * \param flow the index of the flow queue
+   * \param item the packet
+   */
+  void PushPacket (uint32_t flow, Ptr<QueueDiscItem> item);
+
+  /**
+   * \brief Remove the packet at the head of a flow queue, and account for
+   * its dequeue
+   * \param flow the index of the flow queue
+   * \return the packet, or 0 if the flow queue is empty
+   */
+  Ptr<QueueDiscItem> PopPacket (uint32_t flow);
+
+  /**
+   * \brief Dequeue a packet from a flow queue, after running the CoDel
+   * algorithm on it, exactly as CoDelQueueDisc::DoDequeue does.
+   * \param flow the index of the flow queue
+   * \return the packet, or 0 if the flow queue is or becomes empty
+   */
+  Ptr<QueueDiscItem> CoDelDequeue (uint32_t flow);
+
+  /**
+   * \brief Determine whether the CoDel instance of a flow queue may drop
+   * a packet, as CoDelQueueDisc::OkToDrop does
+   * \param flow the index of the flow queue
+   * \param item the packet just removed from the flow queue
+   * \param now the current time in CoDel time representation
+   * \return true if the sojourn time has been above target for at least interval
+   */
+  bool OkToDrop (uint32_t flow, Ptr<QueueDiscItem> item, uint32_t now);
+
+  /**
+   * \brief Update the reciprocal square root of the count of a flow queue
+   * with Newton's method, as CoDelQueueDisc::NewtonStep does
+   * \param flow the index of the flow queue
+   */
+  void NewtonStep (uint32_t flow);
+
+  /**
+   * \brief Apply the CoDel control law of a flow queue, as
+   * CoDelQueueDisc::ControlLaw does
+   * \param flow the index of the flow queue
+   * \param t current next drop time
+   * \return the new next drop time
+   */
+  uint32_t ControlLaw (uint32_t flow, uint32_t t) const;
+
+  /**
+   * \brief Append a flow queue to a list
+   * \param list the list
+   * \param flow the index of the flow queue
+   */
+  void PushFlow (FlowList &list, uint32_t flow);
+
+  /**
+   * \brief Remove the flow queue at the head of a list
+   * \param list the list, not empty
+   * \return the index of the flow queue
+   */
+  uint32_t PopFlow (FlowList &list);
+
   std::string m_interval;    //!< CoDel interval attribute
   std::string m_target;      //!< CoDel target attribute
+  uint32_t m_minBytes;       //!< CoDel minimum bytes in a flow queue to allow a packet drop
   uint32_t m_quantum;        //!< Deficit assigned to flows at each round
   uint32_t m_flows;          //!< Number of flow queues
   uint32_t m_dropBatchSize;  //!< Max number of packets dropped from the fat flow
   uint32_t m_perturbation;   //!< hash perturbation value
 
-  std::list<Ptr<FqCoDelFlow> > m_newFlows;    //!< The list of new flows
-  std::list<Ptr<FqCoDelFlow> > m_oldFlows;    //!< The list of old flows
+  uint32_t m_codelInterval;  //!< CoDel interval, in CoDel time representation
+  uint32_t m_codelTarget;    //!< CoDel target, in CoDel time representation
 
-  std::map<uint32_t, uint32_t> m_flowsIndices;    //!< Map with the index of class for each flow
+  FlowList m_newFlows;       //!< The list of new flows
+  FlowList m_oldFlows;       //!< The list of old flows
 
-  ObjectFactory m_flowFactory;         //!< Factory to create a new flow
-  ObjectFactory m_queueDiscFactory;    //!< Factory to create a new queue
+  std::vector<Flow> m_flowQueues;           //!< Flow queues, in order of creation
+  std::vector<uint32_t> m_flowsIndices;     //!< Index of the flow queue of each hash bucket, or NONE
+  std::vector<PacketNode> m_packetNodes;    //!< Packet nodes of all the flow queues
+  uint32_t m_freePacketNodes;               //!< First free packet node, or NONE
 };
 
 } // namespace ns3
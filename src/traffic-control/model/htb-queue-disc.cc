@@ -0,0 +1,595 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * This implementation is based on the linux kernel code (sch_htb.c) by
+ * Martin Devera and contributors.
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/integer.h"
+#include "htb-queue-disc.h"
+#include <algorithm>
+#include <limits>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("HtbQueueDisc");
+
+NS_OBJECT_ENSURE_REGISTERED (HtbClass);
+NS_OBJECT_ENSURE_REGISTERED (HtbQueueDisc);
+
+/**
+ * \param bytes an amount of bytes
+ * \param rate a rate in bps
+ * \return the time needed to send the bytes at the rate, in ns
+ */
+static int64_t
+BytesToNs (uint64_t bytes, uint64_t rate)
+{
+  return static_cast<int64_t> (bytes * 8000000000ULL / rate);
+}
+
+TypeId HtbClass::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::HtbClass")
+    .SetParent<QueueDiscClass> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<HtbClass> ()
+    .AddAttribute ("Rate",
+                   "The rate guaranteed to the class",
+                   DataRateValue (DataRate ("1Mbps")),
+                   MakeDataRateAccessor (&HtbClass::m_rate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("Ceil",
+                   "The maximum rate of the class, borrowing included. If null, it is "
+                   "equal to the rate of the class",
+                   DataRateValue (DataRate ("0bps")),
+                   MakeDataRateAccessor (&HtbClass::m_ceil),
+                   MakeDataRateChecker ())
+    .AddAttribute ("Burst",
+                   "Size of the bucket of the rate in bytes. If null, the amount of bytes "
+                   "sent in 1 ms at the rate plus the MTU of the device",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&HtbClass::m_burst),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Cburst",
+                   "Size of the bucket of the ceil rate in bytes. If null, the amount of "
+                   "bytes sent in 1 ms at the ceil rate plus the MTU of the device",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&HtbClass::m_cburst),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Quantum",
+                   "Amount of bytes the class may send in a round when sharing the excess "
+                   "bandwidth. If null, the rate in bytes per second divided by the R2q "
+                   "attribute of the queue disc",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&HtbClass::m_quantum),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Priority",
+                   "The priority of the class when sharing the excess bandwidth, 0 being "
+                   "the highest one",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&HtbClass::m_priority),
+                   MakeUintegerChecker<uint8_t> (0, 7))
+    .AddAttribute ("Parent",
+                   "The index of the parent class in the queue disc, -1 for a root class. "
+                   "A parent class must be added to the queue disc before its children",
+                   IntegerValue (-1),
+                   MakeIntegerAccessor (&HtbClass::m_parent),
+                   MakeIntegerChecker<int32_t> (-1))
+  ;
+  return tid;
+}
+
+HtbClass::HtbClass ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+HtbClass::~HtbClass ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+DataRate
+HtbClass::GetRate (void) const
+{
+  return m_rate;
+}
+
+DataRate
+HtbClass::GetCeil (void) const
+{
+  return m_ceil.GetBitRate () > 0 ? m_ceil : m_rate;
+}
+
+uint32_t
+HtbClass::GetBurst (void) const
+{
+  return m_burst;
+}
+
+uint32_t
+HtbClass::GetCburst (void) const
+{
+  return m_cburst;
+}
+
+uint32_t
+HtbClass::GetQuantum (void) const
+{
+  return m_quantum;
+}
+
+uint8_t
+HtbClass::GetPriority (void) const
+{
+  return m_priority;
+}
+
+int32_t
+HtbClass::GetParent (void) const
+{
+  return m_parent;
+}
+
+const uint32_t HtbQueueDisc::NONE = std::numeric_limits<uint32_t>::max ();
+
+TypeId HtbQueueDisc::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::HtbQueueDisc")
+    .SetParent<QueueDisc> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<HtbQueueDisc> ()
+    .AddAttribute ("DefaultClass",
+                   "The index of the leaf class of the packets not classified by the "
+                   "packet filters. If negative, such packets are dropped",
+                   IntegerValue (-1),
+                   MakeIntegerAccessor (&HtbQueueDisc::m_defaultClass),
+                   MakeIntegerChecker<int32_t> ())
+    .AddAttribute ("R2q",
+                   "The divisor of the rates of the classes giving their default quantum",
+                   UintegerValue (10),
+                   MakeUintegerAccessor (&HtbQueueDisc::m_r2q),
+                   MakeUintegerChecker<uint32_t> (1))
+  ;
+  return tid;
+}
+
+HtbQueueDisc::HtbQueueDisc ()
+  : QueueDisc (QueueDiscSizePolicy::NO_LIMITS),
+    m_round (0),
+    m_stamp (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+HtbQueueDisc::~HtbQueueDisc ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+HtbQueueDisc::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_wakeEvent.Cancel ();
+  m_classes.clear ();
+  for (uint8_t p = 0; p < N_PRIORITIES; p++)
+    {
+      m_active[p].clear ();
+    }
+  m_waitQueue.clear ();
+  QueueDisc::DoDispose ();
+}
+
+uint32_t
+HtbQueueDisc::GetClassLevel (std::size_t i) const
+{
+  NS_ASSERT (i < m_classes.size ());
+  return m_classes[i].level;
+}
+
+Time
+HtbQueueDisc::GetClassTokens (std::size_t i) const
+{
+  NS_ASSERT (i < m_classes.size ());
+  return NanoSeconds (m_classes[i].tokens);
+}
+
+Time
+HtbQueueDisc::GetClassCtokens (std::size_t i) const
+{
+  NS_ASSERT (i < m_classes.size ());
+  return NanoSeconds (m_classes[i].ctokens);
+}
+
+HtbQueueDisc::ClassMode
+HtbQueueDisc::GetMode (const ClassState &cl, int64_t now)
+{
+  int64_t diff = now - cl.checkPoint;
+  if (cl.ctokens + diff < 0)
+    {
+      return CANT_SEND;
+    }
+  if (cl.tokens + diff >= 0)
+    {
+      return CAN_SEND;
+    }
+  return MAY_BORROW;
+}
+
+uint32_t
+HtbQueueDisc::GetSendLevel (uint32_t index, int64_t now)
+{
+  ClassState &cl = m_classes[index];
+  if (cl.stamp == m_stamp)
+    {
+      return cl.sendLevel;
+    }
+
+  // the level of a class only depends on its ancestors, hence it is computed
+  // once per dequeue for all the leaves below it
+  uint32_t level = NONE;
+  ClassMode mode = GetMode (cl, now);
+  if (mode == CAN_SEND)
+    {
+      level = cl.level;
+    }
+  else if (mode == MAY_BORROW && cl.parent != NONE)
+    {
+      level = GetSendLevel (cl.parent, now);
+    }
+  cl.stamp = m_stamp;
+  cl.sendLevel = level;
+  return level;
+}
+
+int64_t
+HtbQueueDisc::GetWaitTime (uint32_t index, int64_t now) const
+{
+  const ClassState &cl = m_classes[index];
+  int64_t diff = now - cl.checkPoint;
+  int64_t cwait = std::max<int64_t> (-(cl.ctokens + diff), 0);
+  int64_t wait = std::max<int64_t> (-(cl.tokens + diff), 0);
+  if (wait > 0 && cl.parent != NONE)
+    {
+      // the class may send earlier by borrowing from its parent
+      wait = std::min (wait, GetWaitTime (cl.parent, now));
+    }
+  return std::max (wait, cwait);
+}
+
+void
+HtbQueueDisc::Charge (uint32_t leaf, uint32_t level, uint32_t bytes, int64_t now)
+{
+  NS_LOG_FUNCTION (this << leaf << level << bytes);
+  for (uint32_t i = leaf; i != NONE; i = m_classes[i].parent)
+    {
+      ClassState &cl = m_classes[i];
+      int64_t diff = now - cl.checkPoint;
+      // the classes below the level the packet is sent at borrow the bandwidth,
+      // hence they are not charged on their rate
+      cl.tokens = std::min (cl.tokens + diff, cl.buffer);
+      if (cl.level >= level)
+        {
+          cl.tokens -= BytesToNs (bytes, cl.rate);
+        }
+      cl.ctokens = std::min (cl.ctokens + diff, cl.cbuffer) - BytesToNs (bytes, cl.ceil);
+      cl.checkPoint = now;
+    }
+}
+
+void
+HtbQueueDisc::Activate (uint32_t leaf)
+{
+  NS_LOG_FUNCTION (this << leaf);
+  ClassState &cl = m_classes[leaf];
+  std::list<uint32_t> &active = m_active[cl.priority];
+  cl.activeIt = active.insert (active.end (), leaf);
+  cl.active = true;
+}
+
+void
+HtbQueueDisc::Deactivate (uint32_t leaf)
+{
+  NS_LOG_FUNCTION (this << leaf);
+  ClassState &cl = m_classes[leaf];
+  m_active[cl.priority].erase (cl.activeIt);
+  cl.active = false;
+}
+
+void
+HtbQueueDisc::Block (uint32_t leaf, int64_t now)
+{
+  NS_LOG_FUNCTION (this << leaf << now);
+  Deactivate (leaf);
+  ClassState &cl = m_classes[leaf];
+  // Sending packets of other leaves may only delay this time, which is
+  // checked again when the leaf leaves the wait queue
+  int64_t wakeTime = now + std::max<int64_t> (GetWaitTime (leaf, now), 1);
+  // the leaves waking at the same time, e.g., waiting for the same ancestor,
+  // are moved back in round robin order
+  m_waitQueue.insert (std::make_pair (std::make_pair (wakeTime, cl.round), leaf));
+  cl.waiting = true;
+}
+
+void
+HtbQueueDisc::Unblock (int64_t now)
+{
+  NS_LOG_FUNCTION (this << now);
+  while (!m_waitQueue.empty () && m_waitQueue.begin ()->first.first <= now)
+    {
+      uint32_t leaf = m_waitQueue.begin ()->second;
+      m_waitQueue.erase (m_waitQueue.begin ());
+      m_classes[leaf].waiting = false;
+      Activate (leaf);
+    }
+}
+
+bool
+HtbQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  int32_t ret = Classify (item);
+  uint32_t leaf;
+
+  if (ret >= 0 && static_cast<uint32_t> (ret) < m_classes.size () && m_classes[ret].level == 0)
+    {
+      leaf = ret;
+    }
+  else if (m_defaultClass >= 0)
+    {
+      NS_LOG_DEBUG ("Packet filters returned " << ret << ", using the default class");
+      leaf = m_defaultClass;
+    }
+  else
+    {
+      NS_LOG_DEBUG ("Packet filters returned " << ret << " and there is no default class");
+      DropBeforeEnqueue (item, UNCLASSIFIED_DROP);
+      return false;
+    }
+
+  Ptr<QueueDisc> qd = GetQueueDiscClass (leaf)->GetQueueDisc ();
+  bool retval = qd->Enqueue (item);
+
+  // If Queue::Enqueue fails, QueueDisc::Drop is called by the child queue disc
+  // because QueueDisc::AddQueueDiscClass sets the drop callback
+
+  if (!m_classes[leaf].active && !m_classes[leaf].waiting && qd->GetNPackets () > 0)
+    {
+      m_classes[leaf].round = m_round++;
+      Activate (leaf);
+    }
+
+  NS_LOG_LOGIC ("Number packets class " << leaf << ": " << qd->GetNPackets ());
+
+  return retval;
+}
+
+Ptr<QueueDiscItem>
+HtbQueueDisc::DoDequeue (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  int64_t now = Simulator::Now ().GetNanoSeconds ();
+  Unblock (now);
+
+  while (true)
+    {
+      // Serve the leaves by increasing level, then by priority. Among the
+      // leaves of a priority sending at the same level, the first one in
+      // round robin order is served. The leaves which cannot send are moved
+      // to the wait queue, and the scan stops at the first leaf able to
+      // send at level 0.
+      m_stamp++;
+      uint32_t leaf = NONE;
+      uint32_t level = NONE;
+      for (uint8_t p = 0; p < N_PRIORITIES && level != 0; p++)
+        {
+          std::list<uint32_t>::iterator it = m_active[p].begin ();
+          while (it != m_active[p].end ())
+            {
+              uint32_t l = GetSendLevel (*it, now);
+              if (l == NONE)
+                {
+                  Block (*it++, now);
+                  continue;
+                }
+              if (l < level)
+                {
+                  level = l;
+                  leaf = *it;
+                  if (level == 0)
+                    {
+                      break;
+                    }
+                }
+              it++;
+            }
+        }
+
+      if (leaf == NONE)
+        {
+          if (!m_waitQueue.empty ())
+            {
+              // wake up when the first blocked leaf may send
+              Time delay = NanoSeconds (m_waitQueue.begin ()->first.first - now);
+              if (!m_wakeEvent.IsRunning () || Simulator::GetDelayLeft (m_wakeEvent) > delay)
+                {
+                  m_wakeEvent.Cancel ();
+                  m_wakeEvent = Simulator::Schedule (delay, &QueueDisc::Run, this);
+                  NS_LOG_LOGIC ("Waking event scheduled in " << delay);
+                }
+            }
+          NS_LOG_LOGIC ("No class can send");
+          return 0;
+        }
+
+      Ptr<QueueDisc> qd = GetQueueDiscClass (leaf)->GetQueueDisc ();
+      Ptr<QueueDiscItem> item = qd->Dequeue ();
+      ClassState &cl = m_classes[leaf];
+
+      if (!item)
+        {
+          if (qd->GetNPackets () == 0)
+            {
+              Deactivate (leaf);
+              continue;
+            }
+          NS_LOG_WARN ("The queue disc of class " << leaf << " did not return a packet");
+          return 0;
+        }
+
+      NS_LOG_LOGIC ("Popped from class " << leaf << " at level " << level << ": " << item);
+      Charge (leaf, level, item->GetSize (), now);
+
+      cl.deficit -= item->GetSize ();
+      if (cl.deficit < 0)
+        {
+          cl.deficit += cl.quantum;
+          std::list<uint32_t> &active = m_active[cl.priority];
+          active.splice (active.end (), active, cl.activeIt);
+          cl.round = m_round++;
+        }
+      if (qd->GetNPackets () == 0)
+        {
+          Deactivate (leaf);
+        }
+      return item;
+    }
+}
+
+bool
+HtbQueueDisc::CheckConfig (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (GetNInternalQueues () > 0)
+    {
+      NS_LOG_ERROR ("HtbQueueDisc cannot have internal queues");
+      return false;
+    }
+
+  if (GetNQueueDiscClasses () == 0)
+    {
+      NS_LOG_ERROR ("HtbQueueDisc needs at least one class");
+      return false;
+    }
+
+  std::vector<bool> inner (GetNQueueDiscClasses (), false);
+  for (uint32_t i = 0; i < GetNQueueDiscClasses (); i++)
+    {
+      Ptr<HtbClass> c = DynamicCast<HtbClass> (GetQueueDiscClass (i));
+      if (!c)
+        {
+          NS_LOG_ERROR ("The classes of HtbQueueDisc must be HtbClass objects");
+          return false;
+        }
+      if (c->GetParent () >= static_cast<int32_t> (i))
+        {
+          NS_LOG_ERROR ("The parent of class " << i << " must be added to the queue disc before it");
+          return false;
+        }
+      if (c->GetParent () >= 0)
+        {
+          inner[c->GetParent ()] = true;
+        }
+      if (c->GetRate ().GetBitRate () == 0)
+        {
+          NS_LOG_ERROR ("The rate of class " << i << " is null");
+          return false;
+        }
+      if (c->GetCeil () < c->GetRate ())
+        {
+          NS_LOG_ERROR ("The ceil rate of class " << i << " is lower than its rate");
+          return false;
+        }
+    }
+
+  if (m_defaultClass >= static_cast<int32_t> (GetNQueueDiscClasses ())
+      || (m_defaultClass >= 0 && inner[m_defaultClass]))
+    {
+      NS_LOG_ERROR ("The default class must be a leaf class");
+      return false;
+    }
+
+  return true;
+}
+
+void
+HtbQueueDisc::InitializeParams (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  uint32_t mtu = GetNetDevice () ? GetNetDevice ()->GetMtu () : 1500;
+  int64_t now = Simulator::Now ().GetNanoSeconds ();
+
+  m_classes.resize (GetNQueueDiscClasses ());
+  for (uint32_t i = 0; i < m_classes.size (); i++)
+    {
+      Ptr<HtbClass> c = DynamicCast<HtbClass> (GetQueueDiscClass (i));
+      ClassState &cl = m_classes[i];
+      cl.parent = c->GetParent () >= 0 ? c->GetParent () : NONE;
+      cl.level = 0;
+      cl.priority = c->GetPriority ();
+      cl.rate = c->GetRate ().GetBitRate ();
+      cl.ceil = c->GetCeil ().GetBitRate ();
+
+      uint32_t burst = c->GetBurst () ? c->GetBurst () : cl.rate / 8000 + mtu;
+      uint32_t cburst = c->GetCburst () ? c->GetCburst () : cl.ceil / 8000 + mtu;
+      cl.buffer = BytesToNs (burst, cl.rate);
+      cl.cbuffer = BytesToNs (cburst, cl.ceil);
+      cl.tokens = cl.buffer;
+      cl.ctokens = cl.cbuffer;
+      cl.checkPoint = now;
+
+      cl.quantum = c->GetQuantum ();
+      if (cl.quantum == 0)
+        {
+          // same bounds as Linux
+          cl.quantum = std::min<uint64_t> (std::max<uint64_t> (cl.rate / 8 / m_r2q, 1000), 200000);
+        }
+      cl.deficit = cl.quantum;
+      cl.active = false;
+      cl.waiting = false;
+      cl.round = 0;
+      cl.stamp = 0;
+      cl.sendLevel = NONE;
+    }
+
+  // parents come before their children, hence the levels are known bottom up
+  for (uint32_t i = m_classes.size (); i-- > 0; )
+    {
+      if (m_classes[i].parent != NONE)
+        {
+          ClassState &parent = m_classes[m_classes[i].parent];
+          parent.level = std::max (parent.level, m_classes[i].level + 1);
+        }
+    }
+
+  for (uint8_t p = 0; p < N_PRIORITIES; p++)
+    {
+      m_active[p].clear ();
+    }
+  m_waitQueue.clear ();
+  m_round = 0;
+  m_stamp = 0;
+  m_wakeEvent = EventId ();
+}
+
+} // namespace ns3
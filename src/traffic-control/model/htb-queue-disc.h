@@ -0,0 +1,301 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * This implementation is based on the linux kernel code (sch_htb.c) by
+ * Martin Devera and contributors.
+ */
+#ifndef HTB_QUEUE_DISC_H
+#define HTB_QUEUE_DISC_H
+
+#include "ns3/queue-disc.h"
+#include "ns3/data-rate.h"
+#include "ns3/event-id.h"
+#include <list>
+#include <map>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief A class of an HTB queue disc
+ *
+ * An HtbClass holds the parameters of a node of the HTB class tree: the
+ * guaranteed rate and the ceil rate of the class, the sizes of the
+ * buckets of these rates, the priority and the quantum used to share the
+ * excess bandwidth, and the index of its parent class. A class which is
+ * the parent of another class is an inner class, and its queue disc is
+ * not used; the packets are only queued in the queue discs of the leaf
+ * classes.
+ */
+class HtbClass : public QueueDiscClass {
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  HtbClass ();
+  virtual ~HtbClass ();
+
+  /**
+   * \brief Get the rate guaranteed to the class
+   * \return the rate
+   */
+  DataRate GetRate (void) const;
+
+  /**
+   * \brief Get the maximum rate of the class, borrowing included
+   * \return the ceil rate, or the rate if the ceil rate is null
+   */
+  DataRate GetCeil (void) const;
+
+  /**
+   * \brief Get the size of the bucket of the rate
+   * \return the size in bytes, or 0 if the default size is used
+   */
+  uint32_t GetBurst (void) const;
+
+  /**
+   * \brief Get the size of the bucket of the ceil rate
+   * \return the size in bytes, or 0 if the default size is used
+   */
+  uint32_t GetCburst (void) const;
+
+  /**
+   * \brief Get the quantum of the class
+   * \return the quantum in bytes, or 0 if it is computed from the rate
+   */
+  uint32_t GetQuantum (void) const;
+
+  /**
+   * \brief Get the priority of the class
+   * \return the priority, 0 being the highest one
+   */
+  uint8_t GetPriority (void) const;
+
+  /**
+   * \brief Get the parent of the class
+   * \return the index of the parent class in the queue disc, or -1 for a root class
+   */
+  int32_t GetParent (void) const;
+
+private:
+  DataRate m_rate;       //!< Guaranteed rate
+  DataRate m_ceil;       //!< Ceil rate
+  uint32_t m_burst;      //!< Size of the bucket of the rate in bytes
+  uint32_t m_cburst;     //!< Size of the bucket of the ceil rate in bytes
+  uint32_t m_quantum;    //!< Quantum in bytes
+  uint8_t m_priority;    //!< Priority
+  int32_t m_parent;      //!< Index of the parent class
+};
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief A hierarchical token bucket (HTB) queue disc
+ *
+ * The classes of the queue disc are HtbClass objects forming a tree: each
+ * class is guaranteed its rate and may borrow from its ancestors up to
+ * its ceil rate. A class can send:
+ * - at its own level, if the tokens of its rate and of its ceil rate are
+ *   not exhausted;
+ * - at the level of an ancestor, if the tokens of its ceil rate are not
+ *   exhausted, the tokens of its rate are, and it may borrow from its
+ *   parent.
+ *
+ * The leaves are served by increasing level, then by priority, and the
+ * leaves sending at the same level with the same priority share the
+ * bandwidth by deficit round robin, using the quanta of the classes. When
+ * a packet is sent, the classes below the level it is sent at, which
+ * borrowed the bandwidth, are charged on their ceil rate only, and the other
+ * ancestors of the leaf on both their rates.
+ *
+ * The state of the classes is kept in a flat array indexed by class, and
+ * the backlogged leaves in one round robin list per priority. The mode of
+ * each class is computed at most once per dequeue. As with the wait queues
+ * of Linux, a leaf found unable to send is moved out of its round robin
+ * list into a wait queue, ordered by the time it can send again if no
+ * packet is sent meanwhile, then by round robin order, and moved back
+ * when that time is reached. A dequeue hence only examines the leaves
+ * which could send when last examined, and stops at the first one able
+ * to send at level 0 in the highest priority, at a cost in O(depth) per
+ * leaf examined plus O(log n) per leaf moved in or out of the wait queue.
+ * If no leaf can send, a single timer is scheduled at the head of the wait
+ * queue.
+ *
+ * Packets are classified by the packet filters, which return the index of
+ * a leaf class. Packets not classified are queued in the default class,
+ * or dropped if there is none.
+ */
+class HtbQueueDisc : public QueueDisc {
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * \brief HtbQueueDisc constructor
+   */
+  HtbQueueDisc ();
+
+  virtual ~HtbQueueDisc ();
+
+  /**
+   * \brief Get the level of a class, i.e., 0 for a leaf and one more than the
+   * highest level of its children for an inner class
+   * \param i the index of the class
+   * \return the level of the class
+   */
+  uint32_t GetClassLevel (std::size_t i) const;
+
+  /**
+   * \brief Get the tokens of the rate of a class, as of its last update
+   * \param i the index of the class
+   * \return the tokens, as the time needed to send them at the rate
+   */
+  Time GetClassTokens (std::size_t i) const;
+
+  /**
+   * \brief Get the tokens of the ceil rate of a class, as of its last update
+   * \param i the index of the class
+   * \return the tokens, as the time needed to send them at the ceil rate
+   */
+  Time GetClassCtokens (std::size_t i) const;
+
+  // Reasons for dropping packets
+  static constexpr const char* UNCLASSIFIED_DROP = "Unclassified packet";  //!< No class to enqueue the packet in
+
+protected:
+  /**
+   * \brief Dispose of the object
+   */
+  virtual void DoDispose (void);
+
+private:
+  virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
+  virtual Ptr<QueueDiscItem> DoDequeue (void);
+  virtual bool CheckConfig (void);
+  virtual void InitializeParams (void);
+
+  /// \brief Mode of a class
+  enum ClassMode
+  {
+    CAN_SEND,     //!< Tokens left on both rates
+    MAY_BORROW,   //!< No token left on the rate, tokens left on the ceil rate
+    CANT_SEND     //!< No token left on the ceil rate
+  };
+
+  /// \brief State of a class
+  struct ClassState
+  {
+    uint32_t parent;            //!< Index of the parent class, or NONE
+    uint32_t level;             //!< Level of the class
+    uint8_t priority;           //!< Priority of the class
+    uint64_t rate;              //!< Rate in bps
+    uint64_t ceil;              //!< Ceil rate in bps
+    int64_t buffer;             //!< Size of the bucket of the rate, in ns at the rate
+    int64_t cbuffer;            //!< Size of the bucket of the ceil rate, in ns at the ceil rate
+    int64_t tokens;             //!< Tokens of the rate, in ns
+    int64_t ctokens;            //!< Tokens of the ceil rate, in ns
+    int64_t checkPoint;         //!< Time of the last update of the tokens, in ns
+    uint32_t quantum;           //!< Quantum in bytes
+    int32_t deficit;            //!< Deficit of the leaf in bytes
+    bool active;                //!< True if the leaf is in a round robin list
+    std::list<uint32_t>::iterator activeIt;  //!< Position of the leaf in its round robin list
+    uint64_t round;             //!< Order of the leaf in round robin, kept while it waits
+    bool waiting;               //!< True if the leaf is in the wait queue
+    uint64_t stamp;             //!< Dequeue in which sendLevel was computed
+    uint32_t sendLevel;         //!< Level the class can send at, or NONE
+  };
+
+  /**
+   * \brief Get the mode of a class
+   * \param cl the class
+   * \param now the current time in ns
+   * \return the mode of the class
+   */
+  static ClassMode GetMode (const ClassState &cl, int64_t now);
+
+  /**
+   * \brief Get the level a class can send at, computing it at most once per dequeue
+   * \param index the index of the class
+   * \param now the current time in ns
+   * \return the level, or NONE if the class cannot send
+   */
+  uint32_t GetSendLevel (uint32_t index, int64_t now);
+
+  /**
+   * \brief Get the time until a class can send, if no packet is sent meanwhile
+   * \param index the index of the class
+   * \param now the current time in ns
+   * \return the time in ns
+   */
+  int64_t GetWaitTime (uint32_t index, int64_t now) const;
+
+  /**
+   * \brief Charge the classes for a packet sent by a leaf
+   * \param leaf the index of the leaf
+   * \param level the level the packet is sent at
+   * \param bytes the size of the packet
+   * \param now the current time in ns
+   */
+  void Charge (uint32_t leaf, uint32_t level, uint32_t bytes, int64_t now);
+
+  /**
+   * \brief Add a leaf to the round robin list of its priority
+   * \param leaf the index of the leaf
+   */
+  void Activate (uint32_t leaf);
+
+  /**
+   * \brief Remove a leaf from the round robin list of its priority
+   * \param leaf the index of the leaf
+   */
+  void Deactivate (uint32_t leaf);
+
+  /**
+   * \brief Move a leaf which cannot send from its round robin list to the wait queue
+   * \param leaf the index of the leaf
+   * \param now the current time in ns
+   */
+  void Block (uint32_t leaf, int64_t now);
+
+  /**
+   * \brief Move the leaves of the wait queue which may send again to their round robin lists
+   * \param now the current time in ns
+   */
+  void Unblock (int64_t now);
+
+  static const uint32_t NONE;         //!< No class or no level
+  static const uint8_t N_PRIORITIES = 8;  //!< Number of priorities
+
+  int32_t m_defaultClass;             //!< Class of the packets not classified
+  uint32_t m_r2q;                     //!< Divisor of the rates giving the default quanta
+  std::vector<ClassState> m_classes;  //!< State of the classes
+  std::list<uint32_t> m_active[N_PRIORITIES];  //!< Backlogged leaves of each priority, in round robin order
+  std::map<std::pair<int64_t, uint64_t>, uint32_t> m_waitQueue;  //!< Backlogged leaves which cannot send, by the time they may send again and round robin order
+  uint64_t m_round;                   //!< Number of leaves moved to the end of a round robin list
+  uint64_t m_stamp;                   //!< Number of dequeues
+  EventId m_wakeEvent;                //!< Event waking the queue disc when a leaf can send
+};
+
+} // namespace ns3
+
+#endif /* HTB_QUEUE_DISC_H */
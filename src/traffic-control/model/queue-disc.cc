@@ -29,6 +29,10 @@
 #include "queue-disc.h"
 #include <ns3/drop-tail-queue.h>
 #include "ns3/net-device-queue-interface.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <deque>
 
 namespace ns3 {
 
@@ -37,6 +41,63 @@ NS_OBJECT_TEMPLATE_CLASS_DEFINE (DropTailQueue,QueueDiscItem);
 
 NS_LOG_COMPONENT_DEFINE ("QueueDisc");
 
+/**
+ * \brief The reasons to drop or mark packets, shared by all the queue discs
+ */
+struct QueueDiscReasonTable
+{
+  std::map<std::string, uint16_t> codes;  //!< Reason codes, by reason
+  std::deque<std::string> reasons;        //!< Reasons, by code
+};
+
+/**
+ * \return the table of the reasons to drop or mark packets
+ */
+static QueueDiscReasonTable &
+GetReasonTable (void)
+{
+  static QueueDiscReasonTable table;
+  return table;
+}
+
+/**
+ * \param reason a reason to drop or mark packets
+ * \return the code of the reason, added to the table if needed
+ */
+static uint16_t
+InternReason (const std::string &reason)
+{
+  QueueDiscReasonTable &table = GetReasonTable ();
+  std::map<std::string, uint16_t>::const_iterator it = table.codes.find (reason);
+  if (it != table.codes.end ())
+    {
+      return it->second;
+    }
+  NS_ABORT_MSG_IF (table.reasons.size () >= 0xffff, "Too many reasons to drop or mark packets");
+  uint16_t code = table.reasons.size ();
+  table.reasons.push_back (reason);
+  table.codes[reason] = code;
+  return code;
+}
+
+/**
+ * \param stats the statistics of a queue disc
+ * \param reason a reason to drop or mark packets
+ * \return the counters of the reason, or 0 if no packet was dropped or
+ * marked for this reason
+ */
+static const QueueDisc::Stats::ReasonStats *
+FindReasonStats (const QueueDisc::Stats &stats, const std::string &reason)
+{
+  const QueueDiscReasonTable &table = GetReasonTable ();
+  std::map<std::string, uint16_t>::const_iterator it = table.codes.find (reason);
+  if (it == table.codes.end () || it->second >= stats.reasons.size ())
+    {
+      return 0;
+    }
+  return &stats.reasons[it->second];
+}
+
 
 NS_OBJECT_ENSURE_REGISTERED (QueueDiscClass);
 
@@ -105,76 +166,90 @@ QueueDisc::Stats::Stats ()
     nTotalRequeuedPackets (0),
     nTotalRequeuedBytes (0),
     nTotalMarkedPackets (0),
-    nTotalMarkedBytes (0)
+    nTotalMarkedBytes (0),
+    nSojournTimes (),
+    totalSojournTime (Seconds (0))
+{
+}
+
+QueueDisc::Stats::ReasonStats::ReasonStats ()
+  : nDroppedPacketsBeforeEnqueue (0),
+    nDroppedBytesBeforeEnqueue (0),
+    nDroppedPacketsAfterDequeue (0),
+    nDroppedBytesAfterDequeue (0),
+    nMarkedPackets (0),
+    nMarkedBytes (0)
 {
 }
 
 uint32_t
 QueueDisc::Stats::GetNDroppedPackets (std::string reason) const
 {
-  uint32_t count = 0;
-  auto it = nDroppedPacketsBeforeEnqueue.find (reason);
-
-  if (it != nDroppedPacketsBeforeEnqueue.end ())
-    {
-      count += it->second;
-    }
-
-  it = nDroppedPacketsAfterDequeue.find (reason);
-
-  if (it != nDroppedPacketsAfterDequeue.end ())
-    {
-      count += it->second;
-    }
-
-  return count;
+  const ReasonStats *rs = FindReasonStats (*this, reason);
+  return rs ? rs->nDroppedPacketsBeforeEnqueue + rs->nDroppedPacketsAfterDequeue : 0;
 }
 
 uint64_t
 QueueDisc::Stats::GetNDroppedBytes (std::string reason) const
 {
-  uint64_t count = 0;
-  auto it = nDroppedBytesBeforeEnqueue.find (reason);
-
-  if (it != nDroppedBytesBeforeEnqueue.end ())
-    {
-      count += it->second;
-    }
-
-  it = nDroppedBytesAfterDequeue.find (reason);
-
-  if (it != nDroppedBytesAfterDequeue.end ())
-    {
-      count += it->second;
-    }
-
-  return count;
+  const ReasonStats *rs = FindReasonStats (*this, reason);
+  return rs ? rs->nDroppedBytesBeforeEnqueue + rs->nDroppedBytesAfterDequeue : 0;
 }
 
 uint32_t
 QueueDisc::Stats::GetNMarkedPackets (std::string reason) const
 {
-  auto it = nMarkedPackets.find (reason);
-
-  if (it != nMarkedPackets.end ())
-    {
-      return it->second;
-    }
-
-  return 0;
+  const ReasonStats *rs = FindReasonStats (*this, reason);
+  return rs ? rs->nMarkedPackets : 0;
 }
 
 uint64_t
 QueueDisc::Stats::GetNMarkedBytes (std::string reason) const
 {
-  auto it = nMarkedBytes.find (reason);
+  const ReasonStats *rs = FindReasonStats (*this, reason);
+  return rs ? rs->nMarkedBytes : 0;
+}
 
-  if (it != nMarkedBytes.end ())
+Time
+QueueDisc::Stats::GetMeanSojournTime (void) const
+{
+  uint64_t count = 0;
+  for (uint32_t i = 0; i < SOJOURN_TIME_BINS; i++)
     {
-      return it->second;
+      count += nSojournTimes[i];
     }
+  if (count == 0)
+    {
+      return Seconds (0);
+    }
+  return NanoSeconds (totalSojournTime.GetNanoSeconds () / static_cast<int64_t> (count));
+}
 
-  return 0;
+Time
+QueueDisc::Stats::GetSojournTimeQuantile (double q) const
+{
+  NS_ASSERT_MSG (q >= 0 && q <= 1, "The quantile must be between 0 and 1");
+  uint64_t count = 0;
+  for (uint32_t i = 0; i < SOJOURN_TIME_BINS; i++)
+    {
+      count += nSojournTimes[i];
+    }
+  if (count == 0)
+    {
+      return Seconds (0);
+    }
+  // rank, starting from 1, of the sojourn time to find
+  uint64_t rank = std::max<uint64_t> (static_cast<uint64_t> (std::ceil (q * count)), 1);
+  uint64_t cumulated = 0;
+  for (uint32_t i = 0; i < SOJOURN_TIME_BINS - 1; i++)
+    {
+      cumulated += nSojournTimes[i];
+      if (cumulated >= rank)
+        {
+          return NanoSeconds (i == 0 ? 0 : static_cast<int64_t> (1) << i);
+        }
+    }
+  return NanoSeconds (static_cast<int64_t> (1) << (SOJOURN_TIME_BINS - 2));
 }
 
 void
@@ -252,6 +327,11 @@ QueueDisc::Stats::Print (std::ostream &os) const
       itb++;
     }
 
+  os << std::endl << "Mean sojourn time: " << GetMeanSojournTime ().As (Time::MS)
+     << std::endl << "Sojourn time median / 99th percentile (upper bounds): "
+                  << GetSojournTimeQuantile (0.5).As (Time::MS) << " / "
+                  << GetSojournTimeQuantile (0.99).As (Time::MS);
+
   os << std::endl;
 }
 
@@ -355,13 +435,11 @@ QueueDisc::QueueDisc (QueueDiscSizePolicy policy)
   // the packet is dropped.
   m_childQueueDiscDbeFunctor = [this] (Ptr<const QueueDiscItem> item, const char* r)
     {
-      return DropBeforeEnqueue (item,
-                                m_childQueueDiscDropMsg.assign (CHILD_QUEUE_DISC_DROP).append (r).data ());
+      return DropBeforeEnqueue (item, GetChildDropReason (r));
     };
   m_childQueueDiscDadFunctor = [this] (Ptr<const QueueDiscItem> item, const char* r)
     {
-      return DropAfterDequeue (item,
-                               m_childQueueDiscDropMsg.assign (CHILD_QUEUE_DISC_DROP).append (r).data ());
+      return DropAfterDequeue (item, GetChildDropReason (r));
     };
 }
 
@@ -387,6 +465,8 @@ QueueDisc::DoDispose (void)
   m_device = 0;
   m_devQueueIface = 0;
   m_requeued = 0;
+  m_reasonCache.clear ();
+  m_childReasonCodes.clear ();
   Object::DoDispose ();
 }
 
@@ -433,6 +513,36 @@ QueueDisc::GetStats (void)
   m_stats.nTotalSentBytes = m_stats.nTotalDequeuedBytes - (m_requeued ? m_requeued->GetSize () : 0)
                             - m_stats.nTotalDroppedBytesAfterDequeue;
 
+  // the counters for each reason are kept in an array indexed by reason code,
+  // the maps are only filled here for the users of the string-keyed statistics
+  const QueueDiscReasonTable &table = GetReasonTable ();
+  m_stats.nDroppedPacketsBeforeEnqueue.clear ();
+  m_stats.nDroppedPacketsAfterDequeue.clear ();
+  m_stats.nDroppedBytesBeforeEnqueue.clear ();
+  m_stats.nDroppedBytesAfterDequeue.clear ();
+  m_stats.nMarkedPackets.clear ();
+  m_stats.nMarkedBytes.clear ();
+  for (uint16_t code = 0; code < m_stats.reasons.size (); code++)
+    {
+      const Stats::ReasonStats &rs = m_stats.reasons[code];
+      const std::string &reason = table.reasons[code];
+      if (rs.nDroppedPacketsBeforeEnqueue > 0)
+        {
+          m_stats.nDroppedPacketsBeforeEnqueue[reason] = rs.nDroppedPacketsBeforeEnqueue;
+          m_stats.nDroppedBytesBeforeEnqueue[reason] = rs.nDroppedBytesBeforeEnqueue;
+        }
+      if (rs.nDroppedPacketsAfterDequeue > 0)
+        {
+          m_stats.nDroppedPacketsAfterDequeue[reason] = rs.nDroppedPacketsAfterDequeue;
+          m_stats.nDroppedBytesAfterDequeue[reason] = rs.nDroppedBytesAfterDequeue;
+        }
+      if (rs.nMarkedPackets > 0)
+        {
+          m_stats.nMarkedPackets[reason] = rs.nMarkedPackets;
+          m_stats.nMarkedBytes[reason] = rs.nMarkedBytes;
+        }
+    }
+
   return m_stats;
 }
 
@@ -701,43 +811,100 @@ QueueDisc::PacketDequeued (Ptr<const QueueDiscItem> item)
       m_stats.nTotalDequeuedPackets++;
       m_stats.nTotalDequeuedBytes += item->GetSize ();
 
-      m_sojourn (Simulator::Now () - item->GetTimeStamp ());
+      Time sojourn = Simulator::Now () - item->GetTimeStamp ();
+      int64_t ns = sojourn.GetNanoSeconds ();
+      // bin 0 for null sojourn times, then one bin for each power of two
+      uint32_t bin = 0;
+      if (ns > 0)
+        {
+          bin = std::min<uint32_t> (64 - __builtin_clzll (ns), Stats::SOJOURN_TIME_BINS - 1);
+        }
+      m_stats.nSojournTimes[bin]++;
+      m_stats.totalSojournTime += sojourn;
+
+      m_sojourn (sojourn);
 
       NS_LOG_LOGIC ("m_traceDequeue (p)");
       m_traceDequeue (item);
     }
 }
 
-void
-QueueDisc::DropBeforeEnqueue (Ptr<const QueueDiscItem> item, const char* reason)
-{
-  NS_LOG_FUNCTION (this << item << reason);
+const uint16_t QueueDisc::NO_REASON;
 
-  m_stats.nTotalDroppedPackets++;
-  m_stats.nTotalDroppedBytes += item->GetSize ();
-  m_stats.nTotalDroppedPacketsBeforeEnqueue++;
-  m_stats.nTotalDroppedBytesBeforeEnqueue += item->GetSize ();
+uint16_t
+QueueDisc::GetReasonCode (const char* reason)
+{
+  NS_LOG_FUNCTION (this << reason);
+  const QueueDiscReasonTable &table = GetReasonTable ();
+
+  // the reasons are usually string constants, hence they are first looked up
+  // by address, and the comparison of the strings only guards against a
+  // buffer reused for another reason
+  for (std::vector<ReasonCacheEntry>::iterator it = m_reasonCache.begin ();
+       it != m_reasonCache.end (); it++)
+    {
+      if (it->m_reason == reason)
+        {
+          if (std::strcmp (table.reasons[it->m_code].c_str (), reason) != 0)
+            {
+              it->m_code = InternReason (reason);
+            }
+          return it->m_code;
+        }
+    }
 
-  // update the number of packets dropped for the given reason
-  std::map<std::string, uint32_t>::iterator itp = m_stats.nDroppedPacketsBeforeEnqueue.find (reason);
-  if (itp != m_stats.nDroppedPacketsBeforeEnqueue.end ())
+  uint16_t code = InternReason (reason);
+  if (m_reasonCache.size () < REASON_CACHE_SIZE)
     {
-      itp->second++;
+      ReasonCacheEntry entry;
+      entry.m_reason = reason;
+      entry.m_code = code;
+      m_reasonCache.push_back (entry);
     }
-  else
+  return code;
+}
+
+QueueDisc::Stats::ReasonStats&
+QueueDisc::GetReasonStats (uint16_t code)
+{
+  if (code >= m_stats.reasons.size ())
     {
-      m_stats.nDroppedPacketsBeforeEnqueue[reason] = 1;
+      m_stats.reasons.resize (code + 1);
     }
-  // update the amount of bytes dropped for the given reason
-  std::map<std::string, uint64_t>::iterator itb = m_stats.nDroppedBytesBeforeEnqueue.find (reason);
-  if (itb != m_stats.nDroppedBytesBeforeEnqueue.end ())
+  return m_stats.reasons[code];
+}
+
+const char*
+QueueDisc::GetChildDropReason (const char* reason)
+{
+  NS_LOG_FUNCTION (this << reason);
+  uint16_t code = GetReasonCode (reason);
+  if (code >= m_childReasonCodes.size ())
     {
-      itb->second += item->GetSize ();
+      m_childReasonCodes.resize (code + 1, NO_REASON);
     }
-  else
+  if (m_childReasonCodes[code] == NO_REASON)
     {
-      m_stats.nDroppedBytesBeforeEnqueue[reason] = item->GetSize ();
+      m_childReasonCodes[code] = InternReason (std::string (CHILD_QUEUE_DISC_DROP) + reason);
     }
+  // the strings of the table are never moved nor removed
+  return GetReasonTable ().reasons[m_childReasonCodes[code]].c_str ();
+}
+
+void
+QueueDisc::DropBeforeEnqueue (Ptr<const QueueDiscItem> item, const char* reason)
+{
+  NS_LOG_FUNCTION (this << item << reason);
+
+  m_stats.nTotalDroppedPackets++;
+  m_stats.nTotalDroppedBytes += item->GetSize ();
+  m_stats.nTotalDroppedPacketsBeforeEnqueue++;
+  m_stats.nTotalDroppedBytesBeforeEnqueue += item->GetSize ();
+
+  // update the number of packets and bytes dropped for the given reason
+  Stats::ReasonStats &rs = GetReasonStats (GetReasonCode (reason));
+  rs.nDroppedPacketsBeforeEnqueue++;
+  rs.nDroppedBytesBeforeEnqueue += item->GetSize ();
 
   NS_LOG_DEBUG ("Total packets/bytes dropped before enqueue: "
                 << m_stats.nTotalDroppedPacketsBeforeEnqueue << " / "
@@ -757,26 +924,10 @@ QueueDisc::DropAfterDequeue (Ptr<const QueueDiscItem> item, const char* reason)
   m_stats.nTotalDroppedPacketsAfterDequeue++;
   m_stats.nTotalDroppedBytesAfterDequeue += item->GetSize ();
 
-  // update the number of packets dropped for the given reason
-  std::map<std::string, uint32_t>::iterator itp = m_stats.nDroppedPacketsAfterDequeue.find (reason);
-  if (itp != m_stats.nDroppedPacketsAfterDequeue.end ())
-    {
-      itp->second++;
-    }
-  else
-    {
-      m_stats.nDroppedPacketsAfterDequeue[reason] = 1;
-    }
-  // update the amount of bytes dropped for the given reason
-  std::map<std::string, uint64_t>::iterator itb = m_stats.nDroppedBytesAfterDequeue.find (reason);
-  if (itb != m_stats.nDroppedBytesAfterDequeue.end ())
-    {
-      itb->second += item->GetSize ();
-    }
-  else
-    {
-      m_stats.nDroppedBytesAfterDequeue[reason] = item->GetSize ();
-    }
+  // update the number of packets and bytes dropped for the given reason
+  Stats::ReasonStats &rs = GetReasonStats (GetReasonCode (reason));
+  rs.nDroppedPacketsAfterDequeue++;
+  rs.nDroppedBytesAfterDequeue += item->GetSize ();
 
   // if in the context of a peek request a dequeued packet is dropped, we need
   // to update the statistics and fire the dequeue trace before firing the drop
@@ -812,26 +963,10 @@ QueueDisc::Mark (Ptr<QueueDiscItem> item, const char* reason)
   m_stats.nTotalMarkedPackets++;
   m_stats.nTotalMarkedBytes += item->GetSize ();
 
-  // update the number of packets marked for the given reason
-  std::map<std::string, uint32_t>::iterator itp = m_stats.nMarkedPackets.find (reason);
-  if (itp != m_stats.nMarkedPackets.end ())
-    {
-      itp->second++;
-    }
-  else
-    {
-      m_stats.nMarkedPackets[reason] = 1;
-    }
-  // update the amount of bytes marked for the given reason
-  std::map<std::string, uint64_t>::iterator itb = m_stats.nMarkedBytes.find (reason);
-  if (itb != m_stats.nMarkedBytes.end ())
-    {
-      itb->second += item->GetSize ();
-    }
-  else
-    {
-      m_stats.nMarkedBytes[reason] = item->GetSize ();
-    }
+  // update the number of packets and bytes marked for the given reason
+  Stats::ReasonStats &rs = GetReasonStats (GetReasonCode (reason));
+  rs.nMarkedPackets++;
+  rs.nMarkedBytes += item->GetSize ();
 
   NS_LOG_DEBUG ("Total packets/bytes marked: "
                 << m_stats.nTotalMarkedPackets << " / "
@@ -26,6 +26,7 @@
 #include "ns3/net-device.h"
 #include "ns3/queue-item.h"
 #include "ns3/queue-size.h"
+#include "ns3/nstime.h"
 #include <vector>
 #include <map>
 #include <functional>
@@ -167,14 +168,18 @@ enum QueueDiscSizePolicy
  * When a packet is dropped by an internal queue, e.g., because the queue is full,
  * the reason is "Dropped by internal queue". When a packet is dropped by a child
  * queue disc, the reason is "(Dropped by child queue disc) " followed by the
- * reason why the child queue disc dropped the packet.
+ * reason why the child queue disc dropped the packet.  The reasons are interned
+ * in a table shared by all the queue discs, so that a drop or a mark only
+ * increments counters in an array indexed by the code of its reason.
  *
  * The QueueDisc base class provides the SojournTime trace source, which provides
  * the sojourn time of every packet dequeued from a queue disc, including packets
  * that are dropped or requeued after being dequeued. The sojourn time is taken
  * when the packet is dequeued from the queue disc, hence it does not account for
  * the additional time the packet is retained within the traffic control
- * infrastructure in case it is requeued.
+ * infrastructure in case it is requeued.  The statistics also include a
+ * histogram of the sojourn times of the dequeued packets, with bins
+ * growing in powers of two.
  *
  * The design and implementation of this class is heavily inspired by Linux.
  * For more details, see the traffic-control model page.
@@ -185,6 +190,23 @@ public:
   /// \brief Structure that keeps the queue disc statistics
   struct Stats
   {
+    /// \brief Counters kept for a reason to drop or mark packets
+    struct ReasonStats
+    {
+      uint32_t nDroppedPacketsBeforeEnqueue;  //!< Packets dropped before enqueue
+      uint64_t nDroppedBytesBeforeEnqueue;    //!< Bytes dropped before enqueue
+      uint32_t nDroppedPacketsAfterDequeue;   //!< Packets dropped after dequeue
+      uint64_t nDroppedBytesAfterDequeue;     //!< Bytes dropped after dequeue
+      uint32_t nMarkedPackets;                //!< Marked packets
+      uint64_t nMarkedBytes;                  //!< Marked bytes
+
+      /// constructor
+      ReasonStats ();
+    };
+
+    /// Number of bins of the sojourn time histogram
+    static const uint32_t SOJOURN_TIME_BINS = 40;
+
     /// Total received packets
     uint32_t nTotalReceivedPackets;
     /// Total received bytes
@@ -205,21 +227,21 @@ public:
     uint32_t nTotalDroppedPackets;
     /// Total packets dropped before enqueue
     uint32_t nTotalDroppedPacketsBeforeEnqueue;
-    /// Packets dropped before enqueue, for each reason
+    /// Packets dropped before enqueue, for each reason -- this value is not kept up to date, call GetStats first
     std::map<std::string, uint32_t> nDroppedPacketsBeforeEnqueue;
     /// Total packets dropped after dequeue
     uint32_t nTotalDroppedPacketsAfterDequeue;
-    /// Packets dropped after dequeue, for each reason
+    /// Packets dropped after dequeue, for each reason -- this value is not kept up to date, call GetStats first
     std::map<std::string, uint32_t> nDroppedPacketsAfterDequeue;
     /// Total dropped bytes
     uint64_t nTotalDroppedBytes;
     /// Total bytes dropped before enqueue
     uint64_t nTotalDroppedBytesBeforeEnqueue;
-    /// Bytes dropped before enqueue, for each reason
+    /// Bytes dropped before enqueue, for each reason -- this value is not kept up to date, call GetStats first
     std::map<std::string, uint64_t> nDroppedBytesBeforeEnqueue;
     /// Total bytes dropped after dequeue
     uint64_t nTotalDroppedBytesAfterDequeue;
-    /// Bytes dropped after dequeue, for each reason
+    /// Bytes dropped after dequeue, for each reason -- this value is not kept up to date, call GetStats first
     std::map<std::string, uint64_t> nDroppedBytesAfterDequeue;
     /// Total requeued packets
     uint32_t nTotalRequeuedPackets;
@@ -227,12 +249,22 @@ public:
     uint64_t nTotalRequeuedBytes;
     /// Total marked packets
     uint32_t nTotalMarkedPackets;
-    /// Marked packets, for each reason
+    /// Marked packets, for each reason -- this value is not kept up to date, call GetStats first
     std::map<std::string, uint32_t> nMarkedPackets;
     /// Total marked bytes
     uint32_t nTotalMarkedBytes;
-    /// Marked bytes, for each reason
+    /// Marked bytes, for each reason -- this value is not kept up to date, call GetStats first
     std::map<std::string, uint64_t> nMarkedBytes;
+    /// Counters for each reason to drop or mark packets, indexed by reason code
+    std::vector<ReasonStats> reasons;
+    /**
+     * Dequeued packets, by sojourn time: bin 0 counts the null sojourn times,
+     * bin i > 0 the sojourn times in [2^(i-1), 2^i) ns, and the last bin also
+     * the longer ones
+     */
+    uint32_t nSojournTimes[SOJOURN_TIME_BINS];
+    /// Sum of the sojourn times of the dequeued packets
+    Time totalSojournTime;
 
     /// constructor
     Stats ();
@@ -261,6 +293,19 @@ public:
      * \return the amount of bytes marked for the given reason
      */
     uint64_t GetNMarkedBytes (std::string reason) const;
+    /**
+     * \brief Get the mean sojourn time of the dequeued packets
+     * \return the mean sojourn time, or zero if no packet was dequeued
+     */
+    Time GetMeanSojournTime (void) const;
+    /**
+     * \brief Get an upper bound of a quantile of the sojourn times of the
+     * dequeued packets, from the sojourn time histogram
+     * \param q the quantile, between 0 and 1
+     * \return the upper end of the bin holding the quantile, or, for the
+     * last bin, its lower end, or zero if no packet was dequeued
+     */
+    Time GetSojournTimeQuantile (double q) const;
     /**
      * \brief Print the statistics.
      * \param os output stream in which the data should be printed.
@@ -538,7 +583,51 @@ protected:
    */
   bool Mark (Ptr<QueueDiscItem> item, const char* reason);
 
+  /**
+   *  \brief Perform the actions required when the queue disc is notified of
+   *         a packet enqueue
+   *  \param item item that was enqueued
+   *  The internal queues and the child queue discs call this method through
+   *  their traces.  Subclasses storing packets by themselves must call it
+   *  when they store a packet.
+   */
+  void PacketEnqueued (Ptr<const QueueDiscItem> item);
+
+  /**
+   *  \brief Perform the actions required when the queue disc is notified of
+   *         a packet dequeue
+   *  \param item item that was dequeued
+   *  The internal queues and the child queue discs call this method through
+   *  their traces.  Subclasses storing packets by themselves must call it
+   *  when they remove a packet, including a packet about to be dropped.
+   */
+  void PacketDequeued (Ptr<const QueueDiscItem> item);
+
 private:
+  /**
+   * \brief Get the code of a reason to drop or mark packets, interning it
+   * if needed.  Reasons recently looked up are found by the address of
+   * their string, without hashing or copying it.
+   * \param reason the reason
+   * \return the reason code
+   */
+  uint16_t GetReasonCode (const char* reason);
+
+  /**
+   * \brief Get the counters of a reason
+   * \param code the reason code
+   * \return the counters
+   */
+  Stats::ReasonStats& GetReasonStats (uint16_t code);
+
+  /**
+   * \brief Get the reason recorded for a packet dropped by a child queue disc
+   * \param reason the reason why the child queue disc dropped the packet
+   * \return the reason prefixed by CHILD_QUEUE_DISC_DROP, as a string
+   * which remains valid until the end of the simulation
+   */
+  const char* GetChildDropReason (const char* reason);
+
   /**
    * \brief Copy constructor
    * \param o object to copy
@@ -644,20 +733,6 @@ private:
    */
   bool Transmit (Ptr<QueueDiscItem> item);
 
-  /**
-   *  \brief Perform the actions required when the queue disc is notified of
-   *         a packet enqueue
-   *  \param item item that was enqueued
-   */
-  void PacketEnqueued (Ptr<const QueueDiscItem> item);
-
-  /**
-   *  \brief Perform the actions required when the queue disc is notified of
-   *         a packet dequeue
-   *  \param item item that was dequeued
-   */
-  void PacketDequeued (Ptr<const QueueDiscItem> item);
-
   static const uint32_t DEFAULT_QUOTA = 64; //!< Default quota (as in /proc/sys/net/core/dev_weight)
 
   std::vector<Ptr<InternalQueue> > m_queues;    //!< Internal queues
@@ -676,7 +751,17 @@ private:
   bool m_running;                   //!< The queue disc is performing multiple dequeue operations
   Ptr<QueueDiscItem> m_requeued;    //!< The last packet that failed to be transmitted
   bool m_peeked;                    //!< A packet was dequeued because Peek was called
-  std::string m_childQueueDiscDropMsg;  //!< Reason why a packet was dropped by a child queue disc
+  static const uint32_t REASON_CACHE_SIZE = 16;  //!< Maximum number of reasons looked up by address
+  static const uint16_t NO_REASON = 0xffff;      //!< No reason code
+
+  /// A reason recently looked up, by the address of its string
+  struct ReasonCacheEntry
+  {
+    const char* m_reason;  //!< The reason string
+    uint16_t m_code;       //!< The reason code
+  };
+  std::vector<ReasonCacheEntry> m_reasonCache;  //!< Reasons recently looked up
+  std::vector<uint16_t> m_childReasonCodes;     //!< Code of each reason prefixed by CHILD_QUEUE_DISC_DROP, by code of the reason
   QueueDiscSizePolicy m_sizePolicy;     //!< The queue disc size policy
   bool m_prohibitChangeMode;            //!< True if changing mode is prohibited
 
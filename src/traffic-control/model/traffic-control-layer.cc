@@ -24,6 +24,8 @@
 #include "ns3/packet.h"
 #include "ns3/socket.h"
 #include "ns3/queue-disc.h"
+#include "ns3/boolean.h"
+#include "ns3/simulator.h"
 #include <tuple>
 
 namespace ns3 {
@@ -44,6 +46,13 @@ TrafficControlLayer::GetTypeId (void)
                    MakeObjectMapAccessor (&TrafficControlLayer::GetNDevices,
                                           &TrafficControlLayer::GetRootQueueDiscOnDeviceByIndex),
                    MakeObjectMapChecker<QueueDisc> ())
+    .AddAttribute ("DeferRun",
+                   "If true, the queue disc of the TX queue selected for a packet is run by "
+                   "an event scheduled at the current time, at most one per TX queue, "
+                   "rather than right after the packet is enqueued.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TrafficControlLayer::m_deferRun),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
@@ -55,7 +64,8 @@ TrafficControlLayer::GetInstanceTypeId (void) const
 }
 
 TrafficControlLayer::TrafficControlLayer ()
-  : Object ()
+  : Object (),
+    m_deferRun (false)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -71,6 +81,11 @@ TrafficControlLayer::DoDispose (void)
   NS_LOG_FUNCTION (this);
   m_node = 0;
   m_handlers.clear ();
+  for (NetDeviceInfoMap::iterator ndi = m_netDevices.begin (); ndi != m_netDevices.end (); ndi++)
+    {
+      CancelRuns (ndi->second);
+    }
+  m_netDevicesByIfIndex.clear ();
   m_netDevices.clear ();
   Object::DoDispose ();
 }
@@ -95,7 +110,7 @@ void
 TrafficControlLayer::DoInitialize (void)
 {
   NS_LOG_FUNCTION (this);
-  std::map<Ptr<NetDevice>, NetDeviceInfo>::iterator ndi;
+  NetDeviceInfoMap::iterator ndi;
   for (ndi = m_netDevices.begin (); ndi != m_netDevices.end (); ndi++)
     {
       Ptr<NetDeviceQueueInterface> devQueueIface = ndi->second.m_ndqi;
@@ -123,6 +138,7 @@ TrafficControlLayer::DoInitialize (void)
                   ndi->second.m_queueDiscsToWake.push_back (ndi->second.m_rootQueueDisc->GetQueueDiscClass (i)->GetQueueDisc ());
                 }
             }
+          ndi->second.m_runEvents.resize (ndi->second.m_queueDiscsToWake.size ());
 
           // initialize the queue disc
           ndi->second.m_rootQueueDisc->Initialize ();
@@ -165,9 +181,55 @@ TrafficControlLayer::SetupDevice (Ptr<NetDevice> device)
   NS_ASSERT_MSG (m_netDevices.find (device) == m_netDevices.end (), "This is a bug,"
                  << "  SetupDevice only can insert an entry in the m_netDevices map");
 
-  m_netDevices.emplace (std::piecewise_construct,
-                        std::forward_as_tuple (device),
-                        std::forward_as_tuple ((Ptr<QueueDisc>) 0, devQueueIface, QueueDiscVector (), cb));
+  NetDeviceInfoMap::iterator ndi;
+  std::tie (ndi, std::ignore) = m_netDevices.emplace (std::piecewise_construct,
+                                                      std::forward_as_tuple (device),
+                                                      std::forward_as_tuple ((Ptr<QueueDisc>) 0, devQueueIface,
+                                                                             QueueDiscVector (), cb));
+
+  // the entries of a map are never moved, hence they can be indexed by the
+  // interface index of their device to avoid a map lookup for every packet
+  uint32_t index = device->GetIfIndex ();
+  if (index >= m_netDevicesByIfIndex.size ())
+    {
+      m_netDevicesByIfIndex.resize (index + 1, 0);
+    }
+  if (m_netDevicesByIfIndex[index] == 0)
+    {
+      m_netDevicesByIfIndex[index] = &*ndi;
+    }
+}
+
+TrafficControlLayer::NetDeviceInfoMap::value_type *
+TrafficControlLayer::GetNetDeviceInfo (Ptr<NetDevice> device)
+{
+  uint32_t index = device->GetIfIndex ();
+  if (index < m_netDevicesByIfIndex.size ()
+      && m_netDevicesByIfIndex[index] != 0
+      && m_netDevicesByIfIndex[index]->first == device)
+    {
+      return m_netDevicesByIfIndex[index];
+    }
+
+  // the interface index of a device that does not belong to the node of
+  // this layer may collide with the one of another device
+  NetDeviceInfoMap::iterator ndi = m_netDevices.find (device);
+  if (ndi == m_netDevices.end ())
+    {
+      return 0;
+    }
+  return &*ndi;
+}
+
+void
+TrafficControlLayer::CancelRuns (NetDeviceInfo &info)
+{
+  for (std::vector<EventId>::iterator it = info.m_runEvents.begin ();
+       it != info.m_runEvents.end (); it++)
+    {
+      it->Cancel ();
+    }
+  info.m_runEvents.clear ();
 }
 
 void
@@ -193,7 +255,7 @@ TrafficControlLayer::SetRootQueueDiscOnDevice (Ptr<NetDevice> device, Ptr<QueueD
 {
   NS_LOG_FUNCTION (this << device << qDisc);
 
-  std::map<Ptr<NetDevice>, NetDeviceInfo>::iterator ndi = m_netDevices.find (device);
+  NetDeviceInfoMap::iterator ndi = m_netDevices.find (device);
 
   if (ndi == m_netDevices.end ())
     {
@@ -216,7 +278,7 @@ TrafficControlLayer::GetRootQueueDiscOnDevice (Ptr<NetDevice> device) const
 {
   NS_LOG_FUNCTION (this << device);
 
-  std::map<Ptr<NetDevice>, NetDeviceInfo>::const_iterator ndi = m_netDevices.find (device);
+  NetDeviceInfoMap::const_iterator ndi = m_netDevices.find (device);
 
   if (ndi == m_netDevices.end ())
     {
@@ -237,12 +299,13 @@ TrafficControlLayer::DeleteRootQueueDiscOnDevice (Ptr<NetDevice> device)
 {
   NS_LOG_FUNCTION (this << device);
 
-  std::map<Ptr<NetDevice>, NetDeviceInfo>::iterator ndi = m_netDevices.find (device);
+  NetDeviceInfoMap::iterator ndi = m_netDevices.find (device);
 
   NS_ASSERT_MSG (ndi != m_netDevices.end () && ndi->second.m_rootQueueDisc != 0, "No root queue disc"
                  << " installed on device " << device);
 
   // remove the root queue disc
+  CancelRuns (ndi->second);
   ndi->second.m_rootQueueDisc = 0;
   ndi->second.m_queueDiscsToWake.clear ();
 }
@@ -320,9 +383,9 @@ TrafficControlLayer::Send (Ptr<NetDevice> device, Ptr<QueueDiscItem> item)
   NS_LOG_DEBUG ("Send packet to device " << device << " protocol number " <<
                 item->GetProtocol ());
 
-  std::map<Ptr<NetDevice>, NetDeviceInfo>::iterator ndi = m_netDevices.find (device);
-  NS_ASSERT (ndi != m_netDevices.end ());
-  Ptr<NetDeviceQueueInterface> devQueueIface = ndi->second.m_ndqi;
+  NetDeviceInfoMap::value_type *ndi = GetNetDeviceInfo (device);
+  NS_ASSERT (ndi != 0);
+  const Ptr<NetDeviceQueueInterface> &devQueueIface = ndi->second.m_ndqi;
   NS_ASSERT (devQueueIface);
 
   // determine the transmission queue of the device where the packet will be enqueued
@@ -365,10 +428,19 @@ TrafficControlLayer::Send (Ptr<NetDevice> device, Ptr<QueueDiscItem> item)
       // selected for the packet and try to dequeue packets from such queue disc
       item->SetTxQueueIndex (txq);
 
-      Ptr<QueueDisc> qDisc = ndi->second.m_queueDiscsToWake[txq];
+      const Ptr<QueueDisc> &qDisc = ndi->second.m_queueDiscsToWake[txq];
       NS_ASSERT (qDisc);
       qDisc->Enqueue (item);
-      qDisc->Run ();
+      if (!m_deferRun)
+        {
+          qDisc->Run ();
+        }
+      else if (!ndi->second.m_runEvents[txq].IsRunning ())
+        {
+          // the packets enqueued for this TX queue before the event expires
+          // are dequeued by the same run
+          ndi->second.m_runEvents[txq] = Simulator::ScheduleNow (&QueueDisc::Run, qDisc);
+        }
     }
 }
 
@@ -24,6 +24,7 @@
 #include "ns3/net-device.h"
 #include "ns3/node.h"
 #include "ns3/queue-item.h"
+#include "ns3/event-id.h"
 #include <map>
 #include <vector>
 
@@ -85,6 +86,15 @@ class NetDeviceQueueInterface;
  * Discrimination through callbacks (in other words: what is the right upper-layer
  * callback for this packet?) is done through checks over the device and the
  * protocol number.
+ *
+ * In the OUT direction, the information kept for each device is found through
+ * an array indexed by the interface index of the device, so that sending a
+ * packet does not require a lookup in the map of devices. If the DeferRun
+ * attribute is set, the queue disc associated with the TX queue selected for
+ * a packet is not run right after the packet is enqueued, but by an event
+ * scheduled at the current time. At most one such event is pending for each
+ * TX queue, hence a burst of packets sent at the same time is dequeued by
+ * a single run, and the dequeues of distinct TX queues are distinct events.
  */
 class TrafficControlLayer : public Object
 {
@@ -249,6 +259,7 @@ private:
     Ptr<NetDeviceQueueInterface> m_ndqi;  //!< the netdevice queue interface
     QueueDiscVector m_queueDiscsToWake;   //!< the vector of queue discs to wake
     SelectQueueCallback m_selectQueueCallback;  //!< the select queue callback
+    std::vector<EventId> m_runEvents;     //!< the pending run of each TX queue, if DeferRun is set
   private:
     NetDeviceInfo ();
     /**
@@ -267,6 +278,23 @@ private:
   /// Typedef for protocol handlers container
   typedef std::vector<struct ProtocolHandlerEntry> ProtocolHandlerList;
 
+  /// Typedef for the map storing the information for each device
+  typedef std::map<Ptr<NetDevice>, NetDeviceInfo> NetDeviceInfoMap;
+
+  /**
+   * \brief Get the information stored for a device
+   * \param device the device
+   * \return the entry of the device in the m_netDevices map, or 0 if the
+   *         device has not been set up
+   */
+  NetDeviceInfoMap::value_type *GetNetDeviceInfo (Ptr<NetDevice> device);
+
+  /**
+   * \brief Cancel the pending runs of the TX queues of a device
+   * \param info the information stored for the device
+   */
+  static void CancelRuns (NetDeviceInfo &info);
+
   /**
    * \brief Required by the object map accessor
    * \return the number of devices in the m_netDevices map
@@ -282,8 +310,11 @@ private:
   /// The node this TrafficControlLayer object is aggregated to
   Ptr<Node> m_node;
   /// Map storing the required information for each device with a queue disc installed
-  std::map<Ptr<NetDevice>, NetDeviceInfo> m_netDevices;
+  NetDeviceInfoMap m_netDevices;
+  /// Entries of the m_netDevices map, indexed by the interface index of their device
+  std::vector<NetDeviceInfoMap::value_type *> m_netDevicesByIfIndex;
   ProtocolHandlerList m_handlers;  //!< List of upper-layer handlers
+  bool m_deferRun;                 //!< True if the TX queues are run by scheduled events
 };
 
 } // namespace ns3
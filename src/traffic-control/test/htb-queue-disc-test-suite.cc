@@ -0,0 +1,251 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/htb-queue-disc.h"
+#include "ns3/fifo-queue-disc.h"
+#include "ns3/packet-filter.h"
+#include "ns3/packet.h"
+#include "ns3/integer.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/pointer.h"
+#include "ns3/simulator.h"
+#include "ns3/node-container.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-channel.h"
+#include "ns3/traffic-control-layer.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Htb Queue Disc Test Item
+ */
+class HtbQueueDiscTestItem : public QueueDiscItem
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param p the packet
+   * \param addr the address
+   */
+  HtbQueueDiscTestItem (Ptr<Packet> p, const Address & addr);
+  virtual ~HtbQueueDiscTestItem ();
+  virtual void AddHeader (void);
+  virtual bool Mark (void);
+};
+
+HtbQueueDiscTestItem::HtbQueueDiscTestItem (Ptr<Packet> p, const Address & addr)
+  : QueueDiscItem (p, addr, 0)
+{
+}
+
+HtbQueueDiscTestItem::~HtbQueueDiscTestItem ()
+{
+}
+
+void
+HtbQueueDiscTestItem::AddHeader (void)
+{
+}
+
+bool
+HtbQueueDiscTestItem::Mark (void)
+{
+  return false;
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Htb Queue Disc Test Packet Filter, classifying the packets of even
+ * size in class 1 and the others in class 2
+ */
+class HtbQueueDiscTestFilter : public PacketFilter
+{
+public:
+  HtbQueueDiscTestFilter ();
+  virtual ~HtbQueueDiscTestFilter ();
+
+private:
+  virtual bool CheckProtocol (Ptr<QueueDiscItem> item) const;
+  virtual int32_t DoClassify (Ptr<QueueDiscItem> item) const;
+};
+
+HtbQueueDiscTestFilter::HtbQueueDiscTestFilter ()
+{
+}
+
+HtbQueueDiscTestFilter::~HtbQueueDiscTestFilter ()
+{
+}
+
+bool
+HtbQueueDiscTestFilter::CheckProtocol (Ptr<QueueDiscItem> item) const
+{
+  return true;
+}
+
+int32_t
+HtbQueueDiscTestFilter::DoClassify (Ptr<QueueDiscItem> item) const
+{
+  return item->GetSize () % 2 == 0 ? 1 : 2;
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Htb Queue Disc Test Case
+ *
+ * An HTB queue disc with a root class of 2 Mbps and two leaf classes of
+ * 0.5 Mbps is installed on a 100 Mbps device. Both leaves are backlogged at
+ * time 0 and the packets sent by each of them in one second are checked,
+ * depending on their ceil rates and priorities. Since no packet is
+ * enqueued after time 0, the packets after the initial bursts are only
+ * sent thanks to the wake timer of the queue disc.
+ */
+class HtbQueueDiscTestCase : public TestCase
+{
+public:
+  HtbQueueDiscTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * Run a scenario and check the number of packets sent by each leaf
+   * \param ceil2 the ceil rate of the second leaf
+   * \param priority2 the priority of the second leaf
+   * \param expected1 the expected number of packets sent by the first leaf
+   * \param expected2 the expected number of packets sent by the second leaf
+   * \param msg the scenario
+   */
+  void RunScenario (DataRate ceil2, uint8_t priority2, uint32_t expected1, uint32_t expected2,
+                    std::string msg);
+  /**
+   * Check the number of packets sent by each leaf
+   * \param qd the queue disc
+   * \param expected1 the expected number of packets sent by the first leaf
+   * \param expected2 the expected number of packets sent by the second leaf
+   * \param msg the scenario
+   */
+  void CheckSent (Ptr<QueueDisc> qd, uint32_t expected1, uint32_t expected2, std::string msg);
+};
+
+HtbQueueDiscTestCase::HtbQueueDiscTestCase ()
+  : TestCase ("Sanity check on the rates, borrowing and priorities of the HTB queue disc")
+{
+}
+
+void
+HtbQueueDiscTestCase::CheckSent (Ptr<QueueDisc> qd, uint32_t expected1, uint32_t expected2, std::string msg)
+{
+  uint32_t sent1 = qd->GetQueueDiscClass (1)->GetQueueDisc ()->GetStats ().nTotalDequeuedPackets;
+  uint32_t sent2 = qd->GetQueueDiscClass (2)->GetQueueDisc ()->GetStats ().nTotalDequeuedPackets;
+  NS_TEST_EXPECT_MSG_EQ_TOL (sent1, expected1, 3, msg << ": unexpected number of packets sent by the first leaf");
+  NS_TEST_EXPECT_MSG_EQ_TOL (sent2, expected2, 3, msg << ": unexpected number of packets sent by the second leaf");
+}
+
+void
+HtbQueueDiscTestCase::RunScenario (DataRate ceil2, uint8_t priority2, uint32_t expected1, uint32_t expected2,
+                                   std::string msg)
+{
+  NodeContainer n;
+  n.Create (2);
+  n.Get (0)->AggregateObject (CreateObject<TrafficControlLayer> ());
+
+  Ptr<SimpleNetDevice> txDev = CreateObjectWithAttributes<SimpleNetDevice> ("DataRate", DataRateValue (DataRate ("100Mbps")));
+  Ptr<SimpleNetDevice> rxDev = CreateObject<SimpleNetDevice> ();
+  n.Get (0)->AddDevice (txDev);
+  n.Get (1)->AddDevice (rxDev);
+  txDev->SetMtu (1500);
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  txDev->SetChannel (channel);
+  rxDev->SetChannel (channel);
+
+  Ptr<HtbQueueDisc> qd = CreateObject<HtbQueueDisc> ();
+  qd->AddPacketFilter (CreateObject<HtbQueueDiscTestFilter> ());
+
+  Ptr<HtbClass> root = CreateObjectWithAttributes<HtbClass> ("Rate", DataRateValue (DataRate ("2Mbps")));
+  Ptr<HtbClass> leaf1 = CreateObjectWithAttributes<HtbClass> ("Rate", DataRateValue (DataRate ("500kbps")),
+                                                              "Ceil", DataRateValue (DataRate ("2Mbps")),
+                                                              "Parent", IntegerValue (0));
+  Ptr<HtbClass> leaf2 = CreateObjectWithAttributes<HtbClass> ("Rate", DataRateValue (DataRate ("500kbps")),
+                                                              "Ceil", DataRateValue (ceil2),
+                                                              "Priority", UintegerValue (priority2),
+                                                              "Parent", IntegerValue (0));
+  Ptr<HtbClass> classes[3] = { root, leaf1, leaf2 };
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      Ptr<QueueDisc> child = CreateObjectWithAttributes<FifoQueueDisc> ("MaxSize", StringValue ("1000p"));
+      child->Initialize ();
+      classes[i]->SetQueueDisc (child);
+      qd->AddQueueDiscClass (classes[i]);
+    }
+
+  Ptr<TrafficControlLayer> tc = n.Get (0)->GetObject<TrafficControlLayer> ();
+  qd->SetNetDevice (txDev);
+  tc->SetRootQueueDiscOnDevice (txDev, qd);
+  tc->Initialize ();
+
+  NS_TEST_EXPECT_MSG_EQ (qd->GetClassLevel (0), 1, "The root class must be at level 1");
+  NS_TEST_EXPECT_MSG_EQ (qd->GetClassLevel (1), 0, "The leaves must be at level 0");
+
+  // 400 packets of 1000 bytes for the first leaf and of 1001 bytes for the second one
+  for (uint32_t i = 0; i < 400; i++)
+    {
+      tc->Send (txDev, Create<HtbQueueDiscTestItem> (Create<Packet> (1000), rxDev->GetAddress ()));
+      tc->Send (txDev, Create<HtbQueueDiscTestItem> (Create<Packet> (1001), rxDev->GetAddress ()));
+    }
+
+  Simulator::Schedule (Seconds (1), &HtbQueueDiscTestCase::CheckSent, this, qd, expected1, expected2, msg);
+  Simulator::Stop (Seconds (1.5));
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+HtbQueueDiscTestCase::DoRun (void)
+{
+  // The root class sends about 250 packets in one second. Each leaf sends
+  // about 62 packets at its own rate, and the leaves share the rest.
+  RunScenario (DataRate ("2Mbps"), 0, 125, 125, "Same ceil rate and priority");
+  // The second leaf cannot borrow
+  RunScenario (DataRate ("500kbps"), 0, 187, 63, "Second leaf without borrowing");
+  // The first leaf borrows first
+  RunScenario (DataRate ("2Mbps"), 1, 187, 63, "Second leaf with a lower priority");
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Htb Queue Disc Test Suite
+ */
+static class HtbQueueDiscTestSuite : public TestSuite
+{
+public:
+  HtbQueueDiscTestSuite ()
+    : TestSuite ("htb-queue-disc", UNIT)
+  {
+    AddTestCase (new HtbQueueDiscTestCase (), TestCase::QUICK);
+  }
+} g_htbQueueDiscTestSuite; ///< the test suite
@@ -559,6 +559,134 @@ QueueDiscTracesTestCase::DoRun (void)
 }
 
 
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Queue Disc Statistics Test Case
+ *
+ * This test case makes use of the same root and child queue discs as the traces
+ * test case. Packets are enqueued and dequeued at different times and the
+ * counters kept for each drop reason, including the reasons of the drops
+ * notified by the child queue disc, and the sojourn time histogram are
+ * compared with the expected values.
+ */
+class QueueDiscStatsTestCase : public TestCase
+{
+public:
+  QueueDiscStatsTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * Enqueue a packet
+   * \param qd the queue disc
+   * \param size the size of the packet
+   */
+  void Enqueue (Ptr<QueueDisc> qd, uint32_t size);
+  /**
+   * Dequeue a packet
+   * \param qd the queue disc
+   */
+  void Dequeue (Ptr<QueueDisc> qd);
+};
+
+QueueDiscStatsTestCase::QueueDiscStatsTestCase ()
+  : TestCase ("Check the statistics kept for each drop reason and the sojourn time histogram")
+{
+}
+
+void
+QueueDiscStatsTestCase::Enqueue (Ptr<QueueDisc> qd, uint32_t size)
+{
+  Address dest;
+  qd->Enqueue (Create<qdTestItem> (Create<Packet> (size), dest));
+}
+
+void
+QueueDiscStatsTestCase::Dequeue (Ptr<QueueDisc> qd)
+{
+  Ptr<QueueDiscItem> item = qd->Dequeue ();
+  NS_TEST_EXPECT_MSG_NE (item, 0, "A packet must have been returned");
+}
+
+void
+QueueDiscStatsTestCase::DoRun (void)
+{
+  uint32_t pktSizeUnit = 100;
+
+  Ptr<QueueDisc> root = CreateObject<TestParentQueueDisc> ();
+  root->Initialize ();
+  Ptr<QueueDisc> child = root->GetQueueDiscClass (0)->GetQueueDisc ();
+
+  // No packet dequeued yet: null sojourn times
+  NS_TEST_EXPECT_MSG_EQ (root->GetStats ().GetMeanSojournTime (), Seconds (0),
+                         "Verify the mean sojourn time without any dequeued packet");
+  NS_TEST_EXPECT_MSG_EQ (root->GetStats ().GetSojournTimeQuantile (0.5), Seconds (0),
+                         "Verify the median sojourn time without any dequeued packet");
+  NS_TEST_EXPECT_MSG_EQ (root->GetStats ().GetSojournTimeQuantile (0.99), Seconds (0),
+                         "Verify the 99th percentile of the sojourn times without any dequeued packet");
+
+  // At time 0, the fifth packet is dropped before enqueue and the first dequeue
+  // drops two packets after dequeue, so that three packets leave the root queue
+  // disc with a null sojourn time. The fourth packet is dequeued after 1 ms,
+  // while the last packet is enqueued at 3 ms and dequeued at 5 ms.
+  for (uint16_t i = 1; i <= 5; i++)
+    {
+      Enqueue (root, pktSizeUnit * i);
+    }
+  Dequeue (root);
+  Simulator::Schedule (MilliSeconds (1), &QueueDiscStatsTestCase::Dequeue, this, root);
+  Simulator::Schedule (MilliSeconds (3), &QueueDiscStatsTestCase::Enqueue, this, root, pktSizeUnit);
+  Simulator::Schedule (MilliSeconds (5), &QueueDiscStatsTestCase::Dequeue, this, root);
+  Simulator::Run ();
+
+  QueueDisc::Stats stats = child->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (stats.GetNDroppedPackets (TestChildQueueDisc::BEFORE_ENQUEUE), 1,
+                         "Verify the number of packets dropped by the child queue disc before enqueue");
+  NS_TEST_EXPECT_MSG_EQ (stats.GetNDroppedBytes (TestChildQueueDisc::BEFORE_ENQUEUE), pktSizeUnit * 5,
+                         "Verify the number of bytes dropped by the child queue disc before enqueue");
+  NS_TEST_EXPECT_MSG_EQ (stats.GetNDroppedPackets (TestChildQueueDisc::AFTER_DEQUEUE), 2,
+                         "Verify the number of packets dropped by the child queue disc after dequeue");
+  NS_TEST_EXPECT_MSG_EQ (stats.GetNDroppedBytes (TestChildQueueDisc::AFTER_DEQUEUE), pktSizeUnit * 3,
+                         "Verify the number of bytes dropped by the child queue disc after dequeue");
+  NS_TEST_EXPECT_MSG_EQ (stats.GetNDroppedPackets ("Unknown reason"), 0,
+                         "Verify that no packet is dropped for an unknown reason");
+
+  std::string beforeEnqueue = std::string (QueueDisc::CHILD_QUEUE_DISC_DROP) + TestChildQueueDisc::BEFORE_ENQUEUE;
+  std::string afterDequeue = std::string (QueueDisc::CHILD_QUEUE_DISC_DROP) + TestChildQueueDisc::AFTER_DEQUEUE;
+
+  stats = root->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (stats.GetNDroppedPackets (beforeEnqueue), 1,
+                         "Verify the number of packets dropped by the child queue disc before enqueue");
+  NS_TEST_EXPECT_MSG_EQ (stats.GetNDroppedBytes (afterDequeue), pktSizeUnit * 3,
+                         "Verify the number of bytes dropped by the child queue disc after dequeue");
+  NS_TEST_EXPECT_MSG_EQ (stats.GetNDroppedPackets (TestChildQueueDisc::BEFORE_ENQUEUE), 0,
+                         "Verify that the drops of the child queue disc are recorded with the prefixed reason");
+  NS_TEST_EXPECT_MSG_EQ (stats.nDroppedPacketsBeforeEnqueue.size (), 1,
+                         "Verify the number of reasons to drop packets before enqueue");
+  NS_TEST_EXPECT_MSG_EQ (stats.nDroppedPacketsBeforeEnqueue[beforeEnqueue], 1,
+                         "Verify the number of packets dropped before enqueue for the given reason");
+  NS_TEST_EXPECT_MSG_EQ (stats.nDroppedBytesAfterDequeue.size (), 1,
+                         "Verify the number of reasons to drop packets after dequeue");
+  NS_TEST_EXPECT_MSG_EQ (stats.nDroppedBytesAfterDequeue[afterDequeue], pktSizeUnit * 3,
+                         "Verify the number of bytes dropped after dequeue for the given reason");
+
+  // 1 ms falls in the bin [2^19, 2^20) ns and 2 ms in the bin [2^20, 2^21) ns
+  NS_TEST_EXPECT_MSG_EQ (stats.nSojournTimes[0], 3, "Verify the number of null sojourn times");
+  NS_TEST_EXPECT_MSG_EQ (stats.nSojournTimes[20], 1, "Verify the number of sojourn times of 1 ms");
+  NS_TEST_EXPECT_MSG_EQ (stats.nSojournTimes[21], 1, "Verify the number of sojourn times of 2 ms");
+  NS_TEST_EXPECT_MSG_EQ (stats.GetMeanSojournTime (), MicroSeconds (600), "Verify the mean sojourn time");
+  NS_TEST_EXPECT_MSG_EQ (stats.GetSojournTimeQuantile (0.5), Seconds (0), "Verify the median sojourn time");
+  NS_TEST_EXPECT_MSG_EQ (stats.GetSojournTimeQuantile (0.7), NanoSeconds (1 << 20),
+                         "Verify the 70th percentile of the sojourn times");
+  NS_TEST_EXPECT_MSG_EQ (stats.GetSojournTimeQuantile (1), NanoSeconds (1 << 21),
+                         "Verify the maximum sojourn time");
+
+  Simulator::Destroy ();
+}
+
+
 /**
  * \ingroup traffic-control-test
  * \ingroup tests
@@ -572,5 +700,6 @@ public:
     : TestSuite ("queue-disc-traces", UNIT)
   {
     AddTestCase (new QueueDiscTracesTestCase (), TestCase::QUICK);
+    AddTestCase (new QueueDiscStatsTestCase (), TestCase::QUICK);
   }
 } g_queueDiscTracesTestSuite; ///< the test suite
@@ -24,6 +24,7 @@
 #include "ns3/pointer.h"
 #include "ns3/string.h"
 #include "ns3/double.h"
+#include "ns3/boolean.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
 #include "ns3/node-container.h"
@@ -103,8 +104,9 @@ public:
    * Constructor
    *
    * \param tt the test type
+   * \param deferRun whether the queue disc is run by a scheduled event
    */
-  TcFlowControlTestCase (QueueSizeUnit tt);
+  TcFlowControlTestCase (QueueSizeUnit tt, bool deferRun);
   virtual ~TcFlowControlTestCase ();
 private:
   virtual void DoRun (void);
@@ -136,11 +138,14 @@ private:
    */
   void CheckPacketsInQueueDisc (Ptr<NetDevice> dev, uint16_t nPackets, const char* msg);
   QueueSizeUnit m_type;       //!< the test type
+  bool m_deferRun;            //!< whether the queue disc is run by a scheduled event
 };
 
-TcFlowControlTestCase::TcFlowControlTestCase (QueueSizeUnit tt)
-  : TestCase ("Test the operation of the flow control mechanism"),
-    m_type (tt)
+TcFlowControlTestCase::TcFlowControlTestCase (QueueSizeUnit tt, bool deferRun)
+  : TestCase (deferRun ? "Test the operation of the flow control mechanism with deferred runs"
+                       : "Test the operation of the flow control mechanism"),
+    m_type (tt),
+    m_deferRun (deferRun)
 {
 }
 
@@ -156,6 +161,12 @@ TcFlowControlTestCase::SendPackets (Ptr<Node> n, uint16_t nPackets)
     {
       tc->Send (n->GetDevice (0), Create<QueueDiscTestItem> (Create<Packet> (1000)));
     }
+  if (m_deferRun)
+    {
+      // the queue disc is only run once all the packets are enqueued
+      CheckPacketsInQueueDisc (n->GetDevice (0), nPackets,
+                               "All the packets must be in the queue disc before it is run");
+    }
 }
 
 void
@@ -191,6 +202,7 @@ TcFlowControlTestCase::DoRun (void)
 
   n.Get (0)->AggregateObject (CreateObject<TrafficControlLayer> ());
   n.Get (1)->AggregateObject (CreateObject<TrafficControlLayer> ());
+  n.Get (0)->GetObject<TrafficControlLayer> ()->SetAttribute ("DeferRun", BooleanValue (m_deferRun));
 
   Ptr<Queue<Packet> > queue;
 
@@ -386,7 +398,9 @@ public:
   TcFlowControlTestSuite ()
     : TestSuite ("tc-flow-control", UNIT)
   {
-    AddTestCase (new TcFlowControlTestCase (QueueSizeUnit::PACKETS), TestCase::QUICK);
-    AddTestCase (new TcFlowControlTestCase (QueueSizeUnit::BYTES), TestCase::QUICK);
+    AddTestCase (new TcFlowControlTestCase (QueueSizeUnit::PACKETS, false), TestCase::QUICK);
+    AddTestCase (new TcFlowControlTestCase (QueueSizeUnit::BYTES, false), TestCase::QUICK);
+    AddTestCase (new TcFlowControlTestCase (QueueSizeUnit::PACKETS, true), TestCase::QUICK);
+    AddTestCase (new TcFlowControlTestCase (QueueSizeUnit::BYTES, true), TestCase::QUICK);
   }
 } g_tcFlowControlTestSuite; ///< the test suite
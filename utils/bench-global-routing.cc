@@ -0,0 +1,125 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program times Ipv4GlobalRoutingHelper::PopulateRoutingTables on
+// k-ary fat-tree topologies of point-to-point links, for k = kmin, kmin +
+// step, ..., kmax.  A k-ary fat-tree has 5k^2/4 routers and k^3/2 links.
+// Sample usage:  ./waf --run 'bench-global-routing --kmin=4 --kmax=16'
+//
+// The SPF trees are computed by --GlobalRoutingThreads threads.
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/simulator.h"
+#include "ns3/node-container.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-address-generator.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/point-to-point-helper.h"
+#include <iostream>
+#include <stdlib.h> // for exit ()
+
+using namespace ns3;
+
+/**
+ * Build a k-ary fat-tree and time the routing table population.
+ *
+ * \param k the arity of the fat-tree, even
+ */
+static void
+benchFatTree (uint32_t k)
+{
+  uint32_t half = k / 2;
+  NodeContainer core;
+  core.Create (half * half);
+  NodeContainer agg;
+  agg.Create (k * half);
+  NodeContainer edge;
+  edge.Create (k * half);
+
+  SystemWallClockMs time;
+  time.Start ();
+  InternetStackHelper stack;
+  stack.Install (core);
+  stack.Install (agg);
+  stack.Install (edge);
+
+  PointToPointHelper p2p;
+  Ipv4AddressHelper address ("10.0.0.0", "255.255.255.252");
+  uint32_t links = 0;
+  for (uint32_t pod = 0; pod < k; pod++)
+    {
+      for (uint32_t a = 0; a < half; a++)
+        {
+          Ptr<Node> aggNode = agg.Get (pod * half + a);
+          for (uint32_t e = 0; e < half; e++)
+            {
+              address.Assign (p2p.Install (aggNode, edge.Get (pod * half + e)));
+              address.NewNetwork ();
+              links++;
+            }
+          for (uint32_t c = 0; c < half; c++)
+            {
+              address.Assign (p2p.Install (aggNode, core.Get (a * half + c)));
+              address.NewNetwork ();
+              links++;
+            }
+        }
+    }
+  uint64_t setupMs = time.End ();
+
+  time.Start ();
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  uint64_t populateMs = time.End ();
+
+  std::cout << k << "\t"
+            << core.GetN () + agg.GetN () + edge.GetN () << "\t"
+            << links << "\t"
+            << setupMs << "\t"
+            << populateMs << std::endl;
+
+  Simulator::Destroy ();
+  Ipv4AddressGenerator::Reset ();
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t kmin = 4;
+  uint32_t kmax = 12;
+  uint32_t step = 2;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark global routing table population on fat-trees");
+  cmd.AddValue ("kmin", "smallest fat-tree arity", kmin);
+  cmd.AddValue ("kmax", "largest fat-tree arity", kmax);
+  cmd.AddValue ("step", "arity increment", step);
+  cmd.Parse (argc, argv);
+
+  if (kmin < 2 || kmin % 2 || step == 0 || step % 2)
+    {
+      std::cerr << "Error-- the fat-tree arity must be even" << std::endl;
+      exit (1);
+    }
+
+  std::cout << "k\trouters\tlinks\tsetup (ms)\tpopulate (ms)" << std::endl;
+  for (uint32_t k = kmin; k <= kmax; k += step)
+    {
+      benchFatTree (k);
+    }
+
+  return 0;
+}
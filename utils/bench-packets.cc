@@ -21,14 +21,21 @@
 // This program can be used to benchmark packet serialization/deserialization
 // operations using Headers and Tags, for various numbers of packets 'n'
 // Sample usage:  ./waf --run 'bench-packets --n=10000'
+//
+// With --json, the results are printed as a JSON document whose benchmark
+// ids stay the same across versions, for tracking regressions per commit.
 
 #include "ns3/command-line.h"
 #include "ns3/system-wall-clock-ms.h"
 #include "ns3/packet.h"
 #include "ns3/packet-metadata.h"
+#include "ns3/ethernet-header.h"
+#include "ns3/ethernet-trailer.h"
+#include "ns3/llc-snap-header.h"
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <vector>
 #include <stdlib.h> // for exit ()
 #include <limits>
 #include <algorithm>
@@ -328,6 +335,138 @@ benchByteTags (uint32_t n)
     }
 }
 
+static void
+benchCopyOnWrite (uint32_t n)
+{
+  BenchHeader<25> ipv4;
+  BenchHeader<8> udp;
+
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (2000);
+      p->AddHeader (udp);
+      p->AddHeader (ipv4);
+      // Every copy shares the buffer; writing a header to one of them
+      // must not disturb the others.
+      Ptr<Packet> c0 = p->Copy ();
+      Ptr<Packet> c1 = p->Copy ();
+      Ptr<Packet> c2 = p->Copy ();
+      c0->RemoveHeader (ipv4);
+      c1->AddHeader (udp);
+      c2->AddAtEnd (c0);
+    }
+}
+
+static void
+benchPacketTags (uint32_t n)
+{
+  BenchTag<4> tag1;
+  BenchTag<8> tag2;
+  BenchTag<16> tag3;
+
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (1000);
+      p->AddPacketTag (tag1);
+      p->AddPacketTag (tag2);
+      p->AddPacketTag (tag3);
+      Ptr<Packet> o = p->Copy ();
+      o->PeekPacketTag (tag1);
+      o->ReplacePacketTag (tag2);
+      o->RemovePacketTag (tag3);
+      o->RemovePacketTag (tag1);
+      p->RemoveAllPacketTags ();
+    }
+}
+
+static void
+benchTcpIpv4Ethernet (uint32_t n)
+{
+  // Header sizes of a TCP segment with timestamps over IPv4 and Ethernet,
+  // added and removed in the order of the real stacks.
+  BenchHeader<32> tcp;
+  BenchHeader<20> ipv4;
+  EthernetHeader ethernet;
+  EthernetTrailer fcs;
+
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (1448);
+      p->AddHeader (tcp);
+      Ptr<Packet> segment = p->Copy (); // kept in the TCP transmit buffer
+      segment->AddHeader (ipv4);
+      segment->AddHeader (ethernet);
+      segment->AddTrailer (fcs);
+
+      Ptr<Packet> r = segment->Copy ();
+      r->RemoveTrailer (fcs);
+      r->RemoveHeader (ethernet);
+      r->RemoveHeader (ipv4);
+      r->RemoveHeader (tcp);
+    }
+}
+
+static void
+benchUdpIpv6Wifi (uint32_t n)
+{
+  // Header sizes of a UDP datagram over IPv6, LLC/SNAP and a QoS data
+  // Wi-Fi MAC header with its FCS.
+  BenchHeader<8> udp;
+  BenchHeader<40> ipv6;
+  LlcSnapHeader llc;
+  BenchHeader<26> wifiMac;
+  EthernetTrailer fcs;
+
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (1200);
+      p->AddHeader (udp);
+      p->AddHeader (ipv6);
+      p->AddHeader (llc);
+      p->AddHeader (wifiMac);
+      p->AddTrailer (fcs);
+
+      Ptr<Packet> r = p->Copy ();
+      r->RemoveTrailer (fcs);
+      r->RemoveHeader (wifiMac);
+      r->RemoveHeader (llc);
+      r->RemoveHeader (ipv6);
+      r->RemoveHeader (udp);
+    }
+}
+
+static void
+benchSerialize (uint32_t n)
+{
+  BenchHeader<25> ipv4;
+  BenchHeader<8> udp;
+  BenchTag<16> tag;
+  std::vector<uint8_t> buffer;
+
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (1000);
+      p->AddHeader (udp);
+      p->AddHeader (ipv4);
+      p->AddPacketTag (tag);
+      p->AddByteTag (tag);
+
+      buffer.resize (p->GetSerializedSize ());
+      p->Serialize (&buffer[0], buffer.size ());
+      Ptr<Packet> q = Create<Packet> (&buffer[0], buffer.size (), true);
+      q->RemoveHeader (ipv4);
+      q->RemoveHeader (udp);
+    }
+}
+
+/// The result of one benchmark
+struct BenchResult
+{
+  std::string id;       ///< short identifier, stable across versions
+  std::string name;     ///< description
+  uint64_t minDelay;    ///< fastest iteration, in milliseconds
+};
+
 static uint64_t
 runBenchOneIteration (void (*bench) (uint32_t), uint32_t n)
 {
@@ -340,7 +479,8 @@ runBenchOneIteration (void (*bench) (uint32_t), uint32_t n)
 
 
 static void
-runBench (void (*bench) (uint32_t), uint32_t n, uint32_t minIterations, char const *name)
+runBench (void (*bench) (uint32_t), uint32_t n, uint32_t minIterations,
+          char const *id, char const *name, std::vector<BenchResult> &results, bool json)
 {
   uint64_t minDelay = std::numeric_limits<uint64_t>::max();
   for (uint32_t i = 0; i < minIterations; i++)
@@ -348,6 +488,15 @@ runBench (void (*bench) (uint32_t), uint32_t n, uint32_t minIterations, char con
       uint64_t delay = runBenchOneIteration(bench, n);
       minDelay = std::min(minDelay, delay);
     }
+  BenchResult result;
+  result.id = id;
+  result.name = name;
+  result.minDelay = minDelay;
+  results.push_back (result);
+  if (json)
+    {
+      return;
+    }
   double ps = n;
   ps *= 1000;
   ps /= minDelay;
@@ -357,17 +506,49 @@ runBench (void (*bench) (uint32_t), uint32_t n, uint32_t minIterations, char con
             << std::endl;
 }
 
+static void
+printJson (uint32_t n, uint32_t minIterations, bool metadata, std::vector<BenchResult> const &results)
+{
+  std::cout << "{\n"
+            << "  \"benchmark\": \"bench-packets\",\n"
+            << "  \"n\": " << n << ",\n"
+            << "  \"min_iterations\": " << minIterations << ",\n"
+            << "  \"metadata\": " << (metadata ? "true" : "false") << ",\n"
+            << "  \"results\": [\n";
+  for (std::vector<BenchResult>::const_iterator i = results.begin (); i != results.end (); ++i)
+    {
+      std::cout << "    { \"id\": \"" << i->id << "\", "
+                << "\"name\": \"" << i->name << "\", "
+                << "\"ms\": " << i->minDelay << ", "
+                << "\"packets_per_second\": ";
+      if (i->minDelay == 0)
+        {
+          // too fast to be measured with this n
+          std::cout << "null";
+        }
+      else
+        {
+          std::cout << static_cast<uint64_t> (n * 1000.0 / i->minDelay);
+        }
+      std::cout << " }" << (i + 1 != results.end () ? "," : "") << "\n";
+    }
+  std::cout << "  ]\n"
+            << "}" << std::endl;
+}
+
 int main (int argc, char *argv[])
 {
   uint32_t n = 0;
   uint32_t minIterations = 1;
   bool enablePrinting = false;
+  bool json = false;
 
   CommandLine cmd;
   cmd.Usage ("Benchmark Packet class");
   cmd.AddValue ("n", "number of iterations", n);
   cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
   cmd.AddValue ("enable-printing", "enable packet printing", enablePrinting);
+  cmd.AddValue ("json", "print the results as a JSON document", json);
   cmd.Parse (argc, argv);
 
   if (n == 0)
@@ -376,15 +557,36 @@ int main (int argc, char *argv[])
         "by command-line argument --n=(number of packets)" << std::endl;
       exit (1);
     }
-  std::cout << "Running bench-packets with n=" << n << std::endl;
-  std::cout << "All tests begin by adding UDP and IPv4 headers." << std::endl;
-
-  runBench (&benchA, n, minIterations, "Copy packet, remove headers");
-  runBench (&benchB, n, minIterations, "Just add headers");
-  runBench (&benchC, n, minIterations, "Remove by func call");
-  runBench (&benchD, n, minIterations, "Intermixed add/remove headers and tags");
-  runBench (&benchFragment, n, minIterations, "Fragmentation and concatenation");
-  runBench (&benchByteTags, n, minIterations, "Benchmark byte tags");
+  if (enablePrinting)
+    {
+      // Packet metadata cannot be disabled once enabled, so the benchmarks
+      // are run either all with or all without it.
+      Packet::EnablePrinting ();
+    }
+  if (!json)
+    {
+      std::cout << "Running bench-packets with n=" << n
+                << (enablePrinting ? " and packet metadata" : "") << std::endl;
+      std::cout << "All tests begin by adding UDP and IPv4 headers." << std::endl;
+    }
+
+  std::vector<BenchResult> results;
+  runBench (&benchA, n, minIterations, "copy-remove", "Copy packet, remove headers", results, json);
+  runBench (&benchB, n, minIterations, "add-headers", "Just add headers", results, json);
+  runBench (&benchC, n, minIterations, "remove-by-call", "Remove by func call", results, json);
+  runBench (&benchD, n, minIterations, "headers-and-tags", "Intermixed add/remove headers and tags", results, json);
+  runBench (&benchFragment, n, minIterations, "fragment-concat", "Fragmentation and concatenation", results, json);
+  runBench (&benchByteTags, n, minIterations, "byte-tags", "Benchmark byte tags", results, json);
+  runBench (&benchCopyOnWrite, n, minIterations, "copy-on-write", "Modify copies sharing a buffer", results, json);
+  runBench (&benchPacketTags, n, minIterations, "packet-tags", "Add, peek, replace and remove packet tags", results, json);
+  runBench (&benchTcpIpv4Ethernet, n, minIterations, "tcp-ipv4-ethernet", "TCP/IPv4/Ethernet send and receive", results, json);
+  runBench (&benchUdpIpv6Wifi, n, minIterations, "udp-ipv6-llc-wifi", "UDP/IPv6/LLC/Wi-Fi send and receive", results, json);
+  runBench (&benchSerialize, n, minIterations, "serialize", "Serialize and deserialize packets", results, json);
+
+  if (json)
+    {
+      printJson (n, minIterations, enablePrinting, results);
+    }
 
   return 0;
 }
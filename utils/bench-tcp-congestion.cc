@@ -0,0 +1,848 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program drives TCP congestion control and recovery algorithms
+// through sequences of ACK, duplicate ACK and retransmission timeout
+// events, without sockets nor network stack.  The algorithms are called
+// in the same order as TcpSocketBase calls them, for a window-limited
+// sender, and the program reports the CPU time spent in the algorithms
+// per ACK, along with the resulting congestion windows.
+//
+// The events are either generated on the fly, by a closed-loop model of
+// a single bottleneck (rate, base RTT, buffer, random losses), or
+// replayed from a file recorded with --record, with one event per line:
+//
+//   <time (ns)> ack <segments acked> <rtt (ns)>
+//   <time (ns)> dupack
+//   <time (ns)> rto
+//
+// Several algorithms (--cc), values of one of their attributes (--param
+// and --values) and runs can be swept in a single invocation, printing
+// one line per combination.  The other attributes can be set with the
+// usual --ns3::TcpBic::Beta=0.8 syntax.
+// Sample usage:
+//   ./waf --run 'bench-tcp-congestion --cc=ns3::TcpNewReno,ns3::TcpBic --runs=10'
+//   ./waf --run 'bench-tcp-congestion --cc=ns3::TcpHighSpeed --record=hs.txt'
+//   ./waf --run 'bench-tcp-congestion --cc=ns3::TcpYeah --replay=hs.txt --cwndTrace=yeah.txt'
+
+#include "ns3/command-line.h"
+#include "ns3/abort.h"
+#include "ns3/string.h"
+#include "ns3/double.h"
+#include "ns3/object-factory.h"
+#include "ns3/simulator.h"
+#include "ns3/callback.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/data-rate.h"
+#include "ns3/tcp-congestion-ops.h"
+#include "ns3/tcp-recovery-ops.h"
+#include "ns3/tcp-socket-state.h"
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace ns3;
+
+/**
+ * \brief Calls a congestion control and a recovery algorithm on the
+ * events of a connection, as TcpSocketBase does.
+ *
+ * The sender is window limited: after each event, it sends new segments
+ * as long as the segments in flight (not acknowledged nor selectively
+ * acknowledged) are fewer than the congestion window.
+ */
+class CongestionHarness
+{
+public:
+  /**
+   * \brief Constructor
+   * \param cc the congestion control algorithm
+   * \param recovery the recovery algorithm
+   * \param segmentSize the segment size in bytes
+   * \param initialCwnd the initial congestion window in segments
+   */
+  CongestionHarness (Ptr<TcpCongestionOps> cc, Ptr<TcpRecoveryOps> recovery,
+                     uint32_t segmentSize, uint32_t initialCwnd);
+
+  /**
+   * \brief Start the connection, sending the initial window
+   */
+  void Start (void);
+  /**
+   * \brief Process a cumulative ACK
+   * \param segments the number of segments acknowledged
+   * \param rtt the RTT sample of the ACK
+   */
+  void Ack (uint32_t segments, Time rtt);
+  /**
+   * \brief Process a duplicate ACK, selectively acknowledging one segment
+   */
+  void DupAck (void);
+  /**
+   * \brief Process a retransmission timeout
+   */
+  void Rto (void);
+
+  /**
+   * \brief Set the stream the events are recorded in
+   * \param os the stream, or 0
+   */
+  void SetRecord (std::ostream *os);
+  /**
+   * \brief Set the stream the congestion window is traced in
+   * \param os the stream, or 0
+   */
+  void SetCwndTrace (std::ostream *os);
+  /**
+   * \brief Set the callback invoked with the number of segments sent
+   * \param cb the callback
+   */
+  void SetSendCallback (Callback<void, uint32_t> cb);
+
+  /// \return the congestion state
+  TcpSocketState::TcpCongState_t GetState (void) const;
+  /// \return the number of segments in flight
+  uint32_t GetInFlight (void) const;
+  /// \return the number of segments left to acknowledge to end the recovery
+  uint32_t GetToRecover (void) const;
+
+  uint64_t m_acks {0};          //!< ACKs processed, duplicate ones included
+  uint64_t m_ackedSegments {0}; //!< Segments cumulatively acknowledged
+  uint32_t m_recoveries {0};    //!< Fast recoveries entered
+  uint32_t m_timeouts {0};      //!< Retransmission timeouts
+  double m_cwndSum {0};         //!< Sum of the congestion windows after each ACK, in segments
+  int64_t m_opsTime {0};        //!< Time spent in the algorithms, in ns
+
+private:
+  /**
+   * \brief Send the segments allowed by the congestion window and trace it
+   */
+  void Send (void);
+
+  Ptr<TcpSocketState> m_tcb;           //!< Congestion state
+  Ptr<TcpCongestionOps> m_cc;          //!< Congestion control
+  Ptr<TcpRecoveryOps> m_recovery;      //!< Recovery
+  uint32_t m_acked {0};                //!< Highest segment acknowledged
+  uint32_t m_highTx {0};               //!< Highest segment sent
+  uint32_t m_recover {0};              //!< Recovery point
+  uint32_t m_dupAcks {0};              //!< Duplicate ACKs since the last cumulative ACK
+  Callback<void, uint32_t> m_sendCb;   //!< Callback for the segments sent
+  std::ostream *m_record {0};          //!< Event record
+  std::ostream *m_cwndTrace {0};       //!< Congestion window trace
+  uint32_t m_lastCwnd {0};             //!< Congestion window last traced
+  uint32_t m_lastSsThresh {0};         //!< Slow start threshold last traced
+};
+
+CongestionHarness::CongestionHarness (Ptr<TcpCongestionOps> cc, Ptr<TcpRecoveryOps> recovery,
+                                      uint32_t segmentSize, uint32_t initialCwnd)
+  : m_cc (cc),
+    m_recovery (recovery)
+{
+  m_tcb = CreateObject<TcpSocketState> ();
+  m_tcb->m_segmentSize = segmentSize;
+  m_tcb->m_initialCWnd = initialCwnd;
+  m_tcb->m_initialSsThresh = UINT32_MAX;
+  m_tcb->m_cWnd = initialCwnd * segmentSize;
+  m_tcb->m_cWndInfl = m_tcb->m_cWnd;
+  m_tcb->m_ssThresh = UINT32_MAX;
+}
+
+void
+CongestionHarness::Start (void)
+{
+  m_cc->CwndEvent (m_tcb, TcpSocketState::CA_EVENT_TX_START);
+  Send ();
+}
+
+void
+CongestionHarness::SetRecord (std::ostream *os)
+{
+  m_record = os;
+}
+
+void
+CongestionHarness::SetCwndTrace (std::ostream *os)
+{
+  m_cwndTrace = os;
+}
+
+void
+CongestionHarness::SetSendCallback (Callback<void, uint32_t> cb)
+{
+  m_sendCb = cb;
+}
+
+TcpSocketState::TcpCongState_t
+CongestionHarness::GetState (void) const
+{
+  return m_tcb->m_congState;
+}
+
+uint32_t
+CongestionHarness::GetInFlight (void) const
+{
+  return m_highTx - m_acked - m_dupAcks;
+}
+
+uint32_t
+CongestionHarness::GetToRecover (void) const
+{
+  return m_recover > m_acked ? m_recover - m_acked : 0;
+}
+
+void
+CongestionHarness::Send (void)
+{
+  uint32_t inFlight = GetInFlight ();
+  uint32_t cwnd = m_tcb->GetCwndInSegments ();
+  if (cwnd > inFlight)
+    {
+      m_highTx += cwnd - inFlight;
+      if (m_tcb->m_congState == TcpSocketState::CA_RECOVERY)
+        {
+          m_recovery->UpdateBytesSent ((cwnd - inFlight) * m_tcb->m_segmentSize);
+        }
+      if (!m_sendCb.IsNull ())
+        {
+          m_sendCb (cwnd - inFlight);
+        }
+    }
+  m_tcb->m_bytesInFlight = GetInFlight () * m_tcb->m_segmentSize;
+  m_tcb->m_nextTxSequence = SequenceNumber32 (1 + m_highTx * m_tcb->m_segmentSize);
+  if (m_tcb->m_nextTxSequence > m_tcb->m_highTxMark)
+    {
+      m_tcb->m_highTxMark = m_tcb->m_nextTxSequence;
+    }
+
+  if (m_cwndTrace && (m_tcb->m_cWnd != m_lastCwnd || m_tcb->m_ssThresh != m_lastSsThresh))
+    {
+      m_lastCwnd = m_tcb->m_cWnd;
+      m_lastSsThresh = m_tcb->m_ssThresh;
+      *m_cwndTrace << Simulator::Now ().GetSeconds () << " " << m_lastCwnd << " " << m_lastSsThresh
+                   << " " << TcpSocketState::TcpCongStateName[m_tcb->m_congState] << std::endl;
+    }
+}
+
+void
+CongestionHarness::Ack (uint32_t segments, Time rtt)
+{
+  if (m_record)
+    {
+      *m_record << Simulator::Now ().GetNanoSeconds () << " ack " << segments << " " << rtt.GetNanoSeconds () << "\n";
+    }
+  // a replayed ACK cannot acknowledge segments not sent by this sender
+  segments = std::min (segments, m_highTx - m_acked);
+  if (segments == 0)
+    {
+      return;
+    }
+  m_acked += segments;
+  m_ackedSegments += segments;
+  m_dupAcks = 0;
+  m_acks++;
+
+  m_tcb->m_lastAckedSeq = SequenceNumber32 (1 + m_acked * m_tcb->m_segmentSize);
+  m_tcb->m_lastRtt = rtt;
+  m_tcb->m_minRtt = std::min (m_tcb->m_minRtt, rtt);
+  // timestamps in ms, the receiver stamping the segments halfway
+  m_tcb->m_rcvTimestampValue = static_cast<uint32_t> ((Simulator::Now () - rtt / 2).GetMilliSeconds ()) + 1;
+  m_tcb->m_rcvTimestampEchoReply = static_cast<uint32_t> ((Simulator::Now () - rtt).GetMilliSeconds ()) + 1;
+  m_tcb->m_bytesInFlight = GetInFlight () * m_tcb->m_segmentSize;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  switch (m_tcb->m_congState)
+    {
+    case TcpSocketState::CA_RECOVERY:
+      if (m_acked < m_recover)
+        {
+          // partial ACK
+          uint32_t bytes = segments * m_tcb->m_segmentSize;
+          m_tcb->m_cWndInfl = m_tcb->m_cWndInfl.Get () > bytes ? m_tcb->m_cWndInfl.Get () - bytes : 0;
+          m_recovery->DoRecovery (m_tcb, segments * m_tcb->m_segmentSize, 0);
+          m_cc->PktsAcked (m_tcb, 1, rtt);
+        }
+      else
+        {
+          m_cc->PktsAcked (m_tcb, m_acked - m_recover, rtt);
+          m_cc->CwndEvent (m_tcb, TcpSocketState::CA_EVENT_COMPLETE_CWR);
+          m_cc->CongestionStateSet (m_tcb, TcpSocketState::CA_OPEN);
+          m_tcb->m_congState = TcpSocketState::CA_OPEN;
+          m_recovery->ExitRecovery (m_tcb);
+        }
+      break;
+    case TcpSocketState::CA_LOSS:
+      if (m_acked >= m_recover)
+        {
+          segments = m_acked - m_recover;
+          m_cc->PktsAcked (m_tcb, segments, rtt);
+          m_cc->CongestionStateSet (m_tcb, TcpSocketState::CA_OPEN);
+          m_tcb->m_congState = TcpSocketState::CA_OPEN;
+        }
+      else
+        {
+          m_cc->PktsAcked (m_tcb, segments, rtt);
+        }
+      m_cc->IncreaseWindow (m_tcb, segments);
+      m_tcb->m_cWndInfl = m_tcb->m_cWnd;
+      break;
+    case TcpSocketState::CA_DISORDER:
+      m_cc->PktsAcked (m_tcb, segments, rtt);
+      m_cc->CongestionStateSet (m_tcb, TcpSocketState::CA_OPEN);
+      m_tcb->m_congState = TcpSocketState::CA_OPEN;
+      m_cc->IncreaseWindow (m_tcb, segments);
+      m_tcb->m_cWndInfl = m_tcb->m_cWnd;
+      break;
+    default:
+      m_cc->PktsAcked (m_tcb, segments, rtt);
+      m_cc->IncreaseWindow (m_tcb, segments);
+      m_tcb->m_cWndInfl = m_tcb->m_cWnd;
+      break;
+    }
+  m_opsTime += std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now () - start).count ();
+
+  m_cwndSum += m_tcb->GetCwndInSegments ();
+  Send ();
+}
+
+void
+CongestionHarness::DupAck (void)
+{
+  if (m_record)
+    {
+      *m_record << Simulator::Now ().GetNanoSeconds () << " dupack\n";
+    }
+  if (GetInFlight () == 0 || m_tcb->m_congState == TcpSocketState::CA_LOSS)
+    {
+      return;
+    }
+  m_dupAcks++;
+  m_acks++;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  if (m_tcb->m_congState == TcpSocketState::CA_OPEN)
+    {
+      m_cc->CongestionStateSet (m_tcb, TcpSocketState::CA_DISORDER);
+      m_tcb->m_congState = TcpSocketState::CA_DISORDER;
+    }
+  if (m_tcb->m_congState == TcpSocketState::CA_DISORDER && m_dupAcks == 3)
+    {
+      m_recover = m_highTx;
+      m_recoveries++;
+      m_cc->CongestionStateSet (m_tcb, TcpSocketState::CA_RECOVERY);
+      m_tcb->m_congState = TcpSocketState::CA_RECOVERY;
+      m_tcb->m_ssThresh = m_cc->GetSsThresh (m_tcb, m_tcb->m_bytesInFlight);
+      m_recovery->EnterRecovery (m_tcb, m_dupAcks, (m_highTx - m_acked) * m_tcb->m_segmentSize,
+                                 m_dupAcks * m_tcb->m_segmentSize);
+    }
+  else if (m_tcb->m_congState == TcpSocketState::CA_RECOVERY)
+    {
+      m_recovery->DoRecovery (m_tcb, 0, m_dupAcks * m_tcb->m_segmentSize);
+    }
+  m_opsTime += std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now () - start).count ();
+
+  m_cwndSum += m_tcb->GetCwndInSegments ();
+  Send ();
+}
+
+void
+CongestionHarness::Rto (void)
+{
+  if (m_record)
+    {
+      *m_record << Simulator::Now ().GetNanoSeconds () << " rto\n";
+    }
+  m_timeouts++;
+  m_tcb->m_bytesInFlight = (m_highTx - m_acked) * m_tcb->m_segmentSize;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  if (m_tcb->m_congState != TcpSocketState::CA_LOSS)
+    {
+      m_tcb->m_ssThresh = m_cc->GetSsThresh (m_tcb, m_tcb->m_bytesInFlight);
+    }
+  m_tcb->m_cWnd = m_tcb->m_segmentSize;
+  m_tcb->m_cWndInfl = m_tcb->m_cWnd;
+  m_cc->CwndEvent (m_tcb, TcpSocketState::CA_EVENT_LOSS);
+  m_cc->CongestionStateSet (m_tcb, TcpSocketState::CA_LOSS);
+  m_tcb->m_congState = TcpSocketState::CA_LOSS;
+  m_opsTime += std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now () - start).count ();
+
+  // all the segments in flight are retransmitted
+  m_recover = m_highTx;
+  m_highTx = m_acked;
+  m_dupAcks = 0;
+  Send ();
+}
+
+/**
+ * \brief Generates the events of a flow through a single bottleneck.
+ *
+ * Each segment sent by the harness leaves the bottleneck after the
+ * segments queued before it, and its ACK arrives a base RTT later. A
+ * segment is lost when the bottleneck buffer is full, or at random. The
+ * segments arriving after a loss are duplicate ACKs, until the
+ * retransmission of the lost segments, sent when the harness enters the
+ * recovery, is acknowledged one RTT later. If the recovery does not
+ * start or the retransmission is lost, a retransmission timeout fires.
+ */
+class SyntheticPath
+{
+public:
+  /**
+   * \brief Constructor
+   * \param harness the harness receiving the events
+   * \param rtt the base RTT
+   * \param rate the bottleneck rate, or 0 for no bottleneck
+   * \param buffer the bottleneck buffer in segments, or 0 for one bandwidth-delay product
+   * \param segmentSize the segment size in bytes
+   * \param ackSegments the segments acknowledged by each ACK
+   * \param jitter the maximum relative variation of the RTT
+   * \param loss the probability to lose a segment
+   * \param rto the probability to lose a retransmission
+   * \param minRto the minimum retransmission timeout
+   */
+  SyntheticPath (CongestionHarness *harness, Time rtt, DataRate rate, uint32_t buffer, uint32_t segmentSize,
+                 uint32_t ackSegments, double jitter, double loss, double rto, Time minRto);
+
+  /**
+   * \brief Take the segments sent by the harness
+   * \param segments the number of segments sent
+   */
+  void Send (uint32_t segments);
+
+private:
+  /// \brief A segment in flight
+  struct Segment
+  {
+    Time arrival;     //!< Arrival time of its ACK
+    Time rtt;         //!< RTT sample of its ACK
+    bool lost;        //!< True if the segment is lost
+  };
+
+  /**
+   * \brief Schedule the arrival of the next segment, if not scheduled yet
+   */
+  void ScheduleNext (void);
+  /**
+   * \brief Process the arrival of the first segment in flight
+   */
+  void Arrive (void);
+  /**
+   * \brief Queue the retransmissions of the lost segments not retransmitted yet at the bottleneck
+   * \param lost the segments lost
+   * \return the time until the last retransmission leaves the bottleneck
+   */
+  Time Charge (uint32_t lost);
+  /**
+   * \brief Acknowledge the retransmitted segments and the ones received since the loss
+   * \param rtt the RTT sample
+   */
+  void Retransmitted (Time rtt);
+  /**
+   * \brief Process a retransmission timeout
+   */
+  void Timeout (void);
+
+  CongestionHarness *m_harness;         //!< Harness
+  Time m_rtt;                           //!< Base RTT
+  Time m_transmission;                  //!< Transmission time of a segment at the bottleneck
+  double m_buffer;                      //!< Bottleneck buffer in segments
+  uint32_t m_ackSegments;               //!< Segments acknowledged per ACK
+  double m_jitter;                      //!< Relative variation of the RTT
+  double m_loss;                        //!< Loss probability
+  double m_rto;                         //!< Retransmission loss probability
+  Time m_minRto;                        //!< Minimum retransmission timeout
+  Time m_lastDeparture;                 //!< Departure time of the last segment from the bottleneck
+  Time m_lastArrival;                   //!< Arrival time of the last ACK
+  std::deque<Segment> m_inFlight;       //!< Segments in flight, in order
+  uint32_t m_pending {0};               //!< Segments received and not acknowledged yet
+  uint32_t m_lost {0};                  //!< Segments lost since the first loss not repaired
+  uint32_t m_received {0};              //!< Segments received since the first loss not repaired
+  uint32_t m_retransmitted {0};         //!< Lost segments retransmitted through the bottleneck
+  bool m_repairing {false};             //!< True if the losses are being retransmitted
+  EventId m_arrival;                    //!< Arrival of the next segment
+  EventId m_retransmission;             //!< Arrival of the ACK of the retransmission
+  EventId m_timeout;                    //!< Retransmission timeout
+  Ptr<UniformRandomVariable> m_random;  //!< Random variable
+};
+
+SyntheticPath::SyntheticPath (CongestionHarness *harness, Time rtt, DataRate rate, uint32_t buffer,
+                              uint32_t segmentSize, uint32_t ackSegments, double jitter, double loss,
+                              double rto, Time minRto)
+  : m_harness (harness),
+    m_rtt (rtt),
+    m_buffer (buffer),
+    m_ackSegments (std::max<uint32_t> (ackSegments, 1)),
+    m_jitter (jitter),
+    m_loss (loss),
+    m_rto (rto),
+    m_minRto (minRto)
+{
+  m_random = CreateObject<UniformRandomVariable> ();
+  if (rate.GetBitRate () > 0)
+    {
+      m_transmission = rate.CalculateBytesTxTime (segmentSize);
+      if (m_buffer == 0)
+        {
+          m_buffer = std::max (1.0, m_rtt.GetSeconds () / m_transmission.GetSeconds ());
+        }
+    }
+}
+
+void
+SyntheticPath::Send (uint32_t segments)
+{
+  Time now = Simulator::Now ();
+  for (uint32_t i = 0; i < segments; i++)
+    {
+      Segment s;
+      Time departure = Max (now, m_lastDeparture) + m_transmission;
+      s.lost = m_random->GetValue () < m_loss;
+      if (m_transmission.IsStrictlyPositive () && departure - now > m_transmission * m_buffer)
+        {
+          // tail drop
+          s.lost = true;
+        }
+      else
+        {
+          m_lastDeparture = departure;
+        }
+      s.arrival = Max (departure + m_rtt * (1 + m_jitter * m_random->GetValue (-1, 1)), m_lastArrival);
+      s.rtt = s.arrival - now;
+      m_lastArrival = s.arrival;
+      m_inFlight.push_back (s);
+    }
+  ScheduleNext ();
+}
+
+void
+SyntheticPath::ScheduleNext (void)
+{
+  if (!m_inFlight.empty () && !m_arrival.IsRunning ())
+    {
+      m_arrival = Simulator::Schedule (m_inFlight.front ().arrival - Simulator::Now (), &SyntheticPath::Arrive, this);
+    }
+}
+
+void
+SyntheticPath::Arrive (void)
+{
+  Segment s = m_inFlight.front ();
+  m_inFlight.pop_front ();
+
+  if (s.lost)
+    {
+      if (m_lost++ == 0)
+        {
+          m_timeout = Simulator::Schedule (Max (m_minRto, s.rtt + s.rtt), &SyntheticPath::Timeout, this);
+          if (m_pending > 0)
+            {
+              m_harness->Ack (m_pending, s.rtt);
+              m_pending = 0;
+            }
+        }
+    }
+  else if (m_lost > 0)
+    {
+      m_received++;
+      m_harness->DupAck ();
+      if (m_harness->GetState () == TcpSocketState::CA_RECOVERY && !m_repairing)
+        {
+          // the retransmission is lost with probability m_rto, and then
+          // only the timeout repairs the losses
+          m_repairing = true;
+          Time rtt = Charge (m_lost) + m_rtt;
+          if (m_random->GetValue () >= m_rto)
+            {
+              m_retransmission = Simulator::Schedule (rtt, &SyntheticPath::Retransmitted, this, rtt);
+            }
+        }
+    }
+  else if (++m_pending >= m_ackSegments || m_inFlight.empty ())
+    {
+      m_harness->Ack (m_pending, s.rtt);
+      m_pending = 0;
+    }
+  ScheduleNext ();
+}
+
+Time
+SyntheticPath::Charge (uint32_t lost)
+{
+  Time now = Simulator::Now ();
+  if (lost > m_retransmitted && m_transmission.IsStrictlyPositive ())
+    {
+      m_lastDeparture = Max (now, m_lastDeparture) + m_transmission * (lost - m_retransmitted);
+    }
+  m_retransmitted = lost;
+  return Max (m_lastDeparture - now, Time (0));
+}
+
+void
+SyntheticPath::Retransmitted (Time rtt)
+{
+  m_timeout.Cancel ();
+  // the segments lost after the retransmission was sent are retransmitted too
+  Charge (m_lost);
+  uint32_t segments = m_lost + m_received;
+  m_lost = 0;
+  m_received = 0;
+  m_retransmitted = 0;
+  m_repairing = false;
+  m_harness->Ack (segments, rtt);
+}
+
+void
+SyntheticPath::Timeout (void)
+{
+  // the segments in flight are dropped, and all the data sent since the
+  // last ACK is retransmitted
+  m_arrival.Cancel ();
+  m_retransmission.Cancel ();
+  m_inFlight.clear ();
+  m_lastDeparture = Max (m_lastDeparture, Simulator::Now ());
+  m_lastArrival = Simulator::Now ();
+  m_pending = 0;
+  m_lost = 0;
+  m_received = 0;
+  m_retransmitted = 0;
+  m_repairing = false;
+  m_harness->Rto ();
+}
+
+/**
+ * \brief Replays the events recorded in a file
+ */
+class TraceReplay
+{
+public:
+  /**
+   * \brief Constructor
+   * \param harness the harness receiving the events
+   * \param file the name of the file
+   */
+  TraceReplay (CongestionHarness *harness, std::string file);
+
+  /**
+   * \brief Schedule the next event of the file
+   */
+  void Next (void);
+
+private:
+  /**
+   * \brief Deliver an event to the harness and schedule the next one
+   * \param type the type of the event
+   * \param segments the segments acknowledged, for an ACK
+   * \param rtt the RTT sample, for an ACK
+   */
+  void Deliver (std::string type, uint32_t segments, Time rtt);
+
+  CongestionHarness *m_harness;   //!< Harness
+  std::ifstream m_file;           //!< Event file
+};
+
+TraceReplay::TraceReplay (CongestionHarness *harness, std::string file)
+  : m_harness (harness),
+    m_file (file.c_str ())
+{
+  NS_ABORT_MSG_UNLESS (m_file.is_open (), "Cannot open " << file);
+}
+
+void
+TraceReplay::Next (void)
+{
+  std::string line;
+  while (std::getline (m_file, line))
+    {
+      std::istringstream is (line);
+      int64_t time;
+      std::string type;
+      if (!(is >> time >> type))
+        {
+          continue;
+        }
+      uint32_t segments = 0;
+      int64_t rtt = 0;
+      if (type == "ack")
+        {
+          is >> segments >> rtt;
+        }
+      else
+        {
+          NS_ABORT_MSG_UNLESS (type == "dupack" || type == "rto", "Unknown event " << line);
+        }
+      Simulator::Schedule (Max (NanoSeconds (time) - Simulator::Now (), Time (0)),
+                           &TraceReplay::Deliver, this, type, segments, NanoSeconds (rtt));
+      return;
+    }
+}
+
+void
+TraceReplay::Deliver (std::string type, uint32_t segments, Time rtt)
+{
+  if (type == "ack")
+    {
+      m_harness->Ack (segments, rtt);
+    }
+  else if (type == "dupack")
+    {
+      m_harness->DupAck ();
+    }
+  else
+    {
+      m_harness->Rto ();
+    }
+  Next ();
+}
+
+/**
+ * \brief Split a comma separated list
+ * \param list the list
+ * \return the items of the list
+ */
+static std::vector<std::string>
+Split (std::string list)
+{
+  std::vector<std::string> items;
+  std::istringstream is (list);
+  std::string item;
+  while (std::getline (is, item, ','))
+    {
+      items.push_back (item);
+    }
+  if (items.empty ())
+    {
+      items.push_back ("");
+    }
+  return items;
+}
+
+int main (int argc, char *argv[])
+{
+  std::string cc = "ns3::TcpNewReno";
+  std::string recovery = "ns3::TcpClassicRecovery";
+  std::string param;
+  std::string values;
+  uint32_t runs = 1;
+  double duration = 100;
+  uint32_t segmentSize = 1448;
+  uint32_t initialCwnd = 10;
+  double rtt = 0.1;
+  std::string rate = "100Mbps";
+  uint32_t buffer = 0;
+  uint32_t ackSegments = 1;
+  double jitter = 0;
+  double loss = 0;
+  double rto = 0;
+  double minRto = 0.2;
+  std::string replay;
+  std::string record;
+  std::string cwndTrace;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark TCP congestion control algorithms on synthetic or recorded ACK sequences");
+  cmd.AddValue ("cc", "comma separated congestion control algorithms", cc);
+  cmd.AddValue ("recovery", "recovery algorithm", recovery);
+  cmd.AddValue ("param", "attribute of the congestion control algorithms to sweep", param);
+  cmd.AddValue ("values", "comma separated values of the swept attribute", values);
+  cmd.AddValue ("runs", "number of runs of each combination", runs);
+  cmd.AddValue ("time", "simulated duration of each run (s)", duration);
+  cmd.AddValue ("segmentSize", "TCP segment size (bytes)", segmentSize);
+  cmd.AddValue ("initialCwnd", "initial congestion window (segments)", initialCwnd);
+  cmd.AddValue ("rtt", "base round-trip time (s)", rtt);
+  cmd.AddValue ("rate", "bottleneck rate (0bps: no bottleneck)", rate);
+  cmd.AddValue ("buffer", "bottleneck buffer (segments, 0: one bandwidth-delay product)", buffer);
+  cmd.AddValue ("ackSegments", "segments acknowledged per ACK", ackSegments);
+  cmd.AddValue ("jitter", "maximum relative variation of the RTT samples", jitter);
+  cmd.AddValue ("loss", "probability to lose a segment", loss);
+  cmd.AddValue ("rto", "probability to lose a retransmission, recovered by a timeout", rto);
+  cmd.AddValue ("minRto", "minimum retransmission timeout (s)", minRto);
+  cmd.AddValue ("replay", "file of events to replay instead of the synthetic path", replay);
+  cmd.AddValue ("record", "file to record the events in", record);
+  cmd.AddValue ("cwndTrace", "file to trace the congestion window in", cwndTrace);
+  cmd.Parse (argc, argv);
+
+  std::vector<std::string> ccs = Split (cc);
+  std::vector<std::string> vals = Split (values);
+  NS_ABORT_MSG_IF ((!record.empty () || !cwndTrace.empty ()) && ccs.size () * vals.size () * runs > 1,
+                   "A single combination can be recorded or traced");
+
+  std::cout << "congestion\trecovery\tvalue\trun\tacks\trecoveries\ttimeouts\tmean cwnd (segments)\t"
+            << "goodput (Mb/s)\tops (ns/ack)" << std::endl;
+  for (std::vector<std::string>::const_iterator c = ccs.begin (); c != ccs.end (); c++)
+    {
+      for (std::vector<std::string>::const_iterator v = vals.begin (); v != vals.end (); v++)
+        {
+          for (uint32_t run = 1; run <= runs; run++)
+            {
+              RngSeedManager::SetRun (run);
+
+              ObjectFactory ccFactory (*c);
+              if (!param.empty ())
+                {
+                  ccFactory.Set (param, StringValue (*v));
+                }
+              CongestionHarness harness (ccFactory.Create<TcpCongestionOps> (),
+                                         ObjectFactory (recovery).Create<TcpRecoveryOps> (),
+                                         segmentSize, initialCwnd);
+
+              std::ofstream recordFile;
+              if (!record.empty ())
+                {
+                  recordFile.open (record.c_str ());
+                  harness.SetRecord (&recordFile);
+                }
+              std::ofstream cwndFile;
+              if (!cwndTrace.empty ())
+                {
+                  cwndFile.open (cwndTrace.c_str ());
+                  harness.SetCwndTrace (&cwndFile);
+                }
+
+              SyntheticPath path (&harness, Seconds (rtt), DataRate (rate), buffer, segmentSize,
+                                  ackSegments, jitter, loss, rto, Seconds (minRto));
+              TraceReplay *trace = 0;
+              if (replay.empty ())
+                {
+                  harness.SetSendCallback (MakeCallback (&SyntheticPath::Send, &path));
+                }
+              else
+                {
+                  trace = new TraceReplay (&harness, replay);
+                  trace->Next ();
+                }
+              harness.Start ();
+              Simulator::Stop (Seconds (duration));
+              Simulator::Run ();
+              double simulated = Simulator::Now ().GetSeconds ();
+              Simulator::Destroy ();
+              delete trace;
+
+              std::cout << *c << "\t" << recovery << "\t" << *v << "\t" << run << "\t"
+                        << harness.m_acks << "\t"
+                        << harness.m_recoveries << "\t"
+                        << harness.m_timeouts << "\t"
+                        << (harness.m_acks ? harness.m_cwndSum / harness.m_acks : 0) << "\t"
+                        << (simulated > 0 ? harness.m_ackedSegments * segmentSize * 8 / simulated / 1e6 : 0) << "\t"
+                        << (harness.m_acks ? static_cast<double> (harness.m_opsTime) / harness.m_acks : 0)
+                        << std::endl;
+            }
+        }
+    }
+  return 0;
+}
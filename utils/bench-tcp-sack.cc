@@ -0,0 +1,127 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program times a single SACK-enabled TCP bulk transfer over a
+// point-to-point link with a large bandwidth-delay product and random
+// losses: by default 10 Gb/s, 100 ms of round-trip time and 1% of the
+// data packets dropped at the receiver.  The congestion window starts
+// at the bandwidth-delay product, so that every loss recovery walks a
+// scoreboard of tens of thousands of segments in flight.
+// With --tso=N, the sender emulates segmentation offload with
+// super-segments of up to N segments.
+// Sample usage:  ./waf --run 'bench-tcp-sack --time=2 --loss=0.01'
+
+#include "ns3/command-line.h"
+#include "ns3/config.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/string.h"
+#include "ns3/pointer.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/simulator.h"
+#include "ns3/node-container.h"
+#include "ns3/data-rate.h"
+#include "ns3/error-model.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/bulk-send-helper.h"
+#include "ns3/packet-sink-helper.h"
+#include "ns3/packet-sink.h"
+#include <iostream>
+
+using namespace ns3;
+
+int main (int argc, char *argv[])
+{
+  std::string rate = "10Gbps";
+  double rtt = 0.1;
+  double loss = 0.01;
+  double duration = 1;
+  uint32_t segmentSize = 1448;
+  uint32_t tso = 1;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark a SACK-enabled TCP flow with a large window and random losses");
+  cmd.AddValue ("rate", "link data rate", rate);
+  cmd.AddValue ("rtt", "round-trip time (s)", rtt);
+  cmd.AddValue ("loss", "probability to drop a data packet", loss);
+  cmd.AddValue ("time", "simulated duration of the transfer (s)", duration);
+  cmd.AddValue ("segmentSize", "TCP segment size (bytes)", segmentSize);
+  cmd.AddValue ("tso", "maximum number of segments per super-segment (1: no segmentation offload)", tso);
+  cmd.Parse (argc, argv);
+
+  uint64_t bdp = static_cast<uint64_t> (DataRate (rate).GetBitRate () * rtt / 8);
+  uint32_t window = static_cast<uint32_t> (bdp / segmentSize) + 1;
+  uint32_t buffer = static_cast<uint32_t> (std::min<uint64_t> (4 * bdp, 0x7fffffff));
+
+  Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (segmentSize));
+  Config::SetDefault ("ns3::TcpSocket::InitialCwnd", UintegerValue (window));
+  Config::SetDefault ("ns3::TcpSocket::SndBufSize", UintegerValue (buffer));
+  Config::SetDefault ("ns3::TcpSocket::RcvBufSize", UintegerValue (buffer));
+  Config::SetDefault ("ns3::TcpSocketBase::Sack", BooleanValue (true));
+  Config::SetDefault ("ns3::TcpSocketBase::TsoSegments", UintegerValue (tso));
+  Config::SetDefault ("ns3::PfifoFastQueueDisc::MaxSize", StringValue ("1000000p"));
+
+  NodeContainer nodes;
+  nodes.Create (2);
+
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue (rate));
+  p2p.SetChannelAttribute ("Delay", TimeValue (Seconds (rtt / 2)));
+  NetDeviceContainer devices = p2p.Install (nodes);
+
+  Ptr<RateErrorModel> errors = CreateObject<RateErrorModel> ();
+  errors->SetUnit (RateErrorModel::ERROR_UNIT_PACKET);
+  errors->SetRate (loss);
+  errors->AssignStreams (1);
+  devices.Get (1)->SetAttribute ("ReceiveErrorModel", PointerValue (errors));
+
+  InternetStackHelper stack;
+  stack.Install (nodes);
+  Ipv4AddressHelper address ("10.0.0.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = address.Assign (devices);
+
+  uint16_t port = 50000;
+  BulkSendHelper source ("ns3::TcpSocketFactory", InetSocketAddress (interfaces.GetAddress (1), port));
+  source.SetAttribute ("SendSize", UintegerValue (segmentSize));
+  ApplicationContainer sourceApps = source.Install (nodes.Get (0));
+  sourceApps.Start (Seconds (0));
+  sourceApps.Stop (Seconds (duration));
+
+  PacketSinkHelper sink ("ns3::TcpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), port));
+  ApplicationContainer sinkApps = sink.Install (nodes.Get (1));
+  sinkApps.Start (Seconds (0));
+
+  SystemWallClockMs time;
+  time.Start ();
+  Simulator::Stop (Seconds (duration));
+  Simulator::Run ();
+  uint64_t runMs = time.End ();
+
+  uint64_t received = DynamicCast<PacketSink> (sinkApps.Get (0))->GetTotalRx ();
+  std::cout << "window (segments)\tsimulated (s)\treceived (MB)\tgoodput (Mb/s)\twall (ms)" << std::endl;
+  std::cout << window << "\t"
+            << duration << "\t"
+            << received / 1e6 << "\t"
+            << received * 8 / duration / 1e6 << "\t"
+            << runMs << std::endl;
+
+  Simulator::Destroy ();
+  return 0;
+}
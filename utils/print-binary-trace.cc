@@ -0,0 +1,87 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program converts a binary trace file written by the
+// EnableBinaryTrace helpers back to text, one line per record:
+//
+//   + 1.234 /NodeList/3/DeviceList/0 uid=42 size=1052 [captured bytes in hex]
+//
+// Sample usage:  ./waf --run 'print-binary-trace --file=trace-0-1.btr'
+
+#include "ns3/command-line.h"
+#include "ns3/binary-trace-file.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <stdlib.h> // for exit ()
+
+using namespace ns3;
+
+int main (int argc, char *argv[])
+{
+  std::string filename;
+  bool hex = true;
+
+  CommandLine cmd;
+  cmd.Usage ("Convert a binary trace file to text");
+  cmd.AddValue ("file", "binary trace file to read", filename);
+  cmd.AddValue ("hex", "print the captured packet bytes, if any", hex);
+  cmd.Parse (argc, argv);
+
+  if (filename.empty ())
+    {
+      std::cerr << "Error-- missing --file argument" << std::endl;
+      exit (1);
+    }
+
+  BinaryTraceFile file;
+  file.Open (filename, std::ios::in);
+  if (file.Fail ())
+    {
+      std::cerr << "Error-- unable to read binary trace file " << filename << std::endl;
+      exit (1);
+    }
+
+  std::vector<uint8_t> data (file.GetSnapLen () + 1);
+  BinaryTraceFile::Record record;
+  uint32_t readLen;
+
+  while (true)
+    {
+      file.Read (record, &data[0], file.GetSnapLen (), readLen);
+      if (file.Fail ())
+        {
+          break;
+        }
+      std::cout << BinaryTraceFile::GetEventChar (record.m_event) << " "
+                << NanoSeconds (record.m_timeNs).GetSeconds ()
+                << " /NodeList/" << record.m_nodeId << "/DeviceList/" << record.m_deviceId
+                << " uid=" << record.m_uid << " size=" << record.m_size;
+      if (hex && readLen)
+        {
+          std::cout << " " << std::hex << std::setfill ('0');
+          for (uint32_t i = 0; i < readLen; ++i)
+            {
+              std::cout << std::setw (2) << static_cast<uint32_t> (data[i]);
+            }
+          std::cout << std::dec << std::setfill (' ');
+        }
+      std::cout << '\n';
+    }
+
+  return 0;
+}